@@ -29,12 +29,18 @@
 #include <linux/slab.h>
 #include <linux/errno.h>
 #include <linux/delay.h>
+#include <linux/err.h>
+#include <linux/debugfs.h>
+#include <linux/seq_file.h>
+#include <linux/uaccess.h>
 
 #include <asm/system.h>
 #include <asm/irq.h>
 #include <mach/hardware.h>
 #include <asm/io.h>
+#include <asm/div64.h>
 #include <linux/dma-mapping.h>
+#include <linux/platform_device.h>
 
 #include <asm/dma.h>
 
@@ -42,6 +48,11 @@
 #include <mach/dma.h>
 #include <plat/dma.h>
 #include <mach/map.h>
+#include <plat/dma-trace.h>
+
+#ifdef CONFIG_S3C_PL330_DMAENGINE
+#include <plat/dma-pl330-engine.h>
+#endif
 
 #include "dma-pl330-mcode.h"
 
@@ -63,6 +74,9 @@
 #undef SECURE_M2M_DMA_MODE_SET
 #endif
 
+DEFINE_TRACE(s3c_dma_enqueue);
+DEFINE_TRACE(s3c_dma_buffdone);
+
 /* io map for dma */
 static void __iomem 		*dma_base;
 static struct kmem_cache 	*dma_kmem;
@@ -82,6 +96,10 @@ s3c_dma_controller_t 		s3c_dma_cntlrs[S3C_DMA_CONTROLLERS];
 #endif
 
 #define SIZE_OF_MICRO_CODES		512
+/* worst case micro code size of one setup_DMA_channel() segment */
+#define SIZE_OF_SEG_MICRO_CODES		96
+/* most buffers emitted into one chained program */
+#define S3C_DMA_CHAIN_MAX		32
 #define PL330_NON_SECURE_DMA		1
 #define PL330_SECURE_DMA		0
 
@@ -175,6 +193,45 @@ static void s3c_dma_stats_timeout(struct s3c_dma_stats *stats, int val)
 	stats->timeout_avg += val;
 }
 
+/* s3c_dma_stats_done
+ *
+ * account a buffer leaving the channel queue, together with the buffers
+ * merged into its program when it was loaded
+ */
+static void s3c_dma_stats_done(struct s3c2410_dma_chan *chan,
+			       struct s3c_dma_buf *buf,
+			       enum s3c2410_dma_buffresult result)
+{
+	struct s3c_dma_stats *stats = chan->stats;
+	unsigned long long delta;
+	int bucket;
+
+	if (stats == NULL)
+		return;
+
+	stats->depth -= min_t(unsigned long, stats->depth, 1 + buf->merged);
+
+	if (result != S3C2410_RES_OK) {
+		stats->aborted += 1 + buf->merged;
+		return;
+	}
+
+	stats->done += 1 + buf->merged;
+	stats->bytes += buf->size + buf->merged_size;
+
+	/* only buffers completed from the interrupt have a latency */
+	if (chan->irq_ns) {
+		delta = sched_clock() - chan->irq_ns;
+		do_div(delta, 1000);
+
+		bucket = delta ? fls((unsigned long) min(delta, 1ULL << 30)) : 0;
+		if (bucket >= S3C_DMA_LAT_BUCKETS)
+			bucket = S3C_DMA_LAT_BUCKETS - 1;
+
+		stats->latency[bucket]++;
+	}
+}
+
 void s3c_enable_dmac(unsigned int dcon_num)
 {
 	s3c_dma_controller_t *dma_controller = &s3c_dma_cntlrs[dcon_num];
@@ -199,6 +256,49 @@ void s3c_clear_interrupts(int dcon_num, int channel)
 	dma_wrreg(dma_controller, S3C_DMAC_INTCLR, tmp);
 }
 
+/* s3c_dma_go
+ *
+ * issue DMAGO for the micro code program at mcptr on the given channel,
+ * picking the security state the channel's controller runs in
+ */
+static void s3c_dma_go(struct s3c2410_dma_chan *chan, dma_addr_t mcptr)
+{
+	int secure = PL330_NON_SECURE_DMA;
+
+#ifdef SECURE_M2M_DMA_MODE_SET
+#if defined(CONFIG_MACH_SMDK6442)
+	secure = PL330_SECURE_DMA;
+#else  /* CONFIG_MACH_SMDK6442 */
+	if (chan->dma_con->number == 0)
+		secure = PL330_SECURE_DMA;
+#endif /* CONFIG_MACH_SMDK6442 */
+#endif /* SECURE_M2M_DMA_MODE */
+
+	start_DMA_channel(dma_regaddr(chan->dma_con, S3C_DMAC_DBGSTATUS),
+			  chan->number, mcptr, secure);
+}
+
+/* s3c_dma_wait_stopped
+ *
+ * wait for a channel that has signalled its last event to execute the
+ * DMAEND behind it, so that it can take a new DMAGO
+ */
+static int s3c_dma_wait_stopped(struct s3c2410_dma_chan *chan)
+{
+	int timeout = chan->load_timeout;
+
+	while ((dma_rdreg(chan->dma_con, S3C_DMAC_CS(chan->number)) & 0xf)
+			!= S3C_DMAC_CS_STOPPED) {
+		if (--timeout == 0) {
+			printk(KERN_ERR "dma CH %d: timeout waiting for stop\n",
+			       chan->number);
+			return 0;
+		}
+	}
+
+	return 1;
+}
+
 /* s3c_dma_waitforload
  *
  * wait for the DMA engine to load a buffer, and update the state accordingly
@@ -244,6 +344,189 @@ static int s3c_dma_waitforload(struct s3c2410_dma_chan *chan, int line)
 }
 
 static inline void s3c_dma_freebuf(struct s3c_dma_buf *buf);
+static inline void s3c_dma_buffdone(struct s3c2410_dma_chan *chan,
+				struct s3c_dma_buf *buf,
+				enum s3c2410_dma_buffresult result);
+
+/* s3c_dma_setparam
+ *
+ * fill in the micro code parameters to move the given buffer
+ */
+static int s3c_dma_setparam(struct s3c2410_dma_chan *chan,
+			    struct s3c_dma_buf *buf,
+			    pl330_DMA_parameters_t *dma_param)
+{
+	dma_param->mPeriNum = chan->config_flags;
+	dma_param->mDirection = chan->source;
+
+	switch (dma_param->mDirection) {
+
+	/* source is Memory : Mem-to-Peri (Write into FIFO) */
+	case S3C2410_DMASRC_MEM:
+		dma_param->mSrcAddr = buf->data;
+		dma_param->mDstAddr = chan->dev_addr;
+		break;
+
+	/* source is peripheral : Peri-to-Mem (Read from FIFO) */
+	case S3C2410_DMASRC_HW:
+		dma_param->mSrcAddr = chan->dev_addr;
+		dma_param->mDstAddr = buf->data;
+		break;
+
+	/* source & destination : Mem-to-Mem  */
+	case S3C_DMA_MEM2MEM:
+		dma_param->mSrcAddr = chan->dev_addr;
+		dma_param->mDstAddr = buf->data;
+		break;
+
+	/* source & destination : Mem-to-Mem  */
+	case S3C_DMA_MEM2MEM_SET:
+		dma_param->mDirection = S3C_DMA_MEM2MEM;
+		dma_param->mSrcAddr = chan->dev_addr;
+		dma_param->mDstAddr = buf->data;
+		break;
+
+	case S3C_DMA_PER2PER:
+	default:
+		printk("Peripheral-to-Peripheral DMA NOT YET implemented !! \n");
+		return -EINVAL;
+	}
+
+	dma_param->mTrSize = buf->size;
+
+	dma_param->mLoop = 0;
+	dma_param->mControl = *(pl330_DMA_control_t *) &chan->dcon;
+
+	return 0;
+}
+
+/* s3c_dma_chain_load
+ *
+ * chained mode: emit the queued buffers, up to S3C_DMA_CHAIN_MAX, into
+ * the channel's program with an event after each of them, so the
+ * controller runs them back to back. The buffers stay on the queue until
+ * s3c_dma_chain_irq() has seen them finish. Returns the number loaded.
+ */
+static int s3c_dma_chain_load(struct s3c2410_dma_chan *chan)
+{
+	pl330_DMA_parameters_t dma_param;
+	struct s3c_dma_buf *buf;
+	unsigned long tmp;
+	int bwJump = 0, count = 0;
+
+	for (buf = chan->next; buf != NULL; buf = buf->next) {
+		memset(&dma_param, 0, sizeof(pl330_DMA_parameters_t));
+
+		if (s3c_dma_setparam(chan, buf, &dma_param))
+			break;
+
+		dma_param.mIrqEnable = 1;
+		dma_param.mLastReq = (buf->next == NULL ||
+				      count == S3C_DMA_CHAIN_MAX - 1);
+
+		bwJump += setup_DMA_channel(chan->chain_mc_cpu + bwJump,
+					    dma_param, chan->number);
+
+		if (++count == S3C_DMA_CHAIN_MAX) {
+			buf = buf->next;
+			break;
+		}
+	}
+
+	pr_debug("%s: DMA CH %d: %d buffers, %d bytes of micro code\n",
+		 __FUNCTION__, chan->number, count, bwJump);
+
+	chan->next = buf;
+	chan->chain_loaded = count;
+
+	if (count) {
+		tmp = dma_rdreg(chan->dma_con, S3C_DMAC_INTEN);
+		tmp |= (1 << chan->number);
+		dma_wrreg(chan->dma_con, S3C_DMAC_INTEN, tmp);
+
+		chan->load_state = S3C_DMALOAD_1RUNNING;
+	}
+
+	return count;
+}
+
+/* s3c_dma_chain_done
+ *
+ * work out how many of the loaded buffers have finished. Events of
+ * consecutive buffers may be merged into one interrupt, so look at where
+ * the memory side of the channel has got to.
+ */
+static int s3c_dma_chain_done(struct s3c2410_dma_chan *chan)
+{
+	struct s3c_dma_buf *buf;
+	unsigned long cs;
+	dma_addr_t pos;
+	int done = 0;
+
+	cs = dma_rdreg(chan->dma_con, S3C_DMAC_CS(chan->number)) & 0xf;
+	if (cs == S3C_DMAC_CS_STOPPED)
+		return chan->chain_loaded;
+
+	if (chan->source == S3C2410_DMASRC_MEM)
+		pos = dma_rdreg(chan->dma_con, S3C_DMAC_SA(chan->number));
+	else
+		pos = dma_rdreg(chan->dma_con, S3C_DMAC_DA(chan->number));
+
+	for (buf = chan->curr; buf != NULL && done < chan->chain_loaded;
+	     buf = buf->next) {
+		if (pos >= buf->data && pos < buf->data + buf->size)
+			return done;
+
+		done++;
+
+		if (pos == buf->data + buf->size)
+			return done;
+	}
+
+	/* no loaded buffer matches, just account for this event */
+	return 1;
+}
+
+/* s3c_dma_chain_irq
+ *
+ * complete the finished buffers of a chained program and, once the
+ * program has ended, start the next one from whatever got queued
+ */
+static void s3c_dma_chain_irq(struct s3c2410_dma_chan *chan)
+{
+	struct s3c_dma_buf *buf;
+	int done = s3c_dma_chain_done(chan);
+
+	while (done-- > 0 && chan->chain_loaded > 0) {
+		buf = chan->curr;
+
+		chan->curr = buf->next;
+		if (chan->curr == NULL)
+			chan->end = NULL;
+		buf->next = NULL;
+		chan->chain_loaded--;
+
+		s3c_dma_buffdone(chan, buf, S3C2410_RES_OK);
+		s3c_dma_freebuf(buf);
+	}
+
+	/* the callbacks may have stopped or flushed the channel */
+	if (chan->chain_loaded > 0 || chan->state == S3C_DMA_IDLE)
+		return;
+
+	if (chan->next != NULL && s3c_dma_wait_stopped(chan)) {
+		s3c_dma_chain_load(chan);
+		s3c_dma_go(chan, chan->chain_mc);
+		return;
+	}
+
+	/* the channel ran dry */
+	if (chan->stats != NULL)
+		chan->stats->stalls++;
+
+	pr_debug("# DMA CH %d: end of chain, stopping channel\n", chan->number);
+	s3c2410_dma_ctrl(chan->index | DMACH_LOW_LEVEL, S3C2410_DMAOP_STOP);
+}
 
 /* s3c_dma_loadbuffer
  *
@@ -276,47 +559,13 @@ static inline int s3c_dma_loadbuffer(struct s3c2410_dma_chan *chan,
 	last1buf = buf;
 	last2buf = buf;
 
-	do {
-		dma_param.mPeriNum = chan->config_flags;
-		dma_param.mDirection = chan->source;
-
-		switch (dma_param.mDirection) {
-
-		/* source is Memory : Mem-to-Peri (Write into FIFO) */
-		case S3C2410_DMASRC_MEM:
-			dma_param.mSrcAddr = buf->data;
-			dma_param.mDstAddr = chan->dev_addr;
-			break;
-
-		/* source is peripheral : Peri-to-Mem (Read from FIFO) */
-		case S3C2410_DMASRC_HW:
-			dma_param.mSrcAddr = chan->dev_addr;
-			dma_param.mDstAddr = buf->data;
-			break;
-
-		/* source & destination : Mem-to-Mem  */
-		case S3C_DMA_MEM2MEM:
-			dma_param.mSrcAddr = chan->dev_addr;
-			dma_param.mDstAddr = buf->data;
-			break;
-
-		/* source & destination : Mem-to-Mem  */
-		case S3C_DMA_MEM2MEM_SET:
-			dma_param.mDirection = S3C_DMA_MEM2MEM;
-			dma_param.mSrcAddr = chan->dev_addr;
-			dma_param.mDstAddr = buf->data;
-			break;
+	/* merged buffers are accounted when firstbuf completes */
+	firstbuf->merged = 0;
+	firstbuf->merged_size = 0;
 
-		case S3C_DMA_PER2PER:
-		default:
-			printk("Peripheral-to-Peripheral DMA NOT YET implemented !! \n");
+	do {
+		if (s3c_dma_setparam(chan, buf, &dma_param))
 			return -EINVAL;
-		}
-
-		dma_param.mTrSize = buf->size;
-
-		dma_param.mLoop = 0;
-		dma_param.mControl = *(pl330_DMA_control_t *) &chan->dcon;
 
 		last2buf = last1buf;
 		last1buf = buf;
@@ -337,13 +586,19 @@ static inline int s3c_dma_loadbuffer(struct s3c2410_dma_chan *chan,
 			dma_param, chan->number);
 		pr_debug("%s: DMA bwJump - %d\n", __FUNCTION__, bwJump);
 
-		if (last2buf != firstbuf)
+		if (last2buf != firstbuf) {
+			firstbuf->merged++;
+			firstbuf->merged_size += last2buf->size;
 			s3c_dma_freebuf(last2buf);
+		}
 
 	} while (buf != NULL);
 
-	if (last1buf != firstbuf)
+	if (last1buf != firstbuf) {
+		firstbuf->merged++;
+		firstbuf->merged_size += last1buf->size;
 		s3c_dma_freebuf(last1buf);
+	}
 
 	if (dma_param.mIrqEnable) {
 		tmp = dma_rdreg(chan->dma_con, S3C_DMAC_INTEN);
@@ -394,6 +649,9 @@ static inline void s3c_dma_buffdone(struct s3c2410_dma_chan *chan,
 	pr_debug("callback_fn will be called=%p, buf=%p, id=%p, size=%d, result=%d\n",
 		 chan->callback_fn, buf, buf->id, buf->size, result);
 
+	s3c_dma_stats_done(chan, buf, result);
+	trace_s3c_dma_buffdone(chan, buf->id, buf->size, result);
+
 	if (chan->callback_fn != NULL)
 		(chan->callback_fn) (chan, buf->id, buf->size, result);
 }
@@ -422,7 +680,14 @@ static int s3c_dma_start(struct s3c2410_dma_chan *chan)
 	 * if we can find anything to load
 	 */
 
-	if (chan->load_state == S3C_DMALOAD_NONE) {
+	if (chan->flags & S3C2410_DMAF_CHAIN) {
+		if (chan->chain_loaded == 0 && s3c_dma_chain_load(chan) == 0) {
+			printk(KERN_ERR "dma CH %d: dcon_num has nothing loaded\n", chan->number);
+			chan->state = S3C_DMA_IDLE;
+			local_irq_restore(flags);
+			return -EINVAL;
+		}
+	} else if (chan->load_state == S3C_DMALOAD_NONE) {
 		if (chan->next == NULL) {
 			printk(KERN_ERR "dma CH %d: dcon_num has nothing loaded\n", chan->number);
 			chan->state = S3C_DMA_IDLE;
@@ -441,25 +706,10 @@ static int s3c_dma_start(struct s3c2410_dma_chan *chan)
 		chan->irq_enabled = 1;
 	}
 
-#ifndef SECURE_M2M_DMA_MODE_SET
-	start_DMA_channel(dma_regaddr(chan->dma_con, S3C_DMAC_DBGSTATUS), chan->number,
-					chan->curr->mcptr, PL330_NON_SECURE_DMA);
-#else	/* SECURE_M2M_DMA_MODE */
-
-#if defined(CONFIG_MACH_SMDK6442)
-	start_DMA_channel(dma_regaddr(chan->dma_con, S3C_DMAC_DBGSTATUS), chan->number,
-					chan->curr->mcptr, PL330_SECURE_DMA);
-#else  /* CONFIG_MACH_SMDK6442 */
-	if (chan->dma_con->number == 0) {
-		start_DMA_channel(dma_regaddr(chan->dma_con, S3C_DMAC_DBGSTATUS), chan->number,
-					chan->curr->mcptr, PL330_SECURE_DMA);
-	} else {
-		start_DMA_channel(dma_regaddr(chan->dma_con, S3C_DMAC_DBGSTATUS), chan->number,
-					chan->curr->mcptr, PL330_NON_SECURE_DMA);
-	}
-#endif /* CONFIG_MACH_SMDK6442 */
-
-#endif /* SECURE_M2M_DMA_MODE */
+	if (chan->flags & S3C2410_DMAF_CHAIN)
+		s3c_dma_go(chan, chan->chain_mc);
+	else
+		s3c_dma_go(chan, chan->curr->mcptr);
 
 	/* Start the DMA operation on Peripheral */
 	s3c_dma_call_op(chan, S3C2410_DMAOP_START);
@@ -521,14 +771,24 @@ int s3c2410_dma_enqueue(unsigned int channel, void *id,
 	buf->size = size;
 	buf->id = id;
 	buf->magic = BUF_MAGIC;
+	buf->merged = 0;
+	buf->merged_size = 0;
+
+	trace_s3c_dma_enqueue(chan, id, data, size);
 
 	local_irq_save(flags);
 
-	buf->mcptr_cpu = dma_alloc_coherent(NULL, SIZE_OF_MICRO_CODES, &buf->mcptr, GFP_ATOMIC);
+	/* chained buffers are emitted into the channel's own program */
+	if (!(chan->flags & S3C2410_DMAF_CHAIN)) {
+		buf->mcptr_cpu = dma_alloc_coherent(NULL, SIZE_OF_MICRO_CODES,
+						    &buf->mcptr, GFP_ATOMIC);
 
-	if (buf->mcptr_cpu == NULL) {
-		printk(KERN_ERR "%s: failed to allocate memory for micro codes\n", __FUNCTION__);
-		return -ENOMEM;
+		if (buf->mcptr_cpu == NULL) {
+			printk(KERN_ERR "%s: failed to allocate memory for micro codes\n", __FUNCTION__);
+			kmem_cache_free(dma_kmem, buf);
+			local_irq_restore(flags);
+			return -ENOMEM;
+		}
 	}
 
 	if (chan->curr == NULL) {
@@ -555,9 +815,18 @@ int s3c2410_dma_enqueue(unsigned int channel, void *id,
 	if (chan->next == NULL)
 		chan->next = buf;
 
-	/* check to see if we can load a buffer */
+	if (chan->stats != NULL) {
+		chan->stats->buffers++;
+		if (++chan->stats->depth > chan->stats->depth_hwm)
+			chan->stats->depth_hwm = chan->stats->depth;
+	}
+
+	/* check to see if we can load a buffer; a running chain picks up
+	 * new buffers by itself when its program ends */
 	if (chan->state == S3C_DMA_RUNNING) {
-		if (chan->load_state == S3C_DMALOAD_1LOADED && 1) {
+		if (chan->flags & S3C2410_DMAF_CHAIN) {
+			/* nothing to do */
+		} else if (chan->load_state == S3C_DMALOAD_1LOADED && 1) {
 			if (s3c_dma_waitforload(chan, __LINE__) == 0) {
 				printk(KERN_ERR "dma CH %d: loadbuffer:"
 				       "timeout loading buffer\n", chan->number);
@@ -588,9 +857,11 @@ static inline void s3c_dma_freebuf(struct s3c_dma_buf *buf)
 	buf->magic = -1;
 
 	if (magicok) {
-		local_irq_enable();
-		dma_free_coherent(NULL, SIZE_OF_MICRO_CODES, buf->mcptr_cpu, buf->mcptr);
-		local_irq_disable();
+		if (buf->mcptr_cpu != NULL) {
+			local_irq_enable();
+			dma_free_coherent(NULL, SIZE_OF_MICRO_CODES, buf->mcptr_cpu, buf->mcptr);
+			local_irq_disable();
+		}
 
 		kmem_cache_free(dma_kmem, buf);
 	} else {
@@ -629,6 +900,10 @@ static inline void s3c_dma_lastxfer(struct s3c2410_dma_chan *chan)
 
 #define dmadbg2(x...)
 
+#ifdef CONFIG_S3C_PL330_DMAENGINE
+static void s3c_pl330_engine_irq(struct s3c2410_dma_chan *hw);
+#endif
+
 static irqreturn_t s3c_dma_irq(int irq, void *devpw)
 {
 	unsigned int channel = 0, dcon_num, i;
@@ -638,6 +913,8 @@ static irqreturn_t s3c_dma_irq(int irq, void *devpw)
 	struct s3c2410_dma_chan *chan = NULL;
 	struct s3c_dma_buf *buf;
 
+	unsigned long long now = sched_clock();
+
 	dcon_num = dma_controller->number;
 	tmp = dma_rdreg(dma_controller, S3C_DMAC_INTSTATUS);
 	pr_debug("# s3c_dma_irq: IRQ status : 0x%x\n", tmp);
@@ -654,6 +931,24 @@ static irqreturn_t s3c_dma_irq(int irq, void *devpw)
 			chan = &s3c_dma_chans[channel + dcon_num * S3C_CHANNELS_PER_DMA];
 			pr_debug("# DMA CH:%d, index:%d load_state:%d\n", chan->number, chan->index, chan->load_state);
 
+			chan->irq_ns = now;
+
+#ifdef CONFIG_S3C_PL330_DMAENGINE
+			/* channels claimed through dmaengine run their own
+			 * programs and have no s3c_dma_buf queue */
+			if (chan->engine != NULL) {
+				s3c_clear_interrupts(dcon_num, chan->number);
+				s3c_pl330_engine_irq(chan);
+				goto next_channel;
+			}
+#endif
+
+			if (chan->flags & S3C2410_DMAF_CHAIN) {
+				s3c_clear_interrupts(dcon_num, chan->number);
+				s3c_dma_chain_irq(chan);
+				goto next_channel;
+			}
+
 			buf = chan->curr;
 
 			dbg_showchan(chan);
@@ -756,26 +1051,15 @@ static irqreturn_t s3c_dma_irq(int irq, void *devpw)
 
 				local_irq_save(flags);
 				s3c_dma_loadbuffer(chan, chan->next);
-#ifndef SECURE_M2M_DMA_MODE_SET
-				start_DMA_channel(dma_regaddr(chan->dma_con, S3C_DMAC_DBGSTATUS), chan->number,
-								chan->curr->mcptr, PL330_NON_SECURE_DMA);
-#else	/* SECURE_M2M_DMA_MODE */
-#if defined(CONFIG_MACH_SMDK6442)
-				start_DMA_channel(dma_regaddr(chan->dma_con, S3C_DMAC_DBGSTATUS), chan->number,
-							chan->curr->mcptr, PL330_SECURE_DMA);
-#else  /* CONFIG_MACH_SMDK6442 */
-				if (chan->dma_con->number == 0) {
-					start_DMA_channel(dma_regaddr(chan->dma_con, S3C_DMAC_DBGSTATUS), chan->number,
-								chan->curr->mcptr, PL330_SECURE_DMA);
-				} else {
-					start_DMA_channel(dma_regaddr(chan->dma_con, S3C_DMAC_DBGSTATUS), chan->number,
-								chan->curr->mcptr, PL330_NON_SECURE_DMA);
-				}
-#endif /* CONFIG_MACH_SMDK6442 */
-#endif /* SECURE_M2M_DMA_MODE */
+				s3c_dma_go(chan, chan->curr->mcptr);
 				local_irq_restore(flags);
 
 			} else {
+				/* the channel ran dry */
+				if (chan->state != S3C_DMA_IDLE &&
+				    chan->stats != NULL)
+					chan->stats->stalls++;
+
 				s3c_dma_lastxfer(chan);
 
 				/* see if we can stop this channel.. */
@@ -789,6 +1073,8 @@ static irqreturn_t s3c_dma_irq(int irq, void *devpw)
 
 		}
 next_channel:
+		if (chan != NULL)
+			chan->irq_ns = 0;
 		tmp >>= 1;
 	}
 
@@ -917,8 +1203,16 @@ int s3c2410_dma_free(unsigned int channel, struct s3c2410_dma_client *client)
 	if (!(channel & DMACH_LOW_LEVEL))
 		dma_chan_map[channel] = NULL;
 
+	chan->flags = 0;
+
 	local_irq_restore(flags);
 
+	if (chan->chain_mc_cpu != NULL) {
+		dma_free_coherent(NULL, S3C_DMA_CHAIN_MAX * SIZE_OF_SEG_MICRO_CODES,
+				  chan->chain_mc_cpu, chan->chain_mc);
+		chan->chain_mc_cpu = NULL;
+	}
+
 	return 0;
 }
 EXPORT_SYMBOL(s3c2410_dma_free);
@@ -941,6 +1235,12 @@ static int s3c_dma_dostop(struct s3c2410_dma_chan *chan)
 
 	chan->load_state = S3C_DMALOAD_NONE;
 
+	/* unfinished chained buffers get loaded again on the next start */
+	if (chan->chain_loaded) {
+		chan->next = chan->curr;
+		chan->chain_loaded = 0;
+	}
+
 	local_irq_restore(flags);
 
 	return 0;
@@ -982,6 +1282,7 @@ static int s3c_dma_flush(struct s3c2410_dma_chan *chan)
 
 	chan->curr = chan->next = chan->end = NULL;
 	chan->load_state = S3C_DMALOAD_NONE;
+	chan->chain_loaded = 0;
 
 	if (buf != NULL) {
 		for (; buf != NULL; buf = next) {
@@ -1144,6 +1445,17 @@ int s3c2410_dma_setflags(unsigned int channel, unsigned int flags)
 
 	pr_debug("%s: chan=%p, flags=%08x\n", __FUNCTION__, chan, flags);
 
+	if ((flags & S3C2410_DMAF_CHAIN) && chan->chain_mc_cpu == NULL) {
+		chan->chain_mc_cpu = dma_alloc_coherent(NULL,
+				S3C_DMA_CHAIN_MAX * SIZE_OF_SEG_MICRO_CODES,
+				&chan->chain_mc, GFP_KERNEL);
+
+		if (chan->chain_mc_cpu == NULL) {
+			printk(KERN_ERR "%s: failed to allocate memory for micro codes\n", __FUNCTION__);
+			return -ENOMEM;
+		}
+	}
+
 	chan->flags = flags;
 
 	return 0;
@@ -1578,3 +1890,979 @@ int __init s3c_dma_order_set(struct s3c_dma_order *ord)
 	memcpy(nord, ord, sizeof(struct s3c_dma_order));
 	return 0;
 }
+
+#ifdef CONFIG_DEBUG_FS
+
+/*
+ * per channel statistics, in <debugfs>/pl330-dma/chN. Writing anything to
+ * a file clears the counters of that channel.
+ */
+
+static const char *s3c_dma_state_names[] = {
+	[S3C_DMA_IDLE]		= "idle",
+	[S3C_DMA_RUNNING]	= "running",
+	[S3C_DMA_PAUSED]	= "paused",
+};
+
+static int s3c_dma_stats_show(struct seq_file *s, void *v)
+{
+	struct s3c2410_dma_chan *chan = s->private;
+	struct s3c_dma_stats stats;
+	unsigned long flags;
+	int i;
+
+	local_irq_save(flags);
+	stats = *chan->stats;
+	local_irq_restore(flags);
+
+	seq_printf(s, "client:    %s\n",
+		   chan->in_use && chan->client ? chan->client->name : "-");
+	seq_printf(s, "state:     %s%s\n", s3c_dma_state_names[chan->state],
+		   chan->flags & S3C2410_DMAF_CHAIN ? " (chained)" : "");
+	seq_printf(s, "buffers:   %lu\n", stats.buffers);
+	seq_printf(s, "done:      %lu\n", stats.done);
+	seq_printf(s, "aborted:   %lu\n", stats.aborted);
+	seq_printf(s, "bytes:     %llu\n", stats.bytes);
+	seq_printf(s, "depth:     %lu (max %lu)\n", stats.depth, stats.depth_hwm);
+	seq_printf(s, "stalls:    %lu\n", stats.stalls);
+	seq_printf(s, "loads:     %lu\n", stats.loads);
+	seq_printf(s, "timeouts:  %lu\n", stats.timeout_failed);
+
+	seq_printf(s, "latency (irq to callback):\n");
+	for (i = 0; i < S3C_DMA_LAT_BUCKETS - 1; i++)
+		seq_printf(s, "  < %5u us: %lu\n", 1 << i, stats.latency[i]);
+	seq_printf(s, "  >= %4u us: %lu\n", 1 << (i - 1), stats.latency[i]);
+
+	return 0;
+}
+
+static int s3c_dma_stats_open(struct inode *inode, struct file *file)
+{
+	return single_open(file, s3c_dma_stats_show, inode->i_private);
+}
+
+static ssize_t s3c_dma_stats_write(struct file *file, const char __user *buf,
+				   size_t count, loff_t *ppos)
+{
+	struct seq_file *s = file->private_data;
+	struct s3c2410_dma_chan *chan = s->private;
+	struct s3c_dma_stats *stats = chan->stats;
+	unsigned long depth;
+	unsigned long flags;
+
+	local_irq_save(flags);
+
+	/* the queue itself is still there */
+	depth = stats->depth;
+	memset(stats, 0, sizeof(*stats));
+	stats->timeout_shortest = LONG_MAX;
+	stats->depth = depth;
+	stats->depth_hwm = depth;
+
+	local_irq_restore(flags);
+
+	return count;
+}
+
+static const struct file_operations s3c_dma_stats_fops = {
+	.owner		= THIS_MODULE,
+	.open		= s3c_dma_stats_open,
+	.read		= seq_read,
+	.write		= s3c_dma_stats_write,
+	.llseek		= seq_lseek,
+	.release	= single_release,
+};
+
+static int __init s3c_dma_debugfs_init(void)
+{
+	struct dentry *root;
+	char name[8];
+	int channel;
+
+	root = debugfs_create_dir("pl330-dma", NULL);
+	if (root == NULL || IS_ERR(root))
+		return 0;
+
+	for (channel = 0; channel < dma_channels; channel++) {
+		snprintf(name, sizeof(name), "ch%d", channel);
+		debugfs_create_file(name, S_IRUGO | S_IWUSR, root,
+				    &s3c_dma_chans[channel],
+				    &s3c_dma_stats_fops);
+	}
+
+	return 0;
+}
+
+late_initcall(s3c_dma_debugfs_init);
+
+#endif /* CONFIG_DEBUG_FS */
+
+#ifdef CONFIG_S3C_PL330_DMAENGINE
+
+/*
+ * dmaengine interface
+ *
+ * A dmaengine channel claims its hardware channel through
+ * s3c2410_dma_request() when its resources are allocated, so the board
+ * channel maps keep working and the legacy clients can share the
+ * controllers. Each descriptor owns one complete PL330 program: every
+ * segment of a scatterlist, or every period of a cyclic ring, is emitted
+ * back to back and only the last segment (or every period) raises an
+ * event, instead of one interrupt and one reload per buffer.
+ *
+ * The device is DMA_PRIVATE: its memcpy channels sit on the same MDMA
+ * MTOM virtual channels as the legacy clients (3D, m2m test), so they are
+ * only handed out through dma_request_channel() and never picked up by
+ * async_tx or net_dma behind those clients' backs.
+ */
+
+#define S3C_PL330_ENGINE_CHANNELS	S3C_CHANNELS_PER_DMA
+#define S3C_PL330_DESCS_PER_CHANNEL	16
+
+/* room for the closing DMAEND or DMALPFE */
+#define S3C_PL330_MC_TRAILER		4
+/* DMALPFE can only jump this far back */
+#define S3C_PL330_MAX_BWJUMP		255
+/* segments of micro code each descriptor gets up front; a 1MB memcpy
+ * fits even with single beat bursts */
+#define S3C_PL330_MC_PREALLOC_SEGS	8
+/* tasklet runs to wait for a long cyclic ring to stop before restarting */
+#define S3C_PL330_RESTART_TRIES		8
+
+struct s3c_pl330_desc {
+	struct dma_async_tx_descriptor	txd;
+	struct list_head		node;
+
+	u8				*mc_cpu;	/* program, cpu view */
+	dma_addr_t			mc_phys;	/* program, bus view */
+	size_t				mc_size;	/* bytes allocated */
+	size_t				mc_end;		/* offset of DMAEND */
+
+	dma_addr_t			src;		/* memcpy unmap info */
+	dma_addr_t			dst;
+	size_t				len;
+
+	unsigned int			cyclic:1;	/* never completes */
+	unsigned int			restart:1;	/* DMAGO again on wrap */
+};
+
+struct s3c_pl330_chan {
+	struct dma_chan			common;
+	spinlock_t			lock;
+
+	unsigned int			req;		/* virtual channel claimed */
+	struct s3c2410_dma_client	client;
+	struct s3c2410_dma_chan		*hw;
+
+	dma_cookie_t			completed;
+	dma_cookie_t			failed;		/* cyclic ring that died */
+	unsigned int			periods;	/* periods not yet reported */
+	unsigned int			restart;	/* tries left, 0 if none */
+
+	struct list_head		active;		/* running, at most one */
+	struct list_head		queue;		/* submitted, not started */
+	struct list_head		done;		/* finished, for the tasklet */
+	struct list_head		free_list;
+	unsigned int			descs_allocated;
+
+	struct tasklet_struct		tasklet;
+};
+
+static struct dma_device s3c_pl330_dma;
+static struct s3c_pl330_chan s3c_pl330_chans[S3C_PL330_ENGINE_CHANNELS];
+
+static u64 s3c_pl330_dmamask = 0xffffffffUL;
+
+static struct platform_device s3c_pl330_device = {
+	.name		= "s3c-pl330-dmaengine",
+	.id		= -1,
+	.dev		= {
+		.dma_mask		= &s3c_pl330_dmamask,
+		.coherent_dma_mask	= 0xffffffffUL,
+	},
+};
+
+static inline struct s3c_pl330_chan *to_s3c_pl330_chan(struct dma_chan *chan)
+{
+	return container_of(chan, struct s3c_pl330_chan, common);
+}
+
+static inline struct s3c_pl330_desc *
+txd_to_s3c_pl330_desc(struct dma_async_tx_descriptor *txd)
+{
+	return container_of(txd, struct s3c_pl330_desc, txd);
+}
+
+static struct s3c_pl330_desc *s3c_pl330_desc_get(struct s3c_pl330_chan *pc)
+{
+	struct s3c_pl330_desc *desc, *ret = NULL;
+	unsigned long flags;
+
+	spin_lock_irqsave(&pc->lock, flags);
+	list_for_each_entry(desc, &pc->free_list, node) {
+		if (async_tx_test_ack(&desc->txd)) {
+			list_del(&desc->node);
+			ret = desc;
+			break;
+		}
+	}
+	spin_unlock_irqrestore(&pc->lock, flags);
+
+	return ret;
+}
+
+/* the micro code stays with the descriptor for the next user */
+static void s3c_pl330_desc_put(struct s3c_pl330_chan *pc,
+			       struct s3c_pl330_desc *desc)
+{
+	unsigned long flags;
+
+	spin_lock_irqsave(&pc->lock, flags);
+	list_add(&desc->node, &pc->free_list);
+	spin_unlock_irqrestore(&pc->lock, flags);
+}
+
+static void s3c_pl330_desc_free_mc(struct s3c_pl330_desc *desc)
+{
+	if (desc->mc_cpu != NULL)
+		dma_free_coherent(NULL, desc->mc_size,
+				  desc->mc_cpu, desc->mc_phys);
+	desc->mc_cpu = NULL;
+	desc->mc_size = 0;
+}
+
+/* s3c_pl330_desc_alloc_mc
+ *
+ * make room for segs segments of micro code. The buffer a descriptor got
+ * when the channel was set up covers the usual requests, so the prep
+ * callbacks only allocate, atomically, for unusually long programs.
+ */
+static int s3c_pl330_desc_alloc_mc(struct s3c_pl330_desc *desc, int segs,
+				   gfp_t gfp)
+{
+	size_t size = segs * SIZE_OF_SEG_MICRO_CODES + S3C_PL330_MC_TRAILER;
+
+	if (size <= desc->mc_size)
+		return 0;
+
+	s3c_pl330_desc_free_mc(desc);
+
+	desc->mc_cpu = dma_alloc_coherent(NULL, size, &desc->mc_phys, gfp);
+	if (desc->mc_cpu == NULL)
+		return -ENOMEM;
+
+	desc->mc_size = size;
+	return 0;
+}
+
+/* s3c_pl330_max_chunk
+ *
+ * the largest transfer config_DMA_transfer_size() can express with its
+ * two loop counters, for the burst setup currently in the channel
+ */
+static size_t s3c_pl330_max_chunk(struct s3c2410_dma_chan *hw)
+{
+	pl330_DMA_control_t ctrl = *(pl330_DMA_control_t *) &hw->dcon;
+	size_t lcsize = (ctrl.uSBLength + 1) << ctrl.uSBSize;
+	size_t limit;
+
+	limit = (hw->source == S3C_DMA_MEM2MEM) ?
+		(8 * 1024 * 1024) : (2 * 1024 * 1024);
+
+	return min(limit, lcsize * PL330_MAX_ITERATION_NUM *
+				PL330_MAX_ITERATION_NUM);
+}
+
+/* s3c_pl330_emit_xfer
+ *
+ * append the micro code moving len bytes from src to dst, split into
+ * chunks the loop counters can cover. The channel event is raised after
+ * the last chunk if irq is set. Returns the number of bytes emitted.
+ */
+static int s3c_pl330_emit_xfer(struct s3c2410_dma_chan *hw, u8 *mc,
+			       unsigned long src, unsigned long dst,
+			       size_t len, int irq)
+{
+	pl330_DMA_parameters_t dma_param;
+	size_t chunk, max = s3c_pl330_max_chunk(hw);
+	int size = 0;
+
+	while (len > 0) {
+		chunk = min(len, max);
+
+		memset(&dma_param, 0, sizeof(pl330_DMA_parameters_t));
+		dma_param.mDirection = hw->source;
+		dma_param.mPeriNum = hw->config_flags;
+		dma_param.mSrcAddr = src;
+		dma_param.mDstAddr = dst;
+		dma_param.mTrSize = chunk;
+		dma_param.mControl = *(pl330_DMA_control_t *) &hw->dcon;
+		dma_param.mIrqEnable = irq && chunk == len;
+
+		size += setup_DMA_channel(mc + size, dma_param, hw->number);
+
+		/* the fifo side of a peripheral transfer stays put */
+		if (hw->source != S3C2410_DMASRC_HW)
+			src += chunk;
+		if (hw->source != S3C2410_DMASRC_MEM)
+			dst += chunk;
+		len -= chunk;
+	}
+
+	return size;
+}
+
+/* s3c_pl330_emit_tail
+ *
+ * append byte beats for the last (len & 3) bytes of a memcpy, which the
+ * word sized remainder loop of config_DMA_transfer_size() cannot move
+ */
+static int s3c_pl330_emit_tail(struct s3c2410_dma_chan *hw, u8 *mc,
+			       unsigned long src, unsigned long dst,
+			       int len, int irq)
+{
+	pl330_DMA_control_t ctrl = *(pl330_DMA_control_t *) &hw->dcon;
+	int size = 0, loop;
+
+	ctrl.uSBSize = 0;	/* 1 byte     */
+	ctrl.uSBLength = 0;	/* 1 transfer */
+	ctrl.uDBSize = 0;	/* 1 byte     */
+	ctrl.uDBLength = 0;	/* 1 transfer */
+
+	size += config_DMA_start_address(mc + size, src);
+	size += config_DMA_destination_address(mc + size, dst);
+	size += config_DMA_control(mc + size, ctrl);
+
+	size += encodeDmaLoop(mc + size, 0, (u8)(len - 1));
+	loop = size;
+	size += encodeDmaLoad(mc + size);
+	size += encodeDmaReadMemBarrier(mc + size);
+	size += encodeDmaStore(mc + size);
+	size += encodeDmaWriteMemBarrier(mc + size);
+	size += encodeDmaLoopEnd(mc + size, 0, (u8)(size - loop));
+
+	if (irq)
+		size += register_irq_to_DMA_channel(mc + size, hw->number);
+
+	return size;
+}
+
+/* s3c_pl330_slave_config
+ *
+ * point the hardware channel at the slave's fifo for the given direction
+ */
+static int s3c_pl330_slave_config(struct s3c_pl330_chan *pc,
+				  enum dma_data_direction direction)
+{
+	struct s3c_pl330_dma_slave *slave = pc->common.private;
+	enum s3c2410_dmasrc source;
+	int ret;
+
+	switch (direction) {
+	case DMA_TO_DEVICE:
+		source = S3C2410_DMASRC_MEM;
+		break;
+	case DMA_FROM_DEVICE:
+		source = S3C2410_DMASRC_HW;
+		break;
+	default:
+		return -EINVAL;
+	}
+
+	ret = s3c2410_dma_devconfig(pc->req, source, 0, slave->fifo);
+	if (ret)
+		return ret;
+
+	return s3c2410_dma_config(pc->req, slave->width, 0);
+}
+
+/* called with pc->lock held */
+static void s3c_pl330_start_next(struct s3c_pl330_chan *pc)
+{
+	struct s3c_pl330_desc *desc;
+
+	if (!list_empty(&pc->active) || list_empty(&pc->queue))
+		return;
+
+	desc = list_first_entry(&pc->queue, struct s3c_pl330_desc, node);
+	list_move_tail(&desc->node, &pc->active);
+
+	pr_debug("%s: DMA CH %d: cookie %d\n", __FUNCTION__,
+		 pc->hw->number, desc->txd.cookie);
+
+	s3c_dma_go(pc->hw, desc->mc_phys);
+}
+
+/* s3c_pl330_last_period
+ *
+ * for a cyclic program too long for DMALPFE, find out whether the event
+ * came from its last period, after which the channel stops on DMAEND
+ */
+static int s3c_pl330_last_period(struct s3c2410_dma_chan *hw,
+				 struct s3c_pl330_desc *desc)
+{
+	unsigned long cs, cpc;
+
+	cs = dma_rdreg(hw->dma_con, S3C_DMAC_CS(hw->number)) & 0xf;
+	cpc = dma_rdreg(hw->dma_con, S3C_DMAC_CPC(hw->number));
+
+	return cs == S3C_DMAC_CS_STOPPED || cpc == desc->mc_phys + desc->mc_end;
+}
+
+/* s3c_pl330_restart
+ *
+ * called from the tasklet with pc->lock held: DMAGO a long cyclic ring
+ * again once its channel has stopped. The DMAEND normally follows the
+ * last event within a few cycles; if it does not, give up after a few
+ * tasklet runs and report the ring as failed. Returns non-zero if the
+ * tasklet has to run again.
+ */
+static int s3c_pl330_restart(struct s3c_pl330_chan *pc)
+{
+	struct s3c2410_dma_chan *hw = pc->hw;
+	struct s3c_pl330_desc *desc;
+	unsigned long cs;
+
+	if (!pc->restart || list_empty(&pc->active)) {
+		pc->restart = 0;
+		return 0;
+	}
+
+	desc = list_first_entry(&pc->active, struct s3c_pl330_desc, node);
+
+	cs = dma_rdreg(hw->dma_con, S3C_DMAC_CS(hw->number)) & 0xf;
+	if (cs == S3C_DMAC_CS_STOPPED) {
+		pc->restart = 0;
+		s3c_dma_go(hw, desc->mc_phys);
+		return 0;
+	}
+
+	if (--pc->restart)
+		return 1;
+
+	printk(KERN_ERR "dma CH %d: cyclic ring did not stop, state %lu\n",
+	       hw->number, cs);
+	pc->failed = desc->txd.cookie;
+	return 0;
+}
+
+static void s3c_pl330_engine_irq(struct s3c2410_dma_chan *hw)
+{
+	struct s3c_pl330_chan *pc = hw->engine;
+	struct s3c_pl330_desc *desc;
+
+	spin_lock(&pc->lock);
+
+	if (list_empty(&pc->active)) {
+		printk(KERN_ERR "dma CH %d: IRQ with no active descriptor\n",
+		       hw->number);
+		spin_unlock(&pc->lock);
+		return;
+	}
+
+	desc = list_first_entry(&pc->active, struct s3c_pl330_desc, node);
+
+	if (desc->cyclic) {
+		pc->periods++;
+
+		/* restarted from the tasklet, not while in the IRQ */
+		if (desc->restart && s3c_pl330_last_period(hw, desc))
+			pc->restart = S3C_PL330_RESTART_TRIES;
+	} else {
+		if (hw->stats != NULL) {
+			if (hw->stats->depth)
+				hw->stats->depth--;
+			hw->stats->done++;
+			hw->stats->bytes += desc->len;
+		}
+
+		pc->completed = desc->txd.cookie;
+		list_move_tail(&desc->node, &pc->done);
+
+		/* keep the channel busy before any callback runs */
+		s3c_pl330_start_next(pc);
+	}
+
+	spin_unlock(&pc->lock);
+
+	tasklet_schedule(&pc->tasklet);
+}
+
+static void s3c_pl330_complete(struct s3c_pl330_chan *pc,
+			       struct s3c_pl330_desc *desc, int callback)
+{
+	struct dma_async_tx_descriptor *txd = &desc->txd;
+	struct device *dev = pc->common.device->dev;
+
+	list_del(&desc->node);
+
+	/* memcpy buffers were mapped by the client on our behalf */
+	if (pc->common.private == NULL) {
+		if (!(txd->flags & DMA_COMPL_SKIP_DEST_UNMAP))
+			dma_unmap_page(dev, desc->dst, desc->len,
+				       DMA_FROM_DEVICE);
+		if (!(txd->flags & DMA_COMPL_SKIP_SRC_UNMAP))
+			dma_unmap_page(dev, desc->src, desc->len,
+				       DMA_TO_DEVICE);
+	}
+
+	if (callback && txd->callback != NULL)
+		txd->callback(txd->callback_param);
+
+	s3c_pl330_desc_put(pc, desc);
+}
+
+static void s3c_pl330_tasklet(unsigned long data)
+{
+	struct s3c_pl330_chan *pc = (struct s3c_pl330_chan *) data;
+	struct s3c_pl330_desc *desc, *_desc;
+	dma_async_tx_callback callback = NULL;
+	void *param = NULL;
+	unsigned int periods;
+	unsigned long flags;
+	int again;
+	LIST_HEAD(list);
+
+	spin_lock_irqsave(&pc->lock, flags);
+
+	again = s3c_pl330_restart(pc);
+
+	list_splice_init(&pc->done, &list);
+
+	periods = pc->periods;
+	pc->periods = 0;
+
+	if (periods && !list_empty(&pc->active)) {
+		desc = list_first_entry(&pc->active,
+					struct s3c_pl330_desc, node);
+		callback = desc->txd.callback;
+		param = desc->txd.callback_param;
+	}
+
+	spin_unlock_irqrestore(&pc->lock, flags);
+
+	if (again)
+		tasklet_schedule(&pc->tasklet);
+
+	while (callback != NULL && periods--)
+		callback(param);
+
+	list_for_each_entry_safe(desc, _desc, &list, node)
+		s3c_pl330_complete(pc, desc, 1);
+}
+
+static dma_cookie_t s3c_pl330_tx_submit(struct dma_async_tx_descriptor *tx)
+{
+	struct s3c_pl330_desc *desc = txd_to_s3c_pl330_desc(tx);
+	struct s3c_pl330_chan *pc = to_s3c_pl330_chan(tx->chan);
+	dma_cookie_t cookie;
+	unsigned long flags;
+
+	spin_lock_irqsave(&pc->lock, flags);
+
+	cookie = pc->common.cookie;
+	if (++cookie < 0)
+		cookie = 1;
+	pc->common.cookie = cookie;
+	desc->txd.cookie = cookie;
+
+	list_add_tail(&desc->node, &pc->queue);
+
+	if (pc->hw->stats != NULL && !desc->cyclic) {
+		pc->hw->stats->buffers++;
+		if (++pc->hw->stats->depth > pc->hw->stats->depth_hwm)
+			pc->hw->stats->depth_hwm = pc->hw->stats->depth;
+	}
+
+	spin_unlock_irqrestore(&pc->lock, flags);
+
+	return cookie;
+}
+
+static struct dma_async_tx_descriptor *
+s3c_pl330_prep_memcpy(struct dma_chan *chan, dma_addr_t dest, dma_addr_t src,
+		      size_t len, unsigned long flags)
+{
+	struct s3c_pl330_chan *pc = to_s3c_pl330_chan(chan);
+	struct s3c2410_dma_chan *hw = pc->hw;
+	struct s3c_pl330_desc *desc;
+	size_t body = len & ~3;
+	int size = 0;
+
+	if (unlikely(!len || chan->private != NULL))
+		return NULL;
+
+	desc = s3c_pl330_desc_get(pc);
+	if (desc == NULL)
+		return NULL;
+
+	if (s3c_pl330_desc_alloc_mc(desc,
+			DIV_ROUND_UP(body, s3c_pl330_max_chunk(hw)) + 1,
+			GFP_ATOMIC)) {
+		s3c_pl330_desc_put(pc, desc);
+		return NULL;
+	}
+
+	if (body)
+		size += s3c_pl330_emit_xfer(hw, desc->mc_cpu, src, dest,
+					    body, body == len);
+	if (body != len)
+		size += s3c_pl330_emit_tail(hw, desc->mc_cpu + size,
+					    src + body, dest + body,
+					    len - body, 1);
+
+	desc->mc_end = size;
+	config_DMA_mark_end(desc->mc_cpu + size);
+
+	desc->src = src;
+	desc->dst = dest;
+	desc->len = len;
+	desc->cyclic = 0;
+	desc->restart = 0;
+	desc->txd.flags = flags;
+	desc->txd.cookie = -EBUSY;
+
+	return &desc->txd;
+}
+
+static struct dma_async_tx_descriptor *
+s3c_pl330_prep_slave_sg(struct dma_chan *chan, struct scatterlist *sgl,
+			unsigned int sg_len, enum dma_data_direction direction,
+			unsigned long flags)
+{
+	struct s3c_pl330_chan *pc = to_s3c_pl330_chan(chan);
+	struct s3c_pl330_dma_slave *slave = chan->private;
+	struct s3c2410_dma_chan *hw = pc->hw;
+	struct s3c_pl330_desc *desc;
+	struct scatterlist *sg;
+	size_t max, len = 0;
+	int segs = 0, size = 0;
+	int i;
+
+	if (unlikely(slave == NULL || !sg_len))
+		return NULL;
+
+	if (s3c_pl330_slave_config(pc, direction))
+		return NULL;
+
+	max = s3c_pl330_max_chunk(hw);
+
+	for_each_sg(sgl, sg, sg_len, i) {
+		if (!sg_dma_len(sg) || (sg_dma_len(sg) & (slave->width - 1)))
+			return NULL;
+		segs += DIV_ROUND_UP(sg_dma_len(sg), max);
+		len += sg_dma_len(sg);
+	}
+
+	desc = s3c_pl330_desc_get(pc);
+	if (desc == NULL)
+		return NULL;
+
+	if (s3c_pl330_desc_alloc_mc(desc, segs, GFP_ATOMIC)) {
+		s3c_pl330_desc_put(pc, desc);
+		return NULL;
+	}
+
+	for_each_sg(sgl, sg, sg_len, i) {
+		dma_addr_t mem = sg_dma_address(sg);
+
+		if (direction == DMA_TO_DEVICE)
+			size += s3c_pl330_emit_xfer(hw, desc->mc_cpu + size,
+					mem, slave->fifo, sg_dma_len(sg),
+					i == sg_len - 1);
+		else
+			size += s3c_pl330_emit_xfer(hw, desc->mc_cpu + size,
+					slave->fifo, mem, sg_dma_len(sg),
+					i == sg_len - 1);
+	}
+
+	desc->mc_end = size;
+	config_DMA_mark_end(desc->mc_cpu + size);
+
+	desc->len = len;
+	desc->cyclic = 0;
+	desc->restart = 0;
+	desc->txd.flags = flags;
+	desc->txd.cookie = -EBUSY;
+
+	return &desc->txd;
+}
+
+struct dma_async_tx_descriptor *
+s3c_pl330_prep_cyclic(struct dma_chan *chan, dma_addr_t buf, size_t buf_len,
+		      size_t period_len, enum dma_data_direction direction)
+{
+	struct s3c_pl330_chan *pc = to_s3c_pl330_chan(chan);
+	struct s3c_pl330_dma_slave *slave = chan->private;
+	struct s3c2410_dma_chan *hw = pc->hw;
+	struct s3c_pl330_desc *desc;
+	unsigned int periods, i;
+	int size = 0;
+
+	if (unlikely(slave == NULL || !period_len || buf_len % period_len ||
+		     (period_len & (slave->width - 1))))
+		return NULL;
+
+	if (s3c_pl330_slave_config(pc, direction))
+		return NULL;
+
+	periods = buf_len / period_len;
+
+	desc = s3c_pl330_desc_get(pc);
+	if (desc == NULL)
+		return NULL;
+
+	if (s3c_pl330_desc_alloc_mc(desc, periods *
+			DIV_ROUND_UP(period_len, s3c_pl330_max_chunk(hw)),
+			GFP_ATOMIC)) {
+		s3c_pl330_desc_put(pc, desc);
+		return NULL;
+	}
+
+	for (i = 0; i < periods; i++) {
+		dma_addr_t mem = buf + i * period_len;
+
+		if (direction == DMA_TO_DEVICE)
+			size += s3c_pl330_emit_xfer(hw, desc->mc_cpu + size,
+					mem, slave->fifo, period_len, 1);
+		else
+			size += s3c_pl330_emit_xfer(hw, desc->mc_cpu + size,
+					slave->fifo, mem, period_len, 1);
+	}
+
+	/* short rings loop in the controller itself; longer ones end and
+	 * are restarted from the interrupt of their last period */
+	desc->mc_end = size;
+	if (size <= S3C_PL330_MAX_BWJUMP) {
+		config_DMA_set_infinite_loop(desc->mc_cpu + size, size);
+		desc->restart = 0;
+	} else {
+		config_DMA_mark_end(desc->mc_cpu + size);
+		desc->restart = 1;
+	}
+
+	desc->len = buf_len;
+	desc->cyclic = 1;
+	desc->txd.flags = DMA_CTRL_ACK;
+	desc->txd.cookie = -EBUSY;
+
+	return &desc->txd;
+}
+EXPORT_SYMBOL(s3c_pl330_prep_cyclic);
+
+static void s3c_pl330_terminate_all(struct dma_chan *chan)
+{
+	struct s3c_pl330_chan *pc = to_s3c_pl330_chan(chan);
+	struct s3c_pl330_desc *desc, *_desc;
+	unsigned long flags;
+	LIST_HEAD(list);
+
+	spin_lock_irqsave(&pc->lock, flags);
+
+	stop_DMA_channel(dma_regaddr(pc->hw->dma_con, S3C_DMAC_DBGSTATUS),
+			 pc->hw->number);
+
+	list_splice_init(&pc->active, &list);
+	list_splice_init(&pc->queue, &list);
+	pc->periods = 0;
+	pc->restart = 0;
+	pc->failed = 0;
+
+	spin_unlock_irqrestore(&pc->lock, flags);
+
+	list_for_each_entry_safe(desc, _desc, &list, node)
+		s3c_pl330_complete(pc, desc, 0);
+}
+
+static enum dma_status
+s3c_pl330_is_tx_complete(struct dma_chan *chan, dma_cookie_t cookie,
+			 dma_cookie_t *done, dma_cookie_t *used)
+{
+	struct s3c_pl330_chan *pc = to_s3c_pl330_chan(chan);
+	dma_cookie_t last_used;
+	dma_cookie_t last_complete;
+
+	last_complete = pc->completed;
+	last_used = chan->cookie;
+
+	if (done)
+		*done = last_complete;
+	if (used)
+		*used = last_used;
+
+	if (cookie == pc->failed)
+		return DMA_ERROR;
+
+	return dma_async_is_complete(cookie, last_complete, last_used);
+}
+
+static void s3c_pl330_issue_pending(struct dma_chan *chan)
+{
+	struct s3c_pl330_chan *pc = to_s3c_pl330_chan(chan);
+	unsigned long flags;
+
+	spin_lock_irqsave(&pc->lock, flags);
+	s3c_pl330_start_next(pc);
+	spin_unlock_irqrestore(&pc->lock, flags);
+}
+
+static int s3c_pl330_alloc_chan_resources(struct dma_chan *chan)
+{
+	struct s3c_pl330_chan *pc = to_s3c_pl330_chan(chan);
+	struct s3c_pl330_dma_slave *slave = chan->private;
+	struct s3c_pl330_desc *desc;
+	unsigned long flags, tmp;
+	int ret;
+
+	pc->req = slave ? slave->req : DMACH_MTOM_0 + chan->chan_id;
+
+	ret = s3c2410_dma_request(pc->req, &pc->client, NULL);
+	if (ret)
+		return ret;
+
+	pc->hw = lookup_dma_channel(pc->req);
+
+	if (slave == NULL) {
+		s3c2410_dma_devconfig(pc->req, S3C_DMA_MEM2MEM, 0, 0);
+		s3c2410_dma_config(pc->req, 4, 0);
+	}
+
+	pc->completed = chan->cookie = 1;
+
+	while (pc->descs_allocated < S3C_PL330_DESCS_PER_CHANNEL) {
+		desc = kzalloc(sizeof(struct s3c_pl330_desc), GFP_KERNEL);
+		if (desc == NULL)
+			break;
+
+		if (s3c_pl330_desc_alloc_mc(desc, S3C_PL330_MC_PREALLOC_SEGS,
+					    GFP_KERNEL)) {
+			kfree(desc);
+			break;
+		}
+
+		dma_async_tx_descriptor_init(&desc->txd, chan);
+		desc->txd.tx_submit = s3c_pl330_tx_submit;
+		desc->txd.flags = DMA_CTRL_ACK;
+		INIT_LIST_HEAD(&desc->txd.tx_list);
+
+		s3c_pl330_desc_put(pc, desc);
+		pc->descs_allocated++;
+	}
+
+	if (!pc->descs_allocated) {
+		s3c2410_dma_free(pc->req, &pc->client);
+		return -ENOMEM;
+	}
+
+	local_irq_save(flags);
+
+	pc->hw->engine = pc;
+
+	tmp = dma_rdreg(pc->hw->dma_con, S3C_DMAC_INTEN);
+	tmp |= (1 << pc->hw->number);
+	dma_wrreg(pc->hw->dma_con, S3C_DMAC_INTEN, tmp);
+
+	local_irq_restore(flags);
+
+	return pc->descs_allocated;
+}
+
+static void s3c_pl330_free_chan_resources(struct dma_chan *chan)
+{
+	struct s3c_pl330_chan *pc = to_s3c_pl330_chan(chan);
+	struct s3c_pl330_desc *desc, *_desc;
+	unsigned long flags, tmp;
+	LIST_HEAD(list);
+
+	s3c_pl330_terminate_all(chan);
+	tasklet_kill(&pc->tasklet);
+
+	local_irq_save(flags);
+
+	tmp = dma_rdreg(pc->hw->dma_con, S3C_DMAC_INTEN);
+	tmp &= ~(1 << pc->hw->number);
+	dma_wrreg(pc->hw->dma_con, S3C_DMAC_INTEN, tmp);
+
+	pc->hw->engine = NULL;
+
+	local_irq_restore(flags);
+
+	s3c2410_dma_free(pc->req, &pc->client);
+	pc->hw = NULL;
+
+	spin_lock_irqsave(&pc->lock, flags);
+	list_splice_init(&pc->free_list, &list);
+	pc->descs_allocated = 0;
+	spin_unlock_irqrestore(&pc->lock, flags);
+
+	list_for_each_entry_safe(desc, _desc, &list, node) {
+		s3c_pl330_desc_free_mc(desc);
+		kfree(desc);
+	}
+}
+
+static int __init s3c_pl330_engine_init(void)
+{
+	struct s3c_pl330_chan *pc;
+	int i, ret;
+
+	/* memcpy channels must not reach the ones drivers reserve */
+	BUILD_BUG_ON(S3C_PL330_ENGINE_CHANNELS > DMACH_MDMA_M2M_NR);
+
+	/* s3c_dma_init() has not run on this machine */
+	if (dma_kmem == NULL)
+		return -ENODEV;
+
+	ret = platform_device_register(&s3c_pl330_device);
+	if (ret)
+		return ret;
+
+	INIT_LIST_HEAD(&s3c_pl330_dma.channels);
+
+	for (i = 0; i < S3C_PL330_ENGINE_CHANNELS; i++) {
+		pc = &s3c_pl330_chans[i];
+
+		pc->common.device = &s3c_pl330_dma;
+		pc->common.cookie = pc->completed = 1;
+		list_add_tail(&pc->common.device_node,
+			      &s3c_pl330_dma.channels);
+
+		pc->client.name = "pl330-dmaengine";
+		spin_lock_init(&pc->lock);
+
+		INIT_LIST_HEAD(&pc->active);
+		INIT_LIST_HEAD(&pc->queue);
+		INIT_LIST_HEAD(&pc->done);
+		INIT_LIST_HEAD(&pc->free_list);
+
+		tasklet_init(&pc->tasklet, s3c_pl330_tasklet,
+			     (unsigned long) pc);
+	}
+
+	dma_cap_set(DMA_MEMCPY, s3c_pl330_dma.cap_mask);
+	dma_cap_set(DMA_SLAVE, s3c_pl330_dma.cap_mask);
+	dma_cap_set(DMA_PRIVATE, s3c_pl330_dma.cap_mask);
+	s3c_pl330_dma.dev = &s3c_pl330_device.dev;
+
+	s3c_pl330_dma.device_alloc_chan_resources = s3c_pl330_alloc_chan_resources;
+	s3c_pl330_dma.device_free_chan_resources = s3c_pl330_free_chan_resources;
+	s3c_pl330_dma.device_prep_dma_memcpy = s3c_pl330_prep_memcpy;
+	s3c_pl330_dma.device_prep_slave_sg = s3c_pl330_prep_slave_sg;
+	s3c_pl330_dma.device_terminate_all = s3c_pl330_terminate_all;
+	s3c_pl330_dma.device_is_tx_complete = s3c_pl330_is_tx_complete;
+	s3c_pl330_dma.device_issue_pending = s3c_pl330_issue_pending;
+
+	ret = dma_async_device_register(&s3c_pl330_dma);
+	if (ret) {
+		platform_device_unregister(&s3c_pl330_device);
+		return ret;
+	}
+
+	printk(KERN_INFO "S3C PL330-DMA: dmaengine interface, %d channels\n",
+	       s3c_pl330_dma.chancnt);
+
+	return 0;
+}
+device_initcall(s3c_pl330_engine_init);
+
+#endif /* CONFIG_S3C_PL330_DMAENGINE */
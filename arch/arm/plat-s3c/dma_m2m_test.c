@@ -25,6 +25,9 @@
 #include <linux/moduleparam.h>
 #include <linux/wait.h>
 #include <linux/dma-mapping.h>
+#include <linux/sched.h>
+
+#include <asm/div64.h>
 
 #include <mach/s3c-dma.h>
 
@@ -51,6 +54,10 @@ static unsigned int channels = 10000; /* Use all channels by default */
 module_param(channels, uint, S_IRUGO);
 MODULE_PARM_DESC(channels, "Number of channels to test (default: 8)");
 
+static unsigned short chain = 1;
+module_param(chain, ushort, S_IRUGO);
+MODULE_PARM_DESC(chain, "Buffers queued per round, >1 runs them as one chained program");
+
 struct s3cdma_thread {
 	unsigned id; /* For Channel index */
 	struct task_struct *task;
@@ -63,6 +70,12 @@ struct s3cdma_thread {
 	enum s3c2410_dma_buffresult res;
 	int size;
 	unsigned done;
+	unsigned pending; /* Buffers of this round not yet completed */
+	unsigned long long start_ns; /* When the round was started */
+	unsigned long long last_ns; /* When the previous buffer completed */
+	unsigned long long lat_sum, lat_max; /* Start to first completion */
+	unsigned long long gap_sum, gap_min, gap_max; /* Between completions */
+	unsigned rounds, gaps;
 	struct s3c2410_dma_client cl;
 	struct completion xfer_cmplt;
 	struct list_head node;
@@ -72,6 +85,31 @@ static unsigned int delta;
 static unsigned long cycles, maxtime;
 static LIST_HEAD(channel_list);
 
+/* Account one buffer completion, the first of a round against the
+ * start of the round and the others against the previous completion */
+static void s3cdma_account(struct s3cdma_thread *thread, unsigned long long now)
+{
+	unsigned long long delta_ns;
+
+	if (thread->last_ns == 0) {
+		delta_ns = now - thread->start_ns;
+		thread->lat_sum += delta_ns;
+		if (delta_ns > thread->lat_max)
+			thread->lat_max = delta_ns;
+		thread->rounds++;
+	} else {
+		delta_ns = now - thread->last_ns;
+		thread->gap_sum += delta_ns;
+		if (delta_ns > thread->gap_max)
+			thread->gap_max = delta_ns;
+		if (!thread->gaps || delta_ns < thread->gap_min)
+			thread->gap_min = delta_ns;
+		thread->gaps++;
+	}
+
+	thread->last_ns = now;
+}
+
 void s3cdma_cb(struct s3c2410_dma_chan *chan, void *buf_id,
 			int size, enum s3c2410_dma_buffresult res)
 {
@@ -80,7 +118,11 @@ void s3cdma_cb(struct s3c2410_dma_chan *chan, void *buf_id,
 	thread->res = res;
 	thread->size = size;
 
-	complete(&thread->xfer_cmplt);
+	if (res == S3C2410_RES_OK)
+		s3cdma_account(thread, sched_clock());
+
+	if (--thread->pending == 0)
+		complete(&thread->xfer_cmplt);
 }
 
 static void dmatest_init_buf(u32 buf[], int clr, unsigned int bytes)
@@ -112,7 +154,7 @@ static int dmatest_func(void *data)
 	enum dma_ch chan = DMACH_MTOM_0 + thread->id;
 	unsigned long tout = jiffies + msecs_to_jiffies(sec * 1000);
 	int src_idx = 0;
-	unsigned val;
+	unsigned val, i;
 
 	thread->jiffies = jiffies;
 	thread->done = 0;
@@ -131,9 +173,14 @@ static int dmatest_func(void *data)
 		s3c2410_dma_devconfig(chan, S3C_DMA_MEM2MEM,
 					0, thread->buff_phys[src_idx]);
 
-		s3c2410_dma_enqueue(chan, (void *)thread,
+		thread->pending = chain;
+		thread->last_ns = 0;
+
+		for (i = 0; i < chain; i++)
+			s3c2410_dma_enqueue(chan, (void *)thread,
 				thread->buff_phys[1 - src_idx], xfer_size - delta);
 
+		thread->start_ns = sched_clock();
 		s3c2410_dma_ctrl(chan, S3C2410_DMAOP_START);
 
 		val = wait_for_completion_timeout(&thread->xfer_cmplt, msecs_to_jiffies(5*1000));
@@ -153,7 +200,7 @@ static int dmatest_func(void *data)
 			printk(KERN_INFO "S3C DMA M2M Test: Thrd-%u: Cycle-%u Res-%u Xfer_size-%d!\n",
 			thread->id, thread->done, thread->res, thread->size);
 		} else {
-			thread->done++;
+			thread->done += chain;
 		}
 
 		if (!perf_test &&
@@ -180,6 +227,13 @@ static int __init dmatest_init(void)
 
 	xfer_size *= XFER_UNIT;
 
+	if (chain < 1)
+		chain = 1;
+
+	/* stay on the MDMA channels, the ones past them belong to drivers */
+	if (channels > DMACH_MDMA_M2M_NR)
+		channels = DMACH_MDMA_M2M_NR;
+
 	if (sec < 5) {
 		sec = 5;
 		printk(KERN_INFO "S3C DMA M2M Test: Using 5secs test time\n");
@@ -235,6 +289,15 @@ static int __init dmatest_init(void)
 
 		s3c2410_dma_set_buffdone_fn(DMACH_MTOM_0 + thread->id, s3cdma_cb);
 
+		if (chain > 1) {
+			ret = s3c2410_dma_setflags(DMACH_MTOM_0 + thread->id,
+						S3C2410_DMAF_CHAIN);
+			if (ret) {
+				printk(KERN_INFO "S3C DMA M2M Test: Thrd-%d chain(%d)\n", i, ret);
+				goto thrd_dma_cfg_err;
+			}
+		}
+
 		ret = s3c2410_dma_config(DMACH_MTOM_0 + thread->id, burst, 0);
 		if (ret) {
 			printk(KERN_INFO "S3C DMA M2M Test: Thrd-%d config(%d)\n", i, ret);
@@ -267,7 +330,8 @@ thrd_alloc_err:
 		break;
 	}
 
-	printk(KERN_INFO "S3C DMA M2M Test: Testing with %u Channels\n", i);
+	printk(KERN_INFO "S3C DMA M2M Test: Testing with %u Channels, %u buffers per round\n",
+			i, chain);
 
 	return 0;
 }
@@ -299,6 +363,27 @@ static void __exit dmatest_exit(void)
 			thread->id, thread->done, xfer_size / XFER_UNIT,
 			jiffies_to_msecs(thread->jiffies));
 
+		if (thread->rounds) {
+			unsigned long long avg = thread->lat_sum;
+
+			do_div(avg, thread->rounds);
+			do_div(thread->lat_max, 1000);
+			do_div(avg, 1000);
+			printk(KERN_INFO "S3C DMA M2M Test: Thrd-%u first buffer latency avg %lluus max %lluus\n",
+				thread->id, avg, thread->lat_max);
+		}
+
+		if (thread->gaps) {
+			unsigned long long avg = thread->gap_sum;
+
+			do_div(avg, thread->gaps);
+			do_div(avg, 1000);
+			do_div(thread->gap_min, 1000);
+			do_div(thread->gap_max, 1000);
+			printk(KERN_INFO "S3C DMA M2M Test: Thrd-%u buffer to buffer min %lluus avg %lluus max %lluus\n",
+				thread->id, thread->gap_min, avg, thread->gap_max);
+		}
+
 		s3c2410_dma_free(DMACH_MTOM_0 + thread->id, &thread->cl);
 
 		dma_free_coherent(NULL, xfer_size,
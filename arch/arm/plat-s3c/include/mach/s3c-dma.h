@@ -22,6 +22,7 @@
 
 #define S3C2410_DMAF_AUTOSTART	(1 << 0)
 #define S3C2410_DMAF_CIRCULAR	(1 << 1)
+#define S3C2410_DMAF_CHAIN	(1 << 2)	/* run queued buffers as one program */
 
 /* We use `virtual` dma channels to hide the fact we have only a limited
  * number of DMA channels, and not of all of them (dependant on the device)
@@ -128,6 +129,14 @@ enum dma_ch {
 #define DMACH_3D_M2M6	DMACH_MTOM_6
 #define DMACH_3D_M2M7	DMACH_MTOM_7
 
+/*
+ * The first eight M->M channels are the MDMA controller, which the
+ * dmaengine memcpy channels and the m2m test hand out by number. The
+ * NAND controller owns one on a peripheral controller, past that range.
+ */
+#define DMACH_MDMA_M2M_NR	8
+#define DMACH_NAND_M2M		DMACH_MTOM_8
+
 /* types */
 
 enum s3c_dma_state {
@@ -226,6 +235,8 @@ struct s3c_dma_buf {
 	void			*id;		/* client's id */
 	dma_addr_t		mcptr;		/* physical pointer to a set of micro codes */
 	unsigned long 		*mcptr_cpu;	/* virtual pointer to a set of micro codes */
+	int			 merged;	/* buffers merged into this program */
+	int			 merged_size;	/* bytes of the merged buffers */
 };
 
 /* [1] is this updated for both recv/send modes? */
@@ -244,12 +255,24 @@ typedef void (*s3c2410_dma_cbfn_t)(struct s3c2410_dma_chan *,
 typedef int  (*s3c2410_dma_opfn_t)(struct s3c2410_dma_chan *,
 				   enum s3c_chan_op );
 
+/* irq to callback latency buckets: <1us, <2us, <4us ... and the rest */
+#define S3C_DMA_LAT_BUCKETS	12
+
 struct s3c_dma_stats {
 	unsigned long		loads;
 	unsigned long		timeout_longest;
 	unsigned long		timeout_shortest;
 	unsigned long		timeout_avg;
 	unsigned long		timeout_failed;
+
+	unsigned long long	bytes;		/* bytes moved */
+	unsigned long		buffers;	/* buffers queued */
+	unsigned long		done;		/* buffers completed */
+	unsigned long		aborted;	/* buffers flushed */
+	unsigned long		depth;		/* buffers on the queue now */
+	unsigned long		depth_hwm;	/* queue depth high-water mark */
+	unsigned long		stalls;		/* channel ran out of buffers */
+	unsigned long		latency[S3C_DMA_LAT_BUCKETS];
 };
 
 struct s3c2410_dma_map;
@@ -336,6 +359,17 @@ struct s3c2410_dma_chan {
 	unsigned int            config_flags;        /* channel flags */
 	unsigned int            control_flags;        /* channel flags */
 	s3c_dma_controller_t	*dma_con;
+
+	unsigned long long	 irq_ns;	/* entry of the irq being handled */
+
+	/* chained mode (S3C2410_DMAF_CHAIN) */
+	u8			*chain_mc_cpu;	/* program for the loaded buffers */
+	dma_addr_t		 chain_mc;
+	unsigned int		 chain_loaded;	/* buffers in the running program */
+
+#ifdef CONFIG_S3C_PL330_DMAENGINE
+	void			*engine;	/* owning dmaengine channel */
+#endif
 };
 
 /* the currently allocated channel information */
@@ -0,0 +1,45 @@
+/* linux/arch/arm/plat-s3c/include/plat/dma-pl330-engine.h
+ *
+ * Copyright (c) 2010 Samsung Electronics Co., Ltd.
+ * 		http://www.samsung.com
+ *
+ * dmaengine interface for the S3C PL330 DMA controllers
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ */
+
+#ifndef __PLAT_DMA_PL330_ENGINE_H
+#define __PLAT_DMA_PL330_ENGINE_H __FILE__
+
+#include <linux/dmaengine.h>
+#include <linux/dma-mapping.h>
+#include <mach/dma.h>
+
+/* struct s3c_pl330_dma_slave
+ *
+ * passed in dma_chan->private by the filter function of a slave client.
+ *
+ * req		the virtual channel (DMACH_xxx) of the peripheral request line
+ * fifo		physical address of the peripheral data register
+ * width	peripheral register width in bytes (1, 2, 4 or 8)
+ */
+struct s3c_pl330_dma_slave {
+	enum dma_ch		req;
+	dma_addr_t		fifo;
+	int			width;
+};
+
+/* s3c_pl330_prep_cyclic
+ *
+ * prepare a ring of buf_len bytes, split into periods of period_len bytes,
+ * which the controller walks forever. The descriptor callback is called
+ * once per completed period, until the channel is terminated with
+ * device_terminate_all().
+ */
+extern struct dma_async_tx_descriptor *
+s3c_pl330_prep_cyclic(struct dma_chan *chan, dma_addr_t buf, size_t buf_len,
+		      size_t period_len, enum dma_data_direction direction);
+
+#endif /* __PLAT_DMA_PL330_ENGINE_H */
@@ -0,0 +1,29 @@
+/* linux/arch/arm/plat-s3c/include/plat/dma-trace.h
+ *
+ * Copyright (c) 2010 Samsung Electronics Co., Ltd.
+ * 		http://www.samsung.com
+ *
+ * S3C DMA tracepoints
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ */
+
+#ifndef __PLAT_DMA_TRACE_H
+#define __PLAT_DMA_TRACE_H __FILE__
+
+#include <linux/tracepoint.h>
+#include <mach/dma.h>
+
+DECLARE_TRACE(s3c_dma_enqueue,
+	TPPROTO(struct s3c2410_dma_chan *chan, void *id,
+		dma_addr_t data, int size),
+		TPARGS(chan, id, data, size));
+
+DECLARE_TRACE(s3c_dma_buffdone,
+	TPPROTO(struct s3c2410_dma_chan *chan, void *id, int size,
+		enum s3c2410_dma_buffresult result),
+		TPARGS(chan, id, size, result));
+
+#endif /* __PLAT_DMA_TRACE_H */
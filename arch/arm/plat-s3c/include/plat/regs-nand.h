@@ -163,6 +163,8 @@
 #define S3C_NFCONT_ECC_ENC	(1<<18)
 #define S3C_NFCONT_LOCKTGHT	(1<<17)
 #define S3C_NFCONT_LOCKSOFT	(1<<16)
+#define S3C_NFCONT_ENCINT	(1<<13)
+#define S3C_NFCONT_DECINT	(1<<12)
 #define S3C_NFCONT_MECCLOCK	(1<<7)
 #define S3C_NFCONT_SECCLOCK	(1<<6)
 #define S3C_NFCONT_INITMECC	(1<<5)
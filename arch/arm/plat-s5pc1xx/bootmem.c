@@ -14,8 +14,17 @@
 #include <linux/mm.h>
 #include <linux/bootmem.h>
 #include <linux/swap.h>
+#include <linux/init.h>
+#include <linux/module.h>
+#include <linux/mutex.h>
+#include <linux/list.h>
+#include <linux/slab.h>
+#include <linux/kobject.h>
+#include <linux/sysfs.h>
+#include <linux/page-isolation.h>
 #include <asm/setup.h>
 #include <asm/io.h>
+#include <asm/cacheflush.h>
 #include <mach/memory.h>
 
 #include <plat/media.h>
@@ -119,9 +128,236 @@ static struct s3c_media_device *s3c_get_media_device(int dev_id)
 	return mdev;
 }
 
+/*
+ * All media devices share one region reserved at boot. Devices claim
+ * pieces of it with s3c_media_alloc() within their quota (the configured
+ * memory size). With CONFIG_S5PC1XX_MEDIA_SHARED the unclaimed pages are
+ * lent to the page allocator as MIGRATE_CONTIG pageblocks, which only
+ * movable pages may use, and alloc_contig_range() migrates them away
+ * again when a device claims the memory.
+ */
+struct s3c_media_chunk {
+	struct list_head	list;
+	int			dev_id;
+	unsigned long		pfn;
+	unsigned long		nr_pages;
+};
+
+static struct s3c_media_region {
+	unsigned long		base_pfn;
+	unsigned long		nr_pages;
+	unsigned long		*bitmap;	/* pages claimed by devices */
+	int			lent;		/* free pages are in the buddy */
+	struct list_head	chunks;
+	struct mutex		lock;
+} s3c_media_region = {
+	.chunks	= LIST_HEAD_INIT(s3c_media_region.chunks),
+	.lock	= __MUTEX_INITIALIZER(s3c_media_region.lock),
+};
+
+static void s3c_media_mark(unsigned long pos, unsigned long nr, int claim)
+{
+	while (nr--) {
+		if (claim)
+			__set_bit(pos++, s3c_media_region.bitmap);
+		else
+			__clear_bit(pos++, s3c_media_region.bitmap);
+	}
+}
+
+/* best fit among the holes starting at or after from */
+static long s3c_media_find(unsigned long nr, unsigned long from)
+{
+	struct s3c_media_region *r = &s3c_media_region;
+	unsigned long start, end, len, best_len = ~0UL;
+	long best = -1;
+
+	start = find_next_zero_bit(r->bitmap, r->nr_pages, from);
+	while (start < r->nr_pages) {
+		end = find_next_bit(r->bitmap, r->nr_pages, start);
+		len = end - start;
+
+		if (len >= nr && len < best_len) {
+			best = start;
+			best_len = len;
+			if (len == nr)
+				break;
+		}
+
+		start = find_next_zero_bit(r->bitmap, r->nr_pages, end);
+	}
+
+	return best;
+}
+
+/* called with the region lock held */
+static dma_addr_t __s3c_media_alloc(struct s3c_media_device *mdev,
+				    size_t size)
+{
+	struct s3c_media_region *r = &s3c_media_region;
+	struct s3c_media_chunk *chunk;
+	unsigned long nr = PAGE_ALIGN(size) >> PAGE_SHIFT;
+	unsigned long from = 0, pfn = 0;
+	dma_addr_t paddr = 0;
+	void *vaddr;
+	long pos;
+
+	if (!nr)
+		return 0;
+
+	chunk = kmalloc(sizeof(*chunk), GFP_KERNEL);
+	if (!chunk)
+		return 0;
+
+	if (mdev->used + (nr << PAGE_SHIFT) > mdev->memsize) {
+		printk(KERN_ERR "%s: %lu bytes over media quota\n",
+			mdev->name, (unsigned long) mdev->used + (nr << PAGE_SHIFT)
+			- mdev->memsize);
+		goto out;
+	}
+
+	while ((pos = s3c_media_find(nr, from)) >= 0) {
+		pfn = r->base_pfn + pos;
+		s3c_media_mark(pos, nr, 1);
+
+		if (!r->lent || !alloc_contig_range(pfn, pfn + nr)) {
+			paddr = __pfn_to_phys(pfn);
+			break;
+		}
+
+		/* some borrowed page is pinned, try another hole */
+		s3c_media_mark(pos, nr, 0);
+		from = pos + nr;
+	}
+
+	if (!paddr) {
+		printk(KERN_ERR "no memory for %s\n", mdev->name);
+		goto out;
+	}
+
+	/* the pages may have dirty lines from their time as normal memory */
+	if (r->lent) {
+		vaddr = phys_to_virt(paddr);
+		dmac_flush_range(vaddr, vaddr + (nr << PAGE_SHIFT));
+		outer_flush_range(paddr, paddr + (nr << PAGE_SHIFT));
+	}
+
+	chunk->dev_id = mdev->id;
+	chunk->pfn = pfn;
+	chunk->nr_pages = nr;
+	list_add_tail(&chunk->list, &r->chunks);
+
+	mdev->used += nr << PAGE_SHIFT;
+	chunk = NULL;
+
+out:
+	kfree(chunk);
+
+	return paddr;
+}
+
+dma_addr_t s3c_media_alloc(int dev_id, size_t size)
+{
+	struct s3c_media_region *r = &s3c_media_region;
+	struct s3c_media_device *mdev;
+	dma_addr_t paddr;
+
+	mdev = s3c_get_media_device(dev_id);
+	if (!mdev || !size) {
+		printk(KERN_ERR "invalid media device\n");
+		return 0;
+	}
+
+	mutex_lock(&r->lock);
+	paddr = __s3c_media_alloc(mdev, size);
+	mutex_unlock(&r->lock);
+
+	return paddr;
+}
+EXPORT_SYMBOL(s3c_media_alloc);
+
+void s3c_media_free(int dev_id, dma_addr_t paddr)
+{
+	struct s3c_media_region *r = &s3c_media_region;
+	struct s3c_media_device *mdev;
+	struct s3c_media_chunk *chunk;
+	unsigned long pfn = __phys_to_pfn(paddr);
+
+	mdev = s3c_get_media_device(dev_id);
+	if (!mdev) {
+		printk(KERN_ERR "invalid media device\n");
+		return;
+	}
+
+	mutex_lock(&r->lock);
+
+	list_for_each_entry(chunk, &r->chunks, list) {
+		if (chunk->dev_id == dev_id && chunk->pfn == pfn)
+			goto found;
+	}
+
+	mutex_unlock(&r->lock);
+	printk(KERN_ERR "%s: freeing unknown media memory 0x%08x\n",
+		mdev->name, paddr);
+	return;
+
+found:
+	list_del(&chunk->list);
+	s3c_media_mark(pfn - r->base_pfn, chunk->nr_pages, 0);
+
+	if (r->lent)
+		free_contig_range(pfn, chunk->nr_pages);
+
+	mdev->used -= chunk->nr_pages << PAGE_SHIFT;
+
+	mutex_unlock(&r->lock);
+
+	kfree(chunk);
+}
+EXPORT_SYMBOL(s3c_media_free);
+
+/*
+ * Whether [paddr, paddr + size) lies in one piece of media memory that
+ * dev_id holds, for drivers given physical addresses by userspace. The
+ * answer is only good for as long as the device keeps the piece.
+ */
+int s3c_media_claimed(int dev_id, dma_addr_t paddr, size_t size)
+{
+	struct s3c_media_region *r = &s3c_media_region;
+	struct s3c_media_chunk *chunk;
+	dma_addr_t start;
+	size_t len;
+	int ret = 0;
+
+	if (!size)
+		return 0;
+
+	mutex_lock(&r->lock);
+
+	list_for_each_entry(chunk, &r->chunks, list) {
+		if (chunk->dev_id != dev_id)
+			continue;
+
+		start = __pfn_to_phys(chunk->pfn);
+		len = chunk->nr_pages << PAGE_SHIFT;
+		if (paddr >= start && size <= len &&
+		    paddr - start <= len - size) {
+			ret = 1;
+			break;
+		}
+	}
+
+	mutex_unlock(&r->lock);
+
+	return ret;
+}
+EXPORT_SYMBOL(s3c_media_claimed);
+
 dma_addr_t s3c_get_media_memory(int dev_id)
 {
+	struct s3c_media_region *r = &s3c_media_region;
 	struct s3c_media_device *mdev;
+	dma_addr_t paddr;
 
 	mdev = s3c_get_media_device(dev_id);
 	if (!mdev){
@@ -129,12 +365,19 @@ dma_addr_t s3c_get_media_memory(int dev_id)
 		return 0;
 	}
 
-	if (!mdev->paddr) {
+	/* drivers using this get their whole quota, for good */
+	mutex_lock(&r->lock);
+	if (!mdev->paddr && mdev->memsize)
+		mdev->paddr = __s3c_media_alloc(mdev, mdev->memsize);
+	paddr = mdev->paddr;
+	mutex_unlock(&r->lock);
+
+	if (!paddr) {
 		printk(KERN_ERR "no memory for %s\n", mdev->name);
 		return 0;
 	}
 
-	return mdev->paddr;
+	return paddr;
 }
 EXPORT_SYMBOL(s3c_get_media_memory);
 
@@ -166,22 +409,182 @@ EXPORT_SYMBOL(s3c_get_media_memsize_node);
 
 void s5pc1xx_reserve_bootmem(void)
 {
-	struct s3c_media_device *mdev;
+	struct s3c_media_region *r = &s3c_media_region;
+	unsigned long nr = 0, align = PAGE_SIZE;
 	int i;
 
-	for(i = 0; i < sizeof(s3c_mdevs) / sizeof(s3c_mdevs[0]); i++) {
+	for (i = 0; i < ARRAY_SIZE(s3c_mdevs); i++)
+		nr += PAGE_ALIGN(s3c_mdevs[i].memsize) >> PAGE_SHIFT;
+
+	if (!nr)
+		return;
+
+#ifdef CONFIG_S5PC1XX_MEDIA_SHARED
+	/* the region is lent in whole pageblocks */
+	nr = ALIGN(nr, pageblock_nr_pages);
+	align = pageblock_nr_pages << PAGE_SHIFT;
+#endif
+
+	r->base_pfn = __phys_to_pfn(virt_to_phys(__alloc_bootmem(
+				nr << PAGE_SHIFT, align,
+				__pa(MAX_DMA_ADDRESS))));
+	r->nr_pages = nr;
+	r->bitmap = alloc_bootmem(BITS_TO_LONGS(nr) * sizeof(long));
+
+	printk(KERN_INFO "s5pc1xx: %lu bytes system memory reserved "
+		"for media devices at 0x%08lx\n", nr << PAGE_SHIFT,
+		__pfn_to_phys(r->base_pfn));
+}
+
+#ifdef CONFIG_S5PC1XX_MEDIA_SHARED
+/* give what the drivers have not claimed while probing to the buddy */
+static int __init s3c_media_lend(void)
+{
+	struct s3c_media_region *r = &s3c_media_region;
+	unsigned long start, end, lent = 0;
+
+	if (!r->nr_pages || page_group_by_mobility_disabled)
+		return 0;
+
+	mutex_lock(&r->lock);
+
+	init_contig_range(r->base_pfn, r->nr_pages);
+
+	start = find_first_zero_bit(r->bitmap, r->nr_pages);
+	while (start < r->nr_pages) {
+		end = find_next_bit(r->bitmap, r->nr_pages, start);
+		free_contig_range(r->base_pfn + start, end - start);
+		lent += end - start;
+		start = find_next_zero_bit(r->bitmap, r->nr_pages, end);
+	}
+
+	r->lent = 1;
+
+	mutex_unlock(&r->lock);
+
+	printk(KERN_INFO "s5pc1xx: %lu KB of media memory lent to the "
+		"page allocator\n", lent << (PAGE_SHIFT - 10));
+
+	return 0;
+}
+late_initcall(s3c_media_lend);
+#endif
+
+/* /sys/kernel/s3c-media */
+
+static ssize_t s3c_media_devices_show(struct kobject *kobj,
+				      struct kobj_attribute *attr, char *buf)
+{
+	struct s3c_media_region *r = &s3c_media_region;
+	struct s3c_media_chunk *chunk;
+	struct s3c_media_device *mdev;
+	ssize_t len = 0;
+	int i, count;
+
+	mutex_lock(&r->lock);
+
+	len += sprintf(buf + len, "%-8s %10s %10s %6s\n",
+			"device", "quota(KB)", "used(KB)", "chunks");
+
+	for (i = 0; i < ARRAY_SIZE(s3c_mdevs); i++) {
 		mdev = &s3c_mdevs[i];
-		if (mdev->memsize > 0) {
-			mdev->paddr = virt_to_phys( \
-				alloc_bootmem_pages(mdev->memsize));
-			printk(KERN_INFO \
-				"s5pc1xx: %lu bytes system memory reserved "
-				"for %s at 0x%08x\n",
-				(unsigned long) mdev->memsize, \
-				mdev->name, mdev->paddr);
+
+		count = 0;
+		list_for_each_entry(chunk, &r->chunks, list)
+			if (chunk->dev_id == mdev->id)
+				count++;
+
+		len += sprintf(buf + len, "%-8s %10lu %10lu %6d\n",
+				mdev->name,
+				(unsigned long) mdev->memsize >> 10,
+				(unsigned long) mdev->used >> 10, count);
+	}
+
+	mutex_unlock(&r->lock);
+
+	return len;
+}
+
+static ssize_t s3c_media_region_show(struct kobject *kobj,
+				     struct kobj_attribute *attr, char *buf)
+{
+	struct s3c_media_region *r = &s3c_media_region;
+	unsigned long start, end, free = 0, largest = 0, holes = 0;
+	unsigned long pfn, borrowed = 0;
+	struct page *page;
+
+	mutex_lock(&r->lock);
+
+	start = find_first_zero_bit(r->bitmap, r->nr_pages);
+	while (start < r->nr_pages) {
+		end = find_next_bit(r->bitmap, r->nr_pages, start);
+
+		free += end - start;
+		largest = max(largest, end - start);
+		holes++;
+
+		/* pages the system is using right now */
+		for (pfn = start; r->lent && pfn < end; pfn++) {
+			page = pfn_to_page(r->base_pfn + pfn);
+			if (page_count(page))
+				borrowed++;
 		}
+
+		start = find_next_zero_bit(r->bitmap, r->nr_pages, end);
 	}
+
+	mutex_unlock(&r->lock);
+
+	return sprintf(buf,
+		"base:          0x%08lx\n"
+		"size:          %lu KB\n"
+		"claimed:       %lu KB\n"
+		"free:          %lu KB\n"
+		"largest free:  %lu KB\n"
+		"free holes:    %lu\n"
+		"fragmentation: %lu%%\n"
+		"lent:          %s\n"
+		"borrowed:      %lu KB\n",
+		__pfn_to_phys(r->base_pfn),
+		r->nr_pages << (PAGE_SHIFT - 10),
+		(r->nr_pages - free) << (PAGE_SHIFT - 10),
+		free << (PAGE_SHIFT - 10),
+		largest << (PAGE_SHIFT - 10),
+		holes,
+		free ? 100 - largest * 100 / free : 0,
+		r->lent ? "yes" : "no",
+		borrowed << (PAGE_SHIFT - 10));
+}
+
+static struct kobj_attribute s3c_media_devices_attr =
+	__ATTR(devices, 0444, s3c_media_devices_show, NULL);
+static struct kobj_attribute s3c_media_region_attr =
+	__ATTR(region, 0444, s3c_media_region_show, NULL);
+
+static struct attribute *s3c_media_attrs[] = {
+	&s3c_media_devices_attr.attr,
+	&s3c_media_region_attr.attr,
+	NULL,
+};
+
+static struct attribute_group s3c_media_attr_group = {
+	.attrs = s3c_media_attrs,
+};
+
+static int __init s3c_media_sysfs_init(void)
+{
+	struct kobject *kobj;
+
+	if (!s3c_media_region.nr_pages)
+		return 0;
+
+	kobj = kobject_create_and_add("s3c-media", kernel_kobj);
+	if (!kobj)
+		return -ENOMEM;
+
+	return sysfs_create_group(kobj, &s3c_media_attr_group);
 }
+late_initcall(s3c_media_sysfs_init);
 
 /* FIXME: temporary implementation to avoid compile error */
 int dma_needs_bounce(struct device *dev, dma_addr_t addr, size_t size)
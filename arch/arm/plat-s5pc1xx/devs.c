@@ -193,6 +193,11 @@ static struct resource s3c_nand_resource[] = {
                 .start = S5PC1XX_PA_NAND,
                 .end   = S5PC1XX_PA_NAND + S5PC1XX_SZ_NAND - 1,
                 .flags = IORESOURCE_MEM,
+        },
+        [1] = {
+                .start = IRQ_NFC,
+                .end   = IRQ_NFC,
+                .flags = IORESOURCE_IRQ,
         }
 };
 
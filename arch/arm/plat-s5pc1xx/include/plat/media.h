@@ -31,10 +31,21 @@
 struct s3c_media_device {
 	int		id;
 	const char 	*name;
-	size_t		memsize;
-	dma_addr_t	paddr;
+	size_t		memsize;	/* quota in the media region */
+	dma_addr_t	paddr;		/* whole quota, see s3c_get_media_memory */
+	size_t		used;
 };
 
+/*
+ * s3c_media_alloc() and s3c_media_free() hand out and take back
+ * contiguous memory of the media region, within the quota of the device.
+ * s3c_get_media_memory() claims the whole quota once and keeps it.
+ * s3c_media_claimed() tells whether a range is memory the device holds.
+ */
+extern dma_addr_t s3c_media_alloc(int dev_id, size_t size);
+extern void s3c_media_free(int dev_id, dma_addr_t paddr);
+extern int s3c_media_claimed(int dev_id, dma_addr_t paddr, size_t size);
+
 extern dma_addr_t s3c_get_media_memory(int dev_id);
 extern dma_addr_t s3c_get_media_memory_node(int dev_id, int node);
 extern size_t s3c_get_media_memsize(int dev_id);
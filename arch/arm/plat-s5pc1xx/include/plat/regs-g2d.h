@@ -107,6 +107,8 @@
 
 #define G2D_ALPHA(x)					((x)&0xFF)
 
+#define G2D_CONTROL_REG_R				(1<<0)	/* software reset */
+
 /* inter mode select */
 #define	G2D_INTC_PEND_REG_CLRSEL_LEVEL			(1<<31)
 #define	G2D_INTC_PEND_REG_CLRSEL_PULSE			(0<<31)
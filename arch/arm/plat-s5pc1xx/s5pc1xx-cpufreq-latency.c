@@ -0,0 +1,297 @@
+/*
+ *  linux/arch/arm/plat-s5pc1xx/s5pc1xx-cpufreq-latency.c
+ *
+ *  Latency driven cpufreq governor for S5PC1XX
+ *
+ *  Copyright (C) 2009 Samsung Electronics
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ */
+
+/*
+ * ondemand only reacts after a sampling period sized from the transition
+ * latency, and a burst of requests pays that delay every time. This
+ * governor follows two signals instead:
+ *
+ * - the PM_QOS_CPU_DMA_LATENCY requirement. While a driver asks for a
+ *   response time shorter than one sample plus one transition, the CPU
+ *   is held at the maximum level. The pm_qos notifier applies this at
+ *   once rather than at the next sample.
+ *
+ * - the run-queue depth, sampled every sampling_ms. Each task waiting
+ *   for the CPU steps the level up, up_depth of them jump straight to
+ *   the maximum, and down_samples empty samples in a row step it down.
+ *
+ * The transition cost comes from cpuinfo.transition_latency, which the
+ * S5PC100 driver keeps at the worst case it has measured.
+ */
+
+#include <linux/kernel.h>
+#include <linux/module.h>
+#include <linux/init.h>
+#include <linux/sched.h>
+#include <linux/cpufreq.h>
+#include <linux/workqueue.h>
+#include <linux/pm_qos_params.h>
+
+#define LATENCY_SAMPLING_MS	10
+#define LATENCY_UP_DEPTH	2
+#define LATENCY_DOWN_SAMPLES	5
+
+struct latency_gov {
+	struct cpufreq_policy	*policy;
+	struct delayed_work	work;
+	struct work_struct	qos_work;
+	unsigned int		idle_samples;
+	unsigned int		enable:1;
+};
+
+static struct latency_gov gov;
+
+static struct latency_tuners {
+	unsigned int		sampling_ms;
+	unsigned int		up_depth;
+	unsigned int		down_samples;
+} tuners = {
+	.sampling_ms		= LATENCY_SAMPLING_MS,
+	.up_depth		= LATENCY_UP_DEPTH,
+	.down_samples		= LATENCY_DOWN_SAMPLES,
+};
+
+static struct workqueue_struct *latency_wq;
+
+/*
+ * true while a CPU-DMA latency requirement is tighter than the time it
+ * takes to notice load and ramp up.
+ */
+static int latency_gov_qos_bound(struct cpufreq_policy *policy)
+{
+	s32 qos = pm_qos_requirement(PM_QOS_CPU_DMA_LATENCY);
+	unsigned int reaction_us;
+
+	reaction_us = tuners.sampling_ms * USEC_PER_MSEC +
+		      policy->cpuinfo.transition_latency / NSEC_PER_USEC;
+
+	return qos >= 0 && qos < reaction_us;
+}
+
+static void latency_gov_set(struct cpufreq_policy *policy,
+			    unsigned int target, unsigned int relation)
+{
+	if (target > policy->max)
+		target = policy->max;
+	if (target < policy->min)
+		target = policy->min;
+
+	if (target != policy->cur)
+		__cpufreq_driver_target(policy, target, relation);
+}
+
+/* called with the policy rwsem held for writing */
+static void latency_gov_sample(struct latency_gov *g)
+{
+	struct cpufreq_policy *policy = g->policy;
+	unsigned long depth = nr_running();
+	int bound = latency_gov_qos_bound(policy);
+
+	/* the sampler itself is one of the runnable tasks */
+	depth = depth > 1 ? depth - 1 : 0;
+
+	if (bound || depth)
+		g->idle_samples = 0;
+
+	if (bound || depth >= tuners.up_depth)
+		latency_gov_set(policy, policy->max, CPUFREQ_RELATION_H);
+	else if (depth)
+		latency_gov_set(policy, policy->cur + 1, CPUFREQ_RELATION_L);
+	else if (++g->idle_samples >= tuners.down_samples) {
+		g->idle_samples = 0;
+		latency_gov_set(policy, policy->cur - 1, CPUFREQ_RELATION_H);
+	}
+}
+
+static void latency_gov_timer(struct work_struct *work)
+{
+	struct latency_gov *g = container_of(work, struct latency_gov,
+					     work.work);
+
+	if (lock_policy_rwsem_write(0) < 0)
+		return;
+
+	if (g->enable) {
+		latency_gov_sample(g);
+		queue_delayed_work(latency_wq, &g->work,
+				   msecs_to_jiffies(tuners.sampling_ms));
+	}
+
+	unlock_policy_rwsem_write(0);
+}
+
+static void latency_gov_qos_work(struct work_struct *work)
+{
+	struct latency_gov *g = container_of(work, struct latency_gov,
+					     qos_work);
+
+	if (lock_policy_rwsem_write(0) < 0)
+		return;
+
+	if (g->enable && latency_gov_qos_bound(g->policy)) {
+		g->idle_samples = 0;
+		latency_gov_set(g->policy, g->policy->max, CPUFREQ_RELATION_H);
+	}
+
+	unlock_policy_rwsem_write(0);
+}
+
+/* pm_qos notifiers may run with locks held, so defer to the workqueue */
+static int latency_gov_qos_notify(struct notifier_block *nb,
+				  unsigned long value, void *data)
+{
+	if (gov.enable)
+		queue_work(latency_wq, &gov.qos_work);
+
+	return NOTIFY_OK;
+}
+
+static struct notifier_block latency_gov_qos_nb = {
+	.notifier_call	= latency_gov_qos_notify,
+};
+
+/************************** sysfs interface ************************/
+
+#define show_one(file_name)						\
+static ssize_t show_##file_name						\
+(struct cpufreq_policy *unused, char *buf)				\
+{									\
+	return sprintf(buf, "%u\n", tuners.file_name);			\
+}
+
+#define store_one(file_name, min)					\
+static ssize_t store_##file_name					\
+(struct cpufreq_policy *unused, const char *buf, size_t count)		\
+{									\
+	unsigned int input;						\
+									\
+	if (sscanf(buf, "%u", &input) != 1 || input < (min))		\
+		return -EINVAL;						\
+									\
+	tuners.file_name = input;					\
+	return count;							\
+}
+
+#define define_one_rw(_name)						\
+static struct freq_attr _name =						\
+__ATTR(_name, 0644, show_##_name, store_##_name)
+
+show_one(sampling_ms);
+show_one(up_depth);
+show_one(down_samples);
+
+store_one(sampling_ms, 1);
+store_one(up_depth, 1);
+store_one(down_samples, 1);
+
+define_one_rw(sampling_ms);
+define_one_rw(up_depth);
+define_one_rw(down_samples);
+
+static struct attribute *latency_attributes[] = {
+	&sampling_ms.attr,
+	&up_depth.attr,
+	&down_samples.attr,
+	NULL
+};
+
+static struct attribute_group latency_attr_group = {
+	.attrs = latency_attributes,
+	.name = "latency",
+};
+
+/************************** sysfs end ************************/
+
+static int cpufreq_governor_latency(struct cpufreq_policy *policy,
+				    unsigned int event)
+{
+	int rc;
+
+	switch (event) {
+	case CPUFREQ_GOV_START:
+		if (policy->cpu || !cpu_online(policy->cpu) || !policy->cur)
+			return -EINVAL;
+
+		rc = sysfs_create_group(&policy->kobj, &latency_attr_group);
+		if (rc)
+			return rc;
+
+		gov.policy = policy;
+		gov.idle_samples = 0;
+		gov.enable = 1;
+
+		if (latency_gov_qos_bound(policy))
+			latency_gov_set(policy, policy->max, CPUFREQ_RELATION_H);
+
+		queue_delayed_work(latency_wq, &gov.work,
+				   msecs_to_jiffies(tuners.sampling_ms));
+		break;
+
+	case CPUFREQ_GOV_STOP:
+		gov.enable = 0;
+		cancel_delayed_work(&gov.work);
+		sysfs_remove_group(&policy->kobj, &latency_attr_group);
+		break;
+
+	case CPUFREQ_GOV_LIMITS:
+		if (latency_gov_qos_bound(policy))
+			latency_gov_set(policy, policy->max, CPUFREQ_RELATION_H);
+		else
+			latency_gov_set(policy, policy->cur, CPUFREQ_RELATION_L);
+		break;
+	}
+
+	return 0;
+}
+
+struct cpufreq_governor cpufreq_gov_latency = {
+	.name		= "latency",
+	.governor	= cpufreq_governor_latency,
+	.owner		= THIS_MODULE,
+};
+
+static int __init cpufreq_gov_latency_init(void)
+{
+	int ret;
+
+	latency_wq = create_singlethread_workqueue("klatencygov");
+	if (!latency_wq) {
+		printk(KERN_ERR "Creation of klatencygov failed\n");
+		return -EFAULT;
+	}
+
+	INIT_DELAYED_WORK_DEFERRABLE(&gov.work, latency_gov_timer);
+	INIT_WORK(&gov.qos_work, latency_gov_qos_work);
+
+	ret = cpufreq_register_governor(&cpufreq_gov_latency);
+	if (ret) {
+		destroy_workqueue(latency_wq);
+		return ret;
+	}
+
+	pm_qos_add_notifier(PM_QOS_CPU_DMA_LATENCY, &latency_gov_qos_nb);
+
+	return 0;
+}
+
+static void __exit cpufreq_gov_latency_exit(void)
+{
+	pm_qos_remove_notifier(PM_QOS_CPU_DMA_LATENCY, &latency_gov_qos_nb);
+	cpufreq_unregister_governor(&cpufreq_gov_latency);
+	destroy_workqueue(latency_wq);
+}
+
+module_init(cpufreq_gov_latency_init);
+module_exit(cpufreq_gov_latency_exit);
+
+MODULE_DESCRIPTION("Latency driven cpufreq governor for S5PC1XX");
+MODULE_LICENSE("GPL");
@@ -19,6 +19,9 @@
 #include <linux/err.h>
 #include <linux/clk.h>
 #include <linux/io.h>
+#include <linux/hrtimer.h>
+#include <linux/math64.h>
+#include <linux/spinlock.h>
 
 //#include <mach/hardware.h>
 #include <asm/system.h>
@@ -244,6 +247,102 @@ void iem_init(void)
 	set_sample_iem_clk();
 }
 
+/*
+ * Transition latency
+ *
+ * The time s5pc100_target() spends reprogramming the PMIC, dividers and
+ * IEM is measured on every change. The worst case seen so far is what
+ * cpuinfo.transition_latency reports. The latency governor reads it on
+ * every sample; ondemand and conservative only read it when they start,
+ * so they size their sampling on it after the next governor switch.
+ */
+enum {
+	TRANS_UP,
+	TRANS_DOWN,
+	TRANS_DIRS,
+};
+
+struct s5pc100_trans_stat {
+	unsigned long	count;
+	u64		last_ns;
+	u64		max_ns;
+	u64		total_ns;
+};
+
+static struct s5pc100_trans_stat trans_stat[TRANS_DIRS];
+static DEFINE_SPINLOCK(trans_lock);
+
+static void s5pc100_account_transition(struct cpufreq_policy *policy,
+				       int dir, u64 ns)
+{
+	struct s5pc100_trans_stat *st = &trans_stat[dir];
+	unsigned long flags;
+
+	spin_lock_irqsave(&trans_lock, flags);
+
+	st->count++;
+	st->last_ns = ns;
+	st->total_ns += ns;
+	if (ns > st->max_ns)
+		st->max_ns = ns;
+
+	spin_unlock_irqrestore(&trans_lock, flags);
+
+	if (ns > policy->cpuinfo.transition_latency)
+		policy->cpuinfo.transition_latency = ns;
+}
+
+static ssize_t show_transition_stats(struct cpufreq_policy *policy, char *buf)
+{
+	static const char *dir_name[TRANS_DIRS] = { "up", "down" };
+	struct s5pc100_trans_stat st[TRANS_DIRS];
+	unsigned long flags;
+	ssize_t len = 0;
+	u64 avg;
+	int i;
+
+	spin_lock_irqsave(&trans_lock, flags);
+	memcpy(st, trans_stat, sizeof(st));
+	spin_unlock_irqrestore(&trans_lock, flags);
+
+	len += sprintf(buf + len, "dir\tcount\tlast_us\tavg_us\tmax_us\n");
+
+	for (i = 0; i < TRANS_DIRS; i++) {
+		avg = st[i].count ? div_u64(st[i].total_ns, st[i].count) : 0;
+
+		len += sprintf(buf + len, "%s\t%lu\t%llu\t%llu\t%llu\n",
+			       dir_name[i], st[i].count,
+			       div_u64(st[i].last_ns, NSEC_PER_USEC),
+			       div_u64(avg, NSEC_PER_USEC),
+			       div_u64(st[i].max_ns, NSEC_PER_USEC));
+	}
+
+	return len;
+}
+
+/* any write clears the counters */
+static ssize_t store_transition_stats(struct cpufreq_policy *policy,
+				      const char *buf, size_t count)
+{
+	unsigned long flags;
+
+	spin_lock_irqsave(&trans_lock, flags);
+	memset(trans_stat, 0, sizeof(trans_stat));
+	spin_unlock_irqrestore(&trans_lock, flags);
+
+	return count;
+}
+
+static struct freq_attr s5pc100_transition_stats =
+	__ATTR(transition_stats, 0644, show_transition_stats,
+	       store_transition_stats);
+
+static struct freq_attr *s5pc100_cpufreq_attr[] = {
+	&cpufreq_freq_attr_scaling_available_freqs,
+	&s5pc100_transition_stats,
+	NULL,
+};
+
 /* TODO: Add support for SDRAM timing changes */
 
 int s5pc100_verify_speed(struct cpufreq_policy *policy)
@@ -300,6 +399,7 @@ static int s5pc100_target(struct cpufreq_policy *policy,
 	struct clk * mpu_clk;
 	struct clk * apll_clk;
 	struct cpufreq_freqs freqs;
+	ktime_t start;
 	int ret = 0;
 	unsigned long arm_clk;
 	unsigned int index,reg;
@@ -335,6 +435,8 @@ static int s5pc100_target(struct cpufreq_policy *policy,
 
 	cpufreq_notify_transition(&freqs, CPUFREQ_PRECHANGE);
 
+	start = ktime_get();
+
 	if(freqs.new > freqs.old) {
 		
 		/* Frequency up */	
@@ -452,9 +554,14 @@ static int s5pc100_target(struct cpufreq_policy *policy,
 		}
 	}
 
+	if (freqs.new != freqs.old)
+		s5pc100_account_transition(policy,
+			freqs.new > freqs.old ? TRANS_UP : TRANS_DOWN,
+			ktime_to_ns(ktime_sub(ktime_get(), start)));
+
 	cpufreq_notify_transition(&freqs, CPUFREQ_POSTCHANGE);
 
-	printk("Perf changed[L%d]\n",index);
+	pr_debug("Perf changed[L%d]\n",index);
 
 out: 	
 	clk_put(mpu_clk);
@@ -514,6 +621,7 @@ static struct cpufreq_driver s5pc100_driver = {
 	.get		= s5pc100_getspeed,
 	.init		= s5pc100_cpu_init,
 	.name		= "s5pc100",
+	.attr		= s5pc100_cpufreq_attr,
 };
 
 static int __init s5pc100_cpufreq_init(void)
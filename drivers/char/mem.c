@@ -27,6 +27,7 @@
 #include <linux/splice.h>
 #include <linux/pfn.h>
 #include <linux/smp_lock.h>
+#include <linux/poll.h>
 
 #include <asm/uaccess.h>
 #include <asm/io.h>
@@ -866,10 +867,20 @@ static const struct file_operations oldmem_fops = {
 #ifdef CONFIG_S3C_MEM
 extern int s3c_mem_mmap(struct file* filp, struct vm_area_struct *vma);
 extern int s3c_mem_ioctl(struct inode *inode, struct file *file, unsigned int cmd, unsigned long arg);
+#ifdef CONFIG_S3C_MEM_DMA_USER
+extern int s3c_mem_open(struct inode *inode, struct file *file);
+extern int s3c_mem_release(struct inode *inode, struct file *file);
+extern unsigned int s3c_mem_poll(struct file *file, poll_table *wait);
+#endif
 
 static const struct file_operations s3c_mem_fops = {
 	.ioctl 	= s3c_mem_ioctl,
 	.mmap	= s3c_mem_mmap,
+#ifdef CONFIG_S3C_MEM_DMA_USER
+	.open	= s3c_mem_open,
+	.release = s3c_mem_release,
+	.poll	= s3c_mem_poll,
+#endif
 };
 #endif
 
@@ -38,6 +38,15 @@
 #include <mach/hardware.h>
 
 #include <linux/dma-mapping.h>
+#ifdef CONFIG_S3C_MEM_DMA_USER
+#include <linux/dmaengine.h>
+#include <linux/scatterlist.h>
+#include <linux/eventfd.h>
+#include <linux/poll.h>
+#include <linux/sched.h>
+#include <linux/file.h>
+#include <linux/workqueue.h>
+#endif
 
 #include <asm/dma.h>
 #include <mach/dma.h>
@@ -65,6 +74,467 @@ static void s3c_m2m_dma_finish(struct s3c2410_dma_chan *dma_ch, void *buf_id,
 }
 /*----------------------------------------------------------------------*/
 
+#ifdef CONFIG_S3C_MEM_DMA_USER
+/*----------------------------------------------------------------------*/
+/*                zero-copy user buffer M2M DMA                         */
+/*--------------------------------------------------------------------- */
+
+/*
+ * S3C_MEM_DMA_USER_COPY pins the user pages of both buffers and copies
+ * between them with memcpy descriptors on a private dmaengine channel of
+ * the PL330. A job is cut into one descriptor per physically contiguous
+ * piece of source and destination, at most S3C_MEM_DMA_USER_PIECE long so
+ * that its micro code fits the buffer the channel keeps per descriptor.
+ * The channel only has a handful of descriptors, so the pieces are fed
+ * from a work item, kicked by the completion callback as earlier ones
+ * finish. Descriptors are only prepared in process context.
+ */
+
+#define S3C_MEM_DMA_USER_PIECE	(1 << 20)
+
+struct s3c_mem_ctx {
+	struct mutex		mutex;		/* serialises ioctls */
+	struct mutex		feed;		/* serialises the feeders */
+	spinlock_t		lock;		/* protects the job lists */
+	struct dma_chan		*chan;
+	struct list_head	running;
+	struct list_head	done;
+	wait_queue_head_t	wait;
+	struct work_struct	work;
+	unsigned int		next_id;
+	int			jobs;		/* unreaped jobs */
+	int			bytes;		/* bytes of unreaped jobs */
+	int			inflight;	/* descriptors on the channel */
+};
+
+struct s3c_mem_job {
+	struct list_head	node;
+	struct s3c_mem_ctx	*ctx;
+	unsigned int		id;
+	int			result;
+	struct file		*eventfd;
+
+	struct page		**pages;	/* source pages, then destination */
+	int			src_pages;
+	int			dst_pages;
+
+	struct scatterlist	*src_sg;
+	struct scatterlist	*dst_sg;
+	int			src_nents;
+	int			dst_nents;
+
+	/* feeding position */
+	struct scatterlist	*src_pos;
+	struct scatterlist	*dst_pos;
+	unsigned int		src_off;
+	unsigned int		dst_off;
+	unsigned int		remaining;
+	int			inflight;
+	int			size;
+};
+
+static int s3c_mem_nr_pages(unsigned long addr, int size)
+{
+	return ((addr & ~PAGE_MASK) + size + PAGE_SIZE - 1) >> PAGE_SHIFT;
+}
+
+static void s3c_mem_unpin(struct page **pages, int nr, int dirty)
+{
+	int i;
+
+	for (i = 0; i < nr; i++) {
+		if (dirty && !PageReserved(pages[i]))
+			set_page_dirty_lock(pages[i]);
+		page_cache_release(pages[i]);
+	}
+}
+
+/* pin the user buffer and describe it in sg, merging physically
+ * contiguous pages. Returns the number of sg entries used. */
+static int s3c_mem_pin(unsigned long addr, int size, int write,
+		       struct page **pages, struct scatterlist *sg)
+{
+	int nr = s3c_mem_nr_pages(addr, size);
+	unsigned int off = addr & ~PAGE_MASK;
+	unsigned int len;
+	int got, i, nents = 0;
+
+	down_read(&current->mm->mmap_sem);
+	got = get_user_pages(current, current->mm, addr & PAGE_MASK, nr,
+			     write, 0, pages, NULL);
+	up_read(&current->mm->mmap_sem);
+
+	if (got < nr) {
+		if (got > 0)
+			s3c_mem_unpin(pages, got, 0);
+		return got < 0 ? got : -EFAULT;
+	}
+
+	sg_init_table(sg, nr);
+
+	for (i = 0; i < nr; i++) {
+		len = min_t(unsigned int, PAGE_SIZE - off, size);
+
+		if (nents && off == 0 &&
+		    page_to_pfn(pages[i]) == page_to_pfn(pages[i - 1]) + 1)
+			sg[nents - 1].length += len;
+		else
+			sg_set_page(&sg[nents++], pages[i], len, off);
+
+		size -= len;
+		off = 0;
+	}
+
+	sg_mark_end(&sg[nents - 1]);
+
+	return nents;
+}
+
+static void s3c_mem_job_free(struct s3c_mem_job *job)
+{
+	struct device *dev = job->ctx->chan->device->dev;
+
+	if (job->src_nents > 0)
+		dma_unmap_sg(dev, job->src_sg, job->src_nents, DMA_TO_DEVICE);
+	if (job->dst_nents > 0)
+		dma_unmap_sg(dev, job->dst_sg, job->dst_nents, DMA_FROM_DEVICE);
+
+	s3c_mem_unpin(job->pages, job->src_pages, 0);
+	s3c_mem_unpin(job->pages + job->src_pages, job->dst_pages, 1);
+
+	if (job->eventfd)
+		fput(job->eventfd);
+
+	kfree(job->src_sg);
+	kfree(job->pages);
+	kfree(job);
+}
+
+static void s3c_mem_job_finish(struct s3c_mem_job *job)
+{
+	struct s3c_mem_ctx *ctx = job->ctx;
+
+	list_move_tail(&job->node, &ctx->done);
+
+	if (job->eventfd)
+		eventfd_signal(job->eventfd, 1);
+
+	wake_up(&ctx->wait);
+}
+
+/* dmaengine callback, once per descriptor, from the channel tasklet */
+static void s3c_mem_dma_user_seg_done(void *param)
+{
+	struct s3c_mem_job *job = param;
+	struct s3c_mem_ctx *ctx = job->ctx;
+	unsigned long flags;
+
+	spin_lock_irqsave(&ctx->lock, flags);
+
+	ctx->inflight--;
+	if (--job->inflight == 0 && job->remaining == 0)
+		s3c_mem_job_finish(job);
+
+	/* under the lock, so that release can tell when we are done */
+	schedule_work(&ctx->work);
+
+	spin_unlock_irqrestore(&ctx->lock, flags);
+}
+
+/* the first running job with pieces left to feed, or NULL */
+static struct s3c_mem_job *s3c_mem_dma_user_next(struct s3c_mem_ctx *ctx)
+{
+	struct s3c_mem_job *job, *ret = NULL;
+	unsigned long flags;
+
+	spin_lock_irqsave(&ctx->lock, flags);
+	list_for_each_entry(job, &ctx->running, node) {
+		if (job->remaining) {
+			ret = job;
+			break;
+		}
+	}
+	spin_unlock_irqrestore(&ctx->lock, flags);
+
+	return ret;
+}
+
+/* feed as many pieces of the running jobs to the channel as it will take.
+ * Only one feeder runs at a time, so the feeding positions of the jobs
+ * need no lock; the lists and counters are shared with the callback. */
+static void s3c_mem_dma_user_pump(struct s3c_mem_ctx *ctx)
+{
+	struct dma_chan *chan = ctx->chan;
+	struct dma_async_tx_descriptor *tx;
+	struct s3c_mem_job *job;
+	unsigned long flags;
+	unsigned int len;
+	int issued = 0;
+
+	mutex_lock(&ctx->feed);
+
+	while ((job = s3c_mem_dma_user_next(ctx)) != NULL) {
+		len = min(sg_dma_len(job->src_pos) - job->src_off,
+			  sg_dma_len(job->dst_pos) - job->dst_off);
+		len = min_t(unsigned int, len, S3C_MEM_DMA_USER_PIECE);
+
+		tx = chan->device->device_prep_dma_memcpy(chan,
+			sg_dma_address(job->dst_pos) + job->dst_off,
+			sg_dma_address(job->src_pos) + job->src_off,
+			len, DMA_CTRL_ACK | DMA_COMPL_SKIP_SRC_UNMAP |
+			DMA_COMPL_SKIP_DEST_UNMAP);
+
+		if (tx == NULL) {
+			spin_lock_irqsave(&ctx->lock, flags);
+
+			/* out of descriptors, the callback kicks us again */
+			if (ctx->inflight) {
+				spin_unlock_irqrestore(&ctx->lock, flags);
+				break;
+			}
+
+			/* nothing will call us back, give up on the job */
+			job->result = -ENOMEM;
+			job->remaining = 0;
+			s3c_mem_job_finish(job);
+
+			spin_unlock_irqrestore(&ctx->lock, flags);
+			continue;
+		}
+
+		tx->callback = s3c_mem_dma_user_seg_done;
+		tx->callback_param = job;
+
+		spin_lock_irqsave(&ctx->lock, flags);
+		job->inflight++;
+		ctx->inflight++;
+		job->remaining -= len;
+		spin_unlock_irqrestore(&ctx->lock, flags);
+
+		tx->tx_submit(tx);
+		issued++;
+
+		if (job->remaining == 0)
+			continue;
+
+		job->src_off += len;
+		if (job->src_off == sg_dma_len(job->src_pos)) {
+			job->src_pos = sg_next(job->src_pos);
+			job->src_off = 0;
+		}
+
+		job->dst_off += len;
+		if (job->dst_off == sg_dma_len(job->dst_pos)) {
+			job->dst_pos = sg_next(job->dst_pos);
+			job->dst_off = 0;
+		}
+	}
+
+	if (issued)
+		dma_async_issue_pending(chan);
+
+	mutex_unlock(&ctx->feed);
+}
+
+static void s3c_mem_dma_user_work(struct work_struct *work)
+{
+	struct s3c_mem_ctx *ctx = container_of(work, struct s3c_mem_ctx, work);
+
+	s3c_mem_dma_user_pump(ctx);
+}
+
+static int s3c_mem_dma_user_copy(struct s3c_mem_ctx *ctx,
+				 struct s3c_mem_dma_user *param)
+{
+	struct device *dev;
+	struct s3c_mem_job *job;
+	dma_cap_mask_t mask;
+	unsigned long flags;
+	int nr, ret;
+
+	if (param->size <= 0 || param->size > S3C_MEM_DMA_USER_MAX_SIZE)
+		return -EINVAL;
+
+	if (ctx->jobs >= S3C_MEM_DMA_USER_MAX_JOBS ||
+	    ctx->bytes + param->size > S3C_MEM_DMA_USER_MAX_BYTES)
+		return -EBUSY;
+
+	if (ctx->chan == NULL) {
+		dma_cap_zero(mask);
+		dma_cap_set(DMA_MEMCPY, mask);
+
+		ctx->chan = dma_request_channel(mask, NULL, NULL);
+		if (ctx->chan == NULL) {
+			printk(KERN_WARNING "Unable to get DMA channel.\n");
+			return -EBUSY;
+		}
+	}
+
+	dev = ctx->chan->device->dev;
+
+	job = kzalloc(sizeof(*job), GFP_KERNEL);
+	if (job == NULL)
+		return -ENOMEM;
+
+	job->ctx = ctx;
+	job->size = param->size;
+	INIT_LIST_HEAD(&job->node);
+
+	if (param->eventfd >= 0) {
+		job->eventfd = eventfd_fget(param->eventfd);
+		if (IS_ERR(job->eventfd)) {
+			ret = PTR_ERR(job->eventfd);
+			job->eventfd = NULL;
+			goto err_free;
+		}
+	}
+
+	nr = s3c_mem_nr_pages(param->src_addr, param->size) +
+	     s3c_mem_nr_pages(param->dst_addr, param->size);
+
+	job->pages = kmalloc(nr * sizeof(struct page *), GFP_KERNEL);
+	job->src_sg = kmalloc(nr * sizeof(struct scatterlist), GFP_KERNEL);
+	if (job->pages == NULL || job->src_sg == NULL) {
+		ret = -ENOMEM;
+		goto err_free;
+	}
+
+	ret = s3c_mem_pin(param->src_addr, param->size, 0,
+			  job->pages, job->src_sg);
+	if (ret < 0)
+		goto err_free;
+
+	job->src_pages = s3c_mem_nr_pages(param->src_addr, param->size);
+	job->src_nents = ret;
+	job->dst_sg = job->src_sg + job->src_pages;
+
+	ret = s3c_mem_pin(param->dst_addr, param->size, 1,
+			  job->pages + job->src_pages, job->dst_sg);
+	if (ret < 0) {
+		job->src_nents = 0;
+		goto err_free;
+	}
+
+	job->dst_pages = s3c_mem_nr_pages(param->dst_addr, param->size);
+	job->dst_nents = ret;
+
+	/* on this platform dma_map_sg() does not merge, the counts hold */
+	dma_map_sg(dev, job->src_sg, job->src_nents, DMA_TO_DEVICE);
+	dma_map_sg(dev, job->dst_sg, job->dst_nents, DMA_FROM_DEVICE);
+
+	job->src_pos = job->src_sg;
+	job->dst_pos = job->dst_sg;
+	job->remaining = param->size;
+
+	spin_lock_irqsave(&ctx->lock, flags);
+
+	job->id = param->id = ctx->next_id++;
+	ctx->jobs++;
+	ctx->bytes += job->size;
+	list_add_tail(&job->node, &ctx->running);
+
+	spin_unlock_irqrestore(&ctx->lock, flags);
+
+	s3c_mem_dma_user_pump(ctx);
+
+	return 0;
+
+err_free:
+	s3c_mem_job_free(job);
+	return ret;
+}
+
+/* called with ctx->mutex held, like the copy that counted the job in */
+static int s3c_mem_dma_user_reap(struct s3c_mem_ctx *ctx,
+				 struct s3c_mem_dma_done *done)
+{
+	struct s3c_mem_job *job = NULL;
+	unsigned long flags;
+
+	spin_lock_irqsave(&ctx->lock, flags);
+	if (!list_empty(&ctx->done)) {
+		job = list_first_entry(&ctx->done, struct s3c_mem_job, node);
+		list_del(&job->node);
+		ctx->jobs--;
+		ctx->bytes -= job->size;
+	}
+	spin_unlock_irqrestore(&ctx->lock, flags);
+
+	if (job == NULL)
+		return -EAGAIN;
+
+	done->id = job->id;
+	done->result = job->result;
+
+	s3c_mem_job_free(job);
+
+	return 0;
+}
+
+int s3c_mem_open(struct inode *inode, struct file *file)
+{
+	struct s3c_mem_ctx *ctx;
+
+	ctx = kzalloc(sizeof(*ctx), GFP_KERNEL);
+	if (ctx == NULL)
+		return -ENOMEM;
+
+	mutex_init(&ctx->mutex);
+	mutex_init(&ctx->feed);
+	spin_lock_init(&ctx->lock);
+	INIT_LIST_HEAD(&ctx->running);
+	INIT_LIST_HEAD(&ctx->done);
+	init_waitqueue_head(&ctx->wait);
+	INIT_WORK(&ctx->work, s3c_mem_dma_user_work);
+
+	file->private_data = ctx;
+
+	return 0;
+}
+
+int s3c_mem_release(struct inode *inode, struct file *file)
+{
+	struct s3c_mem_ctx *ctx = file->private_data;
+	struct s3c_mem_dma_done done;
+
+	/* the pages stay pinned until the engine is done with them */
+	wait_event(ctx->wait, list_empty(&ctx->running));
+
+	/* let the last callback leave the lock, then stop the feeder */
+	spin_lock_irq(&ctx->lock);
+	spin_unlock_irq(&ctx->lock);
+	cancel_work_sync(&ctx->work);
+
+	mutex_lock(&ctx->mutex);
+	while (s3c_mem_dma_user_reap(ctx, &done) == 0)
+		;
+	mutex_unlock(&ctx->mutex);
+
+	if (ctx->chan)
+		dma_release_channel(ctx->chan);
+
+	kfree(ctx);
+
+	return 0;
+}
+
+unsigned int s3c_mem_poll(struct file *file, poll_table *wait)
+{
+	struct s3c_mem_ctx *ctx = file->private_data;
+	unsigned int mask = 0;
+	unsigned long flags;
+
+	poll_wait(file, &ctx->wait, wait);
+
+	spin_lock_irqsave(&ctx->lock, flags);
+	if (!list_empty(&ctx->done))
+		mask |= POLLIN | POLLRDNORM;
+	spin_unlock_irqrestore(&ctx->lock, flags);
+
+	return mask;
+}
+#endif /* CONFIG_S3C_MEM_DMA_USER */
+
 static int flag = 0;
 
 static unsigned int physical_address;
@@ -84,6 +554,12 @@ int s3c_mem_ioctl(struct inode *inode, struct file *file, unsigned int cmd, unsi
 	struct mm_struct *mm = current->mm;
 	struct s3c_mem_alloc param;
 	struct s3c_mem_dma_param dma_param;
+#ifdef CONFIG_S3C_MEM_DMA_USER
+	struct s3c_mem_ctx *ctx = file->private_data;
+	struct s3c_mem_dma_user user_param;
+	struct s3c_mem_dma_done done_param;
+	int ret;
+#endif
 
 	switch (cmd) {
 		case S3C_MEM_ALLOC:
@@ -355,6 +831,33 @@ int s3c_mem_ioctl(struct inode *inode, struct file *file, unsigned int cmd, unsi
 			}
 			break;
 
+#ifdef CONFIG_S3C_MEM_DMA_USER
+		case S3C_MEM_DMA_USER_COPY:
+			if (copy_from_user(&user_param, (struct s3c_mem_dma_user *)arg, sizeof(struct s3c_mem_dma_user)))
+				return -EFAULT;
+
+			mutex_lock(&ctx->mutex);
+			ret = s3c_mem_dma_user_copy(ctx, &user_param);
+			mutex_unlock(&ctx->mutex);
+			if (ret)
+				return ret;
+
+			if (copy_to_user((struct s3c_mem_dma_user *)arg, &user_param, sizeof(struct s3c_mem_dma_user)))
+				return -EFAULT;
+			break;
+
+		case S3C_MEM_DMA_USER_DONE:
+			mutex_lock(&ctx->mutex);
+			ret = s3c_mem_dma_user_reap(ctx, &done_param);
+			mutex_unlock(&ctx->mutex);
+			if (ret)
+				return ret;
+
+			if (copy_to_user((struct s3c_mem_dma_done *)arg, &done_param, sizeof(struct s3c_mem_dma_done)))
+				return -EFAULT;
+			break;
+#endif
+
 		default:
 			DEBUG("s3c_mem_ioctl() : default !!\n");
 			return -EINVAL;
@@ -33,6 +33,9 @@
 #define S3C_MEM_DMA_COPY		_IOWR(MEM_IOCTL_MAGIC, 318, struct s3c_mem_dma_param)
 #define S3C_MEM_DMA_SET			_IOWR(MEM_IOCTL_MAGIC, 319, struct s3c_mem_dma_param)
 
+#define S3C_MEM_DMA_USER_COPY		_IOWR(MEM_IOCTL_MAGIC, 320, struct s3c_mem_dma_user)
+#define S3C_MEM_DMA_USER_DONE		_IOR(MEM_IOCTL_MAGIC, 321, struct s3c_mem_dma_done)
+
 #define MEM_ALLOC			1
 #define MEM_ALLOC_SHARE			2
 #define MEM_ALLOC_CACHEABLE		3
@@ -67,3 +70,28 @@ struct s3c_mem_dma_param {
 	int		cfg;
 };
 
+/* S3C_MEM_DMA_USER_COPY
+ *
+ * copy size bytes between two user virtual addresses of the caller. The
+ * pages are pinned and the copy runs asynchronously; the ioctl returns the
+ * job id in id. When the copy has finished the eventfd (if not -1) is
+ * signalled and the file becomes readable for poll(). Finished jobs must be
+ * reaped with S3C_MEM_DMA_USER_DONE, which unpins the pages.
+ */
+struct s3c_mem_dma_user {
+	unsigned int	src_addr;
+	unsigned int	dst_addr;
+	int		size;
+	int		eventfd;
+	unsigned int	id;
+};
+
+struct s3c_mem_dma_done {
+	unsigned int	id;
+	int		result;
+};
+
+#define S3C_MEM_DMA_USER_MAX_SIZE	(4 << 20)
+#define S3C_MEM_DMA_USER_MAX_JOBS	16
+/* bytes of unreaped jobs per open file, each pins source and destination */
+#define S3C_MEM_DMA_USER_MAX_BYTES	(8 << 20)
@@ -16,6 +16,7 @@
 #ifdef __KERNEL__
 #include <linux/wait.h>
 #include <linux/mutex.h>
+#include <linux/ktime.h>
 #include <linux/i2c.h>
 #include <linux/fb.h>
 #include <linux/videodev2.h>
@@ -168,6 +169,10 @@ struct fimc_buf_set {
 	enum videobuf_state	state;
 	u32			flags;
 	atomic_t		mapped_cnt;
+	unsigned long		userptr;
+	struct file		*file;		/* exporter of the userptr */
+	struct timeval		timestamp;	/* when the frame was done */
+	u32			sequence;
 	struct list_head	list;
 };
 
@@ -177,6 +182,7 @@ struct fimc_capinfo {
 	struct v4l2_rect	crop;
 	struct v4l2_pix_format	fmt;
 	struct fimc_buf_set	bufs[FIMC_CAPBUFS];
+	enum v4l2_memory	memory;
 	struct list_head	inq;
 	int			outq[FIMC_PHYBUFS];
 	int			nr_bufs;
@@ -208,6 +214,7 @@ struct fimc_outinfo {
 	struct fimc_buf_set	dst[FIMC_OUTBUFS];
 	s32			in_queue[FIMC_INQ_BUFS];
 	s32			out_queue[FIMC_OUTQ_BUFS];
+	u32			sequence;
 
 	/* flip: V4L2_CID_xFLIP, rotate: 90, 180, 270 */
 	u32			flip;
@@ -285,6 +292,24 @@ struct fimc_limit {
 	u32 real_h_rot;
 };
 
+/* output DMA throughput, reported through the bench attribute */
+struct fimc_out_stat {
+	u32	bench;		/* frames to loop before returning them */
+	u32	frames;
+	s64	busy_us;	/* sum of start to interrupt */
+	ktime_t	start;		/* start of the running frame */
+	ktime_t	first;
+	ktime_t	last;
+
+	/* stream setup the numbers belong to */
+	u32	src_width;
+	u32	src_height;
+	u32	src_format;
+	u32	dst_width;
+	u32	dst_height;
+	u32	rotate;
+};
+
 /* fimc controller abstration */
 struct fimc_control {
 	int				id;		/* controller id */
@@ -314,6 +339,7 @@ struct fimc_control {
 	struct fimc_outinfo		*out;		/* output dev info */
 	struct fimc_fbinfo		fb;		/* fimd info */
 	struct fimc_scaler		sc;		/* scaler info */
+	struct fimc_out_stat		stat;		/* output dma stats */
 
 	enum fimc_status		status;
 	enum fimc_log			log;
@@ -390,12 +416,31 @@ extern int s3cfb_close_fifo(int id, int (*do_priv) (void *), void *param);
 extern void s3c_csis_start(int lanes, int settle, int align, int width, int height, int pixel_format);
 extern int fimc_dma_alloc(struct fimc_control *ctrl, struct fimc_buf_set *bs, int i, int align);
 extern void fimc_dma_free(struct fimc_control *ctrl, struct fimc_buf_set *bs, int i);
+extern int fimc_get_userptr(unsigned long userptr, size_t len, dma_addr_t *paddr, struct file **filp);
+extern void fimc_put_userptr(struct fimc_buf_set *bs);
 extern u32 fimc_mapping_rot_flip(u32 rot, u32 flip);
 extern int fimc_get_scaler_factor(u32 src, u32 tar, u32 *ratio, u32 *shift);
 
 /* camera */
 extern int fimc_select_camera(struct fimc_control *ctrl);
 
+/* memory to memory device */
+#ifdef CONFIG_VIDEO_FIMC_M2M
+extern int fimc_m2m_init(void);
+extern void fimc_m2m_exit(void);
+extern int fimc_m2m_irq(struct fimc_control *ctrl);
+extern int fimc_m2m_owns(struct fimc_control *ctrl);
+extern void fimc_m2m_suspend(struct fimc_control *ctrl);
+extern void fimc_m2m_resume(struct fimc_control *ctrl);
+#else
+static inline int fimc_m2m_init(void) { return 0; }
+static inline void fimc_m2m_exit(void) { }
+static inline int fimc_m2m_irq(struct fimc_control *ctrl) { return 0; }
+static inline int fimc_m2m_owns(struct fimc_control *ctrl) { return 0; }
+static inline void fimc_m2m_suspend(struct fimc_control *ctrl) { }
+static inline void fimc_m2m_resume(struct fimc_control *ctrl) { }
+#endif
+
 /* capture device */
 extern int fimc_enum_input(struct file *file, void *fh, struct v4l2_input *inp);
 extern int fimc_g_input(struct file *file, void *fh, unsigned int *i);
@@ -429,6 +474,12 @@ extern int fimc_fimd_rect(const struct fimc_control *ctrl, struct v4l2_rect *fim
 extern int fimc_outdev_stop_streaming(struct fimc_control *ctrl);
 extern int fimc_outdev_resume_dma(struct fimc_control *ctrl);
 extern int fimc_outdev_start_camif(void *param);
+extern int fimc_outdev_run(struct fimc_control *ctrl, int index);
+extern int fimc_outdev_check_param(struct fimc_control *ctrl);
+extern u32 fimc_outdev_src_size(struct fimc_outinfo *out);
+extern void fimc_outdev_fill_src(struct fimc_outinfo *out, struct fimc_buf_set *bs, dma_addr_t base);
+extern u32 fimc_outdev_none_dst_size(struct fimc_outinfo *out);
+extern int fimc_outdev_fill_none_dst(struct fimc_outinfo *out, struct fimc_buf_set *bs, dma_addr_t base);
 extern int fimc_reqbufs_output(void *fh, struct v4l2_requestbuffers *b);
 extern int fimc_querybuf_output(void *fh, struct v4l2_buffer *b);
 extern int fimc_g_ctrl_output(void *fh, struct v4l2_control *c);
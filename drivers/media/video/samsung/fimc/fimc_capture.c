@@ -20,6 +20,7 @@
 #include <linux/videodev2_samsung.h>
 #include <linux/clk.h>
 #include <linux/mm.h>
+#include <linux/file.h>
 #include <linux/io.h>
 #include <linux/uaccess.h>
 #include <plat/media.h>
@@ -693,6 +694,13 @@ static int fimc_alloc_buffers(struct fimc_control *ctrl,
 	}
 
 	for (i = 0; i < cap->nr_bufs; i++) {
+		/* user buffers only get their layout, addresses come at qbuf */
+		if (cap->memory == V4L2_MEMORY_USERPTR) {
+			for (j = 0; j < plane; j++)
+				cap->bufs[i].length[j] = plane_length[j];
+			continue;
+		}
+
 		for (j = 0; j < plane; j++) {
 			cap->bufs[i].length[j] = plane_length[j];
 			fimc_dma_alloc(ctrl, &cap->bufs[i], j, align);
@@ -729,27 +737,44 @@ int fimc_reqbufs_capture(void *fh, struct v4l2_requestbuffers *b)
 		return -ENODEV;
 	}
 
+	if (b->memory != V4L2_MEMORY_MMAP && b->memory != V4L2_MEMORY_USERPTR) {
+		fimc_err("%s: invalid memory type\n", __func__);
+		return -EINVAL;
+	}
+
+	if (b->count > FIMC_CAPBUFS) {
+		fimc_warn("%s: buffer count is modified from %d to %d\n",
+			__func__, b->count, FIMC_CAPBUFS);
+		b->count = FIMC_CAPBUFS;
+	}
+
 	mutex_lock(&ctrl->v4l2_lock);
 
 #if defined(PINGPONG_2ADDR_MODE)
 	if (b->count < 3) {
 		fimc_err("%s: invalid buffer count\n", __func__);
+		mutex_unlock(&ctrl->v4l2_lock);
 		return -EINVAL;
 	}
 #else
 	if (b->count < 1 || b->count == 3) {
 		fimc_err("%s: invalid buffer count\n", __func__);
+		mutex_unlock(&ctrl->v4l2_lock);
 		return -EINVAL;
 	}
 #endif
 
-	cap->nr_bufs = b->count;
 	fimc_dbg("%s: requested %d buffers\n", __func__, b->count);
 
 	INIT_LIST_HEAD(&cap->inq);
 	for (i = 0; i < FIMC_CAPBUFS; i++) {
-		/* free previous buffers */
-		fimc_dma_free(ctrl, &cap->bufs[i], 0);
+		/* free previous buffers, user buffers were never ours */
+		if (cap->memory == V4L2_MEMORY_USERPTR) {
+			fimc_put_userptr(&cap->bufs[i]);
+			memset(&cap->bufs[i], 0, sizeof(cap->bufs[i]));
+		} else {
+			fimc_dma_free(ctrl, &cap->bufs[i], 0);
+		}
 		cap->bufs[i].id = i;
 		cap->bufs[i].state = VIDEOBUF_NEEDS_INIT;
 
@@ -757,6 +782,9 @@ int fimc_reqbufs_capture(void *fh, struct v4l2_requestbuffers *b)
 		INIT_LIST_HEAD(&cap->bufs[i].list);
 	}
 
+	cap->nr_bufs = b->count;
+	cap->memory = b->memory;
+
 	bpp = fimc_fmt_depth(ctrl, &cap->fmt);
 	switch (cap->fmt.pixelformat) {
 	case V4L2_PIX_FMT_JPEG:		/* fall through */
@@ -804,6 +832,24 @@ int fimc_reqbufs_capture(void *fh, struct v4l2_requestbuffers *b)
 	return 0;
 }
 
+static u32 fimc_cap_buf_length(struct fimc_capinfo *cap, int index)
+{
+	struct fimc_buf_set *bs = &cap->bufs[index];
+
+	switch (cap->fmt.pixelformat) {
+	case V4L2_PIX_FMT_NV12:		/* fall through */
+	case V4L2_PIX_FMT_NV12T:
+		return ALIGN(bs->length[0], SZ_64K) + ALIGN(bs->length[1], SZ_64K);
+
+	case V4L2_PIX_FMT_YUV422P:	/* fall through */
+	case V4L2_PIX_FMT_YUV420:
+		return bs->length[0] + bs->length[1] + bs->length[2];
+
+	default:
+		return bs->length[0];
+	}
+}
+
 int fimc_querybuf_capture(void *fh, struct v4l2_buffer *b)
 {
 	struct fimc_control *ctrl = fh;
@@ -814,39 +860,19 @@ int fimc_querybuf_capture(void *fh, struct v4l2_buffer *b)
 		return -EBUSY;
 	}
 
-	mutex_lock(&ctrl->v4l2_lock);
-
-	switch (cap->fmt.pixelformat) {
-	case V4L2_PIX_FMT_JPEG:		/* fall through */
-	case V4L2_PIX_FMT_RGB32:	/* fall through */
-	case V4L2_PIX_FMT_RGB565:	/* fall through */
-	case V4L2_PIX_FMT_YUYV:		/* fall through */
-	case V4L2_PIX_FMT_UYVY:		/* fall through */
-	case V4L2_PIX_FMT_VYUY:		/* fall through */
-	case V4L2_PIX_FMT_YVYU:		/* fall through */
-	case V4L2_PIX_FMT_NV16:		/* fall through */
-	case V4L2_PIX_FMT_NV61:		/* fall through */
-	case V4L2_PIX_FMT_NV21:
-		b->length = cap->bufs[b->index].length[0];
-		break;
+	if (b->index >= cap->nr_bufs) {
+		fimc_err("%s: invalid buffer index(%d)\n", __func__, b->index);
+		return -EINVAL;
+	}
 
-	case V4L2_PIX_FMT_NV12:		/* fall through */
-	case V4L2_PIX_FMT_NV12T:
-		b->length = ALIGN(ctrl->cap->bufs[b->index].length[0], SZ_64K)
-			+ ALIGN(ctrl->cap->bufs[b->index].length[1], SZ_64K);
-		break;
-	case V4L2_PIX_FMT_YUV422P:	/* fall through */
-	case V4L2_PIX_FMT_YUV420:
-		b->length = ctrl->cap->bufs[b->index].length[0]
-			+ ctrl->cap->bufs[b->index].length[1]
-			+ ctrl->cap->bufs[b->index].length[2];
-		break;
+	mutex_lock(&ctrl->v4l2_lock);
 
-	default:
-		b->length = cap->bufs[b->index].length[0];
-		break;
-	}
-	b->m.offset = b->index * PAGE_SIZE;
+	b->length = fimc_cap_buf_length(cap, b->index);
+	b->memory = cap->memory;
+	if (cap->memory == V4L2_MEMORY_USERPTR)
+		b->m.userptr = cap->bufs[b->index].userptr;
+	else
+		b->m.offset = b->index * PAGE_SIZE;
 
 	ctrl->cap->bufs[b->index].state = VIDEOBUF_IDLE;
 
@@ -1083,6 +1109,106 @@ int fimc_stop_capture(struct fimc_control *ctrl)
 	return 0;
 }
 
+/*
+ * Point a capture buffer at the user buffer resolved by fimc_get_userptr.
+ * The buffer takes over the reference to the exporter's file.
+ */
+static int fimc_set_userptr(struct fimc_control *ctrl, int index,
+			    unsigned long userptr, dma_addr_t paddr,
+			    struct file *file)
+{
+	struct fimc_capinfo *cap = ctrl->cap;
+	struct fimc_buf_set *bs = &cap->bufs[index];
+	u32 align = 0;
+	int j;
+
+	if (cap->fmt.pixelformat == V4L2_PIX_FMT_NV12 ||
+	    cap->fmt.pixelformat == V4L2_PIX_FMT_NV12T)
+		align = SZ_64K;
+
+	/* planes follow each other as fimc_alloc_buffers lays them */
+	if (align && !IS_ALIGNED(paddr, align)) {
+		fimc_err("%s: buffer must be aligned to %u bytes\n",
+			__func__, align);
+		return -EINVAL;
+	}
+
+	bs->base[0] = paddr;
+	for (j = 1; j < 3; j++) {
+		bs->base[j] = 0;
+		if (!bs->length[j])
+			continue;
+
+		bs->base[j] = bs->base[j - 1] + bs->length[j - 1];
+		if (align)
+			bs->base[j] = ALIGN(bs->base[j], align);
+	}
+
+	fimc_put_userptr(bs);
+	bs->file = file;
+	bs->userptr = userptr;
+	bs->state = VIDEOBUF_PREPARED;
+
+#if !defined(PINGPONG_2ADDR_MODE)
+	/* with few buffers each hardware slot is tied to one of them */
+	if (cap->nr_bufs <= FIMC_PHYBUFS) {
+		for (j = index; j < FIMC_PHYBUFS; j += cap->nr_bufs) {
+			if (j != index) {
+				memcpy(cap->bufs[j].base, bs->base,
+					sizeof(bs->base));
+				cap->bufs[j].userptr = userptr;
+			}
+
+			if (ctrl->status == FIMC_STREAMON)
+				fimc_hwset_output_address(ctrl,
+							&cap->bufs[j], j);
+		}
+	}
+#endif
+
+	return 0;
+}
+
+/* streamoff hands user buffers back, they are queued again to restart */
+static void fimc_drop_userptrs(struct fimc_capinfo *cap)
+{
+	int i;
+
+	INIT_LIST_HEAD(&cap->inq);
+	for (i = 0; i < FIMC_CAPBUFS; i++) {
+		fimc_put_userptr(&cap->bufs[i]);
+		memset(cap->bufs[i].base, 0, sizeof(cap->bufs[i].base));
+		INIT_LIST_HEAD(&cap->bufs[i].list);
+		cap->bufs[i].state = VIDEOBUF_NEEDS_INIT;
+	}
+}
+
+static int fimc_userptr_ready(struct fimc_capinfo *cap)
+{
+	struct list_head *pos;
+	int queued = 0;
+#if !defined(PINGPONG_2ADDR_MODE)
+	int i;
+#endif
+
+	list_for_each(pos, &cap->inq)
+		queued++;
+
+#if defined(PINGPONG_2ADDR_MODE)
+	return queued >= FIMC_PINGPONG;
+#else
+	if (cap->nr_bufs > FIMC_PHYBUFS)
+		return queued >= FIMC_PHYBUFS;
+
+	for (i = 0; i < cap->nr_bufs; i++) {
+		if (!cap->bufs[i].base[0])
+			return 0;
+	}
+
+	return 1;
+#endif
+}
+
 int fimc_streamon_capture(void *fh)
 {
 	struct fimc_control *ctrl = fh;
@@ -1091,6 +1217,11 @@ int fimc_streamon_capture(void *fh)
 
 	fimc_dbg("%s\n", __func__);
 
+	if (cap->memory == V4L2_MEMORY_USERPTR && !fimc_userptr_ready(cap)) {
+		fimc_err("%s: user buffers must be queued first\n", __func__);
+		return -EINVAL;
+	}
+
 	ctrl->status = FIMC_READY_ON;
 	cap->irq = 0;
 
@@ -1170,6 +1301,11 @@ int fimc_streamoff_capture(void *fh)
 	for(i = 0; i < FIMC_PHYBUFS; i++)
 		fimc_add_inqueue(ctrl, cap->outq[i]);
 #endif
+	if (cap->memory == V4L2_MEMORY_USERPTR) {
+		mutex_lock(&ctrl->v4l2_lock);
+		fimc_drop_userptrs(cap);
+		mutex_unlock(&ctrl->v4l2_lock);
+	}
 	ctrl->status = FIMC_STREAMOFF;
 
 	return 0;
@@ -1178,26 +1314,50 @@ int fimc_streamoff_capture(void *fh)
 int fimc_qbuf_capture(void *fh, struct v4l2_buffer *b)
 {
 	struct fimc_control *ctrl = fh;
+	struct fimc_capinfo *cap = ctrl->cap;
+	struct file *file = NULL;
+	dma_addr_t paddr = 0;
+	int ret = 0;
 
-	if (b->memory != V4L2_MEMORY_MMAP) {
+	if (b->memory != cap->memory) {
 		fimc_err("%s: invalid memory type\n", __func__);
 		return -EINVAL;
 	}
 
+	if (b->index >= cap->nr_bufs) {
+		fimc_err("%s: invalid buffer index(%d)\n", __func__, b->index);
+		return -EINVAL;
+	}
+
+	if (b->memory == V4L2_MEMORY_USERPTR) {
+		ret = fimc_get_userptr(b->m.userptr,
+				fimc_cap_buf_length(cap, b->index), &paddr,
+				&file);
+		if (ret < 0)
+			return ret;
+	}
+
 	fimc_info2("%s: buffer(%d)\n", __func__, b->index);
-#if defined(PINGPONG_2ADDR_MODE)
+
 	mutex_lock(&ctrl->v4l2_lock);
-	fimc_add_inqueue(ctrl, b->index);
-	mutex_unlock(&ctrl->v4l2_lock);
+
+	if (b->memory == V4L2_MEMORY_USERPTR) {
+		ret = fimc_set_userptr(ctrl, b->index, b->m.userptr, paddr,
+				       file);
+		if (ret)
+			fput(file);
+	}
+#if defined(PINGPONG_2ADDR_MODE)
+	if (!ret)
+		fimc_add_inqueue(ctrl, b->index);
 #else
-	if (ctrl->cap->nr_bufs > FIMC_PHYBUFS) {
-		mutex_lock(&ctrl->v4l2_lock);
+	if (!ret && cap->nr_bufs > FIMC_PHYBUFS)
 		fimc_add_inqueue(ctrl, b->index);
-		mutex_unlock(&ctrl->v4l2_lock);
-	}
 #endif
 
-	return 0;
+	mutex_unlock(&ctrl->v4l2_lock);
+
+	return ret;
 }
 
 int fimc_dqbuf_capture(void *fh, struct v4l2_buffer *b)
@@ -1206,7 +1366,7 @@ int fimc_dqbuf_capture(void *fh, struct v4l2_buffer *b)
 	struct fimc_capinfo *cap = ctrl->cap;
 	int pp, ret = 0;
 
-	if (b->memory != V4L2_MEMORY_MMAP) {
+	if (b->memory != cap->memory) {
 		fimc_err("%s: invalid memory type\n", __func__);
 		return -EINVAL;
 	}
@@ -1246,6 +1406,16 @@ int fimc_dqbuf_capture(void *fh, struct v4l2_buffer *b)
 	}
 #endif
 
+	if (!ret && cap->memory == V4L2_MEMORY_USERPTR) {
+		b->m.userptr = cap->bufs[b->index].userptr;
+
+		/* off the hardware now, unless it is tied to a slot */
+#if !defined(PINGPONG_2ADDR_MODE)
+		if (cap->nr_bufs > FIMC_PHYBUFS)
+#endif
+			fimc_put_userptr(&cap->bufs[b->index]);
+	}
+
 	mutex_unlock(&ctrl->v4l2_lock);
 
 	return ret;
@@ -27,6 +27,8 @@
 #include <linux/poll.h>
 #include <linux/wait.h>
 #include <linux/fs.h>
+#include <linux/file.h>
+#include <linux/major.h>
 #include <linux/irq.h>
 #include <linux/mm.h>
 #include <linux/interrupt.h>
@@ -34,6 +36,9 @@
 #include <linux/io.h>
 #include <linux/memory.h>
 #include <linux/ctype.h>
+#include <linux/sched.h>
+#include <linux/math64.h>
+#include <linux/uaccess.h>
 #include <plat/clock.h>
 #include <plat/media.h>
 #include <plat/fimc.h>
@@ -53,8 +58,10 @@ int fimc_dma_alloc(struct fimc_control *ctrl, struct fimc_buf_set *bs, int i, in
 	end = ctrl->mem.base + ctrl->mem.size;
 	curr = &ctrl->mem.curr;
 
-	if (!bs->length[i])
+	if (!bs->length[i]) {
+		mutex_unlock(&ctrl->lock);
 		return -EINVAL;
+	}
 
 	if (!align) {
 		if (*curr + bs->length[i] > end) {
@@ -105,6 +112,162 @@ void fimc_dma_free(struct fimc_control *ctrl, struct fimc_buf_set *bs, int i)
 	mutex_unlock(&ctrl->lock);
 }
 
+static int fimc_follow_pfn(struct mm_struct *mm, unsigned long addr,
+			   unsigned long *pfn)
+{
+	pgd_t *pgd;
+	pud_t *pud;
+	pmd_t *pmd;
+	pte_t *ptep, pte;
+	spinlock_t *ptl;
+
+	pgd = pgd_offset(mm, addr);
+	if (pgd_none(*pgd) || unlikely(pgd_bad(*pgd)))
+		return -EFAULT;
+
+	pud = pud_offset(pgd, addr);
+	if (pud_none(*pud) || unlikely(pud_bad(*pud)))
+		return -EFAULT;
+
+	pmd = pmd_offset(pud, addr);
+	if (pmd_none(*pmd) || unlikely(pmd_bad(*pmd)))
+		return -EFAULT;
+
+	ptep = pte_offset_map_lock(mm, pmd, addr, &ptl);
+	pte = *ptep;
+	pte_unmap_unlock(ptep, ptl);
+
+	if (!pte_present(pte))
+		return -EFAULT;
+
+	*pfn = pte_pfn(pte);
+
+	return 0;
+}
+
+/* the frame buffer, V4L2 nodes (FIMC, TV) and misc devices (MFC, JPEG) */
+static int fimc_userptr_exporter(struct vm_area_struct *vma)
+{
+	struct inode *inode;
+
+	if (!(vma->vm_flags & VM_PFNMAP) || !vma->vm_file)
+		return 0;
+
+	inode = vma->vm_file->f_path.dentry->d_inode;
+	if (!S_ISCHR(inode->i_mode))
+		return 0;
+
+	switch (imajor(inode)) {
+	case FB_MAJOR:
+	case VIDEO_MAJOR:
+	case MISC_MAJOR:
+		return 1;
+	default:
+		return 0;
+	}
+}
+
+#ifdef CONFIG_PLAT_S5PC1XX
+static int fimc_userptr_media(dma_addr_t paddr, size_t len)
+{
+	int id;
+
+	for (id = 0; id < S3C_MDEV_MAX; id++) {
+		if (s3c_media_claimed(id, paddr, len))
+			return 1;
+	}
+
+	return 0;
+}
+#else
+static inline int fimc_userptr_media(dma_addr_t paddr, size_t len)
+{
+	return 1;
+}
+#endif
+
+/*
+ * Resolve the userptr of a V4L2_MEMORY_USERPTR buffer.
+ *
+ * Only a pointer into a PFN mapping of another media device (MFC, JPEG, the
+ * frame buffer or a FIMC node) is taken. It is translated into the physical
+ * address of a contiguous buffer of at least len bytes. Ordinary memory is
+ * refused, the hardware cannot scatter, and so is anything but the frame
+ * buffer that does not lie in media memory a device holds.
+ *
+ * *filp gets a reference to the file of the mapping. It keeps the exporter
+ * from freeing the memory on close and is dropped with fimc_put_userptr()
+ * once the hardware is done with the buffer.
+ */
+int fimc_get_userptr(unsigned long userptr, size_t len, dma_addr_t *paddr,
+		     struct file **filp)
+{
+	struct mm_struct *mm = current->mm;
+	struct vm_area_struct *vma;
+	unsigned long start = userptr & PAGE_MASK;
+	unsigned long addr, pfn, first = 0;
+	int ret;
+
+	down_read(&mm->mmap_sem);
+
+	vma = find_vma(mm, userptr);
+	if (!vma || userptr < vma->vm_start || !fimc_userptr_exporter(vma)) {
+		fimc_err("%s: buffer 0x%08lx is not a media device mapping\n",
+			__func__, userptr);
+		ret = -EINVAL;
+		goto out;
+	}
+
+	if (!len || userptr + len < userptr || userptr + len > vma->vm_end) {
+		fimc_err("%s: buffer 0x%08lx does not fit its mapping\n",
+			__func__, userptr);
+		ret = -EINVAL;
+		goto out;
+	}
+
+	for (addr = start; addr < userptr + len; addr += PAGE_SIZE) {
+		ret = fimc_follow_pfn(mm, addr, &pfn);
+		if (ret)
+			goto out;
+
+		if (addr == start) {
+			first = pfn;
+		} else if (pfn != first + ((addr - start) >> PAGE_SHIFT)) {
+			fimc_err("%s: buffer 0x%08lx is not contiguous\n",
+				__func__, userptr);
+			ret = -EINVAL;
+			goto out;
+		}
+	}
+
+	*paddr = __pfn_to_phys(first) + (userptr & ~PAGE_MASK);
+
+	if (imajor(vma->vm_file->f_path.dentry->d_inode) != FB_MAJOR &&
+	    !fimc_userptr_media(*paddr, len)) {
+		fimc_err("%s: buffer 0x%08lx is not in media memory\n",
+			__func__, userptr);
+		ret = -EINVAL;
+		goto out;
+	}
+
+	get_file(vma->vm_file);
+	*filp = vma->vm_file;
+	ret = 0;
+
+out:
+	up_read(&mm->mmap_sem);
+
+	return ret;
+}
+
+void fimc_put_userptr(struct fimc_buf_set *bs)
+{
+	if (bs->file) {
+		fput(bs->file);
+		bs->file = NULL;
+	}
+}
+
 static inline u32 fimc_irq_out_none(struct fimc_control *ctrl)
 {
 	u32 next = 0, wakeup = 1;
@@ -141,10 +304,11 @@ static inline u32 fimc_irq_out_none(struct fimc_control *ctrl)
 
 static inline u32 fimc_irq_out_dma(struct fimc_control *ctrl)
 {
-	struct fimc_buf_set buf_set;
+	struct fimc_out_stat *stat = &ctrl->stat;
 	u32 next = 0, wakeup = 1;
 	int idx = ctrl->out->idx.active;
-	int ret = -1, i;
+	int ret = -1, loop = 0;
+	ktime_t now;
 
 	if (ctrl->status == FIMC_READY_OFF) {
 		ctrl->out->idx.active = -1;
@@ -152,6 +316,38 @@ static inline u32 fimc_irq_out_dma(struct fimc_control *ctrl)
 		return wakeup;
 	}
 
+	now = ktime_get();
+	stat->busy_us += ktime_us_delta(now, stat->start);
+	stat->last = now;
+	stat->frames++;
+
+	ctrl->out->src[idx].timestamp = ktime_to_timeval(now);
+	ctrl->out->src[idx].sequence = ctrl->out->sequence++;
+
+	/* benchmark mode: run the same frame again instead of returning it */
+	if (stat->bench) {
+		stat->bench--;
+		fimc_attach_in_queue(ctrl, idx);
+		loop = 1;
+	}
+
+	/*
+	 * Start the next queued frame before anything else, so the scaler
+	 * is idle only for the interrupt latency.
+	 */
+	ret =  fimc_detach_in_queue(ctrl, &next);
+	if (ret == 0) {	/* There is a buffer in incomming queue. */
+		ret = fimc_outdev_run(ctrl, next);
+		if (ret < 0)
+			fimc_err("Fail: fimc_start_camif\n");
+	} else {	/* There is no buffer in incomming queue. */
+		ctrl->out->idx.active = -1;
+		ctrl->status = FIMC_STREAMON_IDLE;
+	}
+
+	if (loop)
+		return 0;
+
 	/* Attach done buffer to outgoing queue. */
 	ret = fimc_attach_out_queue(ctrl, idx);
 	if (ret < 0)
@@ -177,28 +373,6 @@ static inline u32 fimc_irq_out_dma(struct fimc_control *ctrl)
 		}
 	}
 
-	/* Detach buffer from incomming queue. */
-	ret =  fimc_detach_in_queue(ctrl, &next);
-	if (ret == 0) {	/* There is a buffer in incomming queue. */
-		fimc_outdev_set_src_addr(ctrl, ctrl->out->src[next].base);
-
-		memset(&buf_set, 0x00, sizeof(buf_set));
-		buf_set.base[FIMC_ADDR_Y] = ctrl->out->dst[next].base[FIMC_ADDR_Y];
-
-		for (i = 0; i < FIMC_PHYBUFS; i++)
-			fimc_hwset_output_address(ctrl, &buf_set, i);
-		
-		ret = fimc_outdev_start_camif(ctrl);
-		if (ret < 0)
-			fimc_err("Fail: fimc_start_camif\n");
-
-		ctrl->out->idx.active = next;
-		ctrl->status = FIMC_STREAMON;
-	} else {	/* There is no buffer in incomming queue. */
-		ctrl->out->idx.active = -1;
-		ctrl->status = FIMC_STREAMON_IDLE;
-	}
-
 	return wakeup;
 }
 
@@ -292,6 +466,9 @@ static irqreturn_t fimc_irq(int irq, void *dev_id)
 {
 	struct fimc_control *ctrl = (struct fimc_control *) dev_id;
 
+	if (fimc_m2m_irq(ctrl))
+		return IRQ_HANDLED;
+
 	if (ctrl->cap)
 		fimc_irq_cap(ctrl);
 	else if (ctrl->out)
@@ -318,8 +495,10 @@ struct fimc_control *fimc_register_controller(struct platform_device *pdev)
 	ctrl->vd = &fimc_video_device[id];
 	ctrl->vd->minor = id;
 
-	/* alloc from bank1 as default */
+	/* alloc from bank1 as default, on open if the region is shared */
+#ifndef CONFIG_S5PC1XX_MEDIA_SHARED
 	ctrl->mem.base = s3c_get_media_memory_node(mdev_id, 1);
+#endif
 	ctrl->mem.size = s3c_get_media_memsize_node(mdev_id, 1);
 	ctrl->mem.curr = ctrl->mem.base;
 
@@ -500,6 +679,12 @@ static inline int fimc_mmap_cap(struct file *filp, struct vm_area_struct *vma)
 	u32 size = vma->vm_end - vma->vm_start;
 	u32 pfn, idx = vma->vm_pgoff;
 
+	if (ctrl->cap->memory != V4L2_MEMORY_MMAP ||
+	    idx >= ctrl->cap->nr_bufs) {
+		fimc_err("%s: no such capture buffer(%d)\n", __func__, idx);
+		return -EINVAL;
+	}
+
 	vma->vm_page_prot = pgprot_noncached(vma->vm_page_prot);
 	vma->vm_flags |= VM_RESERVED;
 
@@ -626,6 +811,43 @@ int fimc_get_scaler_factor(u32 src, u32 tar, u32 *ratio, u32 *shift)
 	return 0;
 }
 
+#ifdef CONFIG_S5PC1XX_MEDIA_SHARED
+/*
+ * The reserved memory is only held while the device is open, the rest of
+ * the time the media region lends it to the page allocator.
+ */
+static int fimc_get_mem(struct fimc_control *ctrl)
+{
+	if (!ctrl->mem.size)
+		return 0;
+
+	ctrl->mem.base = s3c_media_alloc(S3C_MDEV_FIMC0 + ctrl->id,
+					 ctrl->mem.size);
+	if (!ctrl->mem.base)
+		return -ENOMEM;
+
+	return 0;
+}
+
+static void fimc_put_mem(struct fimc_control *ctrl)
+{
+	if (ctrl->mem.base)
+		s3c_media_free(S3C_MDEV_FIMC0 + ctrl->id, ctrl->mem.base);
+
+	ctrl->mem.base = 0;
+	ctrl->mem.curr = 0;
+}
+#else
+static inline int fimc_get_mem(struct fimc_control *ctrl)
+{
+	return 0;
+}
+
+static inline void fimc_put_mem(struct fimc_control *ctrl)
+{
+}
+#endif
+
 static int fimc_open(struct file *filp)
 {
 	struct fimc_control *ctrl;
@@ -637,11 +859,17 @@ static int fimc_open(struct file *filp)
 
 	mutex_lock(&ctrl->lock);
 
-	if (atomic_read(&ctrl->in_use)) {
+	/* the m2m device claims idle controllers the same way */
+	if (atomic_cmpxchg(&ctrl->in_use, 0, 1) != 0) {
 		ret = -EBUSY;
 		goto resource_busy;
-	} else {
-		atomic_inc(&ctrl->in_use);
+	}
+
+	ret = fimc_get_mem(ctrl);
+	if (ret < 0) {
+		fimc_err("%s: no memory for %s\n", __func__, ctrl->name);
+		atomic_set(&ctrl->in_use, 0);
+		goto resource_busy;
 	}
 
 	if (pdata->clk_on)
@@ -698,7 +926,6 @@ static int fimc_release(struct file *filp)
 
 	ctrl->mem.curr = ctrl->mem.base;
 
-	atomic_dec(&ctrl->in_use);
 	filp->private_data = NULL;
 
 	pdata = to_fimc_plat(ctrl->dev);
@@ -717,7 +944,16 @@ static int fimc_release(struct file *filp)
 	}
 
 	if (ctrl->cap) {
+		/* user buffers are only let go once nothing writes them */
+		if (ctrl->status != FIMC_STREAMOFF)
+			fimc_streamoff_capture(ctrl);
+
 		for (i = 0; i < FIMC_CAPBUFS; i++) {
+			if (ctrl->cap->memory == V4L2_MEMORY_USERPTR) {
+				fimc_put_userptr(&ctrl->cap->bufs[i]);
+				continue;
+			}
+
 			fimc_dma_free(ctrl, &ctrl->cap->bufs[i], 0);
 			fimc_dma_free(ctrl, &ctrl->cap->bufs[i], 1);
 			fimc_dma_free(ctrl, &ctrl->cap->bufs[i], 2);
@@ -738,6 +974,8 @@ static int fimc_release(struct file *filp)
 		buf = &ctrl->out->overlay.buf;
 
 		for (i = 0; i < FIMC_OUTBUFS; i++) {
+			fimc_put_userptr(&ctrl->out->src[i]);
+
 			if (buf->vir_addr[i]) {
 				ret = do_munmap(mm, buf->vir_addr[i], buf->size[i]);
 				if (ret < 0)
@@ -752,6 +990,12 @@ static int fimc_release(struct file *filp)
 	if (pdata->clk_off)
 		pdata->clk_off(to_platform_device(ctrl->dev), ctrl->clk);
 
+	/* the next user may only come in once the buffers are gone */
+	mutex_lock(&ctrl->lock);
+	fimc_put_mem(ctrl);
+	atomic_dec(&ctrl->in_use);
+	mutex_unlock(&ctrl->lock);
+
 	fimc_info1("%s: successfully released\n", __func__);
 
 	return 0;
@@ -1025,6 +1269,66 @@ static DEVICE_ATTR(log_level, 0644, \
 			fimc_show_log_level,
 			fimc_store_log_level);
 
+static ssize_t fimc_show_bench(struct device *dev,
+		struct device_attribute *attr, char *buf)
+{
+	struct fimc_control *ctrl;
+	struct fimc_out_stat *stat;
+	u64 fps = 0, hw_fps = 0;
+	s64 elapsed;
+
+	ctrl = get_fimc_ctrl(to_platform_device(dev)->id);
+	stat = &ctrl->stat;
+
+	/* frames per second in hundredths */
+	elapsed = ktime_us_delta(stat->last, stat->first);
+	if (stat->frames && elapsed > 0)
+		fps = div64_u64((u64)stat->frames * 100000000, elapsed);
+	if (stat->frames && stat->busy_us > 0)
+		hw_fps = div64_u64((u64)stat->frames * 100000000,
+					stat->busy_us);
+
+	return sprintf(buf, "src %ux%u %c%c%c%c, dst %ux%u, rotate %u\n"
+			"frames %u, %llu.%02llu fps, hw %llu.%02llu fps\n"
+			"bench %u\n",
+			stat->src_width, stat->src_height,
+			stat->src_format & 0xff,
+			(stat->src_format >> 8) & 0xff,
+			(stat->src_format >> 16) & 0xff,
+			(stat->src_format >> 24) & 0xff,
+			stat->dst_width, stat->dst_height, stat->rotate,
+			stat->frames,
+			div64_u64(fps, 100), fps - div64_u64(fps, 100) * 100,
+			div64_u64(hw_fps, 100),
+			hw_fps - div64_u64(hw_fps, 100) * 100,
+			stat->bench);
+}
+
+/*
+ * Writing N makes the output DMA loop every queued frame until N frames
+ * have run, without returning them to userspace; 0 only clears the stats.
+ */
+static ssize_t fimc_store_bench(struct device *dev,
+		struct device_attribute *attr, const char *buf, size_t len)
+{
+	struct fimc_control *ctrl;
+	unsigned long flags;
+
+	ctrl = get_fimc_ctrl(to_platform_device(dev)->id);
+
+	local_irq_save(flags);
+	ctrl->stat.bench = simple_strtoul(buf, NULL, 0);
+	ctrl->stat.frames = 0;
+	ctrl->stat.busy_us = 0;
+	ctrl->stat.first.tv64 = 0;
+	ctrl->stat.last.tv64 = 0;
+	local_irq_restore(flags);
+
+	return len;
+}
+
+static DEVICE_ATTR(bench, 0644, fimc_show_bench, fimc_store_bench);
+
 static int __devinit fimc_probe(struct platform_device *pdev)
 {
 	struct s3c_platform_fimc *pdata;
@@ -1083,6 +1387,10 @@ static int __devinit fimc_probe(struct platform_device *pdev)
 	ret = device_create_file(&(pdev->dev), &dev_attr_log_level);
 	if (ret < 0)
 		fimc_err("failed to add sysfs entries\n");
+
+	ret = device_create_file(&(pdev->dev), &dev_attr_bench);
+	if (ret < 0)
+		fimc_err("failed to add sysfs entries\n");
 #if (defined(CONFIG_VIDEO_FIMC_DMA_AUTO) && defined(CONFIG_CPU_S5PC110))
         fimc_hwset_clksrc(ctrl,FIMC_HCLK);
 #elif (defined(CONFIG_VIDEO_FIMC_FIFO) && defined(CONFIG_CPU_S5PC110))
@@ -1113,6 +1421,7 @@ static int fimc_remove(struct platform_device *pdev)
 	fimc_unregister_controller(pdev);
 
 	device_remove_file(&(pdev->dev), &dev_attr_log_level);
+	device_remove_file(&(pdev->dev), &dev_attr_bench);
 
 	if (fimc_dev) {
 		kfree(fimc_dev);
@@ -1194,7 +1503,11 @@ int fimc_suspend(struct platform_device *pdev, pm_message_t state)
 	ctrl = get_fimc_ctrl(id);
 	pdata = to_fimc_plat(ctrl->dev);
 
-	if (ctrl->out)
+	fimc_m2m_suspend(ctrl);
+
+	if (fimc_m2m_owns(ctrl))
+		ctrl->status = FIMC_OFF_SLEEP;
+	else if (ctrl->out)
 		fimc_suspend_out(ctrl);
 
 	else if (ctrl->cap)
@@ -1315,7 +1628,9 @@ int fimc_resume(struct platform_device *pdev)
 	if (pdata->clk_on)
 		pdata->clk_on(pdev, ctrl->clk);
 
-	if (ctrl->out)
+	if (fimc_m2m_owns(ctrl))
+		ctrl->status = FIMC_STREAMOFF;
+	else if (ctrl->out)
 		fimc_resume_out(ctrl);
 
 	else if (ctrl->cap)
@@ -1323,6 +1638,8 @@ int fimc_resume(struct platform_device *pdev)
 	else
 		ctrl->status = FIMC_STREAMOFF;
 
+	fimc_m2m_resume(ctrl);
+
 	return 0;
 }
 #else
@@ -1345,11 +1662,15 @@ static int fimc_register(void)
 {
 	platform_driver_register(&fimc_driver);
 
+	if (fimc_m2m_init())
+		printk(KERN_ERR FIMC_NAME ": cannot register m2m device\n");
+
 	return 0;
 }
 
 static void fimc_unregister(void)
 {
+	fimc_m2m_exit();
 	platform_driver_unregister(&fimc_driver);
 }
 
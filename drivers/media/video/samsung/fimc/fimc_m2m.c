@@ -0,0 +1,738 @@
+/* linux/drivers/media/video/samsung/fimc/fimc_m2m.c
+ *
+ * Memory to memory device for Samsung Camera Interface (FIMC) driver
+ *
+ * Any number of file handles share the FIMC controllers. Each handle keeps
+ * its own conversion setup and queue of jobs; the scheduler takes one job
+ * per handle in turn, runs it on whichever controller is idle and switches
+ * the controller registers when the job belongs to another handle.
+ *
+ * Copyright (c) 2010 Samsung Electronics
+ * 	http://www.samsungsemi.com/
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+*/
+
+#include <linux/module.h>
+#include <linux/kernel.h>
+#include <linux/errno.h>
+#include <linux/fs.h>
+#include <linux/miscdevice.h>
+#include <linux/mutex.h>
+#include <linux/poll.h>
+#include <linux/sched.h>
+#include <linux/slab.h>
+#include <linux/spinlock.h>
+#include <linux/timer.h>
+#include <linux/uaccess.h>
+#include <linux/wait.h>
+#include <linux/workqueue.h>
+#include <plat/fimc.h>
+
+#include "fimc.h"
+#include "fimc_m2m.h"
+
+#define FIMC_M2M_TIMEOUT	msecs_to_jiffies(FIMC_ONESHOT_TIMEOUT)
+
+static unsigned int m2m_mask = (1 << FIMC_DEVICES) - 1;
+module_param(m2m_mask, uint, 0644);
+MODULE_PARM_DESC(m2m_mask, "FIMC controllers the m2m device may use");
+
+struct fimc_m2m_ctx;
+
+struct fimc_m2m_req {
+	struct list_head	list;
+	struct fimc_m2m_ctx	*ctx;
+	struct fimc_buf_set	src;
+	struct fimc_buf_set	dst;
+	u32			seq;
+	int			status;		/* -EINPROGRESS until done */
+	int			fimc;
+	unsigned long		start;
+	struct timeval		timestamp;
+};
+
+struct fimc_m2m_ctx {
+	struct list_head	node;		/* on fimc_m2m.ready */
+	struct list_head	pending;
+	struct list_head	done;
+	int			queued;		/* pending, running and done */
+	int			running;
+	u32			id;
+	u32			gen;		/* bumped on every setup */
+	int			has_param;
+	struct fimc_outinfo	out;		/* register state of the jobs */
+	struct mutex		lock;
+	wait_queue_head_t	wait;
+};
+
+static struct fimc_m2m_dev {
+	spinlock_t		lock;
+	struct mutex		mutex;		/* scheduler against pm */
+	struct list_head	ready;		/* contexts with pending jobs */
+	struct fimc_m2m_req	*running[FIMC_DEVICES];
+	int			owned[FIMC_DEVICES];
+	int			suspended[FIMC_DEVICES];
+	u32			last_id[FIMC_DEVICES];
+	u32			last_gen[FIMC_DEVICES];
+	u32			ctx_id;
+	u32			seq;
+	struct workqueue_struct	*wq;
+	struct work_struct	work;
+	struct timer_list	timer;
+	wait_queue_head_t	idle;
+} fimc_m2m;
+
+static struct fimc_control *fimc_m2m_ctrl(int id)
+{
+	struct fimc_control *ctrl;
+
+	if (!fimc_dev || !(m2m_mask & (1 << id)))
+		return NULL;
+
+	ctrl = get_fimc_ctrl(id);
+	if (!ctrl->dev)
+		return NULL;
+
+	return ctrl;
+}
+
+/* take an unused controller, as fimc_open() would */
+static int fimc_m2m_claim(struct fimc_control *ctrl)
+{
+	struct s3c_platform_fimc *pdata = to_fimc_plat(ctrl->dev);
+
+	if (atomic_cmpxchg(&ctrl->in_use, 0, 1) != 0)
+		return -EBUSY;
+
+	if (pdata->clk_on)
+		pdata->clk_on(to_platform_device(ctrl->dev), ctrl->clk);
+
+	fimc_hwset_reset(ctrl);
+	ctrl->status = FIMC_STREAMOFF;
+
+	fimc_m2m.owned[ctrl->id] = 1;
+	fimc_m2m.last_id[ctrl->id] = 0;
+
+	return 0;
+}
+
+static void fimc_m2m_release(struct fimc_control *ctrl)
+{
+	struct s3c_platform_fimc *pdata = to_fimc_plat(ctrl->dev);
+
+	ctrl->out = NULL;
+	fimc_m2m.owned[ctrl->id] = 0;
+
+	if (pdata->clk_off)
+		pdata->clk_off(to_platform_device(ctrl->dev), ctrl->clk);
+
+	atomic_dec(&ctrl->in_use);
+}
+
+static void fimc_m2m_stop(struct fimc_control *ctrl)
+{
+	fimc_hwset_stop_input_dma(ctrl);
+	fimc_hwset_stop_scaler(ctrl);
+	fimc_hwset_disable_capture(ctrl);
+	fimc_hwset_reset(ctrl);
+
+	ctrl->status = FIMC_STREAMOFF;
+	fimc_m2m.last_id[ctrl->id] = 0;
+}
+
+/* round robin: the first context without a running job gives one */
+static struct fimc_m2m_req *fimc_m2m_next(void)
+{
+	struct fimc_m2m_ctx *ctx;
+	struct fimc_m2m_req *req = NULL;
+	unsigned long flags;
+
+	spin_lock_irqsave(&fimc_m2m.lock, flags);
+
+	list_for_each_entry(ctx, &fimc_m2m.ready, node) {
+		if (ctx->running)
+			continue;
+
+		req = list_first_entry(&ctx->pending, struct fimc_m2m_req,
+					list);
+		list_del(&req->list);
+		ctx->running = 1;
+
+		if (list_empty(&ctx->pending))
+			list_del_init(&ctx->node);
+		else
+			list_move_tail(&ctx->node, &fimc_m2m.ready);
+		break;
+	}
+
+	spin_unlock_irqrestore(&fimc_m2m.lock, flags);
+
+	return req;
+}
+
+static int fimc_m2m_has_work(void)
+{
+	struct fimc_m2m_ctx *ctx;
+	unsigned long flags;
+	int ret = 0;
+
+	spin_lock_irqsave(&fimc_m2m.lock, flags);
+
+	list_for_each_entry(ctx, &fimc_m2m.ready, node) {
+		if (!ctx->running) {
+			ret = 1;
+			break;
+		}
+	}
+
+	spin_unlock_irqrestore(&fimc_m2m.lock, flags);
+
+	return ret;
+}
+
+static void fimc_m2m_retire(struct fimc_m2m_req *req)
+{
+	struct fimc_m2m_ctx *ctx = req->ctx;
+	unsigned long flags;
+
+	spin_lock_irqsave(&fimc_m2m.lock, flags);
+
+	if (req->fimc >= 0 && fimc_m2m.running[req->fimc] == req)
+		fimc_m2m.running[req->fimc] = NULL;
+
+	ctx->running = 0;
+	list_add_tail(&req->list, &ctx->done);
+
+	/* under the lock, release frees ctx once it has seen !running */
+	wake_up(&ctx->wait);
+
+	spin_unlock_irqrestore(&fimc_m2m.lock, flags);
+}
+
+static int fimc_m2m_start(struct fimc_control *ctrl, struct fimc_m2m_req *req)
+{
+	struct fimc_m2m_ctx *ctx = req->ctx;
+	unsigned long flags;
+	int i, ret;
+
+	req->fimc = ctrl->id;
+	ctrl->out = &ctx->out;
+
+	/* switch the controller to the setup of this context */
+	if (fimc_m2m.last_id[ctrl->id] != ctx->id ||
+	    fimc_m2m.last_gen[ctrl->id] != ctx->gen) {
+		ctrl->status = FIMC_STREAMOFF;
+
+		ret = fimc_outdev_check_param(ctrl);
+		if (!ret)
+			ret = fimc_outdev_set_param(ctrl);
+		if (ret < 0) {
+			fimc_m2m.last_id[ctrl->id] = 0;
+			ctrl->out = NULL;
+			return ret;
+		}
+
+		fimc_m2m.last_id[ctrl->id] = ctx->id;
+		fimc_m2m.last_gen[ctrl->id] = ctx->gen;
+	}
+
+	fimc_outdev_set_src_addr(ctrl, req->src.base);
+	for (i = 0; i < FIMC_PHYBUFS; i++)
+		fimc_hwset_output_address(ctrl, &req->dst, i);
+
+	spin_lock_irqsave(&fimc_m2m.lock, flags);
+	req->start = jiffies;
+	fimc_m2m.running[ctrl->id] = req;
+	spin_unlock_irqrestore(&fimc_m2m.lock, flags);
+
+	ctrl->status = FIMC_STREAMON;
+
+	return fimc_outdev_start_camif(ctrl);
+}
+
+static void fimc_m2m_work(struct work_struct *work)
+{
+	struct fimc_control *ctrl;
+	struct fimc_m2m_req *req;
+	unsigned long flags;
+	int i, ret, busy = 0;
+
+	mutex_lock(&fimc_m2m.mutex);
+
+	/* retire finished and stuck jobs */
+	for (i = 0; i < FIMC_DEVICES; i++) {
+		req = fimc_m2m.running[i];
+		if (!req)
+			continue;
+
+		ctrl = get_fimc_ctrl(i);
+
+		spin_lock_irqsave(&fimc_m2m.lock, flags);
+		if (req->status == -EINPROGRESS &&
+		    time_after(jiffies, req->start + FIMC_M2M_TIMEOUT))
+			req->status = -ETIMEDOUT;
+		spin_unlock_irqrestore(&fimc_m2m.lock, flags);
+
+		if (req->status == -EINPROGRESS)
+			continue;
+
+		if (req->status == -ETIMEDOUT) {
+			fimc_err("%s: job %u timed out\n", __func__, req->seq);
+			fimc_m2m_stop(ctrl);
+		}
+
+		ctrl->out = NULL;
+		fimc_m2m_retire(req);
+	}
+
+	/* hand queued jobs to idle controllers */
+	for (i = 0; i < FIMC_DEVICES; i++) {
+		if (fimc_m2m.running[i] || fimc_m2m.suspended[i])
+			continue;
+
+		ctrl = fimc_m2m_ctrl(i);
+		if (!ctrl || !fimc_m2m_has_work())
+			continue;
+
+		if (!fimc_m2m.owned[i] && fimc_m2m_claim(ctrl))
+			continue;
+
+		req = fimc_m2m_next();
+		if (!req)
+			break;
+
+		ret = fimc_m2m_start(ctrl, req);
+		if (ret < 0) {
+			req->status = ret;
+			fimc_m2m_retire(req);
+		}
+	}
+
+	/* give back controllers nobody waits for */
+	for (i = 0; i < FIMC_DEVICES; i++) {
+		if (fimc_m2m.running[i]) {
+			busy = 1;
+			continue;
+		}
+
+		if (fimc_m2m.owned[i] && !fimc_m2m.suspended[i] &&
+		    !fimc_m2m_has_work())
+			fimc_m2m_release(get_fimc_ctrl(i));
+	}
+
+	if (busy)
+		mod_timer(&fimc_m2m.timer, jiffies + FIMC_M2M_TIMEOUT);
+	else
+		del_timer(&fimc_m2m.timer);
+
+	mutex_unlock(&fimc_m2m.mutex);
+
+	wake_up(&fimc_m2m.idle);
+}
+
+static void fimc_m2m_timeout(unsigned long data)
+{
+	queue_work(fimc_m2m.wq, &fimc_m2m.work);
+}
+
+/* called from fimc_irq(), returns 1 when the controller runs m2m jobs */
+int fimc_m2m_irq(struct fimc_control *ctrl)
+{
+	struct fimc_m2m_req *req;
+	unsigned long flags;
+
+	if (!fimc_m2m.owned[ctrl->id])
+		return 0;
+
+	fimc_hwset_clear_irq(ctrl);
+
+	spin_lock_irqsave(&fimc_m2m.lock, flags);
+	req = fimc_m2m.running[ctrl->id];
+	if (req && req->status == -EINPROGRESS) {
+		do_gettimeofday(&req->timestamp);
+		req->status = 0;
+	}
+	spin_unlock_irqrestore(&fimc_m2m.lock, flags);
+
+	queue_work(fimc_m2m.wq, &fimc_m2m.work);
+
+	return 1;
+}
+
+int fimc_m2m_owns(struct fimc_control *ctrl)
+{
+	return fimc_m2m.owned[ctrl->id];
+}
+
+void fimc_m2m_suspend(struct fimc_control *ctrl)
+{
+	mutex_lock(&fimc_m2m.mutex);
+	fimc_m2m.suspended[ctrl->id] = 1;
+	mutex_unlock(&fimc_m2m.mutex);
+
+	/* a stuck job is retired by the timer */
+	wait_event_timeout(fimc_m2m.idle, !fimc_m2m.running[ctrl->id],
+				2 * FIMC_M2M_TIMEOUT);
+}
+
+void fimc_m2m_resume(struct fimc_control *ctrl)
+{
+	mutex_lock(&fimc_m2m.mutex);
+
+	fimc_m2m.suspended[ctrl->id] = 0;
+	if (fimc_m2m.owned[ctrl->id]) {
+		fimc_hwset_reset(ctrl);
+		ctrl->status = FIMC_STREAMOFF;
+		fimc_m2m.last_id[ctrl->id] = 0;
+	}
+
+	mutex_unlock(&fimc_m2m.mutex);
+
+	queue_work(fimc_m2m.wq, &fimc_m2m.work);
+}
+
+static int fimc_m2m_set_param(struct fimc_m2m_ctx *ctx,
+			      struct fimc_m2m_param *param)
+{
+	struct fimc_outinfo *out = &ctx->out;
+	struct v4l2_rect *crop = &param->crop;
+	struct v4l2_rect *win = &param->win;
+	unsigned long flags;
+	int busy;
+
+	switch (param->rotate) {
+	case 0:		/* fall through */
+	case 90:	/* fall through */
+	case 180:	/* fall through */
+	case 270:
+		break;
+	default:
+		return -EINVAL;
+	}
+
+	if (param->flip && param->flip != V4L2_CID_HFLIP &&
+	    param->flip != V4L2_CID_VFLIP)
+		return -EINVAL;
+
+	if (crop->left < 0 || crop->top < 0 || !crop->width || !crop->height ||
+	    crop->left + crop->width > param->src.width ||
+	    crop->top + crop->height > param->src.height)
+		return -EINVAL;
+
+	if (win->left < 0 || win->top < 0 || !win->width || !win->height)
+		return -EINVAL;
+
+	spin_lock_irqsave(&fimc_m2m.lock, flags);
+	busy = !list_empty(&ctx->pending) || ctx->running;
+	spin_unlock_irqrestore(&fimc_m2m.lock, flags);
+
+	/* queued jobs were checked against the old setup */
+	if (busy)
+		return -EBUSY;
+
+	memset(out, 0, sizeof(*out));
+	out->pix.width = param->src.width;
+	out->pix.height = param->src.height;
+	out->pix.pixelformat = param->src.pixelformat;
+	out->pix.field = V4L2_FIELD_NONE;
+	out->crop = *crop;
+	out->win.w = *win;
+	out->fbuf.fmt.width = param->dst.width;
+	out->fbuf.fmt.height = param->dst.height;
+	out->fbuf.fmt.pixelformat = param->dst.pixelformat;
+	out->rotate = param->rotate;
+	out->flip = param->flip;
+	out->overlay.mode = FIMC_OVERLAY_NONE;
+
+	if (!fimc_outdev_src_size(out) || !fimc_outdev_none_dst_size(out)) {
+		ctx->has_param = 0;
+		return -EINVAL;
+	}
+
+	ctx->gen++;
+	ctx->has_param = 1;
+
+	return 0;
+}
+
+static int fimc_m2m_get_buf(unsigned long userptr, size_t len,
+			    struct fimc_buf_set *bs, struct fimc_outinfo *out,
+			    int is_dst)
+{
+	dma_addr_t paddr;
+	int ret;
+
+	/* the files are held until the request is freed */
+	ret = fimc_get_userptr(userptr, len, &paddr, &bs->file);
+	if (ret < 0)
+		return ret;
+
+	if (is_dst)
+		return fimc_outdev_fill_none_dst(out, bs, paddr);
+
+	fimc_outdev_fill_src(out, bs, paddr);
+
+	return 0;
+}
+
+static void fimc_m2m_free_req(struct fimc_m2m_req *req)
+{
+	fimc_put_userptr(&req->src);
+	fimc_put_userptr(&req->dst);
+	kfree(req);
+}
+
+static int fimc_m2m_queue(struct fimc_m2m_ctx *ctx, struct fimc_m2m_job *job)
+{
+	struct fimc_m2m_req *req;
+	unsigned long flags;
+	int ret;
+
+	if (!ctx->has_param)
+		return -EINVAL;
+
+	if (ctx->queued >= FIMC_M2M_QUEUE_MAX)
+		return -EBUSY;
+
+	req = kzalloc(sizeof(*req), GFP_KERNEL);
+	if (!req)
+		return -ENOMEM;
+
+	ret = fimc_m2m_get_buf(job->src, fimc_outdev_src_size(&ctx->out),
+				&req->src, &ctx->out, 0);
+	if (!ret)
+		ret = fimc_m2m_get_buf(job->dst,
+				fimc_outdev_none_dst_size(&ctx->out),
+				&req->dst, &ctx->out, 1);
+	if (ret < 0) {
+		fimc_m2m_free_req(req);
+		return ret;
+	}
+
+	req->ctx = ctx;
+	req->status = -EINPROGRESS;
+	req->fimc = -1;
+
+	spin_lock_irqsave(&fimc_m2m.lock, flags);
+
+	req->seq = ++fimc_m2m.seq;
+	list_add_tail(&req->list, &ctx->pending);
+	if (list_empty(&ctx->node))
+		list_add_tail(&ctx->node, &fimc_m2m.ready);
+	ctx->queued++;
+
+	spin_unlock_irqrestore(&fimc_m2m.lock, flags);
+
+	job->seq = req->seq;
+
+	queue_work(fimc_m2m.wq, &fimc_m2m.work);
+
+	return 0;
+}
+
+static int fimc_m2m_dequeue(struct fimc_m2m_ctx *ctx, struct fimc_m2m_job *job,
+			    int nonblock)
+{
+	struct fimc_m2m_req *req = NULL;
+	unsigned long flags;
+	int ret;
+
+	if (!ctx->queued)
+		return -EINVAL;
+
+	if (list_empty(&ctx->done)) {
+		if (nonblock)
+			return -EAGAIN;
+
+		ret = wait_event_interruptible(ctx->wait,
+						!list_empty(&ctx->done));
+		if (ret)
+			return ret;
+	}
+
+	spin_lock_irqsave(&fimc_m2m.lock, flags);
+	if (!list_empty(&ctx->done)) {
+		req = list_first_entry(&ctx->done, struct fimc_m2m_req, list);
+		list_del(&req->list);
+		ctx->queued--;
+	}
+	spin_unlock_irqrestore(&fimc_m2m.lock, flags);
+
+	if (!req)
+		return -EAGAIN;
+
+	job->seq = req->seq;
+	job->status = req->status;
+	job->timestamp = req->timestamp;
+	job->fimc = req->fimc;
+
+	fimc_m2m_free_req(req);
+
+	return 0;
+}
+
+static int fimc_m2m_open(struct inode *inode, struct file *file)
+{
+	struct fimc_m2m_ctx *ctx;
+	unsigned long flags;
+
+	ctx = kzalloc(sizeof(*ctx), GFP_KERNEL);
+	if (!ctx)
+		return -ENOMEM;
+
+	INIT_LIST_HEAD(&ctx->node);
+	INIT_LIST_HEAD(&ctx->pending);
+	INIT_LIST_HEAD(&ctx->done);
+	mutex_init(&ctx->lock);
+	init_waitqueue_head(&ctx->wait);
+
+	spin_lock_irqsave(&fimc_m2m.lock, flags);
+	if (!++fimc_m2m.ctx_id)
+		++fimc_m2m.ctx_id;
+	ctx->id = fimc_m2m.ctx_id;
+	spin_unlock_irqrestore(&fimc_m2m.lock, flags);
+
+	file->private_data = ctx;
+
+	return 0;
+}
+
+static int fimc_m2m_release_file(struct inode *inode, struct file *file)
+{
+	struct fimc_m2m_ctx *ctx = file->private_data;
+	struct fimc_m2m_req *req, *tmp;
+	unsigned long flags;
+
+	spin_lock_irqsave(&fimc_m2m.lock, flags);
+	list_del_init(&ctx->node);
+	list_splice_init(&ctx->pending, &ctx->done);
+	spin_unlock_irqrestore(&fimc_m2m.lock, flags);
+
+	/* the running job still owns its controller */
+	wait_event(ctx->wait, !ctx->running);
+
+	/* fimc_m2m_retire may still be on its way out of ctx->wait */
+	spin_lock_irqsave(&fimc_m2m.lock, flags);
+	spin_unlock_irqrestore(&fimc_m2m.lock, flags);
+
+	list_for_each_entry_safe(req, tmp, &ctx->done, list) {
+		list_del(&req->list);
+		fimc_m2m_free_req(req);
+	}
+
+	kfree(ctx);
+
+	return 0;
+}
+
+static int fimc_m2m_ioctl(struct inode *inode, struct file *file,
+			  unsigned int cmd, unsigned long arg)
+{
+	struct fimc_m2m_ctx *ctx = file->private_data;
+	struct fimc_m2m_param param;
+	struct fimc_m2m_job job;
+	int ret;
+
+	switch (cmd) {
+	case FIMC_M2M_S_PARAM:
+		if (copy_from_user(&param, (void __user *)arg, sizeof(param)))
+			return -EFAULT;
+
+		mutex_lock(&ctx->lock);
+		ret = fimc_m2m_set_param(ctx, &param);
+		mutex_unlock(&ctx->lock);
+
+		return ret;
+
+	case FIMC_M2M_QUEUE:
+		if (copy_from_user(&job, (void __user *)arg, sizeof(job)))
+			return -EFAULT;
+
+		mutex_lock(&ctx->lock);
+		ret = fimc_m2m_queue(ctx, &job);
+		mutex_unlock(&ctx->lock);
+		if (ret < 0)
+			return ret;
+
+		break;
+
+	case FIMC_M2M_DEQUEUE:
+		ret = fimc_m2m_dequeue(ctx, &job, file->f_flags & O_NONBLOCK);
+		if (ret < 0)
+			return ret;
+
+		break;
+
+	default:
+		return -ENOTTY;
+	}
+
+	if (copy_to_user((void __user *)arg, &job, sizeof(job)))
+		return -EFAULT;
+
+	return 0;
+}
+
+static unsigned int fimc_m2m_poll(struct file *file, poll_table *wait)
+{
+	struct fimc_m2m_ctx *ctx = file->private_data;
+	unsigned int mask = 0;
+
+	poll_wait(file, &ctx->wait, wait);
+
+	if (!list_empty(&ctx->done))
+		mask |= POLLIN | POLLRDNORM;
+
+	if (ctx->queued < FIMC_M2M_QUEUE_MAX)
+		mask |= POLLOUT | POLLWRNORM;
+
+	return mask;
+}
+
+static const struct file_operations fimc_m2m_fops = {
+	.owner		= THIS_MODULE,
+	.open		= fimc_m2m_open,
+	.release	= fimc_m2m_release_file,
+	.ioctl		= fimc_m2m_ioctl,
+	.poll		= fimc_m2m_poll,
+};
+
+static struct miscdevice fimc_m2m_misc = {
+	.minor		= MISC_DYNAMIC_MINOR,
+	.name		= FIMC_M2M_NAME,
+	.fops		= &fimc_m2m_fops,
+};
+
+int fimc_m2m_init(void)
+{
+	int ret;
+
+	spin_lock_init(&fimc_m2m.lock);
+	mutex_init(&fimc_m2m.mutex);
+	INIT_LIST_HEAD(&fimc_m2m.ready);
+	INIT_WORK(&fimc_m2m.work, fimc_m2m_work);
+	setup_timer(&fimc_m2m.timer, fimc_m2m_timeout, 0);
+	init_waitqueue_head(&fimc_m2m.idle);
+
+	fimc_m2m.wq = create_singlethread_workqueue("fimc-m2m");
+	if (!fimc_m2m.wq)
+		return -ENOMEM;
+
+	ret = misc_register(&fimc_m2m_misc);
+	if (ret) {
+		destroy_workqueue(fimc_m2m.wq);
+		return ret;
+	}
+
+	return 0;
+}
+
+void fimc_m2m_exit(void)
+{
+	misc_deregister(&fimc_m2m_misc);
+	del_timer_sync(&fimc_m2m.timer);
+	destroy_workqueue(fimc_m2m.wq);
+}
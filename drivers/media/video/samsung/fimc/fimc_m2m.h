@@ -0,0 +1,64 @@
+/* linux/drivers/media/video/samsung/fimc/fimc_m2m.h
+ *
+ * Memory to memory interface shared by the Samsung FIMC controllers
+ *
+ * Copyright (c) 2010 Samsung Electronics
+ * 	http://www.samsungsemi.com/
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+*/
+
+#ifndef _FIMC_M2M_H
+#define _FIMC_M2M_H
+
+#include <linux/types.h>
+#include <linux/time.h>
+#include <linux/videodev2.h>
+
+#define FIMC_M2M_NAME		"s3c-fimc-m2m"
+#define FIMC_M2M_QUEUE_MAX	8
+
+/*
+ * Conversion done by every job of a file handle.
+ *
+ * src:		width, height and pixelformat of the source frame
+ * crop:	part of the source to convert
+ * dst:		width, height and pixelformat of the destination frame
+ *		(V4L2_PIX_FMT_RGB32, V4L2_PIX_FMT_YUV420 or V4L2_PIX_FMT_NV12)
+ * win:		where the result is written in the destination
+ * rotate:	0, 90, 180 or 270
+ * flip:	0, V4L2_CID_HFLIP or V4L2_CID_VFLIP
+ */
+struct fimc_m2m_param {
+	struct v4l2_pix_format	src;
+	struct v4l2_rect	crop;
+	struct v4l2_pix_format	dst;
+	struct v4l2_rect	win;
+	__u32			rotate;
+	__u32			flip;
+};
+
+/*
+ * src and dst are taken like V4L2_MEMORY_USERPTR buffers of the output
+ * device: a pointer into an mmap of MFC, JPEG, the frame buffer or a FIMC
+ * node.
+ *
+ * seq is returned by FIMC_M2M_QUEUE; status (0 or -errno), timestamp of
+ * completion and the controller that ran the job by FIMC_M2M_DEQUEUE.
+ */
+struct fimc_m2m_job {
+	unsigned long		src;
+	unsigned long		dst;
+	__u32			seq;
+	__s32			status;
+	struct timeval		timestamp;
+	__u32			fimc;
+};
+
+#define FIMC_M2M_S_PARAM	_IOW('C', 1, struct fimc_m2m_param)
+#define FIMC_M2M_QUEUE		_IOWR('C', 2, struct fimc_m2m_job)
+#define FIMC_M2M_DEQUEUE	_IOWR('C', 3, struct fimc_m2m_job)
+
+#endif /* _FIMC_M2M_H */
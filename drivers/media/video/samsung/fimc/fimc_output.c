@@ -46,6 +46,34 @@ int fimc_outdev_start_camif(void *param)
 	return 0;
 }
 
+/*
+ * Program the source and destination of frame index and start the one-shot
+ * input DMA. Called from qbuf when the scaler is idle and from the interrupt
+ * to chain the next queued frame.
+ */
+int fimc_outdev_run(struct fimc_control *ctrl, int index)
+{
+	struct fimc_buf_set buf_set;
+	int i;
+
+	fimc_outdev_set_src_addr(ctrl, ctrl->out->src[index].base);
+
+	memset(&buf_set, 0x00, sizeof(buf_set));
+	buf_set.base[FIMC_ADDR_Y] = ctrl->out->dst[index].base[FIMC_ADDR_Y];
+
+	for (i = 0; i < FIMC_PHYBUFS; i++)
+		fimc_hwset_output_address(ctrl, &buf_set, i);
+
+	ctrl->out->idx.active = index;
+	ctrl->status = FIMC_STREAMON;
+
+	ctrl->stat.start = ktime_get();
+	if (!ctrl->stat.first.tv64)
+		ctrl->stat.first = ctrl->stat.start;
+
+	return fimc_outdev_start_camif(ctrl);
+}
+
 static int fimc_outdev_stop_camif(void *param)
 {
 	struct fimc_control *ctrl = (struct fimc_control *)param;
@@ -266,6 +294,7 @@ static void fimc_init_out_buf(struct fimc_control *ctrl)
 	int i;
 
 	for (i = 0; i < FIMC_OUTBUFS; i++) {
+		fimc_put_userptr(&ctrl->out->src[i]);
 		ctrl->out->src[i].state = VIDEOBUF_IDLE;
 		ctrl->out->src[i].flags = 0x0;
 
@@ -274,107 +303,102 @@ static void fimc_init_out_buf(struct fimc_control *ctrl)
 	}
 }
 
-static 
-int fimc_outdev_set_src_buf(struct fimc_control *ctrl)
+u32 fimc_outdev_src_size(struct fimc_outinfo *out)
 {
-	u32 width = ctrl->out->pix.width; 
-	u32 height = ctrl->out->pix.height;
-	u32 format = ctrl->out->pix.pixelformat;
+	u32 width = out->pix.width; 
+	u32 height = out->pix.height;
 	u32 y_size = width * height;
 	u32 c_size = (width * height >> 1) + (width * height >> 4);
-	u32 uv_size = (width * height >> 1);
-	u32 cb_size = (width * height >> 2);
-	u32 cr_size = (width * height >> 2);
-	u32 i, size;
-	dma_addr_t *curr = &ctrl->mem.curr;
 
-	switch (format) {
+	switch (out->pix.pixelformat) {
 	case V4L2_PIX_FMT_RGB32:
-		size = PAGE_ALIGN(width * height * 4);
-		break;
+		return PAGE_ALIGN(width * height * 4);
 	case V4L2_PIX_FMT_YUV420:	/* fall through */
 	case V4L2_PIX_FMT_NV12:		/* fall through */
-		size = PAGE_ALIGN((width * height) + (width * height >> 1));
-		break;
+		return PAGE_ALIGN((width * height) + (width * height >> 1));
 	case V4L2_PIX_FMT_YUYV:		/* fall through */
 	case V4L2_PIX_FMT_UYVY:		/* fall through */
 	case V4L2_PIX_FMT_RGB565:	/* fall through */
-		size = PAGE_ALIGN(width * height * 2);
-		break;
+		return PAGE_ALIGN(width * height * 2);
 	case V4L2_PIX_FMT_NV12T:
-		size = PAGE_ALIGN(y_size + c_size);
-		break;
-
+		return PAGE_ALIGN(y_size + c_size);
 	default: 
-		fimc_err("%s: Invalid pixelformt : %d\n", __func__, format);
-		return -EINVAL;
+		return 0;
 	}
+}
 
-	if ((size * FIMC_OUTBUFS) > ctrl->mem.size) {
-		fimc_err("Reserved memory is not sufficient\n");
-		return -EINVAL;
-	}
+/* split one contiguous source frame at base into its planes */
+void fimc_outdev_fill_src(struct fimc_outinfo *out, struct fimc_buf_set *bs,
+			  dma_addr_t base)
+{
+	u32 width = out->pix.width; 
+	u32 height = out->pix.height;
+	u32 y_size = width * height;
+	u32 c_size = (width * height >> 1) + (width * height >> 4);
+	u32 uv_size = (width * height >> 1);
+	u32 cb_size = (width * height >> 2);
+	u32 cr_size = (width * height >> 2);
 
-	/* Initialize source buffer addr */
-	switch (format) {
+	bs->base[FIMC_ADDR_Y] = base;
+	bs->base[FIMC_ADDR_CB] = 0;
+	bs->base[FIMC_ADDR_CR] = 0;
+	bs->length[FIMC_ADDR_CB] = 0;
+	bs->length[FIMC_ADDR_CR] = 0;
+
+	switch (out->pix.pixelformat) {
 	case V4L2_PIX_FMT_YUYV:		/* fall through */
 	case V4L2_PIX_FMT_UYVY:		/* fall through */
 	case V4L2_PIX_FMT_RGB565:	/* fall through */
 	case V4L2_PIX_FMT_RGB32:
-		for (i = 0; i < FIMC_OUTBUFS; i++) {
-			ctrl->out->src[i].base[FIMC_ADDR_Y] = *curr;
-			ctrl->out->src[i].length[FIMC_ADDR_Y] = size;
-			ctrl->out->src[i].base[FIMC_ADDR_CB] = 0;
-			ctrl->out->src[i].length[FIMC_ADDR_CB] = 0;
-			ctrl->out->src[i].base[FIMC_ADDR_CR] = 0;
-			ctrl->out->src[i].length[FIMC_ADDR_CR] = 0;
-			*curr += size;
-		}
-
+		bs->length[FIMC_ADDR_Y] = fimc_outdev_src_size(out);
 		break;
-	case V4L2_PIX_FMT_NV12:		/* fall through */
-		for (i = 0; i < FIMC_OUTBUFS; i++) {
-			ctrl->out->src[i].base[FIMC_ADDR_Y] = *curr;
-			ctrl->out->src[i].base[FIMC_ADDR_CB] = *curr + y_size;
-			ctrl->out->src[i].length[FIMC_ADDR_Y] = y_size;
-			ctrl->out->src[i].length[FIMC_ADDR_CB] = uv_size;
-			ctrl->out->src[i].base[FIMC_ADDR_CR] = 0;
-			ctrl->out->src[i].length[FIMC_ADDR_CR] = 0;
-			*curr += size;
-		}
 
+	case V4L2_PIX_FMT_NV12:
+		bs->base[FIMC_ADDR_CB] = base + y_size;
+		bs->length[FIMC_ADDR_Y] = y_size;
+		bs->length[FIMC_ADDR_CB] = uv_size;
 		break;
 
 	case V4L2_PIX_FMT_NV12T:
-		for (i = 0; i < FIMC_OUTBUFS; i++) {
-			ctrl->out->src[i].base[FIMC_ADDR_Y] = *curr;
-			ctrl->out->src[i].base[FIMC_ADDR_CB] = *curr + y_size;
-			ctrl->out->src[i].length[FIMC_ADDR_Y] = y_size;
-			ctrl->out->src[i].length[FIMC_ADDR_CB] = c_size;
-			ctrl->out->src[i].base[FIMC_ADDR_CR] = 0;
-			ctrl->out->src[i].length[FIMC_ADDR_CR] = 0;
-			*curr += size;
-		}
-
+		bs->base[FIMC_ADDR_CB] = base + y_size;
+		bs->length[FIMC_ADDR_Y] = y_size;
+		bs->length[FIMC_ADDR_CB] = c_size;
 		break;
-	case V4L2_PIX_FMT_YUV420:
-		for (i = 0; i < FIMC_OUTBUFS; i++) {
-			ctrl->out->src[i].base[FIMC_ADDR_Y] = *curr;
-			ctrl->out->src[i].base[FIMC_ADDR_CB] = *curr + y_size;
-			ctrl->out->src[i].base[FIMC_ADDR_CR] = *curr + y_size + cb_size;
-			ctrl->out->src[i].length[FIMC_ADDR_Y] = y_size;
-			ctrl->out->src[i].length[FIMC_ADDR_CB] = cb_size;
-			ctrl->out->src[i].length[FIMC_ADDR_CR] = cr_size;
-			*curr += size;
-		}
 
+	case V4L2_PIX_FMT_YUV420:
+		bs->base[FIMC_ADDR_CB] = base + y_size;
+		bs->base[FIMC_ADDR_CR] = base + y_size + cb_size;
+		bs->length[FIMC_ADDR_Y] = y_size;
+		bs->length[FIMC_ADDR_CB] = cb_size;
+		bs->length[FIMC_ADDR_CR] = cr_size;
 		break;
+	}
+}
 
-	default: 
+static 
+int fimc_outdev_set_src_buf(struct fimc_control *ctrl)
+{
+	u32 format = ctrl->out->pix.pixelformat;
+	u32 i, size;
+	dma_addr_t *curr = &ctrl->mem.curr;
+
+	size = fimc_outdev_src_size(ctrl->out);
+	if (!size) {
 		fimc_err("%s: Invalid pixelformt : %d\n", __func__, format);
 		return -EINVAL;
 	}
 
+	if ((size * FIMC_OUTBUFS) > ctrl->mem.size) {
+		fimc_err("Reserved memory is not sufficient\n");
+		return -EINVAL;
+	}
+
+	/* Initialize source buffer addr */
+	for (i = 0; i < FIMC_OUTBUFS; i++) {
+		fimc_outdev_fill_src(ctrl->out, &ctrl->out->src[i], *curr);
+		*curr += size;
+	}
+
 	return 0;
 }
 
@@ -428,7 +452,7 @@ static int fimc_set_rot_degree(struct fimc_control *ctrl, int degree)
 	return 0;
 }
 
-static int fimc_outdev_check_param(struct fimc_control *ctrl)
+int fimc_outdev_check_param(struct fimc_control *ctrl)
 {
 	struct v4l2_rect dst, bound;
 	u32 rot = 0;
@@ -1700,6 +1724,7 @@ int fimc_s_crop_output(void *fh, struct v4l2_crop *a)
 int fimc_streamon_output(void *fh)
 {
 	struct fimc_control *ctrl = (struct fimc_control *) fh;
+	u32 bench;
 	int ret = -1;
 	fimc_info1("%s: called\n", __func__);
 
@@ -1715,6 +1740,17 @@ int fimc_streamon_output(void *fh)
 		return ret;
 	}
 
+	bench = ctrl->stat.bench;
+	memset(&ctrl->stat, 0, sizeof(ctrl->stat));
+	ctrl->stat.bench = bench;
+	ctrl->stat.src_width = ctrl->out->pix.width;
+	ctrl->stat.src_height = ctrl->out->pix.height;
+	ctrl->stat.src_format = ctrl->out->pix.pixelformat;
+	ctrl->stat.dst_width = ctrl->out->win.w.width;
+	ctrl->stat.dst_height = ctrl->out->win.w.height;
+	ctrl->stat.rotate = ctrl->out->rotate;
+	ctrl->out->sequence = 0;
+
 	ctrl->status = FIMC_READY_ON;
 
 	return ret;
@@ -1748,6 +1784,7 @@ int fimc_streamoff_output(void *fh)
 
 	/* Make all buffers DQUEUED state. */
 	for (i = 0; i < FIMC_OUTBUFS; i++) {
+		fimc_put_userptr(&ctrl->out->src[i]);
 		ctrl->out->src[i].state	= VIDEOBUF_IDLE;
 		ctrl->out->src[i].flags = V4L2_BUF_FLAG_MAPPED;
 	}
@@ -1761,14 +1798,54 @@ int fimc_streamoff_output(void *fh)
 	return 0;
 }
 
+u32 fimc_outdev_none_dst_size(struct fimc_outinfo *out)
+{
+	u32 y_size = out->fbuf.fmt.width * out->fbuf.fmt.height;
+
+	switch (out->fbuf.fmt.pixelformat) {
+	case V4L2_PIX_FMT_RGB32:
+		return y_size << 2;
+	case V4L2_PIX_FMT_YUV420:	/* fall through */
+	case V4L2_PIX_FMT_NV12:
+		return y_size + (y_size >> 1);
+	default:
+		return 0;
+	}
+}
+
+/* split the destructive overlay target at base into its planes */
+int fimc_outdev_fill_none_dst(struct fimc_outinfo *out,
+			      struct fimc_buf_set *bs, dma_addr_t base)
+{
+	u32 format = out->fbuf.fmt.pixelformat;
+	u32 y_size = out->fbuf.fmt.width * out->fbuf.fmt.height;
+	u32 c_size = (y_size >> 2);
+
+	memset(bs->base, 0, sizeof(bs->base));
+
+	switch (format) {
+	case V4L2_PIX_FMT_RGB32:
+		bs->base[FIMC_ADDR_Y] = base;
+		break;
+	case V4L2_PIX_FMT_YUV420:
+		bs->base[FIMC_ADDR_Y] = base;
+		bs->base[FIMC_ADDR_CB] = bs->base[FIMC_ADDR_Y] + y_size;
+		bs->base[FIMC_ADDR_CR] = bs->base[FIMC_ADDR_CB] + c_size;
+		break;
+	case V4L2_PIX_FMT_NV12:
+		bs->base[FIMC_ADDR_Y] = base;
+		bs->base[FIMC_ADDR_CB] = bs->base[FIMC_ADDR_Y] + y_size;
+		break;
+	default: 
+		return -EINVAL;
+	}
+
+	return 0;
+}
+
 static int fimc_qbuf_output_none(struct fimc_control *ctrl)
 {
 	struct fimc_buf_set buf_set;
-	u32 format = ctrl->out->fbuf.fmt.pixelformat;
-	u32 width = ctrl->out->fbuf.fmt.width;
-	u32 height = ctrl->out->fbuf.fmt.height;
-	u32 y_size = width * height;
-	u32 c_size = (y_size >> 2);
 	u32 index = 0;
 	int ret = -1;
 	u32 i = 0;
@@ -1784,22 +1861,11 @@ static int fimc_qbuf_output_none(struct fimc_control *ctrl)
 		fimc_outdev_set_src_addr(ctrl, ctrl->out->src[index].base);
 
 		memset(&buf_set, 0x00, sizeof(buf_set));
-		
-		switch (format) {
-		case V4L2_PIX_FMT_RGB32:
-		buf_set.base[FIMC_ADDR_Y] = (dma_addr_t)ctrl->out->fbuf.base;
-			break;
-		case V4L2_PIX_FMT_YUV420:
-				buf_set.base[FIMC_ADDR_Y] = (dma_addr_t)ctrl->out->fbuf.base;
-				buf_set.base[FIMC_ADDR_CB] = buf_set.base[FIMC_ADDR_Y] + y_size;
-				buf_set.base[FIMC_ADDR_CR] = buf_set.base[FIMC_ADDR_CB] + c_size;
-			break;	
-		case V4L2_PIX_FMT_NV12:
-		buf_set.base[FIMC_ADDR_Y] = (dma_addr_t)ctrl->out->fbuf.base;
-				buf_set.base[FIMC_ADDR_CB] = buf_set.base[FIMC_ADDR_Y] + y_size;
-			break;
-		default: 
-			fimc_err("%s: Invalid pixelformt : %d\n", __func__, format);
+		ret = fimc_outdev_fill_none_dst(ctrl->out, &buf_set,
+					(dma_addr_t)ctrl->out->fbuf.base);
+		if (ret < 0) {
+			fimc_err("%s: Invalid pixelformt : %d\n", __func__,
+				ctrl->out->fbuf.fmt.pixelformat);
 			return -EINVAL;
 		}
 
@@ -1824,9 +1890,8 @@ static int fimc_qbuf_output_dma_auto(struct fimc_control *ctrl)
 	struct fb_var_screeninfo var;
 	struct s3cfb_user_window window;
 	struct v4l2_rect fimd_rect;
-	struct fimc_buf_set buf_set;
 
-	u32 index = 0, i = 0;
+	u32 index = 0;
 	u32 id = ctrl->id;
 	int ret = -1;
 
@@ -1891,23 +1956,12 @@ static int fimc_qbuf_output_dma_auto(struct fimc_control *ctrl)
 			return -EINVAL;
 		}
 
-		fimc_outdev_set_src_addr(ctrl, ctrl->out->src[index].base);
-
-		memset(&buf_set, 0x00, sizeof(buf_set));
-		buf_set.base[FIMC_ADDR_Y] = ctrl->out->dst[index].base[FIMC_ADDR_Y];
-
-		for (i = 0; i < FIMC_PHYBUFS; i++)
-			fimc_hwset_output_address(ctrl, &buf_set, i);
-
-		ret = fimc_outdev_start_camif(ctrl);
+		ret = fimc_outdev_run(ctrl, index);
 		if (ret < 0) {
 			fimc_err("Fail: fimc_start_camif\n");
 			return -EINVAL;
 		}
 
-		ctrl->out->idx.active = index;
-		ctrl->status = FIMC_STREAMON;
-
 		break;
 
 	default:
@@ -1919,9 +1973,8 @@ static int fimc_qbuf_output_dma_auto(struct fimc_control *ctrl)
 
 static int fimc_qbuf_output_dma_manual(struct fimc_control *ctrl)
 {
-	struct fimc_buf_set buf_set;
 	struct fimc_overlay_buf *buf;
-	u32 index = 0, i = 0, size;
+	u32 index = 0, size;
 	int ret = -1;
 	buf = &ctrl->out->overlay.buf;
 	size = (ctrl->out->win.w.width * ctrl->out->win.w.height) << 2;
@@ -1935,15 +1988,7 @@ static int fimc_qbuf_output_dma_manual(struct fimc_control *ctrl)
 			return -EINVAL;
 		}
 
-		fimc_outdev_set_src_addr(ctrl, ctrl->out->src[index].base);
-
-		memset(&buf_set, 0x00, sizeof(buf_set));
-		buf_set.base[FIMC_ADDR_Y] = ctrl->out->dst[index].base[FIMC_ADDR_Y];
-
-		for (i = 0; i < FIMC_PHYBUFS; i++)
-			fimc_hwset_output_address(ctrl, &buf_set, i);
-
-		ret = fimc_outdev_start_camif(ctrl);
+		ret = fimc_outdev_run(ctrl, index);
 		if (ret < 0) {
 			fimc_err("Fail: fimc_start_camif\n");
 			return -EINVAL;
@@ -1951,9 +1996,6 @@ static int fimc_qbuf_output_dma_manual(struct fimc_control *ctrl)
 		
 		dmac_inv_range((void *)buf->vir_addr[index], \
 				(void *)(buf->vir_addr[index] + size));
-		
-		ctrl->out->idx.active = index;
-		ctrl->status = FIMC_STREAMON;
 
 		break;
 
@@ -1995,31 +2037,18 @@ static int fimc_qbuf_output_fifo(struct fimc_control *ctrl)
 	return 0;
 }
 
-static int fimc_update_in_queue_addr(struct fimc_control *ctrl, u32 index, dma_addr_t *addr)
-{
-	if (index >= FIMC_OUTBUFS) {
-		fimc_err("%s: Failed \n", __func__);
-		return -EINVAL;
-	}
-	
-	ctrl->out->src[index].base[FIMC_ADDR_Y] = addr[FIMC_ADDR_Y];
-	ctrl->out->src[index].base[FIMC_ADDR_CB] = addr[FIMC_ADDR_CB];
-	ctrl->out->src[index].base[FIMC_ADDR_CR] = addr[FIMC_ADDR_CR];
-
-	return 0;
-}
-
 int fimc_qbuf_output(void *fh, struct v4l2_buffer *b)
 {
 	struct fimc_control *ctrl = (struct fimc_control *) fh;
-	struct fimc_buf *buf = (struct fimc_buf *)b->m.userptr;
 	struct fimc_overlay_buf *cbuf;
+	struct file *file;
+	dma_addr_t paddr;
 	int ret = -1;
 	u32 size;
 
 	fimc_info2("%s: queued idx = %d\n", __func__, b->index);
 
-	if (b->index > ctrl->out->buf_num) {
+	if (b->index >= ctrl->out->buf_num || b->index >= FIMC_OUTBUFS) {
 		fimc_err("The index is out of bounds" 
 			"You requested %d buffers. "
 			"But you set the index as %d\n",
@@ -2035,9 +2064,15 @@ int fimc_qbuf_output(void *fh, struct v4l2_buffer *b)
 	}
 
 	if (b->memory == V4L2_MEMORY_USERPTR) {
-		ret = fimc_update_in_queue_addr(ctrl, b->index, buf->base);
+		ret = fimc_get_userptr(b->m.userptr, fimc_outdev_src_size(ctrl->out),
+					&paddr, &file);
 		if (ret < 0)
 			return ret;
+
+		/* held until the buffer is dequeued or streaming stops */
+		fimc_put_userptr(&ctrl->out->src[b->index]);
+		fimc_outdev_fill_src(ctrl->out, &ctrl->out->src[b->index], paddr);
+		ctrl->out->src[b->index].file = file;
 	}
 
 	/* Attach the buffer to the incoming queue. */
@@ -2111,6 +2146,9 @@ int fimc_dqbuf_output(void *fh, struct v4l2_buffer *b)
 	}
 
 	b->index = index;
+	b->timestamp = ctrl->out->src[index].timestamp;
+	b->sequence = ctrl->out->src[index].sequence;
+	fimc_put_userptr(&ctrl->out->src[index]);
 
 	fimc_info2("%s: dqueued idx = %d\n", __func__, b->index);
 
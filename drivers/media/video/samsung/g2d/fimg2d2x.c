@@ -11,8 +11,13 @@
 #include <linux/irq.h>
 #include <linux/mm.h>
 #include <linux/interrupt.h>
+#include <linux/list.h>
+#include <linux/slab.h>
+#include <linux/spinlock.h>
+#include <linux/timer.h>
 
 #include <asm/io.h>
+#include <asm/uaccess.h>
 #include <mach/map.h>
 
 #include <plat/regs-g2d.h>	// arch/arm/plat-s3c/include/plat/regs-g2d.h. need confirm file.
@@ -36,10 +41,39 @@ static struct resource *g2d_mem;
 static void __iomem *g2d_base;
 static wait_queue_head_t waitq_g2d;
 
-static u16 g2d_poll_flag = 0;
-
 static struct mutex *g2d_mutex;
 
+/*
+ * Submitted operations are kept in batches on g2d_queue. The engine runs
+ * one operation at a time; the command finish interrupt programs the next
+ * one, so a batch runs back-to-back without going back to user space.
+ */
+struct g2d_batch {
+	struct list_head	list;
+	u32			seq;
+	u32			num_ops;
+	u32			cur;		/* operation on the engine */
+	G2D_OP			ops[0];
+};
+
+typedef struct
+{
+	G2D_PARAMS	params;
+	u32		last_seq;	/* last batch submitted through this file */
+} G2D_CTX;
+
+static LIST_HEAD(g2d_queue);
+static DEFINE_SPINLOCK(g2d_lock);
+static struct g2d_batch *g2d_active;
+static u32 g2d_queued;
+static u32 g2d_queued_ops;	/* operations not finished yet */
+static u32 g2d_submit_seq;
+static u32 g2d_done_seq;
+static u32 g2d_failed_seq;	/* last batch cut short by the watchdog */
+
+/* catches a command finish interrupt that never comes */
+static struct timer_list g2d_watchdog;
+
 void g2d_check_fifo(int empty_fifo)
 {
 	#if 0
@@ -288,13 +322,195 @@ static void g2d_rotator_start(G2D_PARAMS *params, G2D_ROT rot_degree)
 	g2d_rotate_start(params, rot_degree);
 }
 
+static void g2d_fill_start(G2D_PARAMS *params)
+{
+	u32 x1, y1, x2, y2;
+
+	x1 = params->dst_start_x;
+	y1 = params->dst_start_y;
+	x2 = params->dst_start_x + params->dst_work_width;
+	y2 = params->dst_start_y + params->dst_work_height;
+
+	g2d_init_regs(params);
+
+	/* third operand is the foreground colour, source is not read */
+	__raw_writel(G2D_ROP_REG_OS_FG_COLOR |
+		(params->alpha_mode == TRUE ?
+			G2D_ROP_REG_ABM_REGISTER : G2D_ROP_REG_ABM_NO_BLENDING) |
+		G2D_ROP_REG_T_OPAQUE_MODE |
+		G2D_ROP_3RD_OPRND_ONLY,
+		g2d_base + G2D_ROP_REG);
+
+	__raw_writel(G2D_INTEN_REG_CCF, g2d_base + G2D_INTEN_REG);
+
+	g2d_bitblt_1(x1, y1, x2, y2, x1, y1, x2, y2);
+}
+
+static void g2d_op_start(G2D_OP *op)
+{
+	mod_timer(&g2d_watchdog, jiffies + G2D_TIMEOUT);
+
+	switch(op->type) {
+	case G2D_OP_FILL:
+		g2d_fill_start(&op->params);
+		break;
+	case G2D_OP_ROTATE:
+		g2d_rotator_start(&op->params, op->rot_degree);
+		break;
+	case G2D_OP_BLIT:
+	default:
+		g2d_rotator_start(&op->params, ROT_0);
+		break;
+	}
+}
+
+static int g2d_op_check(G2D_OP *op)
+{
+	if(op->type > G2D_OP_FILL) {
+		DPRINTK("%d : Wrong operation type %d\n", __LINE__, op->type);
+		return -EINVAL;
+	}
+
+	if(op->type == G2D_OP_ROTATE && op->rot_degree > ROT_Y_FLIP) {
+		DPRINTK("%d : Wrong rotation degree %d\n", __LINE__, op->rot_degree);
+		return -EINVAL;
+	}
+
+	if(op->params.alpha_mode == TRUE && op->params.alpha_val > ALPHA_VALUE_MAX) {
+		DPRINTK("%d : g2d driver error : exceed aplha value range 0 ~ 255\n", __LINE__);
+		return -EINVAL;
+	}
+
+	return 0;
+}
+
+/* called with g2d_lock held and the engine idle */
+static void g2d_start_next(void)
+{
+	if(list_empty(&g2d_queue)) {
+		g2d_active = NULL;
+		del_timer(&g2d_watchdog);
+		return;
+	}
+
+	g2d_active = list_first_entry(&g2d_queue, struct g2d_batch, list);
+	list_del(&g2d_active->list);
+	g2d_queued--;
+
+	g2d_active->cur = 0;
+	g2d_op_start(&g2d_active->ops[0]);
+}
+
+static int g2d_queue_full(void)
+{
+	return g2d_queued >= G2D_QUEUE_MAX;
+}
+
+/* returns -EAGAIN if there is no room, the batch is not queued then */
+static int g2d_queue_batch(struct g2d_batch *batch, u32 *seq)
+{
+	unsigned long flags;
+
+	spin_lock_irqsave(&g2d_lock, flags);
+	if(g2d_queue_full()) {
+		spin_unlock_irqrestore(&g2d_lock, flags);
+		return -EAGAIN;
+	}
+
+	*seq = batch->seq = ++g2d_submit_seq;
+	list_add_tail(&batch->list, &g2d_queue);
+	g2d_queued++;
+	g2d_queued_ops += batch->num_ops;
+	if(g2d_active == NULL)
+		g2d_start_next();
+	spin_unlock_irqrestore(&g2d_lock, flags);
+
+	return 0;
+}
+
+static int g2d_seq_done(u32 seq)
+{
+	return (s32)(g2d_done_seq - seq) >= 0;
+}
+
+/*
+ * Every operation runs under its own G2D_TIMEOUT watchdog, so whatever is
+ * queued ahead of a waiter finishes or is dropped within this long.
+ */
+static long g2d_queue_timeout(void)
+{
+	return G2D_TIMEOUT * (ACCESS_ONCE(g2d_queued_ops) + 1);
+}
+
+static int g2d_wait_seq(u32 seq)
+{
+	int ret;
+
+	ret = wait_event_interruptible_timeout(waitq_g2d, g2d_seq_done(seq),
+					       g2d_queue_timeout());
+	if(ret == 0) {
+		DPRINTK("%d : Waiting for interrupt is timeout\n", __LINE__);
+		return -ETIMEDOUT;
+	}
+	if(ret < 0)
+		return ret;
+
+	return seq == g2d_failed_seq ? -EIO : 0;
+}
+
+static void g2d_watchdog_fn(unsigned long data)
+{
+	struct g2d_batch *done = NULL;
+	unsigned long flags;
+
+	spin_lock_irqsave(&g2d_lock, flags);
+	if(g2d_active != NULL) {
+		printk(KERN_ERR "g2d: no interrupt from the engine, "
+		       "resetting it\n");
+
+		__raw_writel(G2D_CONTROL_REG_R, g2d_base + G2D_CONTROL_REG);
+		__raw_writel(G2D_PEND_REG_INTP_CMD_FIN,
+			     g2d_base + G2D_INTC_PEND_REG);
+
+		/* the rest of the batch is dropped, the waiter gets -EIO */
+		done = g2d_active;
+		g2d_queued_ops -= done->num_ops - done->cur;
+		g2d_done_seq = g2d_failed_seq = done->seq;
+		g2d_start_next();
+	}
+	spin_unlock_irqrestore(&g2d_lock, flags);
+
+	if(done != NULL) {
+		kfree(done);
+		wake_up(&waitq_g2d);
+	}
+}
+
 irqreturn_t g2d_irq(int irq, void *dev_id)
 {
+	struct g2d_batch *done = NULL;
+
  	if(__raw_readl(g2d_base + G2D_INTC_PEND_REG) & G2D_PEND_REG_INTP_CMD_FIN) {
 		__raw_writel(G2D_PEND_REG_INTP_CMD_FIN, g2d_base + G2D_INTC_PEND_REG);
-		wake_up_interruptible(&waitq_g2d);
-		DPRINTK("\nafter wake_up_interruptible\n");
-		g2d_poll_flag = 1;	
+
+		spin_lock(&g2d_lock);
+		if(g2d_active != NULL) {
+			g2d_queued_ops--;
+			if(++g2d_active->cur < g2d_active->num_ops) {
+				g2d_op_start(&g2d_active->ops[g2d_active->cur]);
+			} else {
+				done = g2d_active;
+				g2d_done_seq = done->seq;
+				g2d_start_next();
+			}
+		}
+		spin_unlock(&g2d_lock);
+
+		if(done != NULL) {
+			kfree(done);
+			wake_up(&waitq_g2d);
+			DPRINTK("\nafter wake_up\n");
+		}
 	}
 	
 	return IRQ_HANDLED;
@@ -302,29 +518,31 @@ irqreturn_t g2d_irq(int irq, void *dev_id)
 
 int g2d_open(struct inode *inode, struct file *file)
 {
-	G2D_PARAMS *params;
-	params = (G2D_PARAMS *)kmalloc(sizeof(G2D_PARAMS), GFP_KERNEL);
-	if(params == NULL) {
+	G2D_CTX *ctx;
+	ctx = (G2D_CTX *)kmalloc(sizeof(G2D_CTX), GFP_KERNEL);
+	if(ctx == NULL) {
 		DPRINTK("\n%d : Instance memory allocation is failed\n", __LINE__);
 		return -1;
 	}
 
-	memset(params, 0, sizeof(G2D_PARAMS));
+	memset(ctx, 0, sizeof(G2D_CTX));
+	ctx->last_seq = g2d_done_seq;
 
-	file->private_data = (G2D_PARAMS *)params;
+	file->private_data = (G2D_CTX *)ctx;
  	
 	return 0;
 }
 int g2d_release(struct inode *inode, struct file *file)
 {
-	G2D_PARAMS *params;
-	params = (G2D_PARAMS *)file->private_data;
-	if(params == NULL) {
+	G2D_CTX *ctx;
+	ctx = (G2D_CTX *)file->private_data;
+	if(ctx == NULL) {
 		DPRINTK("%d : Can't release g2d \n", __LINE__);
 		return -1;
 	}
 
-	kfree(params);
+	/* queued batches carry their own copy of the parameters */
+	kfree(ctx);
 	
 	return 0;
 }
@@ -355,69 +573,137 @@ int g2d_mmap(struct file *file, struct vm_area_struct *vma)
 	
 	return 0;
 }
-static int g2d_ioctl(struct inode *inode, struct file *file, unsigned int cmd, unsigned long arg)
+/* queue the batch, waiting for room unless the file is non-blocking */
+static int g2d_submit(struct file *file, struct g2d_batch *batch, u32 *seq)
+{
+	int ret;
+
+	while((ret = g2d_queue_batch(batch, seq)) == -EAGAIN) {
+		if(file->f_flags & O_NONBLOCK)
+			break;
+
+		ret = wait_event_interruptible(waitq_g2d, !g2d_queue_full());
+		if(ret)
+			break;
+	}
+
+	return ret;
+}
+
+static int g2d_submit_batch(struct file *file, G2D_BATCH __user *arg)
 {
-	G2D_PARAMS *params;
-	G2D_ROT rot_degree;
+	G2D_CTX *ctx = (G2D_CTX *)file->private_data;
+	struct g2d_batch *batch;
+	G2D_BATCH req;
+	u32 i;
+	int ret;
 
-	params = (G2D_PARAMS *)file->private_data;
-	if(copy_from_user(params, (G2D_PARAMS*) arg, sizeof(G2D_PARAMS)))
+	if(copy_from_user(&req, arg, sizeof(G2D_BATCH)))
 		return -EFAULT;
 
-	//mutex_lock(g2d_mutex);
+	if(req.num_ops == 0 || req.num_ops > G2D_BATCH_MAX)
+		return -EINVAL;
+
+	batch = kmalloc(sizeof(struct g2d_batch) + req.num_ops * sizeof(G2D_OP),
+			GFP_KERNEL);
+	if(batch == NULL)
+		return -ENOMEM;
+
+	if(copy_from_user(batch->ops, (G2D_OP __user *)req.ops,
+			  req.num_ops * sizeof(G2D_OP))) {
+		ret = -EFAULT;
+		goto err;
+	}
+
+	for(i = 0; i < req.num_ops; i++) {
+		ret = g2d_op_check(&batch->ops[i]);
+		if(ret)
+			goto err;
+	}
+	batch->num_ops = req.num_ops;
+
+	ret = g2d_submit(file, batch, &req.seq);
+	if(ret)
+		goto err;
+
+	ctx->last_seq = req.seq;
+
+	if(copy_to_user(arg, &req, sizeof(G2D_BATCH)))
+		return -EFAULT;
+
+	return 0;
+
+err:
+	kfree(batch);
+	return ret;
+}
+
+static int g2d_ioctl(struct inode *inode, struct file *file, unsigned int cmd, unsigned long arg)
+{
+	G2D_CTX *ctx;
+	struct g2d_batch *batch;
+	G2D_OP *op;
+	u32 seq;
+	int ret;
+
+	ctx = (G2D_CTX *)file->private_data;
 
 	switch(cmd) {
+	case G2D_SUBMIT_BATCH:
+		return g2d_submit_batch(file, (G2D_BATCH __user *)arg);
+	case G2D_WAIT_SEQ:
+		if(get_user(seq, (u32 __user *)arg))
+			return -EFAULT;
+		return g2d_wait_seq(seq);
 	case G2D_ROTATOR_0:
-		rot_degree = ROT_0;
-		g2d_rotator_start(params, rot_degree);
-		break;
 	case G2D_ROTATOR_90:
-		rot_degree = ROT_90;
-		g2d_rotator_start(params, rot_degree);
-		break;
 	case G2D_ROTATOR_180:
-		rot_degree = ROT_180;
-		g2d_rotator_start(params, rot_degree);
-		break;
 	case G2D_ROTATOR_270:
-		rot_degree = ROT_270;
-		g2d_rotator_start(params, rot_degree);
-		break;
 	case G2D_ROTATOR_X_FLIP:
-		rot_degree = ROT_X_FLIP;
-		g2d_rotator_start(params, rot_degree);
-		break;
 	case G2D_ROTATOR_Y_FLIP:
-		rot_degree = ROT_Y_FLIP;
-		g2d_rotator_start(params, rot_degree);
 		break;
 	default:
-		mutex_unlock(g2d_mutex);
 		return -EINVAL;
 	}
-	
+
+	if(copy_from_user(&ctx->params, (G2D_PARAMS*) arg, sizeof(G2D_PARAMS)))
+		return -EFAULT;
+
+	/* a single rotation is a batch of one */
+	batch = kmalloc(sizeof(struct g2d_batch) + sizeof(G2D_OP), GFP_KERNEL);
+	if(batch == NULL)
+		return -ENOMEM;
+
+	op = &batch->ops[0];
+	op->type = G2D_OP_ROTATE;
+	op->rot_degree = (G2D_ROT)_IOC_NR(cmd);
+	op->params = ctx->params;
+	batch->num_ops = 1;
+
+	ret = g2d_op_check(op);
+	if(ret == 0)
+		ret = g2d_submit(file, batch, &seq);
+	if(ret) {
+		kfree(batch);
+		return ret;
+	}
+
+	ctx->last_seq = seq;
 
 	if(!(file->f_flags & O_NONBLOCK)) {
-		if(interruptible_sleep_on_timeout(&waitq_g2d, G2D_TIMEOUT) == 0) {
-			DPRINTK("%d : Waiting for interrupt is timeout\n", __LINE__);
-		}
+		return g2d_wait_seq(seq);
 	} else {
 		return -EAGAIN;
 	}
-
-	//mutex_unlock(g2d_mutex);
-	
-	return 0;
 }
 static unsigned int g2d_poll(struct file *file, struct poll_table_struct *wait)
 {
+	G2D_CTX *ctx = (G2D_CTX *)file->private_data;
 	unsigned int mask = 0;
 
 	poll_wait(file, &waitq_g2d, wait);
-	if(g2d_poll_flag == 1) {
+	if(g2d_seq_done(ctx->last_seq))
 		mask = POLLOUT|POLLWRNORM;
-		g2d_poll_flag = 0;
-	}
 	
 	return mask;
 }
@@ -494,6 +780,7 @@ int g2d_probe(struct platform_device *pdev)
 	}
 
 	init_waitqueue_head(&waitq_g2d);
+	setup_timer(&g2d_watchdog, g2d_watchdog_fn, 0);
 
 	ret = misc_register(&g2d_dev);
 	if(ret) {
@@ -511,10 +798,29 @@ int g2d_probe(struct platform_device *pdev)
 	
 	return 0;
 }
+static void g2d_drain(void)
+{
+	wait_event_timeout(waitq_g2d, g2d_active == NULL,
+			   g2d_queue_timeout());
+}
+
 static int g2d_remove(struct platform_device *pdev)
 {
+	struct g2d_batch *batch, *tmp;
+
+	g2d_drain();
 
 	free_irq(g2d_irq_num, NULL);
+	del_timer_sync(&g2d_watchdog);
+
+	kfree(g2d_active);
+	g2d_active = NULL;
+	list_for_each_entry_safe(batch, tmp, &g2d_queue, list) {
+		list_del(&batch->list);
+		kfree(batch);
+	}
+	g2d_queued = 0;
+	g2d_queued_ops = 0;
 
 	if(g2d_mem != NULL) {
 		DPRINTK("%d g2d Driver, releasing resource\n", __LINE__);
@@ -529,6 +835,7 @@ static int g2d_remove(struct platform_device *pdev)
 }
 static int g2d_suspend(struct platform_device *pdev, pm_message_t state)
 {
+	g2d_drain();
 	clk_disable(g2d_clock);
 	
 	return 0;
@@ -22,6 +22,11 @@
 #define G2D_ROTATOR_270		_IO(G2D_IOCTL_MAGIC,3)
 #define G2D_ROTATOR_X_FLIP	_IO(G2D_IOCTL_MAGIC,4)
 #define G2D_ROTATOR_Y_FLIP	_IO(G2D_IOCTL_MAGIC,5)
+#define G2D_SUBMIT_BATCH	_IOWR(G2D_IOCTL_MAGIC,6,G2D_BATCH)
+#define G2D_WAIT_SEQ		_IOW(G2D_IOCTL_MAGIC,7,u32)
+
+#define G2D_BATCH_MAX		64	/* operations in one G2D_SUBMIT_BATCH */
+#define G2D_QUEUE_MAX		16	/* batches waiting for the engine */
 
 #define G2D_ROP_SRC_ONLY			(0xf0)
 #define G2D_ROP_3RD_OPRND_ONLY			(0xaa)
@@ -113,6 +118,34 @@ typedef struct
 	u32	transparent_mode;
 }G2D_PARAMS;
 
+typedef enum
+{
+	G2D_OP_BLIT,		/* copy src to dst, same as G2D_ROTATOR_0 */
+	G2D_OP_ROTATE,		/* rotate or flip src to dst by rot_degree */
+	G2D_OP_FILL		/* fill dst with color_val[G2D_WHITE] */
+} G2D_OP_TYPE;
+
+typedef struct
+{
+	G2D_OP_TYPE	type;
+	G2D_ROT		rot_degree;
+	G2D_PARAMS	params;
+}G2D_OP;
+
+/*
+ * G2D_SUBMIT_BATCH queues num_ops operations and returns at once with the
+ * sequence number of the batch in seq. The operations run in order, and
+ * batches run in the order they were submitted. Completion is reported by
+ * poll() (POLLOUT once all batches of the file are done) or by waiting on
+ * the sequence number with G2D_WAIT_SEQ.
+ */
+typedef struct
+{
+	G2D_OP	*ops;
+	u32	num_ops;
+	u32	seq;
+}G2D_BATCH;
+
 
 
 /* function declearation */
@@ -16,6 +16,8 @@
 #include "jpg_misc.h"
 
 #include <linux/version.h>
+#include <linux/list.h>
+#include <linux/wait.h>
 #include <plat/media.h>
 
 #ifdef CONFIG_CPU_S5PC100
@@ -101,8 +103,25 @@ typedef struct __s5pc100_jpg_ctx {
 	volatile UINT32                  jpg_thumb_data_addr;
 	volatile UINT32                  img_thumb_data_addr;
 	int                          caller_process;
+
+	/* instance's share of the reserved memory, -1 if there is none left */
+	int                          slot;
+	dma_addr_t                   slot_addr;
+
+	/* jobs of the instance, run round robin with the other instances */
+	struct list_head             node;
+	struct list_head             pending;
+	struct list_head             done;
+	unsigned int                 queued;
+	wait_queue_head_t            wait;
+
+	/* MJPEG : parameters shared by every frame of the stream */
+	int                          streaming;
+	struct __jpg_enc_proc_param *stream_param;
 } sspc100_jpg_ctx;
 
+#define jpg_slot_base(slot)	(jpg_data_base_addr + (slot) * JPG_TOTAL_BUF_SIZE)
+
 void *phy_to_vir_addr(UINT32 phy_addr, int mem_size);
 void *mem_move(void *dst, const void *src, unsigned int size);
 void *mem_alloc(unsigned int size);
@@ -22,6 +22,7 @@
 
 extern void __iomem		*s3c_jpeg_base;
 extern int			jpg_irq_reason;
+extern int			jpg_irq_done;
 
 enum {
 	UNKNOWN,
@@ -32,10 +33,14 @@ enum {
 
 jpg_return_status wait_for_interrupt(void)
 {
-	if (interruptible_sleep_on_timeout(&wait_queue_jpeg, INT_TIMEOUT) == 0) {
+	/* the interrupt may come before we get here */
+	if (wait_event_timeout(wait_queue_jpeg, jpg_irq_done, INT_TIMEOUT) == 0) {
 		jpg_err("waiting for interrupt is timeout\n");
+		return ERR_UNKNOWN;
 	}
 
+	jpg_irq_done = 0;
+
 	return jpg_irq_reason;
 }
 
@@ -166,6 +171,8 @@ jpg_return_status decode_jpg(sspc100_jpg_ctx *jpg_ctx,
 
 void reset_jpg(sspc100_jpg_ctx *jpg_ctx)
 {
+	jpg_irq_done = 0;
+
 #ifdef CONFIG_CPU_S5PC100
 	jpg_dbg("s3c_jpeg_base 0x%08x \n", s3c_jpeg_base);
 	writel(S3C_JPEG_SW_RESET_REG_ENABLE, s3c_jpeg_base + S3C_JPEG_SW_RESET_REG);
@@ -112,7 +112,7 @@ typedef struct {
 	UINT32			file_size;
 } jpg_dec_proc_param;
 
-typedef struct {
+typedef struct __jpg_enc_proc_param {
 	sample_mode_t		sample_mode;
 	encode_type_t		enc_type;
 	in_mode_t      		in_format;
@@ -142,6 +142,25 @@ typedef struct {
 	jpg_enc_proc_param	*thumb_enc_param;
 } jpg_args;
 
+/*
+ * One frame of an MJPEG stream started with IOCTL_JPG_STREAM_START.
+ * Both buffers are physical. The output must lie in the instance's own
+ * memory; IOCTL_JPG_GET_PHY_STRBUF gives its stream buffer, which may be
+ * split between several frames in flight. The input may also be a capture
+ * buffer FIMC holds, so it can be encoded as it is. Anything else gets
+ * -EFAULT. out_buf_size must cover
+ * the worst-case stream of the frame size, about 4 bytes a pixel for 4:2:2
+ * and 3 for 4:2:0, or the frame is refused with -ENOSPC.
+ */
+typedef struct {
+	UINT32			index;		/* caller's cookie, returned as is */
+	UINT32			phy_in_buf;	/* YCbCr or RGB frame */
+	UINT32			phy_out_buf;	/* JPEG stream */
+	UINT32			out_buf_size;
+	UINT32			file_size;	/* out : encoded size */
+	int			status;		/* out : 0 or -errno */
+} jpg_stream_frame;
+
 
 jpg_return_status decode_jpg(sspc100_jpg_ctx *jpg_ctx, jpg_dec_proc_param *dec_param);
 void reset_jpg(sspc100_jpg_ctx *jpg_ctx);
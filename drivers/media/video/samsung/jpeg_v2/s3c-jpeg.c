@@ -45,6 +45,9 @@
 
 #include <linux/time.h>
 #include <linux/clk.h>
+#include <linux/spinlock.h>
+#include <linux/workqueue.h>
+#include <asm/uaccess.h>
 
 #include "s3c-jpeg.h"
 #include "jpg_mem.h"
@@ -60,8 +63,36 @@ void __iomem			*s3c_jpeg_base;
 static int			irq_no;
 static int			instanceNo = 0;
 volatile int			jpg_irq_reason;
+volatile int			jpg_irq_done;
 wait_queue_head_t 		wait_queue_jpeg;
 
+/*
+ * Encode and decode requests of every instance are jobs run one at a time
+ * by s3c_jpeg_work. Instances with pending jobs sit on s3c_jpeg_run_list
+ * and take turns, one job each, so a long stream does not hold off the
+ * other instances.
+ */
+struct s3c_jpeg_job {
+	struct list_head	list;
+	int			decode;
+	int			stream;		/* result goes to the done list */
+	UINT32			jpg_addr;
+	UINT32			img_addr;
+	jpg_enc_proc_param	enc;
+	jpg_dec_proc_param	dec;
+	jpg_stream_frame	frame;
+	jpg_return_status	result;
+	int			done;
+};
+
+static LIST_HEAD(s3c_jpeg_run_list);
+static DEFINE_SPINLOCK(s3c_jpeg_lock);
+static sspc100_jpg_ctx		*s3c_jpeg_running;
+static struct workqueue_struct	*s3c_jpeg_wq;
+static struct work_struct	s3c_jpeg_work;
+static int			s3c_jpeg_slots;
+static unsigned long		s3c_jpeg_slot_map;
+
 
 DECLARE_WAIT_QUEUE_HEAD(WaitQueue_JPEG);
 #ifdef CONFIG_CPU_S5PC100
@@ -96,10 +127,12 @@ static irqreturn_t s3c_jpeg_irq(int irq, void *dev_id)
 			jpg_irq_reason = ERR_UNKNOWN;
 		}
 
-		wake_up_interruptible(&wait_queue_jpeg);
+		jpg_irq_done = 1;
+		wake_up(&wait_queue_jpeg);
 	} else {
 		jpg_irq_reason = ERR_UNKNOWN;
-		wake_up_interruptible(&wait_queue_jpeg);
+		jpg_irq_done = 1;
+		wake_up(&wait_queue_jpeg);
 	}
 
 	return IRQ_HANDLED;
@@ -133,28 +166,142 @@ static irqreturn_t s3c_jpeg_irq(int irq, void *dev_id, struct pt_regs *regs)
 			jpg_irq_reason = ERR_UNKNOWN;
 		}
 
-		wake_up_interruptible(&wait_queue_jpeg);
+		jpg_irq_done = 1;
+		wake_up(&wait_queue_jpeg);
 	} else {
 		jpg_irq_reason = ERR_UNKNOWN;
-		wake_up_interruptible(&wait_queue_jpeg);
+		jpg_irq_done = 1;
+		wake_up(&wait_queue_jpeg);
 	}
 
 	return IRQ_HANDLED;
 }
 #endif
+static void s3c_jpeg_run_job(sspc100_jpg_ctx *jpg_ctx, struct s3c_jpeg_job *job)
+{
+	lock_jpg_mutex();
+
+	jpg_ctx->jpg_data_addr = jpg_ctx->jpg_thumb_data_addr = job->jpg_addr;
+	jpg_ctx->img_data_addr = jpg_ctx->img_thumb_data_addr = job->img_addr;
+
+	if (job->decode)
+		job->result = decode_jpg(jpg_ctx, &job->dec);
+	else
+		job->result = encode_jpg(jpg_ctx, &job->enc);
+
+	unlock_jpg_mutex();
+
+	if (!job->stream)
+		return;
+
+	job->frame.file_size = job->enc.file_size;
+	if (job->result != JPG_SUCCESS)
+		job->frame.status = -EIO;
+	else if (job->frame.file_size > job->frame.out_buf_size)
+		job->frame.status = -ENOSPC;
+	else
+		job->frame.status = 0;
+}
+
+static void s3c_jpeg_work_fn(struct work_struct *work)
+{
+	sspc100_jpg_ctx		*jpg_ctx;
+	struct s3c_jpeg_job	*job;
+
+	for (;;) {
+		spin_lock(&s3c_jpeg_lock);
+		if (list_empty(&s3c_jpeg_run_list)) {
+			spin_unlock(&s3c_jpeg_lock);
+			break;
+		}
+
+		jpg_ctx = list_first_entry(&s3c_jpeg_run_list, sspc100_jpg_ctx, node);
+		job = list_first_entry(&jpg_ctx->pending, struct s3c_jpeg_job, list);
+		list_del(&job->list);
+
+		/* one job per turn */
+		list_del_init(&jpg_ctx->node);
+		if (!list_empty(&jpg_ctx->pending))
+			list_add_tail(&jpg_ctx->node, &s3c_jpeg_run_list);
+
+		s3c_jpeg_running = jpg_ctx;
+		spin_unlock(&s3c_jpeg_lock);
+
+		s3c_jpeg_run_job(jpg_ctx, job);
+
+		spin_lock(&s3c_jpeg_lock);
+		job->done = 1;
+		if (job->stream)
+			list_add_tail(&job->list, &jpg_ctx->done);
+		s3c_jpeg_running = NULL;
+		wake_up(&jpg_ctx->wait);
+		spin_unlock(&s3c_jpeg_lock);
+	}
+}
+
+static void s3c_jpeg_submit(sspc100_jpg_ctx *jpg_ctx, struct s3c_jpeg_job *job)
+{
+	spin_lock(&s3c_jpeg_lock);
+	if (list_empty(&jpg_ctx->pending))
+		list_add_tail(&jpg_ctx->node, &s3c_jpeg_run_list);
+	list_add_tail(&job->list, &jpg_ctx->pending);
+	spin_unlock(&s3c_jpeg_lock);
+
+	queue_work(s3c_jpeg_wq, &s3c_jpeg_work);
+}
+
+/* run a job and wait for it, for the one-shot encode and decode ioctls */
+static jpg_return_status s3c_jpeg_run_sync(sspc100_jpg_ctx *jpg_ctx,
+					   struct s3c_jpeg_job *job)
+{
+	s3c_jpeg_submit(jpg_ctx, job);
+	wait_event(jpg_ctx->wait, job->done);
+
+	return job->result;
+}
+
+#ifdef CONFIG_S5PC1XX_MEDIA_SHARED
+/*
+ * A slot is only held while its instance is open, the rest of the time
+ * the media region lends it to the page allocator.
+ */
+static dma_addr_t s3c_jpeg_get_slot(int slot)
+{
+	return s3c_media_alloc(S3C_MDEV_JPEG, JPG_TOTAL_BUF_SIZE);
+}
+
+static void s3c_jpeg_put_slot(dma_addr_t addr)
+{
+	s3c_media_free(S3C_MDEV_JPEG, addr);
+}
+#else
+static inline dma_addr_t s3c_jpeg_get_slot(int slot)
+{
+	return jpg_slot_base(slot);
+}
+
+static inline void s3c_jpeg_put_slot(dma_addr_t addr)
+{
+}
+#endif
+
 static int s3c_jpeg_open(struct inode *inode, struct file *file)
 {
 	sspc100_jpg_ctx *jpg_reg_ctx;
 	DWORD	ret;
 
-        /* clock enable */
-	clk_enable(s3c_jpeg_clk);
-
 	jpg_dbg("JPG_open \r\n");
 
 	jpg_reg_ctx = (sspc100_jpg_ctx *)mem_alloc(sizeof(sspc100_jpg_ctx));
+	if (jpg_reg_ctx == NULL)
+		return -ENOMEM;
 	memset(jpg_reg_ctx, 0x00, sizeof(sspc100_jpg_ctx));
 
+	INIT_LIST_HEAD(&jpg_reg_ctx->node);
+	INIT_LIST_HEAD(&jpg_reg_ctx->pending);
+	INIT_LIST_HEAD(&jpg_reg_ctx->done);
+	init_waitqueue_head(&jpg_reg_ctx->wait);
+
 	ret = lock_jpg_mutex();
 
 	if (!ret) {
@@ -164,18 +311,31 @@ static int s3c_jpeg_open(struct inode *inode, struct file *file)
 		return FALSE;
 	}
 
-	if (instanceNo > MAX_INSTANCE_NUM) {
+	if (instanceNo >= MAX_INSTANCE_NUM) {
 		jpg_err("Instance Number error-JPEG is running, \
 				instance number is %d\n", instanceNo);
 		unlock_jpg_mutex();
 		kfree(jpg_reg_ctx);
-		return FALSE;
+		return -EBUSY;
 	}
 
+	/* an instance without a slot can only encode physical buffers */
+	jpg_reg_ctx->slot = find_first_zero_bit(&s3c_jpeg_slot_map, s3c_jpeg_slots);
+	if (jpg_reg_ctx->slot < s3c_jpeg_slots)
+		jpg_reg_ctx->slot_addr = s3c_jpeg_get_slot(jpg_reg_ctx->slot);
+
+	if (jpg_reg_ctx->slot_addr)
+		set_bit(jpg_reg_ctx->slot, &s3c_jpeg_slot_map);
+	else
+		jpg_reg_ctx->slot = -1;
+
 	instanceNo++;
 
 	unlock_jpg_mutex();
 
+        /* clock enable */
+	clk_enable(s3c_jpeg_clk);
+
 	file->private_data = (sspc100_jpg_ctx *)jpg_reg_ctx;
 
 	return 0;
@@ -186,6 +346,8 @@ static int s3c_jpeg_release(struct inode *inode, struct file *file)
 {
 	DWORD			ret;
 	sspc100_jpg_ctx		*jpg_reg_ctx;
+	struct s3c_jpeg_job	*job, *tmp;
+	LIST_HEAD(drop);
 
 	jpg_dbg("JPG_Close\n");
 
@@ -196,6 +358,20 @@ static int s3c_jpeg_release(struct inode *inode, struct file *file)
 		return FALSE;
 	}
 
+	/* drop queued frames and let the running one finish */
+	spin_lock(&s3c_jpeg_lock);
+	list_del_init(&jpg_reg_ctx->node);
+	list_splice_init(&jpg_reg_ctx->pending, &drop);
+	spin_unlock(&s3c_jpeg_lock);
+
+	wait_event(jpg_reg_ctx->wait, s3c_jpeg_running != jpg_reg_ctx);
+
+	list_splice_init(&jpg_reg_ctx->done, &drop);
+	list_for_each_entry_safe(job, tmp, &drop, list) {
+		list_del(&job->list);
+		kfree(job);
+	}
+
 	ret = lock_jpg_mutex();
 
 	if (!ret) {
@@ -203,10 +379,16 @@ static int s3c_jpeg_release(struct inode *inode, struct file *file)
 		return FALSE;
 	}
 
+	if (jpg_reg_ctx->slot >= 0) {
+		s3c_jpeg_put_slot(jpg_reg_ctx->slot_addr);
+		clear_bit(jpg_reg_ctx->slot, &s3c_jpeg_slot_map);
+	}
+
 	if ((--instanceNo) < 0)
 		instanceNo = 0;
 
 	unlock_jpg_mutex();
+	kfree(jpg_reg_ctx->stream_param);
 	kfree(jpg_reg_ctx);
 
 	/* clock disable */
@@ -227,14 +409,217 @@ static ssize_t s3c_jpeg_read(struct file *file, char *buf, size_t count, loff_t
 	return 0;
 }
 
+static int s3c_jpeg_stream_start(sspc100_jpg_ctx *jpg_ctx, unsigned long arg)
+{
+	jpg_enc_proc_param	*param;
+
+	if (jpg_ctx->streaming)
+		return -EBUSY;
+
+	param = kmalloc(sizeof(jpg_enc_proc_param), GFP_KERNEL);
+	if (param == NULL)
+		return -ENOMEM;
+
+	if (copy_from_user(param, (jpg_enc_proc_param *)arg,
+			   sizeof(jpg_enc_proc_param))) {
+		kfree(param);
+		return -EFAULT;
+	}
+
+	if (param->width <= 0 || param->width > MAX_JPG_WIDTH
+	    || param->height <= 0 || param->height > MAX_JPG_HEIGHT
+	    || param->quality > JPG_QUALITY_LEVEL_4) {
+		jpg_err("invalid stream parameters %dx%d\n",
+			param->width, param->height);
+		kfree(param);
+		return -EINVAL;
+	}
+	param->enc_type = JPG_MAIN;
+
+	kfree(jpg_ctx->stream_param);
+	jpg_ctx->stream_param = param;
+	jpg_ctx->streaming = 1;
+
+	return 0;
+}
+
+/*
+ * The codec has no limit on the stream it writes, so a frame is only taken
+ * if its buffer holds the largest stream the parameters can give: every
+ * MCU Huffman coded at its worst, as libjpeg-turbo's tjBufSize() counts
+ * it, plus room for the headers.
+ */
+#define JPG_HEADER_MAX_SIZE	2048
+
+static UINT32 s3c_jpeg_max_stream_size(jpg_enc_proc_param *param)
+{
+	UINT32 width = ALIGN(param->width, 16);
+
+	if (param->sample_mode == JPG_422)
+		return width * ALIGN(param->height, 8) * 4 + JPG_HEADER_MAX_SIZE;
+
+	return width * ALIGN(param->height, 16) * 3 + JPG_HEADER_MAX_SIZE;
+}
+
+/* YCbCr 4:2:2 and RGB565 input are both two bytes a pixel */
+static UINT32 s3c_jpeg_frame_size(jpg_enc_proc_param *param)
+{
+	return param->width * param->height * 2;
+}
+
+static int s3c_jpeg_in_slot(sspc100_jpg_ctx *jpg_ctx, UINT32 addr,
+			    UINT32 size)
+{
+	dma_addr_t base = jpg_ctx->slot_addr;
+
+	return base && addr >= base && size <= JPG_TOTAL_BUF_SIZE
+		&& addr - base <= JPG_TOTAL_BUF_SIZE - size;
+}
+
+#ifdef CONFIG_PLAT_S5PC1XX
+/* a capture buffer FIMC holds, the codec only reads it */
+static int s3c_jpeg_fimc_buf(UINT32 addr, UINT32 size)
+{
+	return s3c_media_claimed(S3C_MDEV_FIMC0, addr, size)
+		|| s3c_media_claimed(S3C_MDEV_FIMC1, addr, size)
+		|| s3c_media_claimed(S3C_MDEV_FIMC2, addr, size);
+}
+#else
+static inline int s3c_jpeg_fimc_buf(UINT32 addr, UINT32 size)
+{
+	return 0;
+}
+#endif
+
+static int s3c_jpeg_queue_frame(sspc100_jpg_ctx *jpg_ctx, struct file *file,
+				unsigned long arg)
+{
+	struct s3c_jpeg_job	*job;
+	UINT32			in_size;
+	int			ret;
+
+	if (!jpg_ctx->streaming)
+		return -EINVAL;
+
+	job = kzalloc(sizeof(struct s3c_jpeg_job), GFP_KERNEL);
+	if (job == NULL)
+		return -ENOMEM;
+
+	if (copy_from_user(&job->frame, (jpg_stream_frame *)arg,
+			   sizeof(jpg_stream_frame))) {
+		kfree(job);
+		return -EFAULT;
+	}
+
+	if (!job->frame.phy_in_buf || !job->frame.phy_out_buf
+	    || !job->frame.out_buf_size) {
+		kfree(job);
+		return -EINVAL;
+	}
+
+	if (job->frame.out_buf_size <
+	    s3c_jpeg_max_stream_size(jpg_ctx->stream_param)) {
+		jpg_err("output buffer of %d bytes too small for %dx%d\n",
+			job->frame.out_buf_size, jpg_ctx->stream_param->width,
+			jpg_ctx->stream_param->height);
+		kfree(job);
+		return -ENOSPC;
+	}
+
+	/* the codec writes the stream, it must go to our own slot */
+	if (!s3c_jpeg_in_slot(jpg_ctx, job->frame.phy_out_buf,
+			      job->frame.out_buf_size)) {
+		jpg_err("output buffer 0x%08x outside the JPEG memory\n",
+			job->frame.phy_out_buf);
+		kfree(job);
+		return -EFAULT;
+	}
+
+	in_size = s3c_jpeg_frame_size(jpg_ctx->stream_param);
+	if (!s3c_jpeg_in_slot(jpg_ctx, job->frame.phy_in_buf, in_size)
+	    && !s3c_jpeg_fimc_buf(job->frame.phy_in_buf, in_size)) {
+		jpg_err("input buffer 0x%08x outside JPEG and FIMC memory\n",
+			job->frame.phy_in_buf);
+		kfree(job);
+		return -EFAULT;
+	}
+
+	spin_lock(&s3c_jpeg_lock);
+	while (jpg_ctx->queued >= JPG_QUEUE_MAX) {
+		spin_unlock(&s3c_jpeg_lock);
+
+		ret = -EAGAIN;
+		if (!(file->f_flags & O_NONBLOCK))
+			ret = wait_event_interruptible(jpg_ctx->wait,
+					jpg_ctx->queued < JPG_QUEUE_MAX);
+		if (ret) {
+			kfree(job);
+			return ret;
+		}
+
+		spin_lock(&s3c_jpeg_lock);
+	}
+	jpg_ctx->queued++;
+	spin_unlock(&s3c_jpeg_lock);
+
+	job->stream = 1;
+	job->enc = *jpg_ctx->stream_param;
+	job->img_addr = job->frame.phy_in_buf;
+	job->jpg_addr = job->frame.phy_out_buf;
+
+	s3c_jpeg_submit(jpg_ctx, job);
+
+	return 0;
+}
+
+static int s3c_jpeg_dequeue_frame(sspc100_jpg_ctx *jpg_ctx, struct file *file,
+				  unsigned long arg)
+{
+	struct s3c_jpeg_job	*job;
+	int			ret;
+
+	spin_lock(&s3c_jpeg_lock);
+	while (list_empty(&jpg_ctx->done)) {
+		spin_unlock(&s3c_jpeg_lock);
+
+		if (jpg_ctx->queued == 0)
+			return -ENOENT;
+
+		if (file->f_flags & O_NONBLOCK)
+			return -EAGAIN;
+
+		ret = wait_event_interruptible(jpg_ctx->wait,
+				!list_empty(&jpg_ctx->done));
+		if (ret)
+			return ret;
+
+		spin_lock(&s3c_jpeg_lock);
+	}
+
+	job = list_first_entry(&jpg_ctx->done, struct s3c_jpeg_job, list);
+	list_del(&job->list);
+	jpg_ctx->queued--;
+	wake_up(&jpg_ctx->wait);
+	spin_unlock(&s3c_jpeg_lock);
+
+	ret = 0;
+	if (copy_to_user((jpg_stream_frame *)arg, &job->frame,
+			 sizeof(jpg_stream_frame)))
+		ret = -EFAULT;
+
+	kfree(job);
+
+	return ret;
+}
+
 static int s3c_jpeg_ioctl(struct inode *inode, struct file *file, unsigned int cmd, unsigned long arg)
 {
-	static sspc100_jpg_ctx		*jpg_reg_ctx;
+	sspc100_jpg_ctx			*jpg_reg_ctx;
 	jpg_args			param;
+	struct s3c_jpeg_job		job;
+	jpg_enc_proc_param		*enc_param;
 	BOOL				result = TRUE;
-	DWORD				ret;
-	int 				out;
-
+	UINT32				base;
 
 	jpg_reg_ctx = (sspc100_jpg_ctx *)file->private_data;
 
@@ -243,118 +628,155 @@ static int s3c_jpeg_ioctl(struct inode *inode, struct file *file, unsigned int c
 		return FALSE;
 	}
 
-	ret = lock_jpg_mutex();
+	switch (cmd) {
+	case IOCTL_JPG_STREAM_START:
+		jpg_dbg("IOCTL_JPG_STREAM_START\n");
+		return s3c_jpeg_stream_start(jpg_reg_ctx, arg);
 
-	if (!ret) {
-		jpg_err("JPG Mutex Lock Fail\r\n");
-		return FALSE;
+	case IOCTL_JPG_STREAM_STOP:
+		jpg_dbg("IOCTL_JPG_STREAM_STOP\n");
+		/* frames already queued are still encoded and dequeued */
+		jpg_reg_ctx->streaming = 0;
+		return 0;
+
+	case IOCTL_JPG_QUEUE_FRAME:
+		return s3c_jpeg_queue_frame(jpg_reg_ctx, file, arg);
+
+	case IOCTL_JPG_DEQUEUE_FRAME:
+		return s3c_jpeg_dequeue_frame(jpg_reg_ctx, file, arg);
+	}
+
+	if (jpg_reg_ctx->slot < 0) {
+		jpg_err("no reserved memory left for this instance\n");
+		return -ENOMEM;
 	}
+	base = jpg_reg_ctx->slot_addr;
+
+	memset(&job, 0, sizeof(job));
 
 	switch (cmd) {
 	case IOCTL_JPG_DECODE:
 
 		jpg_dbg("IOCTL_JPEG_DECODE\n");
 
-		out = copy_from_user(&param, (jpg_args *)arg, sizeof(jpg_args));
+		if (copy_from_user(&param, (jpg_args *)arg, sizeof(jpg_args)) ||
+		    copy_from_user(&job.dec, param.dec_param,
+				   sizeof(jpg_dec_proc_param)))
+			return -EFAULT;
+
+		job.decode = 1;
+		job.jpg_addr = base;
+		job.img_addr = base + JPG_STREAM_BUF_SIZE + JPG_STREAM_THUMB_BUF_SIZE;
 
-		jpg_reg_ctx->jpg_data_addr = (UINT32)jpg_data_base_addr;
-		jpg_reg_ctx->img_data_addr = (UINT32)jpg_data_base_addr
-						+ JPG_STREAM_BUF_SIZE
-						+ JPG_STREAM_THUMB_BUF_SIZE;
+		result = s3c_jpeg_run_sync(jpg_reg_ctx, &job);
 
-		result = decode_jpg(jpg_reg_ctx, param.dec_param);
-		out = copy_to_user((void *)arg, (void *) & param, sizeof(jpg_args));
+		if (copy_to_user(param.dec_param, &job.dec,
+				 sizeof(jpg_dec_proc_param)))
+			return -EFAULT;
 		break;
 
 	case IOCTL_JPG_ENCODE:
 
 		jpg_dbg("IOCTL_JPEG_ENCODE\n");
 
-		out = copy_from_user(&param, (jpg_args *)arg, sizeof(jpg_args));
+		if (copy_from_user(&param, (jpg_args *)arg, sizeof(jpg_args)) ||
+		    copy_from_user(&job.enc, param.enc_param,
+				   sizeof(jpg_enc_proc_param)))
+			return -EFAULT;
 
 		jpg_dbg("encode size :: width : %d hegiht : %d\n",
-			param.enc_param->width, param.enc_param->height);
+			job.enc.width, job.enc.height);
 
-		if (param.enc_param->enc_type == JPG_MAIN) {
-			jpg_reg_ctx->jpg_data_addr = (UINT32)jpg_data_base_addr ;
-			jpg_reg_ctx->img_data_addr = (UINT32)jpg_data_base_addr
-							+ JPG_STREAM_BUF_SIZE
-							+ JPG_STREAM_THUMB_BUF_SIZE;
+		if (job.enc.enc_type == JPG_MAIN) {
+			enc_param = param.enc_param;
+			job.jpg_addr = base;
+			job.img_addr = base + JPG_STREAM_BUF_SIZE
+					+ JPG_STREAM_THUMB_BUF_SIZE;
 			jpg_dbg("enc_img_data_addr=0x%08x, enc_jpg_data_addr=0x%08x\n"
-				, jpg_reg_ctx->img_data_addr,jpg_reg_ctx->jpg_data_addr);
-
-			result = encode_jpg(jpg_reg_ctx, param.enc_param);
+				, job.img_addr, job.jpg_addr);
 		} else {
-			jpg_reg_ctx->img_thumb_data_addr = (UINT32)jpg_data_base_addr
-								+ JPG_STREAM_BUF_SIZE
-								+ JPG_STREAM_THUMB_BUF_SIZE
-								+ JPG_FRAME_BUF_SIZE;
-			jpg_reg_ctx->jpg_thumb_data_addr = (UINT32)jpg_data_base_addr
-								+ JPG_STREAM_BUF_SIZE;
-
-			result = encode_jpg(jpg_reg_ctx, param.thumb_enc_param);
+			enc_param = param.thumb_enc_param;
+			if (copy_from_user(&job.enc, enc_param,
+					   sizeof(jpg_enc_proc_param)))
+				return -EFAULT;
+			job.img_addr = base + JPG_STREAM_BUF_SIZE
+					+ JPG_STREAM_THUMB_BUF_SIZE
+					+ JPG_FRAME_BUF_SIZE;
+			job.jpg_addr = base + JPG_STREAM_BUF_SIZE;
 		}
-		out = copy_to_user((void *)arg, (void *) & param,  sizeof(jpg_args));
+
+		result = s3c_jpeg_run_sync(jpg_reg_ctx, &job);
+
+		if (copy_to_user(enc_param, &job.enc, sizeof(jpg_enc_proc_param)))
+			return -EFAULT;
 		break;
 
 	case IOCTL_JPG_GET_STRBUF:
 		jpg_dbg("IOCTL_JPG_GET_STRBUF\n");
-		unlock_jpg_mutex();
 		return arg + JPG_MAIN_STRART;
 
 	case IOCTL_JPG_GET_THUMB_STRBUF:
 		log_msg(LOG_TRACE, "s3c_jpeg_ioctl", "IOCTL_JPG_GET_THUMB_STRBUF\n");
-		unlock_jpg_mutex();
 		return arg + JPG_THUMB_START;
 
 	case IOCTL_JPG_GET_FRMBUF:
 		jpg_dbg("IOCTL_JPG_GET_FRMBUF\n");
-		unlock_jpg_mutex();
 		return arg + IMG_MAIN_START;
 
 	case IOCTL_JPG_GET_THUMB_FRMBUF:
 		jpg_dbg("IOCTL_JPG_GET_THUMB_FRMBUF\n");
-		unlock_jpg_mutex();
 		return arg + IMG_THUMB_START;
 
+	case IOCTL_JPG_GET_PHY_STRBUF:
+		jpg_dbg("IOCTL_JPG_GET_PHY_STRBUF\n");
+		return base + JPG_MAIN_STRART;
+
 	case IOCTL_JPG_GET_PHY_FRMBUF:
 		jpg_dbg("IOCTL_JPG_GET_PHY_FRMBUF\n");
-		unlock_jpg_mutex();
-		return jpg_data_base_addr + JPG_STREAM_BUF_SIZE + JPG_STREAM_THUMB_BUF_SIZE;
+		return base + JPG_STREAM_BUF_SIZE + JPG_STREAM_THUMB_BUF_SIZE;
 
 	case IOCTL_JPG_GET_PHY_THUMB_FRMBUF:
 		jpg_dbg("IOCTL_JPG_GET_PHY_THUMB_FRMBUF\n");
-		unlock_jpg_mutex();
-		return jpg_data_base_addr + JPG_STREAM_BUF_SIZE
+		return base + JPG_STREAM_BUF_SIZE
 			+ JPG_STREAM_THUMB_BUF_SIZE + JPG_FRAME_BUF_SIZE;
 
 	default :
 		jpg_dbg("JPG Invalid ioctl : 0x%X\n", cmd);
 	}
 
-	unlock_jpg_mutex();
-
 	return result;
 }
 
 static unsigned int s3c_jpeg_poll(struct file *file, poll_table *wait)
 {
+	sspc100_jpg_ctx	*jpg_reg_ctx = (sspc100_jpg_ctx *)file->private_data;
 	unsigned int mask = 0;
 
 	jpg_dbg("enter poll \n");
-	poll_wait(file, &wait_queue_jpeg, wait);
-	mask = POLLOUT | POLLWRNORM;
+	poll_wait(file, &jpg_reg_ctx->wait, wait);
+
+	spin_lock(&s3c_jpeg_lock);
+	if (!list_empty(&jpg_reg_ctx->done))
+		mask |= POLLIN | POLLRDNORM;
+	if (jpg_reg_ctx->queued < JPG_QUEUE_MAX)
+		mask |= POLLOUT | POLLWRNORM;
+	spin_unlock(&s3c_jpeg_lock);
+
 	return mask;
 }
 int s3c_jpeg_mmap(struct file *filp, struct vm_area_struct *vma)
 {
+	sspc100_jpg_ctx	*jpg_reg_ctx = (sspc100_jpg_ctx *)filp->private_data;
 	unsigned long size	= vma->vm_end - vma->vm_start;
 	unsigned long max_size;
 	unsigned long page_frame_no;
 
-	page_frame_no = __phys_to_pfn(jpg_data_base_addr);
+	if (jpg_reg_ctx->slot < 0)
+		return -ENOMEM;
+
+	page_frame_no = __phys_to_pfn(jpg_reg_ctx->slot_addr);
 
-	max_size = JPG_TOTAL_BUF_SIZE + PAGE_SIZE - (JPG_TOTAL_BUF_SIZE % PAGE_SIZE);
+	max_size = PAGE_ALIGN(JPG_TOTAL_BUF_SIZE);
 
 	if (size > max_size) {
 		return -EINVAL;
@@ -448,6 +870,20 @@ static int s3c_jpeg_probe(struct platform_device *pdev)
 	
 	init_waitqueue_head(&wait_queue_jpeg);
 
+	/* split the reserved memory into one buffer set per instance */
+	s3c_jpeg_slots = s3c_get_media_memsize(S3C_MDEV_JPEG) / JPG_TOTAL_BUF_SIZE;
+	if (s3c_jpeg_slots > MAX_INSTANCE_NUM)
+		s3c_jpeg_slots = MAX_INSTANCE_NUM;
+	s3c_jpeg_slot_map = 0;
+	jpg_dbg("%d instances with reserved buffers\n", s3c_jpeg_slots);
+
+	INIT_WORK(&s3c_jpeg_work, s3c_jpeg_work_fn);
+	s3c_jpeg_wq = create_singlethread_workqueue("s3c-jpeg");
+	if (s3c_jpeg_wq == NULL) {
+		jpg_err("failed to create workqueue\n");
+		return -ENOMEM;
+	}
+
 	jpg_dbg("JPG_Init\n");
 
 	// Mutex initialization
@@ -486,6 +922,7 @@ static int s3c_jpeg_remove(struct platform_device *dev)
 
 	free_irq(irq_no, dev);
 	misc_deregister(&s3c_jpeg_miscdev);
+	destroy_workqueue(s3c_jpeg_wq);
 	return 0;
 }
 
@@ -14,8 +14,9 @@
 #define __JPEG_DRIVER_H__
 
 
-#define MAX_INSTANCE_NUM	1
+#define MAX_INSTANCE_NUM	4
 #define MAX_PROCESSING_THRESHOLD 1000	// 1Sec
+#define JPG_QUEUE_MAX		4	// streaming frames per instance, queued or not dequeued
 
 #define IOCTL_JPG_DECODE			0x00000002
 #define IOCTL_JPG_ENCODE			0x00000003
@@ -25,6 +26,13 @@
 #define IOCTL_JPG_GET_THUMB_FRMBUF		0x0000000B
 #define IOCTL_JPG_GET_PHY_FRMBUF		0x0000000C
 #define IOCTL_JPG_GET_PHY_THUMB_FRMBUF	0x0000000D
+#define IOCTL_JPG_GET_PHY_STRBUF		0x0000000E
+
+/* continuous (MJPEG) encoding, see jpg_stream_frame */
+#define IOCTL_JPG_STREAM_START			0x00000010
+#define IOCTL_JPG_STREAM_STOP			0x00000011
+#define IOCTL_JPG_QUEUE_FRAME			0x00000012
+#define IOCTL_JPG_DEQUEUE_FRAME			0x00000013
 #define JPG_CLOCK_DIVIDER_RATIO_QUARTER	4
 
 #endif /*__JPEG_DRIVER_H__*/
@@ -56,6 +56,85 @@ unsigned char		*s3c_mfc_virt_data_buf;
 DECLARE_WAIT_QUEUE_HEAD(s3c_mfc_wait_queue);
 BOOL s3c_mfc_is_running(void);
 
+static int s3c_mfc_get_data_buf(void)
+{
+	size_t size = s3c_get_media_memsize(S3C_MDEV_MFC);
+
+#ifdef CONFIG_S5PC1XX_MEDIA_SHARED
+	s3c_mfc_phys_data_buf = s3c_media_alloc(S3C_MDEV_MFC, size);
+#else
+	s3c_mfc_phys_data_buf = s3c_get_media_memory(S3C_MDEV_MFC);
+#endif
+	if (!s3c_mfc_phys_data_buf)
+		return -ENOMEM;
+
+	s3c_mfc_virt_data_buf = ioremap_nocache(s3c_mfc_phys_data_buf, size);
+	if (s3c_mfc_virt_data_buf == NULL)
+		goto err_map;
+
+	if (s3c_mfc_init_buffer_manager() < 0) {
+		mfc_err("buffer manager initialization was failed\n");
+		goto err_pool;
+	}
+
+	return 0;
+
+err_pool:
+	iounmap(s3c_mfc_virt_data_buf);
+	s3c_mfc_virt_data_buf = NULL;
+err_map:
+#ifdef CONFIG_S5PC1XX_MEDIA_SHARED
+	s3c_media_free(S3C_MDEV_MFC, s3c_mfc_phys_data_buf);
+#endif
+	s3c_mfc_phys_data_buf = 0;
+	return -ENOMEM;
+}
+
+static void s3c_mfc_put_data_buf(void)
+{
+	if (s3c_mfc_exit_buffer_manager() < 0)
+		return;
+
+	iounmap(s3c_mfc_virt_data_buf);
+	s3c_mfc_virt_data_buf = NULL;
+#ifdef CONFIG_S5PC1XX_MEDIA_SHARED
+	s3c_media_free(S3C_MDEV_MFC, s3c_mfc_phys_data_buf);
+#endif
+	s3c_mfc_phys_data_buf = 0;
+}
+
+#ifdef CONFIG_S5PC1XX_MEDIA_SHARED
+/*
+ * The data buffer is only held while an instance is open, the rest of the
+ * time the media region lends it to the page allocator.
+ */
+static int s3c_mfc_users;
+
+static int s3c_mfc_get_mem(void)
+{
+	if (s3c_mfc_users == 0 && s3c_mfc_get_data_buf() < 0)
+		return -ENOMEM;
+
+	s3c_mfc_users++;
+	return 0;
+}
+
+static void s3c_mfc_put_mem(void)
+{
+	if (--s3c_mfc_users == 0)
+		s3c_mfc_put_data_buf();
+}
+#else
+static inline int s3c_mfc_get_mem(void)
+{
+	return 0;
+}
+
+static inline void s3c_mfc_put_mem(void)
+{
+}
+#endif
+
 static int s3c_mfc_open(struct inode *inode, struct file *file)
 {
 	s3c_mfc_inst_ctx *MfcCtx;
@@ -101,6 +180,14 @@ static int s3c_mfc_open(struct inode *inode, struct file *file)
 		goto out_open;
 	}
 
+	if (s3c_mfc_get_mem() < 0) {
+		mfc_err("MFCINST_MEMORY_ALLOC_FAIL\n");
+		s3c_mfc_return_inst_no(MfcCtx->InstNo);
+		kfree(MfcCtx);
+		ret = -ENOMEM;
+		goto out_open;
+	}
+
 	MfcCtx->extraDPB = MFC_MAX_EXTRA_DPB;
 	MfcCtx->FrameType = MFC_RET_FRAME_NOT_SET;
 
@@ -129,7 +216,8 @@ static int s3c_mfc_release(struct inode *inode, struct file *file)
 
 	s3c_mfc_clear_reset_state(MfcCtx->InstNo);
 
-	s3c_mfc_merge_frag(MfcCtx->InstNo);
+	s3c_mfc_release_inst_mem(MfcCtx);
+	s3c_mfc_put_mem();
 	
 	s3c_mfc_return_inst_no(MfcCtx->InstNo);
 	kfree(MfcCtx);
@@ -539,12 +627,6 @@ static int s3c_mfc_probe(struct platform_device *pdev)
 
 	mutex_init(&s3c_mfc_mutex);
 
-	/*
-	 * buffer memory secure
-	 */
-	s3c_mfc_phys_data_buf = s3c_get_media_memory(S3C_MDEV_MFC);
-	s3c_mfc_virt_data_buf = ioremap_nocache(s3c_mfc_phys_data_buf, s3c_get_media_memsize(S3C_MDEV_MFC));
-
 	/*
 	 * firmware load
 	 */
@@ -563,7 +645,15 @@ static int s3c_mfc_probe(struct platform_device *pdev)
 
 	s3c_mfc_init_inst_no();
 
-	s3c_mfc_init_buffer_manager();
+#ifndef CONFIG_S5PC1XX_MEDIA_SHARED
+	/*
+	 * buffer memory secure
+	 */
+	if (s3c_mfc_get_data_buf() < 0) {
+		ret = -ENOMEM;
+		goto probe_out;
+	}
+#endif
 
 	ret = misc_register(&s3c_mfc_miscdev);
 
@@ -592,7 +682,9 @@ static int s3c_mfc_remove(struct platform_device *pdev)
 	kfree((void *)s3c_mfc_virt_fw_buf);
 
 	iounmap(s3c_mfc_sfr_virt_base);
-	iounmap(s3c_mfc_virt_data_buf);
+#ifndef CONFIG_S5PC1XX_MEDIA_SHARED
+	s3c_mfc_put_data_buf();
+#endif
 
 	/* remove memory region */
 	if (s3c_mfc_mem != NULL) {
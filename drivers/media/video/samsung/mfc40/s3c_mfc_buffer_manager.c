@@ -13,6 +13,7 @@
 
 #include <linux/types.h>
 #include <linux/slab.h>
+#include <linux/genalloc.h>
 #include <plat/media.h>
 
 #include "s3c_mfc_buffer_manager.h"
@@ -21,8 +22,10 @@
 
 s3c_mfc_alloc_mem_t *s3c_mfc_alloc_mem_head;
 s3c_mfc_alloc_mem_t *s3c_mfc_alloc_mem_tail;
-s3c_mfc_free_mem_t *s3c_mfc_free_mem_head;
-s3c_mfc_free_mem_t *s3c_mfc_free_mem_tail;
+
+/* best-fit pool over the MFC data buffer, allocated in BUF_ALIGN_UNIT units */
+static struct gen_pool *s3c_mfc_pool;
+static unsigned int s3c_mfc_pool_used;
 
 extern dma_addr_t s3c_mfc_phys_data_buf;
 extern unsigned char *s3c_mfc_virt_data_buf;
@@ -43,7 +46,6 @@ static void s3c_mfc_insert_node_to_alloc_list(s3c_mfc_alloc_mem_t *node, int ins
 void s3c_mfc_print_list(void)
 {
 	s3c_mfc_alloc_mem_t *node1;
-	s3c_mfc_free_mem_t *node2;
 	int count = 0;
 	unsigned int p_addr;
 
@@ -58,21 +60,18 @@ void s3c_mfc_print_list(void)
 
 	}
 
-	count = 0;
-	for (node2 = s3c_mfc_free_mem_head; node2 != s3c_mfc_free_mem_tail; node2 = node2->next) {
-		printk("s3c_mfc_print_list [FreeList][%d] startAddr : 0x%08x size:%d\n", 
-				count++, node2->start_addr , node2->size);
-	}
+	printk("s3c_mfc_print_list [Pool] used : %d free : %d\n",
+			s3c_mfc_pool_used, s3c_get_media_memsize(S3C_MDEV_MFC) - s3c_mfc_pool_used);
 }
 
 int list_count()
 {
 	int count = 0;
-	s3c_mfc_free_mem_t *node;
+	s3c_mfc_alloc_mem_t *node;
 
-	node = s3c_mfc_free_mem_head;
+	node = s3c_mfc_alloc_mem_head;
 	
-	while (node != s3c_mfc_free_mem_tail) {	
+	while (node != s3c_mfc_alloc_mem_tail) {	
 		node = node->next;
 		count++;
 	}
@@ -80,63 +79,6 @@ int list_count()
 	return count;
 }
 
-static void s3c_mfc_insert_first_node_to_free_list(s3c_mfc_free_mem_t *node,  int inst_no)
-{
-	mfc_debug("[%d]instance(startAddr : 0x%08x size:%d  cached flag : %d)\n",
-			inst_no, node->start_addr, node->size, node->cache_flag);	
-
-	node->next = s3c_mfc_free_mem_head;
-	node->prev = s3c_mfc_free_mem_head->prev;
-	s3c_mfc_free_mem_head->prev->next = node;
-	s3c_mfc_free_mem_head->prev = node;
-	s3c_mfc_free_mem_head = node;
-	
-}
-
-/* insert node ahead of s3c_mfc_free_mem_head */
-static void s3c_mfc_insert_node_to_free_list(s3c_mfc_free_mem_t *node,  int inst_no)
-{
-	s3c_mfc_free_mem_t *itr_node;
-	
-	mfc_debug("[%d]instance(startAddr : 0x%08x size:%d  cached flag : %d)\n",
-			inst_no, node->start_addr, node->size, node->cache_flag);	
-
-	itr_node = s3c_mfc_free_mem_head;
-	
-	while (itr_node != s3c_mfc_free_mem_tail) {
-		
-		if (itr_node->start_addr >= node->start_addr) {
-			/* head */
-			if (itr_node == s3c_mfc_free_mem_head) {
-				node->next = s3c_mfc_free_mem_head;
-				node->prev = s3c_mfc_free_mem_head->prev;
-				s3c_mfc_free_mem_head->prev->next = node;
-				s3c_mfc_free_mem_head->prev = node;
-				s3c_mfc_free_mem_head = node;
-				break;
-			} else { /* mid */
-				node->next = itr_node;
-				node->prev = itr_node->prev;
-				itr_node->prev->next = node;
-				itr_node->prev = node;
-				break;
-			}
-		
-		}
-
-		itr_node = itr_node->next;
-	}
-
-	/* tail */
-	if (itr_node == s3c_mfc_free_mem_tail) {
-		node->next = s3c_mfc_free_mem_tail;
-		node->prev = s3c_mfc_free_mem_tail->prev;
-		s3c_mfc_free_mem_tail->prev->next = node;
-		s3c_mfc_free_mem_tail->prev = node;
-	}
-	
-}
-
 static void s3c_mfc_del_node_from_alloc_list(s3c_mfc_alloc_mem_t *node, int inst_no)
 {
 	mfc_debug("[%d]instance (uncached_p_addr : 0x%08x cached_p_addr : 0x%08x size:%d cacheflag : %d)\n",
@@ -156,141 +98,129 @@ static void s3c_mfc_del_node_from_alloc_list(s3c_mfc_alloc_mem_t *node, int inst
 	kfree(node);
 }
 
+/*
+ * Cached and non-cached requests share the pool: both views map the whole
+ * data buffer, only the user address differs.
+ */
+static unsigned int s3c_mfc_get_mem_area(int allocSize, int inst_no)
+{
+	unsigned int	allocAddr;
 
+	mfc_debug("[%d]instance request Size : %d\n", inst_no, allocSize);
 
-static void s3c_mfc_del_node_from_free_list( s3c_mfc_free_mem_t *node, int inst_no)
-{
-	mfc_debug("[%d]s3c_mfc_del_node_from_free_list(startAddr : 0x%08x size:%d)\n", 
-						inst_no, node->start_addr, node->size);
-	if(node == s3c_mfc_free_mem_tail){
-		mfc_err("InValid node\n");
-		return;
+	allocAddr = gen_pool_alloc_best_fit(s3c_mfc_pool, allocSize, MFC_BUF_ALIGN_ORDER);
+	if (!allocAddr) {
+		mfc_err("there is no suitable chunk (size : %d used : %d)\n",
+				allocSize, s3c_mfc_pool_used);
+		return 0;
 	}
 
-	if(node == s3c_mfc_free_mem_head)
-		s3c_mfc_free_mem_head = node->next;
+	s3c_mfc_pool_used += allocSize;
 
-	node->prev->next = node->next;
-	node->next->prev = node->prev;
-
-	kfree(node);
+	return allocAddr;
 }
 
-/* Remove Fragmentation in FreeMemList */
-void s3c_mfc_merge_frag(int inst_no)
+static void s3c_mfc_put_mem_area(unsigned int addr, int size, int inst_no)
 {
-	s3c_mfc_free_mem_t *node1, *node2;
-
-	node1 = s3c_mfc_free_mem_head;
-
-	while (node1 != s3c_mfc_free_mem_tail) {
-		node2 = s3c_mfc_free_mem_head;
-		while (node2 != s3c_mfc_free_mem_tail) {
-			if ((node1->start_addr + node1->size == node2->start_addr) && (node1->cache_flag == node2->cache_flag)) {
-				node1->size += node2->size;
-				mfc_debug("find merge area !! ( node1->start_addr + node1->size == node2->start_addr)\n");
-				s3c_mfc_del_node_from_free_list(node2, inst_no);
-				break;
-			} else if((node1->start_addr == node2->start_addr + node2->size) && 
-						(node1->cache_flag == node2->cache_flag) ) {
-				mfc_debug("find merge area !! ( node1->start_addr == node2->start_addr + node2->size)\n");
-				node1->start_addr = node2->start_addr;
-				node1->size += node2->size;
-				s3c_mfc_del_node_from_free_list(node2, inst_no);
-				break;
-			}
-			node2 = node2->next;
-		}
-		node1 = node1->next;
-	}
+	mfc_debug("[%d]instance release addr : 0x%08x size : %d\n", inst_no, addr, size);
+
+	gen_pool_free(s3c_mfc_pool, addr, size);
+	s3c_mfc_pool_used -= size;
 }
 
-static unsigned int s3c_mfc_get_mem_area(int allocSize, int inst_no, char cache_flag)
+/* only the address matching the cache flag of a node is set */
+static unsigned int s3c_mfc_node_p_addr(s3c_mfc_alloc_mem_t *node)
 {
-	s3c_mfc_free_mem_t	*node, *match_node = NULL;
-	unsigned int	allocAddr = 0;
-
-
-	mfc_debug("request Size : %ld\n", allocSize);
+	if (node->cache_flag == MFC_MEM_CACHED)
+		return node->cached_p_addr;
 
-	if (s3c_mfc_free_mem_head == s3c_mfc_free_mem_tail) {
-		mfc_err("all memory is gone\n");
-		return(allocAddr);
-	}
+	return node->uncached_p_addr;
+}
 
-	/* find best chunk of memory */
-	for (node = s3c_mfc_free_mem_head; node != s3c_mfc_free_mem_tail; node = node->next) {
-		if (match_node != NULL) {
-			if (cache_flag) {
-				if ((node->size >= allocSize) && (node->size < match_node->size) && (node->cache_flag))
-					match_node = node;
-			} else {
-				if ((node->size >= allocSize) && (node->size < match_node->size) && (!node->cache_flag))
-					match_node = node;
-			}
-		} else {
-			if (cache_flag) {
-				if ((node->size >= allocSize) && (node->cache_flag))
-					match_node = node;
-			} else {
-				if ((node->size >= allocSize) && (!node->cache_flag))
-					match_node = node;
-			}
-		}
-	}
+/* codec working buffers which are not visible to the user */
+unsigned int s3c_mfc_alloc_codec_buf(int inst_no, unsigned int size)
+{
+	return s3c_mfc_get_mem_area(Align(size, BUF_ALIGN_UNIT), inst_no);
+}
 
-	if (match_node != NULL) {
-		mfc_debug("match : startAddr(0x%08x) size(%ld) cache flag(%d)\n", 
-			match_node->start_addr, match_node->size, match_node->cache_flag);
-	}
+void s3c_mfc_free_codec_buf(int inst_no, unsigned int p_addr, unsigned int size)
+{
+	s3c_mfc_put_mem_area(p_addr, Align(size, BUF_ALIGN_UNIT), inst_no);
+}
 
-	/* rearange FreeMemArea */
-	if (match_node != NULL) {
-		allocAddr = match_node->start_addr;
-		match_node->start_addr += allocSize;
-		match_node->size -= allocSize;
+/* Give back everything the instance still holds in the data buffer */
+void s3c_mfc_release_inst_mem(s3c_mfc_inst_ctx *MfcCtx)
+{
+	s3c_mfc_alloc_mem_t *node, *next;
 
-		if(match_node->size == 0)          /* delete match_node. */
-			s3c_mfc_del_node_from_free_list(match_node, inst_no);
+	for (node = s3c_mfc_alloc_mem_head; node != s3c_mfc_alloc_mem_tail; node = next) {
+		next = node->next;
+		if (node->inst_no != MfcCtx->InstNo)
+			continue;
 
-		return(allocAddr);
-	} else {
-		printk("there is no suitable chunk\n");
-		return 0;
+		s3c_mfc_put_mem_area(s3c_mfc_node_p_addr(node), node->size,
+				     MfcCtx->InstNo);
+		s3c_mfc_del_node_from_alloc_list(node, MfcCtx->InstNo);
 	}
 
-	return(allocAddr);
+	if (MfcCtx->vsp_phys_buf) {
+		s3c_mfc_free_codec_buf(MfcCtx->InstNo, MfcCtx->vsp_phys_buf, MfcCtx->vsp_buf_size);
+		MfcCtx->vsp_phys_buf = 0;
+		MfcCtx->vsp_buf_size = 0;
+	}
 }
 
 
 int s3c_mfc_init_buffer_manager(void)
 {
-	s3c_mfc_free_mem_t	*free_node;
 	s3c_mfc_alloc_mem_t	*alloc_node;
 
 	/* init alloc list, if(s3c_mfc_alloc_mem_head == s3c_mfc_alloc_mem_tail) then, the list is NULL */
 	alloc_node = (s3c_mfc_alloc_mem_t *)kmalloc(sizeof(s3c_mfc_alloc_mem_t), GFP_KERNEL);
+	if (alloc_node == NULL)
+		return -ENOMEM;
 	memset(alloc_node, 0x00, sizeof(s3c_mfc_alloc_mem_t));
 	alloc_node->next = alloc_node;
 	alloc_node->prev = alloc_node;
 	s3c_mfc_alloc_mem_head = alloc_node;
 	s3c_mfc_alloc_mem_tail = s3c_mfc_alloc_mem_head;
 
-	/* init free list, if(s3c_mfc_free_mem_head == s3c_mfc_free_mem_tail) then, the list is NULL */
-	free_node = (s3c_mfc_free_mem_t *)kmalloc(sizeof(s3c_mfc_free_mem_t), GFP_KERNEL);
-	memset(free_node, 0x00, sizeof(s3c_mfc_free_mem_t));
-	free_node->next = free_node;
-	free_node->prev = free_node;
-	s3c_mfc_free_mem_head = free_node;
-	s3c_mfc_free_mem_tail = s3c_mfc_free_mem_head;
-
-	/* init free head node */
-	free_node = (s3c_mfc_free_mem_t *)kmalloc(sizeof(s3c_mfc_free_mem_t), GFP_KERNEL);
-	memset(free_node, 0x00, sizeof(s3c_mfc_free_mem_t));
-	free_node->start_addr = s3c_mfc_phys_data_buf;
-	free_node->cache_flag = 0;
-	free_node->size = s3c_get_media_memsize(S3C_MDEV_MFC);
-	s3c_mfc_insert_first_node_to_free_list(free_node, -1);
+	/* the whole data buffer is one chunk of the pool */
+	s3c_mfc_pool = gen_pool_create(MFC_BUF_ALIGN_ORDER, -1);
+	if (s3c_mfc_pool == NULL)
+		goto err_pool;
+
+	if (gen_pool_add(s3c_mfc_pool, s3c_mfc_phys_data_buf,
+			 s3c_get_media_memsize(S3C_MDEV_MFC), -1) < 0)
+		goto err_chunk;
+
+	s3c_mfc_pool_used = 0;
+
+	return 0;
+
+err_chunk:
+	gen_pool_destroy(s3c_mfc_pool);
+	s3c_mfc_pool = NULL;
+err_pool:
+	kfree(alloc_node);
+	return -ENOMEM;
+}
+
+/* Tear the pool down once every instance has given its memory back */
+int s3c_mfc_exit_buffer_manager(void)
+{
+	if (s3c_mfc_pool_used) {
+		mfc_err("%d bytes of the data buffer still in use\n",
+			s3c_mfc_pool_used);
+		return -EBUSY;
+	}
+
+	gen_pool_destroy(s3c_mfc_pool);
+	s3c_mfc_pool = NULL;
+
+	kfree(s3c_mfc_alloc_mem_head);
+	s3c_mfc_alloc_mem_head = NULL;
+	s3c_mfc_alloc_mem_tail = NULL;
 
 	return 0;
 }
@@ -300,8 +230,6 @@ int s3c_mfc_init_buffer_manager(void)
 MFC_ERROR_CODE s3c_mfc_release_alloc_mem(s3c_mfc_inst_ctx  *MfcCtx,  s3c_mfc_args *args)
 {		
 	int ret;
-
-	s3c_mfc_free_mem_t *free_node;
 	s3c_mfc_alloc_mem_t *node;
 
 	for(node = s3c_mfc_alloc_mem_head; node != s3c_mfc_alloc_mem_tail; node = node->next) {
@@ -315,18 +243,8 @@ MFC_ERROR_CODE s3c_mfc_release_alloc_mem(s3c_mfc_inst_ctx  *MfcCtx,  s3c_mfc_arg
 		goto out_releaseallocmem;
 	}
 
-	free_node = (s3c_mfc_free_mem_t	*)kmalloc(sizeof(s3c_mfc_free_mem_t), GFP_KERNEL);
-
-	if(node->cache_flag) {
-		free_node->start_addr = node->cached_p_addr;
-		free_node->cache_flag = 1;
-	} else {
-		free_node->start_addr = node->uncached_p_addr;
-		free_node->cache_flag = 0;
-	}
-
-	free_node->size = node->size;
-	s3c_mfc_insert_node_to_free_list(free_node, MfcCtx->InstNo);
+	s3c_mfc_put_mem_area(s3c_mfc_node_p_addr(node), node->size,
+			     MfcCtx->InstNo);
 
 	/* Delete from AllocMem list */
 	s3c_mfc_del_node_from_alloc_list(node, MfcCtx->InstNo);
@@ -354,10 +272,7 @@ MFC_ERROR_CODE s3c_mfc_get_phys_addr(s3c_mfc_inst_ctx *MfcCtx, s3c_mfc_args *arg
 		goto out_getphysaddr;
 	}
 
-	if(node->cache_flag == MFC_MEM_CACHED)
-		codec_get_phy_addr_arg->p_addr = node->cached_p_addr;
-	else
-		codec_get_phy_addr_arg->p_addr = node->uncached_p_addr;
+	codec_get_phy_addr_arg->p_addr = s3c_mfc_node_p_addr(node);
 
 	ret = MFCINST_RET_OK;
 
@@ -378,7 +293,7 @@ MFC_ERROR_CODE s3c_mfc_get_virt_addr(s3c_mfc_inst_ctx  *MfcCtx,  s3c_mfc_args *a
 
 	/* if user request cachable area, allocate from reserved area */
 	/* if user request uncachable area, allocate dynamically */
-	p_startAddr = s3c_mfc_get_mem_area((int)in_param->buff_size, inst_no, in_param->cache_flag);
+	p_startAddr = s3c_mfc_get_mem_area(Align((int)in_param->buff_size, BUF_ALIGN_UNIT), inst_no);
 	mfc_debug("p_startAddr = 0x%X\n\r", p_startAddr);
 
 	if (!p_startAddr) {
@@ -389,6 +304,12 @@ MFC_ERROR_CODE s3c_mfc_get_virt_addr(s3c_mfc_inst_ctx  *MfcCtx,  s3c_mfc_args *a
 	}
 
 	p_allocMem = (s3c_mfc_alloc_mem_t *)kmalloc(sizeof(s3c_mfc_alloc_mem_t), GFP_KERNEL);
+	if (p_allocMem == NULL) {
+		s3c_mfc_put_mem_area(p_startAddr, Align((int)in_param->buff_size, BUF_ALIGN_UNIT), inst_no);
+		in_param->out_addr = -1;
+		ret = MFCINST_MEMORY_ALLOC_FAIL;
+		goto out_getcodecviraddr;
+	}
 	memset(p_allocMem, 0x00, sizeof(s3c_mfc_alloc_mem_t));
 
 	if (in_param->cache_flag == MFC_MEM_CACHED) {
@@ -419,7 +340,7 @@ MFC_ERROR_CODE s3c_mfc_get_virt_addr(s3c_mfc_inst_ctx  *MfcCtx,  s3c_mfc_args *a
 	mfc_debug("u_addr : 0x%x v_addr : 0x%x cached_p_addr : 0x%x, uncached_p_addr : 0x%x\n",
 		p_allocMem->u_addr, p_allocMem->v_addr, p_allocMem->cached_p_addr, p_allocMem->uncached_p_addr);
 
-	p_allocMem->size = (int)in_param->buff_size;
+	p_allocMem->size = Align((int)in_param->buff_size, BUF_ALIGN_UNIT);
 	p_allocMem->inst_no = inst_no;
 	p_allocMem->cache_flag = in_param->cache_flag;
 
@@ -34,19 +34,16 @@ typedef struct tag_alloc_mem_t
 } s3c_mfc_alloc_mem_t;
 
 
-typedef struct tag_free_mem_t
-{
-	struct tag_free_mem_t *prev;
-	struct tag_free_mem_t *next;
-	unsigned int start_addr;
-	unsigned int size;
-	char cache_flag;
-} s3c_mfc_free_mem_t;
+/* data buffer allocations start on a BUF_ALIGN_UNIT boundary */
+#define MFC_BUF_ALIGN_ORDER	(6)
 
 int list_count(void);
 void s3c_mfc_print_list(void);
 int s3c_mfc_init_buffer_manager(void);
-void s3c_mfc_merge_frag(int inst_no);
+int s3c_mfc_exit_buffer_manager(void);
+void s3c_mfc_release_inst_mem(s3c_mfc_inst_ctx *MfcCtx);
+unsigned int s3c_mfc_alloc_codec_buf(int inst_no, unsigned int size);
+void s3c_mfc_free_codec_buf(int inst_no, unsigned int p_addr, unsigned int size);
 MFC_ERROR_CODE s3c_mfc_release_alloc_mem(s3c_mfc_inst_ctx  *MfcCtx,  s3c_mfc_args *args);
 MFC_ERROR_CODE s3c_mfc_get_phys_addr(s3c_mfc_inst_ctx *MfcCtx, s3c_mfc_args *args);
 MFC_ERROR_CODE s3c_mfc_get_virt_addr(s3c_mfc_inst_ctx  *MfcCtx,  s3c_mfc_args *args);
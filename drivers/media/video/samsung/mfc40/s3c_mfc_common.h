@@ -103,6 +103,12 @@ typedef struct tag_mfc_inst_ctx
 	s3c_mfc_inst_state MfcState;
 
 	u32 virt_stream_buffer;
+
+	/* VSP and deblocking status buffers taken from the data buffer */
+	u32 vsp_phys_buf;
+	u32 vsp_buf_size;
+	u32 vsp_width;		/* widest picture the buffers are sized for */
+	u32 max_img_width;	/* MFC_DEC_SETCONF_MAX_WIDTH hint, 0 if not set */
 } s3c_mfc_inst_ctx;
 
 unsigned int s3c_mfc_get_codec_type(MFC_CODEC_TYPE    codec_type);
@@ -67,7 +67,8 @@ typedef enum
 	MFC_DEC_SETCONF_IS_LAST_FRAME,
 	MFC_DEC_GETCONF_IMG_RESOLUTION,
 	MFC_DEC_GETCONF_PHYS_ADDR,
-	MFC_DEC_SETCONF_CODECTYPE
+	MFC_DEC_SETCONF_CODECTYPE,
+	MFC_DEC_SETCONF_MAX_WIDTH
 }SSBSIP_MFC_DEC_CONF;
 
 typedef enum
@@ -33,11 +33,11 @@ volatile unsigned char *s3c_mfc_get_fw_buf_virt_addr()
 	return (volatile unsigned char *)s3c_mfc_virt_fw_buf;      
 }
 
-volatile unsigned char *s3c_mfc_get_vsp_buf_virt_addr(int instNo)	
+volatile unsigned char *s3c_mfc_get_cmd_vsp_buf_virt_addr(void)
 {
 	volatile unsigned char *virAddr;
 
-	virAddr = s3c_mfc_virt_fw_buf + MFC_MAX_FW_NUM*FIRMWARE_CODE_SIZE + instNo*VSP_BUF_SIZE;
+	virAddr = s3c_mfc_virt_fw_buf + MFC_MAX_FW_NUM*FIRMWARE_CODE_SIZE;
 	return virAddr; 
 }
 
@@ -51,11 +51,11 @@ unsigned int s3c_mfc_get_fw_buf_phys_addr()
 	return (unsigned int)__virt_to_phys((unsigned int)s3c_mfc_virt_fw_buf); /* IMAGE_MFC_BUFFER_PA_START; */
 }
 
-unsigned int s3c_mfc_get_vsp_buf_phys_addr(int instNo)
+unsigned int s3c_mfc_get_cmd_vsp_buf_phys_addr(void)
 {
 	unsigned int phyAddr;
 
-	phyAddr = s3c_mfc_get_fw_buf_phys_addr() + MFC_MAX_FW_NUM*FIRMWARE_CODE_SIZE + instNo * (VSP_BUF_SIZE+DB_STT_SIZE);
+	phyAddr = s3c_mfc_get_fw_buf_phys_addr() + MFC_MAX_FW_NUM*FIRMWARE_CODE_SIZE;
 	return phyAddr; 
 }
 
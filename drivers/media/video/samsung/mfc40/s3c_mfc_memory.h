@@ -29,16 +29,18 @@
 #define FIRMWARE_CODE_SIZE	(98304) /* 98,304 byte */
 #define VSP_BUF_SIZE		(393216) /* 393,216 byte */
 #define DB_STT_SIZE		(MFC_MAX_WIDTH*4*32) /* 163,840 byte */
+#define DB_STT_SIZE_FOR(width)	(Align((width), 16)*4*32)
 
 
 #define MFC_SFR_BUF_SIZE	sizeof(S5PC100_MFC_SFR)
-#define MFC_FW_BUF_SIZE		((MFC_MAX_FW_NUM * FIRMWARE_CODE_SIZE) + (MFC_MAX_INSTANCE_NUM + 1) * (VSP_BUF_SIZE + DB_STT_SIZE)) /* 3,014,656 */
+/* firmware images and the VSP buffer for command control, instances allocate their own */
+#define MFC_FW_BUF_SIZE		((MFC_MAX_FW_NUM * FIRMWARE_CODE_SIZE) + VSP_BUF_SIZE + DB_STT_SIZE) /* 1,343,488 */
 
 volatile unsigned char *s3c_mfc_get_fw_buf_virt_addr(void);
-volatile unsigned char *s3c_mfc_get_vsp_buf_virt_addr(int instNo);
+volatile unsigned char *s3c_mfc_get_cmd_vsp_buf_virt_addr(void);
 unsigned int s3c_mfc_get_sfr_phys_addr(void);
 unsigned int s3c_mfc_get_fw_buf_phys_addr(void);
-unsigned int s3c_mfc_get_vsp_buf_phys_addr(int instNo);
+unsigned int s3c_mfc_get_cmd_vsp_buf_phys_addr(void);
 unsigned int s3c_mfc_get_data_buffer_size(void);
 
 #endif /* _S3C_MFC_MEMORY_H_ */
@@ -42,10 +42,11 @@ static void s3c_mfc_cmd_frame_start(void);
 static void s3c_mfc_cmd_sleep(void);
 static void s3c_mfc_cmd_wakeup(void);
 static void s3c_mfc_set_codec_firmware(s3c_mfc_inst_ctx  *MfcCtx);
-static void s3c_mfc_set_encode_init_param(int inst_no, MFC_CODEC_TYPE mfc_codec_type, s3c_mfc_args *args);
+static MFC_ERROR_CODE s3c_mfc_set_encode_init_param(s3c_mfc_inst_ctx *MfcCtx, MFC_CODEC_TYPE mfc_codec_type, s3c_mfc_args *args);
 static MFC_ERROR_CODE s3c_mfc_set_dec_stream_buffer(int buf_addr, unsigned int buf_size);
 static MFC_ERROR_CODE s3c_mfc_set_dec_frame_buffer(s3c_mfc_inst_ctx  *MfcCtx, int buf_addr, unsigned int buf_size);
-static MFC_ERROR_CODE s3c_mfc_set_vsp_buffer(int InstNo);
+static MFC_ERROR_CODE s3c_mfc_alloc_vsp_buffer(s3c_mfc_inst_ctx *MfcCtx, unsigned int width);
+static MFC_ERROR_CODE s3c_mfc_set_vsp_buffer(s3c_mfc_inst_ctx *MfcCtx);
 static MFC_ERROR_CODE s3c_mfc_decode_one_frame(s3c_mfc_inst_ctx  *MfcCtx,  s3c_mfc_dec_exe_arg_t *DecArg, unsigned int *consumedStrmSize);
 
 static BOOL is_idr_or_islice(u8 *in, s32 in_size, BOOL *is_idr, s32 *start_pos, u32* slice_type);
@@ -145,16 +146,51 @@ static MFC_ERROR_CODE s3c_mfc_set_dec_frame_buffer(s3c_mfc_inst_ctx  *MfcCtx, in
 	return MFCINST_RET_OK;
 }
 
-static MFC_ERROR_CODE s3c_mfc_set_vsp_buffer(int InstNo)
+/*
+ * The VSP buffer has a fixed size, the deblocking status buffer grows with
+ * the picture width. Both come from the data buffer, so a small session
+ * only pays for its own resolution. A wider picture replaces the buffers.
+ */
+static MFC_ERROR_CODE s3c_mfc_alloc_vsp_buffer(s3c_mfc_inst_ctx *MfcCtx, unsigned int width)
+{
+	unsigned int size;
+
+	if ((width == 0) || (width > MFC_MAX_WIDTH))
+		width = MFC_MAX_WIDTH;
+
+	if (MfcCtx->vsp_phys_buf && (width <= MfcCtx->vsp_width))
+		return MFCINST_RET_OK;
+
+	if (MfcCtx->vsp_phys_buf) {
+		s3c_mfc_free_codec_buf(MfcCtx->InstNo, MfcCtx->vsp_phys_buf, MfcCtx->vsp_buf_size);
+		MfcCtx->vsp_phys_buf = 0;
+	}
+
+	size = VSP_BUF_SIZE + DB_STT_SIZE_FOR(width);
+	MfcCtx->vsp_phys_buf = s3c_mfc_alloc_codec_buf(MfcCtx->InstNo, size);
+	if (!MfcCtx->vsp_phys_buf) {
+		mfc_err("MFCINST_MEMORY_ALLOC_FAIL : VSP buffer for width %d\n", width);
+		MfcCtx->vsp_buf_size = 0;
+		MfcCtx->vsp_width = 0;
+		return MFCINST_MEMORY_ALLOC_FAIL;
+	}
+
+	MfcCtx->vsp_buf_size = size;
+	MfcCtx->vsp_width = width;
+
+	return MFCINST_RET_OK;
+}
+
+static MFC_ERROR_CODE s3c_mfc_set_vsp_buffer(s3c_mfc_inst_ctx *MfcCtx)
 {
 	unsigned int VSPPhyBuf;
 
-	VSPPhyBuf = s3c_mfc_get_vsp_buf_phys_addr(InstNo);
+	VSPPhyBuf = MfcCtx->vsp_phys_buf;
 	WRITEL(Align(VSPPhyBuf, BUF_ALIGN_UNIT), S3C_FIMV_VSP_BUF_ADDR);
 	WRITEL(Align(VSPPhyBuf + VSP_BUF_SIZE, BUF_ALIGN_UNIT), S3C_FIMV_DB_STT_ADDR);
 
 	mfc_debug("InstNo : %d VSP_BUF_ADDR : 0x%08x DB_STT_ADDR : 0x%08x\n",	\
-			InstNo, READL(S3C_FIMV_VSP_BUF_ADDR), READL(S3C_FIMV_DB_STT_ADDR));
+			MfcCtx->InstNo, READL(S3C_FIMV_VSP_BUF_ADDR), READL(S3C_FIMV_DB_STT_ADDR));
 
 	return MFCINST_RET_OK;
 }
@@ -178,8 +214,9 @@ static void s3c_mfc_set_codec_firmware(s3c_mfc_inst_ctx  *MfcCtx)
 
 
 /* This function sets the MFC SFR values according to the input arguments. */
-static void s3c_mfc_set_encode_init_param(int inst_no, MFC_CODEC_TYPE mfc_codec_type, s3c_mfc_args *args)
+static MFC_ERROR_CODE s3c_mfc_set_encode_init_param(s3c_mfc_inst_ctx *MfcCtx, MFC_CODEC_TYPE mfc_codec_type, s3c_mfc_args *args)
 {
+	MFC_ERROR_CODE		ret;
 	unsigned int		ms_size;
 
 	s3c_mfc_enc_init_mpeg4_arg_t   *EncInitMpeg4Arg;
@@ -190,7 +227,11 @@ static void s3c_mfc_set_encode_init_param(int inst_no, MFC_CODEC_TYPE mfc_codec_
 
 	mfc_debug("mfc_codec_type : %d\n", mfc_codec_type);
 
-	s3c_mfc_set_vsp_buffer(inst_no);
+	ret = s3c_mfc_alloc_vsp_buffer(MfcCtx, EncInitMpeg4Arg->in_width);
+	if (ret != MFCINST_RET_OK)
+		return ret;
+
+	s3c_mfc_set_vsp_buffer(MfcCtx);
 
 	/* Set the other SFR */
 	WRITEL(EncInitMpeg4Arg->in_dpb_addr, S3C_FIMV_ENC_DPB_ADR);
@@ -339,7 +380,7 @@ MFC_ERROR_CODE s3c_mfc_init_hw()
 	 * 	- set VSP buffer for command control
 	 * 	- set memory structure
 	 */
-	VSPPhyBuf = s3c_mfc_get_vsp_buf_phys_addr(MFC_MAX_INSTANCE_NUM);
+	VSPPhyBuf = s3c_mfc_get_cmd_vsp_buf_phys_addr();
 	WRITEL(Align(VSPPhyBuf, BUF_ALIGN_UNIT), S3C_FIMV_VSP_BUF_ADDR);
 
 	WRITEL(0, S3C_FIMV_BUS_MASTER);
@@ -358,6 +399,8 @@ MFC_ERROR_CODE s3c_mfc_init_hw()
 
 MFC_ERROR_CODE s3c_mfc_init_encode(s3c_mfc_inst_ctx  *MfcCtx,  s3c_mfc_args *args)
 {
+	MFC_ERROR_CODE ret;
+
 	mfc_debug("++\n");
 
 	MfcCtx->MfcCodecType = ((MFC_CODEC_TYPE *) args)[0];
@@ -393,7 +436,9 @@ MFC_ERROR_CODE s3c_mfc_init_encode(s3c_mfc_inst_ctx  *MfcCtx,  s3c_mfc_args *arg
 	 */
 
 	WRITEL(MfcCtx->InstNo, S3C_FIMV_CH_ID);
-	s3c_mfc_set_encode_init_param(MfcCtx->InstNo, MfcCtx->MfcCodecType, args);
+	ret = s3c_mfc_set_encode_init_param(MfcCtx, MfcCtx->MfcCodecType, args);
+	if (ret != MFCINST_RET_OK)
+		return ret;
 
 	WRITEL(s3c_mfc_get_codec_type(MfcCtx->MfcCodecType), S3C_FIMV_STANDARD_SEL);
 	WRITEL(MFC_INIT_CODEC, S3C_FIMV_COMMAND_TYPE);
@@ -427,7 +472,7 @@ MFC_ERROR_CODE s3c_mfc_exe_encode(s3c_mfc_inst_ctx  *MfcCtx,  s3c_mfc_args *args
 								EncExeArg->in_strm_st, EncExeArg->in_strm_end);
 	mfc_debug("EncExeArg->in_Y_addr : 0x%08x EncExeArg->in_CbCr_addr :0x%08x \r\n",   \
 								EncExeArg->in_Y_addr, EncExeArg->in_CbCr_addr);
-	s3c_mfc_set_vsp_buffer(MfcCtx->InstNo);
+	s3c_mfc_set_vsp_buffer(MfcCtx);
 
 
 	/*
@@ -525,7 +570,10 @@ MFC_ERROR_CODE s3c_mfc_init_decode(s3c_mfc_inst_ctx  *MfcCtx,  s3c_mfc_args *arg
 	 * 	- set Input Stream buffer
 	 * 	- set NUM_EXTRA_DPB
 	 */
-	s3c_mfc_set_vsp_buffer(MfcCtx->InstNo);
+	if (s3c_mfc_alloc_vsp_buffer(MfcCtx, MfcCtx->max_img_width) != MFCINST_RET_OK)
+		return MFCINST_MEMORY_ALLOC_FAIL;
+
+	s3c_mfc_set_vsp_buffer(MfcCtx);
 	s3c_mfc_set_dec_stream_buffer(InitArg->in_strm_buf, InitArg->in_strm_size);
 
 	WRITEL(1, S3C_FIMV_BITS_ENDIAN);
@@ -554,6 +602,12 @@ MFC_ERROR_CODE s3c_mfc_init_decode(s3c_mfc_inst_ctx  *MfcCtx,  s3c_mfc_args *arg
 	MfcCtx->img_width = READL(S3C_FIMV_IMG_SIZE_X);
 	MfcCtx->img_height = READL(S3C_FIMV_IMG_SIZE_Y);
 
+	if (MfcCtx->img_width > MfcCtx->vsp_width) {
+		mfc_err("width %d is bigger than MFC_DEC_SETCONF_MAX_WIDTH %d\n",
+				MfcCtx->img_width, MfcCtx->vsp_width);
+		return MFCINST_ERR_DEC_INVALID_STRM;
+	}
+
 
 	switch (MfcCtx->MfcCodecType) {
 	case H264_DEC: 
@@ -669,7 +723,7 @@ static MFC_ERROR_CODE s3c_mfc_decode_one_frame(s3c_mfc_inst_ctx  *MfcCtx,  s3c_m
 	s3c_mfc_set_dec_frame_buffer(MfcCtx, DecArg->in_frm_buf, DecArg->in_frm_size);
 
 	/* Set VSP */
-	s3c_mfc_set_vsp_buffer(MfcCtx->InstNo);
+	s3c_mfc_set_vsp_buffer(MfcCtx);
 
 	WRITEL( MfcCtx->InstNo, S3C_FIMV_CH_ID);
 	WRITEL(s3c_mfc_get_codec_type( MfcCtx->MfcCodecType), S3C_FIMV_STANDARD_SEL);
@@ -849,6 +903,20 @@ MFC_ERROR_CODE s3c_mfc_set_config(s3c_mfc_inst_ctx  *MfcCtx,  s3c_mfc_args *args
 		}
 		break;
 		
+	case MFC_DEC_SETCONF_MAX_WIDTH:
+		if (MfcCtx->MfcState >= MFCINST_STATE_DEC_SEQ_START) {
+			mfc_err("MFC_DEC_SETCONF_MAX_WIDTH : state is invalid\n");
+			return MFCINST_ERR_STATE_INVALID;
+		}
+
+		if ((set_cnf_arg->in_config_value[0] > 0) && (set_cnf_arg->in_config_value[0] <= MFC_MAX_WIDTH))
+			MfcCtx->max_img_width = set_cnf_arg->in_config_value[0];
+		else {
+			mfc_warn("MAX_WIDTH should be between 1 and %d\n", MFC_MAX_WIDTH);
+			MfcCtx->max_img_width = 0;
+		}
+		break;
+
 	case MFC_DEC_SETCONF_IS_LAST_FRAME:
 		if ((MfcCtx->MfcState != MFCINST_STATE_DEC_EXE) &&
 			(MfcCtx->MfcState != MFCINST_STATE_RESET_WAIT))	{
@@ -25,6 +25,7 @@
 #include <linux/slab.h>
 #include <linux/dma-mapping.h>
 #include <linux/clk.h>
+#include <linux/poll.h>
 
 #include <asm/io.h>
 #include <asm/uaccess.h>
@@ -42,6 +43,7 @@
 #include "s3c_mfc_intr.h"
 #include "s3c_mfc_memory.h"
 #include "s3c_mfc_buffer_manager.h"
+#include "s3c_mfc_sched.h"
 
 struct s3c_mfc_ctrl s3c_mfc;
 struct s3c_mfc_ctrl *ctrl = &s3c_mfc;
@@ -100,6 +102,7 @@ static int s3c_mfc_open(struct inode *inode, struct file *file)
 	}
 
 	memset(mfc_ctx, 0, sizeof(s3c_mfc_inst_ctx));
+	s3c_mfc_sched_init_inst(mfc_ctx);
 
 	/* get the inst no allocating some part of memory among reserved memory */
 	mfc_ctx->mem_inst_no = s3c_mfc_get_mem_inst_no(MEMORY);
@@ -144,6 +147,11 @@ static int s3c_mfc_release(struct inode *inode, struct file *file)
 	int ret;
 
 	mfc_debug("MFC Release..\n");
+
+	/* the scheduler thread takes the MFC mutex to run a frame */
+	if (file->private_data != NULL)
+		s3c_mfc_sched_release_inst(file->private_data);
+
 	mutex_lock(&s3c_mfc_mutex);
 
 #if	defined(CONFIG_VIDEO_MFC_FRAME_CLK_GATING)
@@ -204,6 +212,7 @@ static int s3c_mfc_ioctl(struct inode *inode, struct file *file,
 	s3c_mfc_inst_ctx *mfc_ctx = NULL;
 	s3c_mfc_common_args in_param;
 	s3c_mfc_alloc_mem_t *node;
+	struct s3c_mfc_sched_job *job;
 	int port_no = 0;
 	int matched_u_addr = 0;
 	//unsigned char *start;
@@ -284,20 +293,37 @@ static int s3c_mfc_ioctl(struct inode *inode, struct file *file,
 
 		case IOCTL_MFC_ENC_EXE:
 
+			if (s3c_mfc_sched_reserve(mfc_ctx, 0) < 0) {
+				in_param.ret_code = MFC_RET_ENC_EXE_ERR;
+				ret = -ERESTARTSYS;
+				break;
+			}
+
 			mutex_lock(&s3c_mfc_mutex);
 			if (s3c_mfc_set_state(mfc_ctx, MFCINST_STATE_ENC_EXE) < 0) {
 				mfc_err("MFC_RET_STATE_INVALID\n");
 				in_param.ret_code = MFC_RET_STATE_INVALID;
 				ret = -EINVAL;
 				mutex_unlock(&s3c_mfc_mutex);
+				s3c_mfc_sched_unreserve(mfc_ctx);
 				break;
 			}
 
+			job = s3c_mfc_sched_get_job(mfc_ctx, &(in_param.args));
+			mutex_unlock(&s3c_mfc_mutex);
+			if (job == NULL) {
+				mfc_err("MFC_RET_MEM_ALLOC_FAIL\n");
+				in_param.ret_code = MFC_RET_MEM_ALLOC_FAIL;
+				ret = -ENOMEM;
+				s3c_mfc_sched_unreserve(mfc_ctx);
+				break;
+			}
+
+			s3c_mfc_sched_submit(mfc_ctx, job, 0);
 			in_param.ret_code =
-				s3c_mfc_exe_encode(mfc_ctx, &(in_param.args));
+				s3c_mfc_sched_wait(mfc_ctx, job, &(in_param.args));
 			//mfc_debug("InParm->ret_code : %d\n", in_param.ret_code);
 			ret = in_param.ret_code;
-			mutex_unlock(&s3c_mfc_mutex);
 			break;
 
 		case IOCTL_MFC_DEC_INIT:
@@ -357,20 +383,96 @@ static int s3c_mfc_ioctl(struct inode *inode, struct file *file,
 
 		case IOCTL_MFC_DEC_EXE:
 
-			mutex_lock(&s3c_mfc_mutex);
 			mfc_debug("IOCTL_MFC_DEC_EXE\n");
+			if (s3c_mfc_sched_reserve(mfc_ctx, 0) < 0) {
+				in_param.ret_code = MFC_RET_DEC_EXE_ERR;
+				ret = -ERESTARTSYS;
+				break;
+			}
+
+			mutex_lock(&s3c_mfc_mutex);
 			if (s3c_mfc_set_state(mfc_ctx, MFCINST_STATE_DEC_EXE) < 0) {
 				mfc_err("MFC_RET_STATE_INVALID\n");
 				in_param.ret_code = MFC_RET_STATE_INVALID;
 				ret = -EINVAL;
 				mutex_unlock(&s3c_mfc_mutex);
+				s3c_mfc_sched_unreserve(mfc_ctx);
 				break;
 			}
 
+			job = s3c_mfc_sched_get_job(mfc_ctx, &(in_param.args));
+			mutex_unlock(&s3c_mfc_mutex);
+			if (job == NULL) {
+				mfc_err("MFC_RET_MEM_ALLOC_FAIL\n");
+				in_param.ret_code = MFC_RET_MEM_ALLOC_FAIL;
+				ret = -ENOMEM;
+				s3c_mfc_sched_unreserve(mfc_ctx);
+				break;
+			}
+
+			s3c_mfc_sched_submit(mfc_ctx, job, 0);
 			in_param.ret_code =
-				s3c_mfc_exe_decode(mfc_ctx, &(in_param.args));
+				s3c_mfc_sched_wait(mfc_ctx, job, &(in_param.args));
 			ret = in_param.ret_code;
+			break;
+
+		case IOCTL_MFC_QUEUE_EXE:
+
+			ex_ret = s3c_mfc_sched_reserve(mfc_ctx,
+						file->f_flags & O_NONBLOCK);
+			if (ex_ret < 0) {
+				in_param.ret_code = MFC_RET_STATE_INVALID;
+				ret = ex_ret;
+				break;
+			}
+
+			mutex_lock(&s3c_mfc_mutex);
+			if (mfc_ctx->MfcState >= MFCINST_STATE_ENC_INITIALIZE)
+				ex_ret = s3c_mfc_set_state(mfc_ctx,
+						MFCINST_STATE_ENC_EXE);
+			else
+				ex_ret = s3c_mfc_set_state(mfc_ctx,
+						MFCINST_STATE_DEC_EXE);
+			if (ex_ret < 0) {
+				mfc_err("MFC_RET_STATE_INVALID\n");
+				in_param.ret_code = MFC_RET_STATE_INVALID;
+				ret = -EINVAL;
+				mutex_unlock(&s3c_mfc_mutex);
+				s3c_mfc_sched_unreserve(mfc_ctx);
+				break;
+			}
+
+			job = s3c_mfc_sched_get_job(mfc_ctx, &(in_param.args));
 			mutex_unlock(&s3c_mfc_mutex);
+			if (job == NULL) {
+				mfc_err("MFC_RET_MEM_ALLOC_FAIL\n");
+				in_param.ret_code = MFC_RET_MEM_ALLOC_FAIL;
+				ret = -ENOMEM;
+				s3c_mfc_sched_unreserve(mfc_ctx);
+				break;
+			}
+
+			s3c_mfc_sched_submit(mfc_ctx, job, 1);
+			in_param.ret_code = MFC_RET_OK;
+			ret = in_param.ret_code;
+			break;
+
+		case IOCTL_MFC_DEQUEUE_EXE:
+
+			ex_ret = s3c_mfc_sched_dequeue(mfc_ctx, &in_param,
+						file->f_flags & O_NONBLOCK);
+			if (ex_ret == -ENOENT) {
+				mfc_err("no frame queued\n");
+				in_param.ret_code = MFC_RET_STATE_INVALID;
+				ret = -EINVAL;
+				break;
+			} else if (ex_ret < 0) {
+				in_param.ret_code = MFC_RET_STATE_INVALID;
+				ret = ex_ret;
+				break;
+			}
+
+			ret = in_param.ret_code;
 			break;
 
 		case IOCTL_MFC_GET_CONFIG:
@@ -588,11 +690,22 @@ static int s3c_mfc_mmap(struct file *filp, struct vm_area_struct *vma)
 
 }
 
+static unsigned int s3c_mfc_poll(struct file *file, poll_table *wait)
+{
+	s3c_mfc_inst_ctx *mfc_ctx = (s3c_mfc_inst_ctx *) file->private_data;
+
+	if (mfc_ctx == NULL)
+		return POLLERR;
+
+	return s3c_mfc_sched_poll(mfc_ctx, file, wait);
+}
+
 static struct file_operations s3c_mfc_fops = {
 	.owner = THIS_MODULE,
 	.open = s3c_mfc_open,
 	.release = s3c_mfc_release,
 	.ioctl = s3c_mfc_ioctl,
+	.poll = s3c_mfc_poll,
 	.mmap = s3c_mfc_mmap
 };
 
@@ -624,7 +737,7 @@ static irqreturn_t s3c_mfc_irq(int irq, void *dev_id)
 		s3c_mfc_clear_int();
 		s3c_mfc_int_type = int_reason;
 		s3c_mfc_err_type = error_reason;
-		wake_up_interruptible(&s3c_mfc_wait_queue);
+		wake_up(&s3c_mfc_wait_queue);
 	}
 	s3c_mfc_clear_ch_id(int_reason);
 
@@ -723,6 +836,12 @@ static int s3c_mfc_probe(struct platform_device *pdev)
 
 	mutex_init(&s3c_mfc_mutex);
 
+	ret = s3c_mfc_sched_init(&s3c_mfc_mutex);
+	if (ret < 0) {
+		dev_err(&pdev->dev, "failed to start frame scheduler\n");
+		goto probe_out;
+	}
+
 	/*
 	 * buffer memory secure
 	 */
@@ -796,6 +915,7 @@ static int s3c_mfc_remove(struct platform_device *pdev)
 
 	free_irq(IRQ_MFC, pdev);
 
+	s3c_mfc_sched_exit();
 	mutex_destroy(&s3c_mfc_mutex);
 
 	misc_deregister(&s3c_mfc_miscdev);
@@ -14,6 +14,9 @@
 #ifndef _S3C_MFC_COMMON_H_
 #define _S3C_MFC_COMMON_H_
 
+#include <linux/list.h>
+#include <linux/wait.h>
+
 #include <plat/regs-mfc.h>
 
 #include "s3c_mfc_interface.h"
@@ -126,6 +129,26 @@ typedef enum {
 	PORTB = 1
 } s3c_mfc_port_type;
 
+/* per-instance state of the frame scheduler, see s3c_mfc_sched.c */
+struct s3c_mfc_sched_inst {
+	struct list_head node;		/* on s3c_mfc_sched_list while it has work */
+	struct list_head pending;	/* frames waiting for the engine */
+	struct list_head done;		/* finished frames of IOCTL_MFC_QUEUE_EXE */
+	unsigned int queued;		/* pending + running + done */
+	wait_queue_head_t wait;
+
+	unsigned int weight;
+	unsigned long long period_ns;
+	unsigned long long next_deadline;
+	unsigned long long vtime;
+
+	/* statistics, latency is from queueing to completion */
+	unsigned int frames;
+	unsigned int missed;
+	unsigned long long total_ns;
+	unsigned long long max_ns;
+};
+
 typedef struct tag_mfc_inst_ctx {
 	int InstNo;
 	unsigned int DPBCnt;
@@ -157,6 +180,9 @@ typedef struct tag_mfc_inst_ctx {
 	int pre_display_Y_addr;
 	int pre_display_C_addr;
 	s3c_mfc_inst_state MfcState;
+	int decoding_stop;
+
+	struct s3c_mfc_sched_inst sched;
 } s3c_mfc_inst_ctx;
 
 struct s3c_mfc_ctrl {
@@ -21,6 +21,10 @@
 #define IOCTL_MFC_DEC_EXE		(0x00800003)
 #define IOCTL_MFC_ENC_EXE		(0x00800004)
 
+/* queued frames: same arguments as DEC_EXE/ENC_EXE, results in order */
+#define IOCTL_MFC_QUEUE_EXE		(0x00800005)
+#define IOCTL_MFC_DEQUEUE_EXE		(0x00800006)
+
 #define IOCTL_MFC_GET_IN_BUF		(0x00800010)
 #define IOCTL_MFC_FREE_BUF		(0x00800011)
 #define IOCTL_MFC_GET_PHYS_ADDR		(0x00800012)
@@ -90,6 +94,12 @@ typedef enum {
 	MFC_ENC_GETCONF_FRAME_TAG
 } SSBSIP_MFC_ENC_CONF;
 
+typedef enum {
+	MFC_SCHED_SETCONF_WEIGHT = 200,	/* share of the engine, 1 ~ 1000 */
+	MFC_SCHED_SETCONF_FRAME_PERIOD,	/* frame deadline in usec, 0 : none */
+	MFC_SCHED_GETCONF_LATENCY	/* frames, avg/max usec, missed */
+} SSBSIP_MFC_SCHED_CONF;
+
 typedef struct tag_strm_ref_buf_arg {
 	unsigned int strm_ref_y;
 	unsigned int mv_ref_yc;
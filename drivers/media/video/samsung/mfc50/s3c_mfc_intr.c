@@ -73,8 +73,13 @@ int s3c_mfc_wait_for_done(s3c_mfc_wait_done_type command)
 	case R2H_CMD_CLOSE_INSTANCE_RET:
 	case R2H_CMD_SLEEP_RET:
 	case R2H_CMD_WAKEUP_RET:
-		if (interruptible_sleep_on_timeout(&s3c_mfc_wait_queue,
-						   MFC_TIMEOUT) == 0) {
+		/*
+		 * the interrupt may come before we get here; whoever issued
+		 * the command cleared s3c_mfc_int_type just before it
+		 */
+		if (wait_event_timeout(s3c_mfc_wait_queue,
+				       s3c_mfc_int_type != 0,
+				       MFC_TIMEOUT) == 0) {
 			ret_val = 0;
 			mfc_err("Interrupt Time Out(%d)\n", command);
 			dump_sfrs();
@@ -26,6 +26,7 @@
 #include "s3c_mfc_buffer_manager.h"
 #include "s3c_mfc_interface.h"
 #include "s3c_mfc_intr.h"
+#include "s3c_mfc_sched.h"
 
 extern void __iomem *s3c_mfc_sfr_virt_base;
 
@@ -39,9 +40,6 @@ static volatile unsigned char *shared_mem_vir_addr;
 static int acc_consumed_size;
 static int in_strm_buf_base;
 
-/* for stopping sequence */
-static int decoding_stop;
-
 #ifdef DETECT_FRMAE_DROP
 int 	decoded_count_display;
 unsigned long long	mfc_start,mfc_mid,mfc_end;
@@ -77,6 +75,7 @@ static SSBSIP_MFC_ERROR_CODE s3c_mfc_set_dec_stream_buffer(int inst_no,
 		unsigned int
 		buf_size);
 static SSBSIP_MFC_ERROR_CODE s3c_mfc_set_shared_mem_buffer(int inst_no);
+static void s3c_mfc_select_shared_mem(int inst_no);
 static SSBSIP_MFC_ERROR_CODE s3c_mfc_set_risc_buffer(SSBSIP_MFC_CODEC_TYPE
 		codec_type, int inst_no);
 static SSBSIP_MFC_ERROR_CODE s3c_mfc_decode_one_frame(s3c_mfc_inst_ctx *
@@ -184,6 +183,7 @@ static int s3c_mfc_cmd_host2risc(s3c_mfc_facade_cmd cmd, int arg1, int arg2)
 			 s3c_mfc_init_count, fw_phybuf, context_base_addr);
 	}
 
+	s3c_mfc_int_type = 0;
 	WRITEL(cmd, S3C_FIMV_HOST2RISC_CMD);
 	return ret;
 }
@@ -330,6 +330,7 @@ SSBSIP_MFC_ERROR_CODE s3c_mfc_set_dec_frame_buffer(s3c_mfc_inst_ctx * mfc_ctx,
 	}
 
 	/* MFC fw 8/7 */
+	s3c_mfc_int_type = 0;
 	WRITEL((INIT_BUFFER << 16 & 0x70000) | (mfc_ctx->InstNo),
 			S3C_FIMV_SI_CH1_INST_ID);
 	if (s3c_mfc_wait_for_done(R2H_CMD_INIT_BUFFERS_RET) == 0) {
@@ -424,7 +425,11 @@ SSBSIP_MFC_ERROR_CODE s3c_mfc_set_enc_ref_buffer(s3c_mfc_inst_ctx * mfc_ctx,
 	return MFC_RET_OK;
 }
 
-static SSBSIP_MFC_ERROR_CODE s3c_mfc_set_shared_mem_buffer(int inst_no)
+/*
+ * Point the host interface at the shared memory of inst_no. Frames of
+ * different instances are interleaved, so this is done before every frame.
+ */
+static void s3c_mfc_select_shared_mem(int inst_no)
 {
 	unsigned int fw_phybuf;
 
@@ -436,8 +441,13 @@ static SSBSIP_MFC_ERROR_CODE s3c_mfc_set_shared_mem_buffer(int inst_no)
 	shared_mem_phy_addr = Align(shared_mem_phy_addr, 2 * BUF_L_UNIT);
 
 	shared_mem_vir_addr = phys_to_virt(shared_mem_phy_addr);
-	memset((void *)shared_mem_vir_addr, 0, SHARED_MEM_SIZE);
 	WRITEL((shared_mem_phy_addr - fw_phybuf), S3C_FIMV_SI_CH1_HOST_WR_ADR);
+}
+
+static SSBSIP_MFC_ERROR_CODE s3c_mfc_set_shared_mem_buffer(int inst_no)
+{
+	s3c_mfc_select_shared_mem(inst_no);
+	memset((void *)shared_mem_vir_addr, 0, SHARED_MEM_SIZE);
 
 	mfc_debug
 		("inst_no : %d, shared_mem_phy_addr : 0x%08x, shared_mem_vir_addr : 0x%08x\r\n",
@@ -805,6 +815,7 @@ SSBSIP_MFC_ERROR_CODE s3c_mfc_init_hw()
 	/*
 	 * 3. Release reset signal to the RISC.
 	 */
+	s3c_mfc_int_type = 0;
 	WRITEL(0x3ff, S3C_FIMV_SW_RESET);
 
 	if (s3c_mfc_wait_for_done(R2H_CMD_FW_STATUS_RET) == 0) {
@@ -1052,6 +1063,7 @@ SSBSIP_MFC_ERROR_CODE s3c_mfc_encode_header(s3c_mfc_inst_ctx * mfc_ctx,
 	WRITEL(0x1 << 1, S3C_FIMV_ENC_SF_BUF_CTRL);
 
 	/* for MFC fw 8/7 */
+	s3c_mfc_int_type = 0;
 	WRITEL((SEQ_HEADER << 16 & 0x70000) | (mfc_ctx->InstNo),
 			S3C_FIMV_SI_CH1_INST_ID);
 
@@ -1090,6 +1102,8 @@ static SSBSIP_MFC_ERROR_CODE s3c_mfc_encode_one_frame(s3c_mfc_inst_ctx *
 	fw_phybuf = Align(s3c_mfc_get_fw_buf_phys_addr(), 128 * BUF_L_UNIT);
 	dram1_start_addr = MFC_DRAM1_START;
 
+	s3c_mfc_select_shared_mem(mfc_ctx->InstNo);
+
 	/* Set stream buffer addr */
 	WRITEL((enc_arg->in_strm_st - fw_phybuf) >> 11,
 			S3C_FIMV_ENC_SI_CH1_SB_U_ADR);
@@ -1139,6 +1153,7 @@ static SSBSIP_MFC_ERROR_CODE s3c_mfc_encode_one_frame(s3c_mfc_inst_ctx *
 	/* buf reset command if stream buffer is frame mode */
 	WRITEL(0x1 << 1, S3C_FIMV_ENC_SF_BUF_CTRL);
 
+	s3c_mfc_int_type = 0;
 	WRITEL((FRAME << 16 & 0x70000) | (mfc_ctx->InstNo),
 			S3C_FIMV_SI_CH1_INST_ID);
 
@@ -1222,7 +1237,7 @@ SSBSIP_MFC_ERROR_CODE s3c_mfc_init_decode(s3c_mfc_inst_ctx * mfc_ctx,
 #endif
 
 	/* If error no is NOT_SUPPORTED_FEATURE, sequence should be stopped */
-	decoding_stop = 0;
+	mfc_ctx->decoding_stop = 0;
 
 	/* Context setting from input param */
 	mfc_ctx->MfcCodecType = init_arg->in_codec_type;
@@ -1269,6 +1284,7 @@ SSBSIP_MFC_ERROR_CODE s3c_mfc_init_decode(s3c_mfc_inst_ctx * mfc_ctx,
 		WRITEL((mfc_ctx->sliceEnable << 31),
 				S3C_FIMV_SI_CH1_DPB_CONF_CTRL);
 
+	s3c_mfc_int_type = 0;
 	WRITEL((SEQ_HEADER << 16 & 0x70000) | (mfc_ctx->InstNo),
 			S3C_FIMV_SI_CH1_INST_ID);
 
@@ -1347,6 +1363,8 @@ static SSBSIP_MFC_ERROR_CODE s3c_mfc_decode_one_frame(s3c_mfc_inst_ctx *
 
 	mfc_debug("++ InstNo%d \r\n", mfc_ctx->InstNo);
 
+	s3c_mfc_select_shared_mem(mfc_ctx->InstNo);
+
 	WRITEL(0xffffffff, S3C_FIMV_SI_CH1_RELEASE_BUF);	/* MFC fw 8/7 */
 
 	if ((*consumed_strm_size)) {
@@ -1366,6 +1384,7 @@ static SSBSIP_MFC_ERROR_CODE s3c_mfc_decode_one_frame(s3c_mfc_inst_ctx *
 	s3c_mfc_set_dec_stream_buffer(mfc_ctx->InstNo, dec_arg->in_strm_buf,
 			start_byte_num, dec_arg->in_strm_size);
 
+	s3c_mfc_int_type = 0;
 	if (mfc_ctx->endOfFrame) {
 		WRITEL((LAST_FRAME << 16 & 0x70000) | (mfc_ctx->InstNo),
 				S3C_FIMV_SI_CH1_INST_ID);
@@ -1395,11 +1414,11 @@ static SSBSIP_MFC_ERROR_CODE s3c_mfc_decode_one_frame(s3c_mfc_inst_ctx *
 	/* If error no is NOT_SUPPORTED_FEATURE, sequence should be stopped */
 	if((interrupt_flag == R2H_CMD_ERR_RET) &&
 			(s3c_mfc_err_type == 115))
-		decoding_stop = 1;
+		mfc_ctx->decoding_stop = 1;
 
 	if (((interrupt_flag == R2H_CMD_ERR_RET) &&
 				(s3c_mfc_err_type >= MFC_ERR_START_NO) &&
-				(s3c_mfc_err_type < MFC_WARN_START_NO)) || decoding_stop) {
+				(s3c_mfc_err_type < MFC_WARN_START_NO)) || mfc_ctx->decoding_stop) {
 		mfc_err("MFC_RET_DEC_EXE_ERR\n");
 		return MFC_RET_DEC_EXE_ERR;
 	}
@@ -1634,6 +1653,12 @@ SSBSIP_MFC_ERROR_CODE s3c_mfc_get_config(s3c_mfc_inst_ctx * mfc_ctx,
 
 			break;
 
+		case MFC_SCHED_GETCONF_LATENCY:
+			s3c_mfc_sched_get_latency(mfc_ctx,
+					get_cnf_arg->out_config_value);
+
+			break;
+
 		default:
 			mfc_err("invalid config param\n");
 			return MFC_RET_GET_CONF_FAIL;
@@ -1835,6 +1860,22 @@ SSBSIP_MFC_ERROR_CODE s3c_mfc_set_config(s3c_mfc_inst_ctx * mfc_ctx,
 
 			break;
 
+		case MFC_SCHED_SETCONF_WEIGHT:
+			s3c_mfc_sched_set_weight(mfc_ctx,
+					set_cnf_arg->in_config_value[0]);
+
+			break;
+
+		case MFC_SCHED_SETCONF_FRAME_PERIOD:
+			if (set_cnf_arg->in_config_value[0] < 0) {
+				mfc_warn("FRAME_PERIOD should be 0 or more\n");
+				set_cnf_arg->in_config_value[0] = 0;
+			}
+			s3c_mfc_sched_set_period(mfc_ctx,
+					set_cnf_arg->in_config_value[0]);
+
+			break;
+
 		default:
 			mfc_err("invalid config param\n");
 			return MFC_RET_SET_CONF_FAIL;
@@ -0,0 +1,456 @@
+/*
+ * drivers/media/video/samsung/mfc50/s3c_mfc_sched.c
+ *
+ * Frame scheduler for Samsung MFC (Multi Function Codec - FIMV) driver
+ *
+ * Copyright (c) 2010 Samsung Electronics
+ * http://www.samsungsemi.com/
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ *
+ * Every instance has a FIFO of frames. A single kernel thread owns the
+ * codec engine and runs one frame at a time, choosing the instance:
+ *
+ *  - an instance with a frame period whose oldest frame is due within two
+ *    average frame times goes first, earliest deadline first.
+ *  - otherwise the engine is shared by weight: a frame charges its service
+ *    time, scaled by MFC_SCHED_WEIGHT_DEFAULT / weight, to the instance's
+ *    virtual time and the smallest virtual time runs next.
+ *
+ * Results of IOCTL_MFC_QUEUE_EXE are kept in order on the instance's done
+ * list for IOCTL_MFC_DEQUEUE_EXE and poll(). DEC_EXE and ENC_EXE go through
+ * the same queue and wait for their own frame.
+ */
+
+#include <linux/kernel.h>
+#include <linux/sched.h>
+#include <linux/kthread.h>
+#include <linux/slab.h>
+#include <linux/spinlock.h>
+#include <linux/math64.h>
+#include <linux/clk.h>
+
+#include <plat/clock.h>
+
+#include "s3c_mfc_common.h"
+#include "s3c_mfc_logmsg.h"
+#include "s3c_mfc_opr.h"
+#include "s3c_mfc_sched.h"
+
+extern struct s3c_mfc_ctrl *ctrl;
+
+struct s3c_mfc_sched_job {
+	struct list_head list;
+	s3c_mfc_args args;
+	SSBSIP_MFC_ERROR_CODE ret;
+	int queued;		/* result goes to the done list */
+	int done;
+
+	/* per-frame settings taken from the instance when the frame is queued */
+	unsigned int end_of_frame;
+	unsigned int force_frame_type;
+	unsigned int dynamic_framerate;
+	unsigned int dynamic_bitrate;
+
+	unsigned long long submit_ns;
+	unsigned long long deadline_ns;
+};
+
+static LIST_HEAD(s3c_mfc_sched_list);		/* instances with pending frames */
+static DEFINE_SPINLOCK(s3c_mfc_sched_lock);
+static DECLARE_WAIT_QUEUE_HEAD(s3c_mfc_sched_wq);
+
+static struct task_struct *s3c_mfc_sched_task;
+static struct mutex *s3c_mfc_sched_hw_lock;
+static s3c_mfc_inst_ctx *s3c_mfc_sched_running;
+static unsigned long long s3c_mfc_sched_vclock;
+static unsigned long long s3c_mfc_sched_frame_ns;	/* average service time */
+
+static s3c_mfc_inst_ctx *s3c_mfc_sched_pick(unsigned long long now)
+{
+	struct s3c_mfc_sched_inst *si;
+	struct s3c_mfc_sched_job *job;
+	s3c_mfc_inst_ctx *mfc_ctx, *edf = NULL, *fair = NULL;
+	unsigned long long horizon, edf_deadline = 0;
+
+	horizon = now + 2 * s3c_mfc_sched_frame_ns;
+
+	list_for_each_entry(si, &s3c_mfc_sched_list, node) {
+		mfc_ctx = container_of(si, s3c_mfc_inst_ctx, sched);
+		job = list_first_entry(&si->pending, struct s3c_mfc_sched_job,
+				       list);
+
+		if (job->deadline_ns && (job->deadline_ns <= horizon) &&
+		    ((edf == NULL) || (job->deadline_ns < edf_deadline))) {
+			edf = mfc_ctx;
+			edf_deadline = job->deadline_ns;
+		}
+
+		if ((fair == NULL) || (si->vtime < fair->sched.vtime))
+			fair = mfc_ctx;
+	}
+
+	return edf ? edf : fair;
+}
+
+static SSBSIP_MFC_ERROR_CODE s3c_mfc_sched_run(s3c_mfc_inst_ctx *mfc_ctx,
+					       struct s3c_mfc_sched_job *job)
+{
+	SSBSIP_MFC_ERROR_CODE ret;
+
+	mutex_lock(s3c_mfc_sched_hw_lock);
+
+#if	defined(CONFIG_VIDEO_MFC_FRAME_CLK_GATING)
+	s5pc11x_clk_ip0_ctrl(ctrl->clock, 1);
+#endif
+
+	if (mfc_ctx->MfcState >= MFCINST_STATE_ENC_INITIALIZE) {
+		mfc_ctx->forceSetFrameType = job->force_frame_type;
+		mfc_ctx->dynamic_framerate = job->dynamic_framerate;
+		mfc_ctx->dynamic_bitrate = job->dynamic_bitrate;
+		ret = s3c_mfc_exe_encode(mfc_ctx, &job->args);
+	} else {
+		mfc_ctx->endOfFrame = job->end_of_frame;
+		ret = s3c_mfc_exe_decode(mfc_ctx, &job->args);
+	}
+
+#if	defined(CONFIG_VIDEO_MFC_FRAME_CLK_GATING)
+	s5pc11x_clk_ip0_ctrl(ctrl->clock, 0);
+#endif
+
+	mutex_unlock(s3c_mfc_sched_hw_lock);
+
+	return ret;
+}
+
+static int s3c_mfc_sched_thread(void *data)
+{
+	s3c_mfc_inst_ctx *mfc_ctx;
+	struct s3c_mfc_sched_inst *si;
+	struct s3c_mfc_sched_job *job;
+	unsigned long long start, end, latency, service;
+
+	while (!kthread_should_stop()) {
+		wait_event_interruptible(s3c_mfc_sched_wq,
+					 !list_empty(&s3c_mfc_sched_list) ||
+					 kthread_should_stop());
+
+		spin_lock(&s3c_mfc_sched_lock);
+		if (list_empty(&s3c_mfc_sched_list)) {
+			spin_unlock(&s3c_mfc_sched_lock);
+			continue;
+		}
+
+		start = sched_clock();
+		mfc_ctx = s3c_mfc_sched_pick(start);
+		si = &mfc_ctx->sched;
+
+		job = list_first_entry(&si->pending, struct s3c_mfc_sched_job,
+				       list);
+		list_del(&job->list);
+		if (list_empty(&si->pending))
+			list_del_init(&si->node);
+
+		s3c_mfc_sched_running = mfc_ctx;
+		s3c_mfc_sched_vclock = si->vtime;
+		spin_unlock(&s3c_mfc_sched_lock);
+
+		job->ret = s3c_mfc_sched_run(mfc_ctx, job);
+
+		end = sched_clock();
+		service = end - start;
+		latency = end - job->submit_ns;
+
+		mfc_debug("InstNo %d : service %llu ns, latency %llu ns\n",
+			  mfc_ctx->InstNo, service, latency);
+
+		spin_lock(&s3c_mfc_sched_lock);
+		si->vtime += div_u64(service * MFC_SCHED_WEIGHT_DEFAULT,
+				     si->weight);
+		s3c_mfc_sched_frame_ns = (s3c_mfc_sched_frame_ns * 7 + service) >> 3;
+
+		si->frames++;
+		si->total_ns += latency;
+		if (latency > si->max_ns)
+			si->max_ns = latency;
+		if (job->deadline_ns && (end > job->deadline_ns))
+			si->missed++;
+
+		job->done = 1;
+		if (job->queued)
+			list_add_tail(&job->list, &si->done);
+
+		/*
+		 * Wake up while holding the lock: once s3c_mfc_sched_running
+		 * is cleared the instance may be released.
+		 */
+		s3c_mfc_sched_running = NULL;
+		wake_up(&si->wait);
+		spin_unlock(&s3c_mfc_sched_lock);
+	}
+
+	return 0;
+}
+
+void s3c_mfc_sched_init_inst(s3c_mfc_inst_ctx *mfc_ctx)
+{
+	struct s3c_mfc_sched_inst *si = &mfc_ctx->sched;
+
+	INIT_LIST_HEAD(&si->node);
+	INIT_LIST_HEAD(&si->pending);
+	INIT_LIST_HEAD(&si->done);
+	init_waitqueue_head(&si->wait);
+	si->weight = MFC_SCHED_WEIGHT_DEFAULT;
+}
+
+/* called from release(), without the MFC mutex */
+void s3c_mfc_sched_release_inst(s3c_mfc_inst_ctx *mfc_ctx)
+{
+	struct s3c_mfc_sched_inst *si = &mfc_ctx->sched;
+	struct s3c_mfc_sched_job *job, *tmp;
+	LIST_HEAD(drop);
+
+	spin_lock(&s3c_mfc_sched_lock);
+	list_del_init(&si->node);
+	list_splice_init(&si->pending, &drop);
+	spin_unlock(&s3c_mfc_sched_lock);
+
+	wait_event(si->wait, s3c_mfc_sched_running != mfc_ctx);
+
+	spin_lock(&s3c_mfc_sched_lock);
+	list_splice_init(&si->done, &drop);
+	si->queued = 0;
+	spin_unlock(&s3c_mfc_sched_lock);
+
+	list_for_each_entry_safe(job, tmp, &drop, list) {
+		list_del(&job->list);
+		kfree(job);
+	}
+
+	if (si->frames)
+		mfc_debug("InstNo %d : %u frames, avg %llu ns, max %llu ns, missed %u\n",
+			  mfc_ctx->InstNo, si->frames,
+			  div_u64(si->total_ns, si->frames), si->max_ns,
+			  si->missed);
+}
+
+/* take a queue slot, waiting for one unless nonblock */
+int s3c_mfc_sched_reserve(s3c_mfc_inst_ctx *mfc_ctx, int nonblock)
+{
+	struct s3c_mfc_sched_inst *si = &mfc_ctx->sched;
+
+	spin_lock(&s3c_mfc_sched_lock);
+	while (si->queued >= MFC_SCHED_QUEUE_MAX) {
+		spin_unlock(&s3c_mfc_sched_lock);
+
+		if (nonblock)
+			return -EAGAIN;
+
+		if (wait_event_interruptible(si->wait,
+				si->queued < MFC_SCHED_QUEUE_MAX))
+			return -ERESTARTSYS;
+
+		spin_lock(&s3c_mfc_sched_lock);
+	}
+	si->queued++;
+	spin_unlock(&s3c_mfc_sched_lock);
+
+	return 0;
+}
+
+void s3c_mfc_sched_unreserve(s3c_mfc_inst_ctx *mfc_ctx)
+{
+	struct s3c_mfc_sched_inst *si = &mfc_ctx->sched;
+
+	spin_lock(&s3c_mfc_sched_lock);
+	si->queued--;
+	wake_up(&si->wait);
+	spin_unlock(&s3c_mfc_sched_lock);
+}
+
+/* called with the MFC mutex held, after a slot is reserved */
+struct s3c_mfc_sched_job *s3c_mfc_sched_get_job(s3c_mfc_inst_ctx *mfc_ctx,
+						s3c_mfc_args *args)
+{
+	struct s3c_mfc_sched_job *job;
+
+	job = kzalloc(sizeof(struct s3c_mfc_sched_job), GFP_KERNEL);
+	if (job == NULL)
+		return NULL;
+
+	job->args = *args;
+
+	job->end_of_frame = mfc_ctx->endOfFrame;
+	job->force_frame_type = mfc_ctx->forceSetFrameType;
+	job->dynamic_framerate = mfc_ctx->dynamic_framerate;
+	job->dynamic_bitrate = mfc_ctx->dynamic_bitrate;
+
+	mfc_ctx->endOfFrame = 0;
+	mfc_ctx->forceSetFrameType = 0;
+	mfc_ctx->dynamic_framerate = 0;
+	mfc_ctx->dynamic_bitrate = 0;
+
+	return job;
+}
+
+void s3c_mfc_sched_submit(s3c_mfc_inst_ctx *mfc_ctx,
+			  struct s3c_mfc_sched_job *job, int queued)
+{
+	struct s3c_mfc_sched_inst *si = &mfc_ctx->sched;
+	unsigned long long now = sched_clock();
+
+	job->queued = queued;
+	job->submit_ns = now;
+
+	spin_lock(&s3c_mfc_sched_lock);
+	if (si->period_ns) {
+		if (si->next_deadline < now)
+			si->next_deadline = now;
+		si->next_deadline += si->period_ns;
+		job->deadline_ns = si->next_deadline;
+	}
+
+	/* an instance coming back from idle does not get credit for it */
+	if (list_empty(&si->pending)) {
+		if (si->vtime < s3c_mfc_sched_vclock)
+			si->vtime = s3c_mfc_sched_vclock;
+		list_add_tail(&si->node, &s3c_mfc_sched_list);
+	}
+	list_add_tail(&job->list, &si->pending);
+	spin_unlock(&s3c_mfc_sched_lock);
+
+	wake_up_interruptible(&s3c_mfc_sched_wq);
+}
+
+SSBSIP_MFC_ERROR_CODE s3c_mfc_sched_wait(s3c_mfc_inst_ctx *mfc_ctx,
+					 struct s3c_mfc_sched_job *job,
+					 s3c_mfc_args *args)
+{
+	SSBSIP_MFC_ERROR_CODE ret;
+
+	wait_event(mfc_ctx->sched.wait, job->done);
+
+	ret = job->ret;
+	*args = job->args;
+	kfree(job);
+
+	s3c_mfc_sched_unreserve(mfc_ctx);
+
+	return ret;
+}
+
+int s3c_mfc_sched_dequeue(s3c_mfc_inst_ctx *mfc_ctx,
+			  s3c_mfc_common_args *out, int nonblock)
+{
+	struct s3c_mfc_sched_inst *si = &mfc_ctx->sched;
+	struct s3c_mfc_sched_job *job;
+
+	spin_lock(&s3c_mfc_sched_lock);
+	while (list_empty(&si->done)) {
+		if (si->queued == 0) {
+			spin_unlock(&s3c_mfc_sched_lock);
+			return -ENOENT;
+		}
+		spin_unlock(&s3c_mfc_sched_lock);
+
+		if (nonblock)
+			return -EAGAIN;
+
+		if (wait_event_interruptible(si->wait,
+				!list_empty(&si->done) || (si->queued == 0)))
+			return -ERESTARTSYS;
+
+		spin_lock(&s3c_mfc_sched_lock);
+	}
+
+	job = list_first_entry(&si->done, struct s3c_mfc_sched_job, list);
+	list_del(&job->list);
+	si->queued--;
+	wake_up(&si->wait);
+	spin_unlock(&s3c_mfc_sched_lock);
+
+	out->ret_code = job->ret;
+	out->args = job->args;
+	kfree(job);
+
+	return 0;
+}
+
+unsigned int s3c_mfc_sched_poll(s3c_mfc_inst_ctx *mfc_ctx, struct file *file,
+				poll_table *wait)
+{
+	struct s3c_mfc_sched_inst *si = &mfc_ctx->sched;
+	unsigned int mask = 0;
+
+	poll_wait(file, &si->wait, wait);
+
+	spin_lock(&s3c_mfc_sched_lock);
+	if (!list_empty(&si->done))
+		mask |= POLLIN | POLLRDNORM;
+	if (si->queued < MFC_SCHED_QUEUE_MAX)
+		mask |= POLLOUT | POLLWRNORM;
+	spin_unlock(&s3c_mfc_sched_lock);
+
+	return mask;
+}
+
+void s3c_mfc_sched_set_weight(s3c_mfc_inst_ctx *mfc_ctx, unsigned int weight)
+{
+	if ((weight == 0) || (weight > MFC_SCHED_WEIGHT_MAX)) {
+		mfc_warn("WEIGHT should be between 1 and %d\n",
+			 MFC_SCHED_WEIGHT_MAX);
+		weight = MFC_SCHED_WEIGHT_DEFAULT;
+	}
+
+	spin_lock(&s3c_mfc_sched_lock);
+	mfc_ctx->sched.weight = weight;
+	spin_unlock(&s3c_mfc_sched_lock);
+}
+
+void s3c_mfc_sched_set_period(s3c_mfc_inst_ctx *mfc_ctx, unsigned int usec)
+{
+	spin_lock(&s3c_mfc_sched_lock);
+	mfc_ctx->sched.period_ns = (unsigned long long)usec * NSEC_PER_USEC;
+	mfc_ctx->sched.next_deadline = 0;
+	spin_unlock(&s3c_mfc_sched_lock);
+}
+
+/* frames, average and maximum latency in usec, missed deadlines */
+void s3c_mfc_sched_get_latency(s3c_mfc_inst_ctx *mfc_ctx, int *out)
+{
+	struct s3c_mfc_sched_inst *si = &mfc_ctx->sched;
+	unsigned long long total, max;
+	unsigned int frames;
+
+	spin_lock(&s3c_mfc_sched_lock);
+	frames = si->frames;
+	total = si->total_ns;
+	max = si->max_ns;
+	out[3] = si->missed;
+	spin_unlock(&s3c_mfc_sched_lock);
+
+	out[0] = frames;
+	out[1] = frames ? div_u64(div_u64(total, frames), NSEC_PER_USEC) : 0;
+	out[2] = div_u64(max, NSEC_PER_USEC);
+}
+
+int s3c_mfc_sched_init(struct mutex *hw_lock)
+{
+	s3c_mfc_sched_hw_lock = hw_lock;
+
+	s3c_mfc_sched_task = kthread_run(s3c_mfc_sched_thread, NULL,
+					 "s3c-mfc-sched");
+	if (IS_ERR(s3c_mfc_sched_task)) {
+		mfc_err("failed to start the frame scheduler\n");
+		return PTR_ERR(s3c_mfc_sched_task);
+	}
+
+	return 0;
+}
+
+void s3c_mfc_sched_exit(void)
+{
+	kthread_stop(s3c_mfc_sched_task);
+}
@@ -0,0 +1,55 @@
+/*
+ * drivers/media/video/samsung/mfc50/s3c_mfc_sched.h
+ *
+ * Header file for Samsung MFC (Multi Function Codec - FIMV) driver
+ *
+ * Copyright (c) 2010 Samsung Electronics
+ * http://www.samsungsemi.com/
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ */
+
+#ifndef _S3C_MFC_SCHED_H_
+#define _S3C_MFC_SCHED_H_
+
+#include <linux/fs.h>
+#include <linux/mutex.h>
+#include <linux/poll.h>
+
+#include "s3c_mfc_common.h"
+#include "s3c_mfc_errorno.h"
+#include "s3c_mfc_interface.h"
+
+#define MFC_SCHED_QUEUE_MAX		(8)
+#define MFC_SCHED_WEIGHT_DEFAULT	(100)
+#define MFC_SCHED_WEIGHT_MAX		(1000)
+
+struct s3c_mfc_sched_job;
+
+int s3c_mfc_sched_init(struct mutex *hw_lock);
+void s3c_mfc_sched_exit(void);
+
+void s3c_mfc_sched_init_inst(s3c_mfc_inst_ctx *mfc_ctx);
+void s3c_mfc_sched_release_inst(s3c_mfc_inst_ctx *mfc_ctx);
+
+int s3c_mfc_sched_reserve(s3c_mfc_inst_ctx *mfc_ctx, int nonblock);
+void s3c_mfc_sched_unreserve(s3c_mfc_inst_ctx *mfc_ctx);
+struct s3c_mfc_sched_job *s3c_mfc_sched_get_job(s3c_mfc_inst_ctx *mfc_ctx,
+						s3c_mfc_args *args);
+void s3c_mfc_sched_submit(s3c_mfc_inst_ctx *mfc_ctx,
+			  struct s3c_mfc_sched_job *job, int queued);
+SSBSIP_MFC_ERROR_CODE s3c_mfc_sched_wait(s3c_mfc_inst_ctx *mfc_ctx,
+					 struct s3c_mfc_sched_job *job,
+					 s3c_mfc_args *args);
+int s3c_mfc_sched_dequeue(s3c_mfc_inst_ctx *mfc_ctx,
+			  s3c_mfc_common_args *out, int nonblock);
+unsigned int s3c_mfc_sched_poll(s3c_mfc_inst_ctx *mfc_ctx, struct file *file,
+				poll_table *wait);
+
+void s3c_mfc_sched_set_weight(s3c_mfc_inst_ctx *mfc_ctx, unsigned int weight);
+void s3c_mfc_sched_set_period(s3c_mfc_inst_ctx *mfc_ctx, unsigned int usec);
+void s3c_mfc_sched_get_latency(s3c_mfc_inst_ctx *mfc_ctx, int *out);
+
+#endif /* _S3C_MFC_SCHED_H_ */
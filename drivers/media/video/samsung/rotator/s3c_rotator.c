@@ -60,7 +60,39 @@ static void __iomem *s3c_rotator_base;
 
 static wait_queue_head_t waitq_rotator;
 
-static struct mutex *h_rot_mutex;
+/*
+ * Jobs from every file handle wait on s3c_rot_queue. The interrupt handler
+ * finishes the running job and starts the next one, so callers never wait
+ * for the engine to be idle.
+ */
+struct s3c_rot_file;
+
+struct s3c_rot_job {
+	struct list_head	list;
+	ro_params		params;
+	unsigned int		mode;
+	unsigned int		seq;
+	int			status;
+	int			dequeue;	/* result goes to owner's done list */
+	int			sync;		/* the ioctl waits for it and frees it */
+	int			done;
+	struct s3c_rot_file	*owner;		/* NULL once the file is closed */
+};
+
+struct s3c_rot_file {
+	struct list_head	done;
+	unsigned int		running;	/* queued or on the engine */
+	unsigned int		finished;	/* on the done list */
+	wait_queue_head_t	wq;
+};
+
+static LIST_HEAD(s3c_rot_queue);
+static DEFINE_SPINLOCK(s3c_rot_lock);
+static struct s3c_rot_job *s3c_rot_active;
+static unsigned long s3c_rot_deadline;
+static struct timer_list s3c_rot_timer;
+static unsigned int s3c_rot_seq;
+static int s3c_rot_stale;	/* a timed out job is still on the engine */
 
 static inline void s3c_rotator_set_source(ro_params *params)
 {
@@ -124,23 +156,267 @@ static void s3c_rotator_disable_int(void)
 	__raw_writel(cfg, s3c_rotator_base + S3C_ROTATOR_CTRLCFG);
 }
 
-#if defined(CONFIG_CPU_S3C6410)
-irqreturn_t s3c_rotator_irq(int irq, void *dev_id)
+
+static void s3c_rotator_clear_int(void)
+{
+	unsigned int cfg;
+
+	cfg = __raw_readl(s3c_rotator_base + S3C_ROTATOR_STATCFG);
+#if defined(CONFIG_CPU_S5PC100) || defined(CONFIG_CPU_S5PC110)
+	__raw_writel(cfg | S3C_ROTATOR_STATCFG_INT_PEND,
+		     s3c_rotator_base + S3C_ROTATOR_STATCFG);
+#endif
+}
+
+static int s3c_rotator_check_params(ro_params *params)
+{
+	unsigned int divisor = 0;
+
+	if( (params->src_width > 2048) || (params->src_height > 2048)) {
+		printk(KERN_ERR "\n%s: maximum width and height size are 2048\n", __FUNCTION__);
+		return -EINVAL;
+	}
+
+	switch(params->src_format) {
+	case S3C_ROTATOR_CTRLCFG_INPUT_YUV420:
+		divisor = 8;
+		break;
+
+	case S3C_ROTATOR_CTRLCFG_INPUT_YUV422:	/* fall through */
+	case S3C_ROTATOR_CTRLCFG_INPUT_RGB565:	
+		divisor = 2;
+		break;
+
+	case S3C_ROTATOR_CTRLCFG_INPUT_RGB888:
+		divisor = 1;
+		break;
+
+	default :
+		printk(KERN_ERR "requested src type is not supported!! plz check src format!!\n");
+		return -EINVAL;
+	}
+	
+	if((params->src_width % divisor) || (params->src_height % divisor)) {
+		printk(KERN_ERR "\n%s: src & dst size is aligned to %d pixel boundary\n", __FUNCTION__, divisor);
+		return -EINVAL;
+	}
+
+	return 0;
+}
+
+
+static int s3c_rotator_get_mode(unsigned int cmd, unsigned int *mode)
+{
+	switch(cmd) {
+	case ROTATOR_90:   
+		*mode = S3C_ROTATOR_CTRLCFG_DEGREE_90    | S3C_ROTATOR_CTRLCFG_FLIP_BYPASS;
+		break;
+
+	case ROTATOR_180:   
+		*mode = S3C_ROTATOR_CTRLCFG_DEGREE_180   | S3C_ROTATOR_CTRLCFG_FLIP_BYPASS;
+		break;
+
+	case ROTATOR_270:   
+		*mode = S3C_ROTATOR_CTRLCFG_DEGREE_270   | S3C_ROTATOR_CTRLCFG_FLIP_BYPASS;
+		break;
+
+	case HFLIP:   
+		*mode = S3C_ROTATOR_CTRLCFG_DEGREE_BYPASS| S3C_ROTATOR_CTRLCFG_FLIP_HOR;
+		break;
+
+	case VFLIP:   
+		*mode = S3C_ROTATOR_CTRLCFG_DEGREE_BYPASS| S3C_ROTATOR_CTRLCFG_FLIP_VER;
+		break;
+
+	default:
+		return -EINVAL;
+	}
+
+	return 0;
+}
+
+
+/* called with s3c_rot_lock held */
+static void s3c_rotator_run_next(void)
 {
 	struct s3c_rotator_ctrl	*ctrl = &s3c_rot;
+	struct s3c_rot_job	*job;
 
-	__raw_readl(s3c_rotator_base + S3C_ROTATOR_STATCFG);
+	if (s3c_rot_active != NULL || s3c_rot_stale ||
+	    list_empty(&s3c_rot_queue))
+		return;
 
-	ctrl->status = ROT_IDLE;
+	/* suspend lets the running job finish but starts no new one */
+	if (ctrl->status == ROT_READY_SLEEP || ctrl->status == ROT_SLEEP)
+		return;
+
+	job = list_first_entry(&s3c_rot_queue, struct s3c_rot_job, list);
+	list_del(&job->list);
+	s3c_rot_active = job;
+
+	s3c_rotator_set_source(&job->params);
+	s3c_rotator_set_dest(&job->params);
+	s3c_rotator_start(&job->params, job->mode);
+
+	ctrl->status = ROT_RUN;
+
+	s3c_rot_deadline = jiffies + ROTATOR_TIMEOUT;
+	mod_timer(&s3c_rot_timer, s3c_rot_deadline);
+}
 
-	wake_up_interruptible(&waitq_rotator);
+
+static void s3c_rotator_job_done(int status, int timeout)
+{
+	struct s3c_rotator_ctrl	*ctrl = &s3c_rot;
+	struct s3c_rot_job	*job;
+	struct s3c_rot_file	*owner;
+	unsigned long		flags;
+
+	spin_lock_irqsave(&s3c_rot_lock, flags);
+
+	if (s3c_rot_stale) {
+		if (timeout && time_before(jiffies, s3c_rot_deadline))
+			goto out;
+
+		/*
+		 * Either the late interrupt of the timed out job or the end
+		 * of its grace period, the engine is ours again.
+		 */
+		if (timeout)
+			printk(KERN_ERR "%s: engine still busy, going on\n",
+			       __FUNCTION__);
+		else
+			del_timer(&s3c_rot_timer);
+
+		s3c_rot_stale = 0;
+		s3c_rotator_run_next();
+		goto out;
+	}
+
+	job = s3c_rot_active;
+	if (job == NULL ||
+	    (timeout && time_before(jiffies, s3c_rot_deadline)))
+		goto out;
+
+	if (!timeout) {
+		del_timer(&s3c_rot_timer);
+	} else {
+		printk(KERN_ERR "\n%s: Waiting for interrupt is timeout\n",
+		       __FUNCTION__);
+
+		/*
+		 * There is no reset, so a job still on the engine keeps it
+		 * until its interrupt comes in. Starting the next one now
+		 * would have that interrupt complete the wrong job.
+		 */
+		if (s3c_rotator_get_status() != S3C_ROTATOR_STATCFG_STATUS_IDLE) {
+			s3c_rot_stale = 1;
+			s3c_rot_deadline = jiffies + ROTATOR_TIMEOUT;
+			mod_timer(&s3c_rot_timer, s3c_rot_deadline);
+		} else {
+			s3c_rotator_clear_int();
+		}
+	}
+
+	s3c_rot_active = NULL;
+	if (ctrl->status == ROT_RUN)
+		ctrl->status = ROT_IDLE;
+
+	job->status = status;
+	job->done = 1;
+	owner = job->owner;
+	if (owner != NULL) {
+		owner->running--;
+		if (job->dequeue) {
+			list_add_tail(&job->list, &owner->done);
+			owner->finished++;
+			job = NULL;
+		} else if (job->sync) {
+			job = NULL;
+		}
+		wake_up_interruptible(&owner->wq);
+	}
+
+	s3c_rotator_run_next();
+
+	spin_unlock_irqrestore(&s3c_rot_lock, flags);
+
+	kfree(job);
+
+	wake_up(&waitq_rotator);
+	return;
+
+out:
+	spin_unlock_irqrestore(&s3c_rot_lock, flags);
+}
+
+
+static void s3c_rotator_timeout(unsigned long data)
+{
+	s3c_rotator_job_done(-ETIMEDOUT, 1);
+}
+
+
+static int s3c_rotator_full(struct s3c_rot_file *rfile)
+{
+	return rfile->running + rfile->finished >= ROTATOR_QUEUE_MAX;
+}
+
+
+/* returns -EAGAIN if the owner has no room, the job is not queued then */
+static int s3c_rotator_submit(struct s3c_rot_job *job, unsigned int *seq)
+{
+	unsigned long	flags;
+
+	spin_lock_irqsave(&s3c_rot_lock, flags);
+	if (s3c_rotator_full(job->owner)) {
+		spin_unlock_irqrestore(&s3c_rot_lock, flags);
+		return -EAGAIN;
+	}
+
+	*seq = job->seq = ++s3c_rot_seq;
+	job->owner->running++;
+	list_add_tail(&job->list, &s3c_rot_queue);
+	s3c_rotator_run_next();
+	spin_unlock_irqrestore(&s3c_rot_lock, flags);
+
+	return 0;
+}
+
+
+/* called with s3c_rot_lock held, the engine must be stopped */
+static void s3c_rotator_flush(struct list_head *drop)
+{
+	struct s3c_rot_job	*job, *tmp;
+
+	if (s3c_rot_active != NULL) {
+		list_add_tail(&s3c_rot_active->list, &s3c_rot_queue);
+		s3c_rot_active = NULL;
+	}
+	s3c_rot_stale = 0;
+
+	list_for_each_entry_safe(job, tmp, &s3c_rot_queue, list) {
+		if (job->owner != NULL) {
+			job->owner->running--;
+			wake_up_interruptible(&job->owner->wq);
+		}
+		list_move_tail(&job->list, drop);
+	}
+}
+
+
+#if defined(CONFIG_CPU_S3C6410)
+irqreturn_t s3c_rotator_irq(int irq, void *dev_id)
+{
+	__raw_readl(s3c_rotator_base + S3C_ROTATOR_STATCFG);
+
+	s3c_rotator_job_done(0, 0);
 
 	return IRQ_HANDLED;
 }
 #elif defined(CONFIG_CPU_S5PC100) || defined(CONFIG_CPU_S5PC110)
 irqreturn_t s3c_rotator_irq(int irq, void *dev_id)
 {
-	struct s3c_rotator_ctrl	*ctrl = &s3c_rot;
 	unsigned int cfg;
 
 	cfg = __raw_readl(s3c_rotator_base + S3C_ROTATOR_STATCFG);
@@ -148,8 +424,7 @@ irqreturn_t s3c_rotator_irq(int irq, void *dev_id)
 
 	__raw_writel(cfg, s3c_rotator_base + S3C_ROTATOR_STATCFG);
 
-	ctrl->status = ROT_IDLE;
-	wake_up_interruptible(&waitq_rotator);
+	s3c_rotator_job_done(0, 0);
 
 	return IRQ_HANDLED;
 }
@@ -157,20 +432,19 @@ irqreturn_t s3c_rotator_irq(int irq, void *dev_id)
 
 int s3c_rotator_open(struct inode *inode, struct file *file)
 {
-	ro_params	*params;
+	struct s3c_rot_file	*rfile;
 
 	/* allocating the rotator instance */
-	params	= (ro_params *)kmalloc(sizeof(ro_params), GFP_KERNEL);
-	if (params == NULL) {
+	rfile	= (struct s3c_rot_file *)kzalloc(sizeof(struct s3c_rot_file), GFP_KERNEL);
+	if (rfile == NULL) {
 		printk(KERN_ERR "Instance memory allocation was failed\n");
 		return -ENOMEM;
 	}
 
-	memset(params, 0, sizeof(ro_params));
-
-	file->private_data	= (ro_params *)params;
+	INIT_LIST_HEAD(&rfile->done);
+	init_waitqueue_head(&rfile->wq);
 
-	s3c_rotator_enable_int();
+	file->private_data	= (struct s3c_rot_file *)rfile;
 
 	return 0;
 }
@@ -178,133 +452,223 @@ int s3c_rotator_open(struct inode *inode, struct file *file)
 
 int s3c_rotator_release(struct inode *inode, struct file *file)
 {
-	ro_params	*params;
+	struct s3c_rot_file	*rfile;
+	struct s3c_rot_job	*job, *tmp;
+	unsigned long		flags;
+	LIST_HEAD(drop);
 
-	params	= (ro_params *)file->private_data;
-	if (params == NULL) {
+	rfile	= (struct s3c_rot_file *)file->private_data;
+	if (rfile == NULL) {
 		printk(KERN_ERR "Can't release s3c_rotator!!\n");
 		return -1;
 	}
 
-	kfree(params);
+	spin_lock_irqsave(&s3c_rot_lock, flags);
+	list_for_each_entry_safe(job, tmp, &s3c_rot_queue, list) {
+		if (job->owner == rfile)
+			list_move_tail(&job->list, &drop);
+	}
+
+	/* the running job is freed when it finishes */
+	if (s3c_rot_active != NULL && s3c_rot_active->owner == rfile)
+		s3c_rot_active->owner = NULL;
+
+	list_splice_init(&rfile->done, &drop);
+	spin_unlock_irqrestore(&s3c_rot_lock, flags);
+
+	list_for_each_entry_safe(job, tmp, &drop, list) {
+		list_del(&job->list);
+		kfree(job);
+	}
 
-	s3c_rotator_disable_int();	
+	kfree(rfile);
 
 	return 0;
 }
 
 
-static int s3c_rotator_ioctl(struct inode *inode, struct file *file, unsigned int cmd, unsigned long arg)
+/*
+ * Queue a job, waiting for room unless the file is non-blocking. With sync
+ * set the job is handed back in *sync for s3c_rotator_wait_sync().
+ */
+static int s3c_rotator_queue(struct file *file, unsigned int cmd,
+			     ro_params *params, int dequeue, unsigned int *seq,
+			     struct s3c_rot_job **sync)
 {
-	struct s3c_rotator_ctrl	*ctrl = &s3c_rot;
-	ro_params *params;
-	ro_params *parg;
-	unsigned int mode, divisor = 0;
+	struct s3c_rot_file	*rfile = (struct s3c_rot_file *)file->private_data;
+	struct s3c_rot_job	*job;
+	int			ret;
 
-	if (ctrl->status != ROT_IDLE) {
-		printk(KERN_ERR "Rotator is busy.\n");
-		return -EBUSY;
+	job = kzalloc(sizeof(struct s3c_rot_job), GFP_KERNEL);
+	if (job == NULL)
+		return -ENOMEM;
+
+	job->params	= *params;
+	job->owner	= rfile;
+	job->dequeue	= dequeue;
+	job->sync	= sync != NULL;
+
+	ret = s3c_rotator_get_mode(cmd, &job->mode);
+	if (ret == 0)
+		ret = s3c_rotator_check_params(&job->params);
+	if (ret) {
+		kfree(job);
+		return ret;
 	}
 
-	mutex_lock(h_rot_mutex);
+	while ((ret = s3c_rotator_submit(job, seq)) == -EAGAIN) {
+		if (file->f_flags & O_NONBLOCK)
+			break;
 
-	params	        = (ro_params *)file->private_data;
-	parg	        = (ro_params *)arg;    
+		ret = wait_event_interruptible(rfile->wq,
+					       !s3c_rotator_full(rfile));
+		if (ret)
+			break;
+	}
+	if (ret) {
+		kfree(job);
+		return ret;
+	}
 
-	get_user(params->src_width,     &parg->src_width);
-	get_user(params->src_height,    &parg->src_height);
+	if (sync != NULL)
+		*sync = job;
 
-	get_user(params->src_format,    &parg->src_format);
-	get_user(params->src_addr_rgb_y,&parg->src_addr_rgb_y);
-	get_user(params->src_addr_cb,   &parg->src_addr_cb);
-	get_user(params->src_addr_cr,   &parg->src_addr_cr);    
+	return 0;
+}
 
-	get_user(params->dst_addr_rgb_y,&parg->dst_addr_rgb_y);    
-	get_user(params->dst_addr_cb,   &parg->dst_addr_cb);    
-	get_user(params->dst_addr_cr,   &parg->dst_addr_cr);    
 
-	if( (params->src_width > 2048) || (params->src_height > 2048)) {
-		printk(KERN_ERR "\n%s: maximum width and height size are 2048\n", __FUNCTION__);
-		return -EINVAL;
+/*
+ * Every job ahead of this one is finished or failed by the watchdog within
+ * ROTATOR_TIMEOUT of starting, so the wait needs no timeout of its own.
+ */
+static int s3c_rotator_wait_sync(struct file *file, struct s3c_rot_job *job)
+{
+	struct s3c_rot_file	*rfile = (struct s3c_rot_file *)file->private_data;
+	unsigned long		flags;
+	int			ret;
+
+	ret = wait_event_interruptible(rfile->wq, job->done);
+
+	spin_lock_irqsave(&s3c_rot_lock, flags);
+	if (!job->done) {
+		/* given up on, it is freed when it finishes */
+		job->sync = 0;
+		job = NULL;
 	}
+	spin_unlock_irqrestore(&s3c_rot_lock, flags);
 
-	switch(params->src_format) {
-	case S3C_ROTATOR_CTRLCFG_INPUT_YUV420:
-		divisor = 8;
-		break;
+	if (job == NULL)
+		return ret;
 
-	case S3C_ROTATOR_CTRLCFG_INPUT_YUV422:	/* fall through */
-	case S3C_ROTATOR_CTRLCFG_INPUT_RGB565:	
-		divisor = 2;
-		break;
+	ret = job->status;
+	kfree(job);
 
-	case S3C_ROTATOR_CTRLCFG_INPUT_RGB888:
-		divisor = 1;
-		break;
+	return ret;
+}
 
-	default :
-		printk(KERN_ERR "requested src type is not supported!! plz check src format!!\n");
-		break;
-	}
-	
-	if((params->src_width % divisor) || (params->src_height % divisor)) {
-		printk(KERN_ERR "\n%s: src & dst size is aligned to %d pixel boundary\n", __FUNCTION__, divisor);
-		mutex_unlock(h_rot_mutex);
-		return -EINVAL;
+
+static int s3c_rotator_dequeue(struct file *file, ro_job *arg)
+{
+	struct s3c_rot_file	*rfile = (struct s3c_rot_file *)file->private_data;
+	struct s3c_rot_job	*job;
+	unsigned long		flags;
+	int			ret;
+
+	spin_lock_irqsave(&s3c_rot_lock, flags);
+	while (list_empty(&rfile->done)) {
+		spin_unlock_irqrestore(&s3c_rot_lock, flags);
+
+		if (rfile->running == 0)
+			return -ENOENT;
+
+		if (file->f_flags & O_NONBLOCK)
+			return -EAGAIN;
+
+		ret = wait_event_interruptible(rfile->wq,
+				!list_empty(&rfile->done) || rfile->running == 0);
+		if (ret)
+			return ret;
+
+		spin_lock_irqsave(&s3c_rot_lock, flags);
 	}
 
+	job = list_first_entry(&rfile->done, struct s3c_rot_job, list);
+	list_del(&job->list);
+	rfile->finished--;
+	spin_unlock_irqrestore(&s3c_rot_lock, flags);
+
+	wake_up_interruptible(&rfile->wq);
+
+	ret = 0;
+	if (put_user(job->seq, &arg->seq) || put_user(job->status, &arg->status))
+		ret = -EFAULT;
+
+	kfree(job);
+
+	return ret;
+}
+
+
+static int s3c_rotator_ioctl(struct inode *inode, struct file *file, unsigned int cmd, unsigned long arg)
+{
+	struct s3c_rot_job	*job;
+	ro_job		job_arg;
+	ro_params	params;
+	unsigned int	seq;
+	int		ret;
+
 	switch(cmd) {
-	case ROTATOR_90:   
-		mode = S3C_ROTATOR_CTRLCFG_DEGREE_90    | S3C_ROTATOR_CTRLCFG_FLIP_BYPASS;
-		break;
+	case ROTATOR_QUEUE:
+		if (copy_from_user(&job_arg, (ro_job *)arg, sizeof(ro_job)))
+			return -EFAULT;
 
-	case ROTATOR_180:   
-		mode = S3C_ROTATOR_CTRLCFG_DEGREE_180   | S3C_ROTATOR_CTRLCFG_FLIP_BYPASS;
-		break;
+		ret = s3c_rotator_queue(file, job_arg.cmd, &job_arg.params, 1,
+					&seq, NULL);
+		if (ret)
+			return ret;
 
-	case ROTATOR_270:   
-		mode = S3C_ROTATOR_CTRLCFG_DEGREE_270   | S3C_ROTATOR_CTRLCFG_FLIP_BYPASS;
-		break;
+		return put_user(seq, &((ro_job *)arg)->seq);
 
-	case HFLIP:   
-		mode = S3C_ROTATOR_CTRLCFG_DEGREE_BYPASS| S3C_ROTATOR_CTRLCFG_FLIP_HOR;
-		break;
+	case ROTATOR_DEQUEUE:
+		return s3c_rotator_dequeue(file, (ro_job *)arg);
 
-	case VFLIP:   
-		mode = S3C_ROTATOR_CTRLCFG_DEGREE_BYPASS| S3C_ROTATOR_CTRLCFG_FLIP_VER;
+	case ROTATOR_90:
+	case ROTATOR_180:
+	case ROTATOR_270:
+	case HFLIP:
+	case VFLIP:
 		break;
 
 	default:
 		return -EINVAL;
 	}
 
-	s3c_rotator_set_source(params);
-	s3c_rotator_set_dest(params);
-	s3c_rotator_start(params, mode);
-
-	ctrl->status = ROT_RUN;
+	if (copy_from_user(&params, (ro_params *)arg, sizeof(ro_params)))
+		return -EFAULT;
 
-	if(!(file->f_flags & O_NONBLOCK)) {
-		if (interruptible_sleep_on_timeout(&waitq_rotator, ROTATOR_TIMEOUT) == 0) {
-			printk(KERN_ERR "\n%s: Waiting for interrupt is timeout\n", __FUNCTION__);
-		}
-	}
+	if (file->f_flags & O_NONBLOCK)
+		return s3c_rotator_queue(file, cmd, &params, 0, &seq, NULL);
 
-	mutex_unlock(h_rot_mutex);
+	ret = s3c_rotator_queue(file, cmd, &params, 0, &seq, &job);
+	if (ret)
+		return ret;
 
-	return 0;
+	return s3c_rotator_wait_sync(file, job);
 }
 
 
 static unsigned int s3c_rotator_poll(struct file *file, poll_table *wait)
 {
+	struct s3c_rot_file	*rfile = (struct s3c_rot_file *)file->private_data;
 	unsigned int mask = 0;
 
-	poll_wait(file, &waitq_rotator, wait);
+	poll_wait(file, &rfile->wq, wait);
 
-	if (S3C_ROTATOR_IDLE == s3c_rotator_get_status()) {
-		mask = POLLOUT|POLLWRNORM;
-	}
+	if (!list_empty(&rfile->done))
+		mask |= POLLIN|POLLRDNORM;
+
+	if (rfile->running == 0)
+		mask |= POLLOUT|POLLWRNORM;
 
 	return mask;
 }
@@ -378,6 +742,10 @@ int s3c_rotator_probe(struct platform_device *pdev)
 	}
 
 	init_waitqueue_head(&waitq_rotator);
+	setup_timer(&s3c_rot_timer, s3c_rotator_timeout, 0);
+
+	ctrl->status = ROT_IDLE;
+	s3c_rotator_enable_int();
 
 	ret = misc_register(&s3c_rotator_dev);
 	if (ret) {
@@ -385,14 +753,6 @@ int s3c_rotator_probe(struct platform_device *pdev)
 		return ret;
 	}
 
-	h_rot_mutex = (struct mutex *)kmalloc(sizeof(struct mutex), GFP_KERNEL);
-	if (h_rot_mutex == NULL) {
-		printk (KERN_ERR "cannot allocate rotator mutex\n");
-		return -ENOENT;
-	}
-	
-	mutex_init(h_rot_mutex);
-
 	printk("s3c_rotator_probe success\n");
     
 	return 0;  
@@ -402,9 +762,27 @@ int s3c_rotator_probe(struct platform_device *pdev)
 static int s3c_rotator_remove(struct platform_device *dev)
 {
 	struct s3c_rotator_ctrl	*ctrl = &s3c_rot;
+	struct s3c_rot_job	*job, *tmp;
+	unsigned long		flags;
+	LIST_HEAD(drop);
+
+	wait_event_timeout(waitq_rotator, s3c_rot_active == NULL, ROTATOR_TIMEOUT);
+	del_timer_sync(&s3c_rot_timer);
+
+	s3c_rotator_disable_int();
 	clk_disable(ctrl->clock);
 
 	free_irq(s3c_rotator_irq_num, NULL);
+
+	/* nothing runs any more, queued jobs are dropped */
+	spin_lock_irqsave(&s3c_rot_lock, flags);
+	s3c_rotator_flush(&drop);
+	spin_unlock_irqrestore(&s3c_rot_lock, flags);
+
+	list_for_each_entry_safe(job, tmp, &drop, list) {
+		list_del(&job->list);
+		kfree(job);
+	}
 	
 	if (s3c_rotator_mem != NULL) {   
 		printk(KERN_INFO "S3C Rotator Driver, releasing resource\n");
@@ -422,20 +800,16 @@ static int s3c_rotator_remove(struct platform_device *dev)
 static int s3c_rotator_suspend(struct platform_device *dev, pm_message_t state)
 {
 	struct s3c_rotator_ctrl	*ctrl = &s3c_rot;
-	unsigned int 		i = 0;
+	unsigned long		flags;
 
-	if (ctrl->status != ROT_IDLE) {
-		ctrl->status = ROT_READY_SLEEP;
+	/* let the running job finish, queued jobs start again on resume */
+	spin_lock_irqsave(&s3c_rot_lock, flags);
+	ctrl->status = ROT_READY_SLEEP;
+	spin_unlock_irqrestore(&s3c_rot_lock, flags);
 
-		while (i++ > 1000) {
-			if (ctrl->status != ROT_IDLE)
-				printk(KERN_ERR "Rotator is running.\n");
-			else
-				break;
-		}
-	} else {
-		ctrl->status = ROT_READY_SLEEP;
-	}
+	if (wait_event_timeout(waitq_rotator, s3c_rot_active == NULL,
+			       ROTATOR_TIMEOUT) == 0)
+		printk(KERN_ERR "Rotator is running.\n");
 
 	ctrl->status = ROT_SLEEP;
 	clk_disable(ctrl->clock);
@@ -447,12 +821,17 @@ static int s3c_rotator_suspend(struct platform_device *dev, pm_message_t state)
 static int s3c_rotator_resume(struct platform_device *pdev)
 {
 	struct s3c_rotator_ctrl	*ctrl = &s3c_rot;
+	unsigned long		flags;
 	
 	clk_enable(ctrl->clock);
-	ctrl->status = ROT_IDLE;
 
 	s3c_rotator_enable_int();
 
+	spin_lock_irqsave(&s3c_rot_lock, flags);
+	ctrl->status = ROT_IDLE;
+	s3c_rotator_run_next();
+	spin_unlock_irqrestore(&s3c_rot_lock, flags);
+
 	return 0;
 }
 
@@ -489,7 +868,6 @@ int __init s3c_rotator_init(void)
 void  s3c_rotator_exit(void)
 {
 	platform_driver_unregister(&s3c_rotator_driver);
-	mutex_destroy(h_rot_mutex);
 	
 	printk("s3c_rotator_driver exit\n");
 }
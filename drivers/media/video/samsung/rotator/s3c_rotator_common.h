@@ -25,6 +25,10 @@
 #define ROTATOR_270			_IO(ROTATOR_IOCTL_MAGIC, 2)
 #define HFLIP				_IO(ROTATOR_IOCTL_MAGIC, 3)
 #define VFLIP				_IO(ROTATOR_IOCTL_MAGIC, 4)
+#define ROTATOR_QUEUE			_IOWR(ROTATOR_IOCTL_MAGIC, 5, ro_job)
+#define ROTATOR_DEQUEUE			_IOWR(ROTATOR_IOCTL_MAGIC, 6, ro_job)
+
+#define ROTATOR_QUEUE_MAX		8	// jobs per file handle, running or not yet dequeued
 
 typedef struct{
 	unsigned int src_width;			// Source Image Full Width
@@ -39,6 +43,21 @@ typedef struct{
 	unsigned int dst_addr_cr;		// Base Address of the Destination Image (CR Component) : Physical Address		
 }ro_params;
 
+/*
+ * ROTATOR_QUEUE queues a rotation and returns its sequence number without
+ * waiting. The addresses in params are physical, so buffers owned by FIMC
+ * or MFC can be passed in as they are. ROTATOR_DEQUEUE returns the oldest
+ * finished job of the file handle with its status (0 or -errno); poll()
+ * reports POLLIN while finished jobs are waiting and POLLOUT when no job of
+ * the file handle is running.
+ */
+typedef struct{
+	unsigned int cmd;			// ROTATOR_90, ROTATOR_180, ROTATOR_270, HFLIP or VFLIP
+	ro_params params;
+	unsigned int seq;			// out : sequence number of the job
+	int status;				// out (ROTATOR_DEQUEUE) : result of the job
+}ro_job;
+
 enum s3c_rot_status {
 	ROT_IDLE,
 	ROT_RUN,
@@ -14,6 +14,7 @@
 #include <linux/kernel.h>
 #include <linux/stddef.h>
 #include <linux/delay.h>
+#include <linux/sched.h>
 #include <linux/ioctl.h>
 #include <linux/clk.h>
 
@@ -915,3 +916,329 @@ bool _s5p_vlayer_init_param(unsigned long buf_in)
 	return true;
 }
 
+
+/*
+ * Video layer buffer queue
+ *
+ * A buffer goes pending -> latched -> shown -> done. At each vsync the
+ * frame latched at the previous one is on screen, so the frame it
+ * replaced goes back to the user, and the newest pending frame that is
+ * due is written to the shadow registers. Due frames it overtakes are
+ * returned with V4L2_BUF_FLAG_ERROR, which keeps the video on the audio
+ * clock when the decoder falls behind.
+ */
+static void _s5p_vlayer_reset_queue(s5p_vl_queue *q)
+{
+	int i;
+
+	q->n_pending = 0;
+	q->n_done = 0;
+	q->latched = -1;
+	q->shown = -1;
+
+	for (i = 0; i < S5P_VL_QUEUE_MAX; i++)
+		q->bufs[i].buf.flags &= ~(V4L2_BUF_FLAG_QUEUED |
+					  V4L2_BUF_FLAG_DONE);
+}
+
+void _s5p_vlayer_init_queue(void)
+{
+	s5p_vl_queue *q = &s5ptv_status.vl_queue;
+
+	spin_lock_init(&q->lock);
+	init_waitqueue_head(&q->wq);
+
+	q->count = 0;
+	q->streaming = false;
+	q->sequence = 0;
+	q->frame_us = 0;
+
+	_s5p_vlayer_reset_queue(q);
+}
+
+/* called with q->lock held */
+static void _s5p_vlayer_retire(s5p_vl_queue *q, int idx, u32 flags)
+{
+	struct v4l2_buffer *b = &q->bufs[idx].buf;
+
+	b->flags &= ~(V4L2_BUF_FLAG_QUEUED | V4L2_BUF_FLAG_ERROR);
+	b->flags |= V4L2_BUF_FLAG_DONE | flags;
+
+	q->done[q->n_done++] = idx;
+}
+
+/*
+ * a frame latched now is on screen from the next vsync, so take it if
+ * that vsync is the one closest to its presentation time.
+ */
+static bool _s5p_vlayer_due(s5p_vl_queue *q, struct timeval *pts)
+{
+	long sec;
+	long usec;
+
+	if (!pts->tv_sec && !pts->tv_usec)
+		return true;
+
+	sec = pts->tv_sec - q->vsync_time.tv_sec;
+
+	if (sec > 1)
+		return false;
+
+	if (sec < -1)
+		return true;
+
+	usec = sec * USEC_PER_SEC + (pts->tv_usec - q->vsync_time.tv_usec);
+
+	return usec < (long)(q->frame_us + q->frame_us / 2);
+}
+
+void _s5p_vlayer_vsync(void)
+{
+	s5p_vl_queue *q = &s5ptv_status.vl_queue;
+	struct timeval now;
+	u32 n_done;
+	long usec;
+	bool wake;
+	int idx = -1;
+
+	do_gettimeofday(&now);
+
+	spin_lock(&q->lock);
+
+	n_done = q->n_done;
+
+	/* frame period, averaged; gaps while the interrupt was off are skipped */
+	if (q->sequence &&
+	    (unsigned long)(now.tv_sec - q->vsync_time.tv_sec) <= 1) {
+		usec = (now.tv_sec - q->vsync_time.tv_sec) * USEC_PER_SEC +
+			(now.tv_usec - q->vsync_time.tv_usec);
+
+		if (usec > 0 && usec < USEC_PER_SEC / 10)
+			q->frame_us = q->frame_us ?
+				(q->frame_us * 7 + usec) / 8 : usec;
+	}
+
+	q->sequence++;
+	q->vsync_time = now;
+
+	if (!q->streaming || !s5ptv_status.vp_layer_enable)
+		goto out;
+
+	/* the shadow registers took the latched frame at this vsync */
+	if (q->latched >= 0 && !__s5p_vp_get_update_status()) {
+		if (q->shown >= 0)
+			_s5p_vlayer_retire(q, q->shown, 0);
+
+		q->shown = q->latched;
+		q->latched = -1;
+
+		q->bufs[q->shown].buf.timestamp = now;
+		q->bufs[q->shown].buf.sequence = q->sequence;
+	}
+
+	if (q->latched >= 0)
+		goto out;
+
+	while (q->n_pending &&
+	       _s5p_vlayer_due(q, &q->bufs[q->pending[0]].buf.timestamp)) {
+		if (idx >= 0) {
+			q->bufs[idx].buf.timestamp = now;
+			q->bufs[idx].buf.sequence = q->sequence;
+			_s5p_vlayer_retire(q, idx, V4L2_BUF_FLAG_ERROR);
+			VLAYERPRINTK("frame %d dropped\n\r", idx);
+		}
+
+		idx = q->pending[0];
+		q->n_pending--;
+		memmove(q->pending, q->pending + 1, q->n_pending);
+	}
+
+	if (idx >= 0) {
+		_s5p_vlayer_set_top_address((unsigned long)&q->bufs[idx].addr);
+		q->latched = idx;
+	}
+
+out:
+	wake = q->n_done != n_done;
+
+	spin_unlock(&q->lock);
+
+	if (wake)
+		wake_up(&q->wq);
+}
+
+int _s5p_vlayer_reqbufs(u32 count)
+{
+	s5p_vl_queue *q = &s5ptv_status.vl_queue;
+	unsigned long flags;
+	int i;
+
+	if (q->streaming)
+		return -EBUSY;
+
+	if (count > S5P_VL_QUEUE_MAX)
+		count = S5P_VL_QUEUE_MAX;
+
+	spin_lock_irqsave(&q->lock, flags);
+
+	_s5p_vlayer_reset_queue(q);
+
+	for (i = 0; i < count; i++) {
+		memset(&q->bufs[i], 0, sizeof(s5p_vl_buf));
+		q->bufs[i].buf.index = i;
+		q->bufs[i].buf.type = V4L2_BUF_TYPE_VIDEO_OUTPUT;
+		q->bufs[i].buf.memory = V4L2_MEMORY_USERPTR;
+		q->bufs[i].buf.field = V4L2_FIELD_NONE;
+	}
+
+	q->count = count;
+
+	spin_unlock_irqrestore(&q->lock, flags);
+
+	VLAYERPRINTK("%d buffers\n\r", count);
+
+	return count;
+}
+
+int _s5p_vlayer_querybuf(struct v4l2_buffer *b)
+{
+	s5p_vl_queue *q = &s5ptv_status.vl_queue;
+	unsigned long flags;
+
+	if (b->index >= q->count)
+		return -EINVAL;
+
+	spin_lock_irqsave(&q->lock, flags);
+	*b = q->bufs[b->index].buf;
+	spin_unlock_irqrestore(&q->lock, flags);
+
+	return 0;
+}
+
+int _s5p_vlayer_qbuf(struct v4l2_buffer *b, s5p_video_img_address *addr)
+{
+	s5p_vl_queue *q = &s5ptv_status.vl_queue;
+	s5p_vl_buf *vb;
+	unsigned long flags;
+
+	if (b->index >= q->count)
+		return -EINVAL;
+
+	spin_lock_irqsave(&q->lock, flags);
+
+	vb = &q->bufs[b->index];
+
+	if (vb->buf.flags & (V4L2_BUF_FLAG_QUEUED | V4L2_BUF_FLAG_DONE)) {
+		spin_unlock_irqrestore(&q->lock, flags);
+		VLAYERPRINTK("buffer %d is already queued\n\r", b->index);
+		return -EINVAL;
+	}
+
+	vb->addr = *addr;
+	vb->buf.m.userptr = b->m.userptr;
+	vb->buf.timestamp = b->timestamp;
+	vb->buf.flags &= ~V4L2_BUF_FLAG_ERROR;
+	vb->buf.flags |= V4L2_BUF_FLAG_QUEUED;
+
+	q->pending[q->n_pending++] = b->index;
+
+	*b = vb->buf;
+
+	spin_unlock_irqrestore(&q->lock, flags);
+
+	return 0;
+}
+
+int _s5p_vlayer_dqbuf(struct v4l2_buffer *b, bool nonblock)
+{
+	s5p_vl_queue *q = &s5ptv_status.vl_queue;
+	unsigned long flags;
+	int idx;
+	int ret;
+
+	spin_lock_irqsave(&q->lock, flags);
+
+	while (!q->n_done) {
+		if (!q->streaming) {
+			spin_unlock_irqrestore(&q->lock, flags);
+			return -EINVAL;
+		}
+
+		spin_unlock_irqrestore(&q->lock, flags);
+
+		if (nonblock)
+			return -EAGAIN;
+
+		ret = wait_event_interruptible(q->wq,
+				q->n_done || !q->streaming);
+		if (ret)
+			return ret;
+
+		spin_lock_irqsave(&q->lock, flags);
+	}
+
+	idx = q->done[0];
+	q->n_done--;
+	memmove(q->done, q->done + 1, q->n_done);
+
+	q->bufs[idx].buf.flags &= ~V4L2_BUF_FLAG_DONE;
+	*b = q->bufs[idx].buf;
+
+	spin_unlock_irqrestore(&q->lock, flags);
+
+	return 0;
+}
+
+unsigned int _s5p_vlayer_poll(struct file *file, poll_table *wait)
+{
+	s5p_vl_queue *q = &s5ptv_status.vl_queue;
+	unsigned int mask = 0;
+	unsigned long flags;
+
+	poll_wait(file, &q->wq, wait);
+
+	spin_lock_irqsave(&q->lock, flags);
+
+	if (q->n_done)
+		mask |= POLLOUT | POLLWRNORM;
+	else if (!q->streaming)
+		mask |= POLLERR;
+
+	spin_unlock_irqrestore(&q->lock, flags);
+
+	return mask;
+}
+
+void _s5p_vlayer_streamon(void)
+{
+	s5p_vl_queue *q = &s5ptv_status.vl_queue;
+	unsigned long flags;
+
+	/* s_fmt still sets the address directly without a queue */
+	if (!q->count)
+		return;
+
+	spin_lock_irqsave(&q->lock, flags);
+	q->streaming = true;
+	spin_unlock_irqrestore(&q->lock, flags);
+
+	__s5p_vm_set_vsync_interrupt(true);
+}
+
+void _s5p_vlayer_streamoff(void)
+{
+	s5p_vl_queue *q = &s5ptv_status.vl_queue;
+	unsigned long flags;
+
+	if (!q->streaming)
+		return;
+
+	__s5p_vm_set_vsync_interrupt(false);
+
+	spin_lock_irqsave(&q->lock, flags);
+	q->streaming = false;
+	_s5p_vlayer_reset_queue(q);
+	spin_unlock_irqrestore(&q->lock, flags);
+
+	wake_up(&q->wq);
+}
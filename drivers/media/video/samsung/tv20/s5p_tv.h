@@ -14,6 +14,10 @@
 #include <linux/videodev2.h>
 #include <linux/videodev2_samsung.h>
 #include <linux/platform_device.h>
+#include <linux/spinlock.h>
+#include <linux/wait.h>
+#include <linux/time.h>
+#include <linux/poll.h>
 
 #ifdef CONFIG_CPU_S5PC110
 #include "s5pc110/tv_out_s5pc110.h"
@@ -94,6 +98,45 @@ typedef struct _s5p_video_img_address {
 	u32 c_address;
 }s5p_video_img_address;
 
+/*
+ * Video layer buffer queue
+ *
+ * Frames are queued by physical address and flipped onto the video
+ * processor from the mixer vsync interrupt. A frame stays on screen
+ * until the next one has latched, and only then goes back to the user.
+ */
+#define S5P_VL_QUEUE_MAX	4
+
+typedef struct _s5p_vl_buf {
+	struct v4l2_buffer buf;
+	s5p_video_img_address addr;
+}s5p_vl_buf;
+
+typedef struct _s5p_vl_queue {
+	spinlock_t lock;
+	wait_queue_head_t wq;
+	s5p_vl_buf bufs[S5P_VL_QUEUE_MAX];
+	u32 count;
+
+	/* queued by the user, in presentation order */
+	u8 pending[S5P_VL_QUEUE_MAX];
+	u32 n_pending;
+
+	/* shown or dropped, waiting for dqbuf */
+	u8 done[S5P_VL_QUEUE_MAX];
+	u32 n_done;
+
+	/* programmed into the shadow registers, not yet on screen */
+	int latched;
+	/* being scanned out */
+	int shown;
+
+	bool streaming;
+	u32 sequence;
+	struct timeval vsync_time;
+	u32 frame_us;
+}s5p_vl_queue;
+
 typedef struct _s5p_vl_mode {
 	bool line_skip;
 	s5p_vp_mem_mode mem_mode;
@@ -464,6 +507,9 @@ typedef struct _s5p_tv_status {
 	bool vp_layer_enable;
 	bool grp_layer_enable[2];
 
+	// VIDIOC_QBUF/DQBUF on the video layer
+	s5p_vl_queue vl_queue;
+
 	// i2c for hdcp port
 
 	struct i2c_client 	*hdcp_i2c_client;
@@ -554,6 +600,17 @@ struct v4l2_pix_format_s5p_tvout {
 	struct v4l2_pix_format	pix_fmt;
 };
 
+/*
+ * VIDIOC_QBUF on the video layer takes V4L2_MEMORY_USERPTR buffers whose
+ * m.userptr points at this, so MFC/FIMC output is displayed in place.
+ * timestamp is the presentation time in do_gettimeofday() time, zero
+ * meaning as soon as possible.
+ */
+struct v4l2_buffer_s5p_tvout {
+	void *base_y;
+	void *base_c;
+};
+
 extern const struct v4l2_ioctl_ops s5p_tv_v4l2_v_ops;
 extern const struct v4l2_ioctl_ops s5p_tv_v4l2_vo_ops;
 
@@ -630,6 +687,15 @@ extern	bool _s5p_vlayer_set_poly_filter_coef(unsigned long p_buf_in);
 extern	bool _s5p_vlayer_set_csc_coef(unsigned long p_buf_in);
 extern	bool _s5p_vlayer_start(void);
 extern	bool _s5p_vlayer_stop(void);
+extern	void _s5p_vlayer_init_queue(void);
+extern	int _s5p_vlayer_reqbufs(u32 count);
+extern	int _s5p_vlayer_querybuf(struct v4l2_buffer *b);
+extern	int _s5p_vlayer_qbuf(struct v4l2_buffer *b, s5p_video_img_address *addr);
+extern	int _s5p_vlayer_dqbuf(struct v4l2_buffer *b, bool nonblock);
+extern	unsigned int _s5p_vlayer_poll(struct file *file, poll_table *wait);
+extern	void _s5p_vlayer_streamon(void);
+extern	void _s5p_vlayer_streamoff(void);
+extern	void _s5p_vlayer_vsync(void);
 
 /*
  * raw i/o ftn!!
@@ -744,6 +810,7 @@ s5p_tv_vmx_err 	__s5p_vm_get_layer_info(s5p_tv_vmx_layer layer, bool *show, u32
 void 	__s5p_vm_start(void);
 void 	__s5p_vm_stop(void);
 s5p_tv_vmx_err 	__s5p_vm_set_underflow_interrupt_enable(s5p_tv_vmx_layer layer, bool en);
+void 	__s5p_vm_set_vsync_interrupt(bool en);
 void __s5p_vm_clear_pend_all(void);
 irqreturn_t __s5p_mixer_irq(int irq, void *dev_id);
 
@@ -408,8 +408,15 @@ int s5p_tv_v_mmap(struct file *filp, struct vm_area_struct *vma)
 	return 0;
 }
 
+unsigned int s5p_tv_v_poll(struct file *filp, poll_table *wait)
+{
+	return _s5p_vlayer_poll(filp, wait);
+}
+
 int s5p_tv_v_release(struct file *filp)
 {
+	_s5p_vlayer_streamoff();
+	_s5p_vlayer_reqbufs(0);
 	_s5p_vlayer_stop();
 	_s5p_tv_if_stop();
 
@@ -536,6 +543,7 @@ static struct v4l2_file_operations s5p_tv_v_fops = {
 	.open		= s5p_tv_v_open,
 	.read		= s5p_tv_v_read,
 	.write		= s5p_tv_v_write,
+	.poll		= s5p_tv_v_poll,
 	.ioctl		= s5p_tv_v_ioctl,
 	.mmap		= s5p_tv_v_mmap,
 	.release	= s5p_tv_v_release
@@ -666,6 +674,8 @@ static int __devinit s5p_tv_probe(struct platform_device *pdev)
 
 	
 	
+	_s5p_vlayer_init_queue();
+
 	/* interrupt */
 	TVOUT_IRQ_INIT(irq_num, ret, pdev, 0, out, __s5p_mixer_irq, "mixer");
 	TVOUT_IRQ_INIT(irq_num, ret, pdev, 1, out_hdmi_irq, __s5p_hdmi_irq , "hdmi");
@@ -22,6 +22,8 @@
 #include <asm/io.h>
 #include <asm/uaccess.h>
 
+#include <plat/media.h>
+
 #include "s5p_tv.h"
 
 #ifdef COFIG_TVOUT_DBG
@@ -475,7 +477,7 @@ static int s5p_tv_v4l2_s_fmt_vid_out(struct file *file, void *fh, struct v4l2_fo
 		s5ptv_status.vl_basic_param.top_c_address = (unsigned int)vparam.base_c;
 
 		/* check progressive or not */
-		if (vparam.pix_fmt.field == V4L2_FIELD_NONE){
+		if (vparam.pix_fmt.field == V4L2_FIELD_NONE){
 
 			/* progressive */
 			
@@ -642,22 +644,100 @@ static int s5p_tv_v4l2_try_fmt_vid_out_overlay(struct file *file, void *fh, stru
 /* Buffer handlers */
 static int s5p_tv_v4l2_reqbufs(struct file *file, void *fh, struct v4l2_requestbuffers *b)
 {
+	int ret;
+
+	if (b->type != V4L2_BUF_TYPE_VIDEO_OUTPUT)
+		return 0;
+
+	if (b->memory != V4L2_MEMORY_USERPTR) {
+		V4L2PRINTK("only V4L2_MEMORY_USERPTR is supported\n");
+		return -EINVAL;
+	}
+
+	ret = _s5p_vlayer_reqbufs(b->count);
+
+	if (ret < 0)
+		return ret;
+
+	b->count = ret;
+
 	return 0;
 }
 
 static int s5p_tv_v4l2_querybuf(struct file *file, void *fh, struct v4l2_buffer *b)
 {
+	if (b->type != V4L2_BUF_TYPE_VIDEO_OUTPUT)
+		return 0;
+
+	return _s5p_vlayer_querybuf(b);
+}
+
+#ifdef CONFIG_PLAT_S5PC1XX
+/* a frame the TV, MFC or FIMC driver holds in media memory */
+static int s5p_tv_v4l2_media_buf(u32 addr, u32 len)
+{
+	static const int mdevs[] = {
+		S3C_MDEV_TV, S3C_MDEV_MFC,
+		S3C_MDEV_FIMC0, S3C_MDEV_FIMC1, S3C_MDEV_FIMC2,
+	};
+	int i;
+
+	for (i = 0; i < ARRAY_SIZE(mdevs); i++) {
+		if (s3c_media_claimed(mdevs[i], addr, len))
+			return 1;
+	}
+
 	return 0;
 }
+#else
+static inline int s5p_tv_v4l2_media_buf(u32 addr, u32 len)
+{
+	return 1;
+}
+#endif
 
+/*
+ * m.userptr points at a struct v4l2_buffer_s5p_tvout with the physical
+ * addresses of the luma and chroma planes, which the video processor
+ * reads as they are. Both must lie in media memory.
+ */
 static int s5p_tv_v4l2_qbuf(struct file *file, void *fh, struct v4l2_buffer *b)
 {
-	return 0;
+	struct v4l2_buffer_s5p_tvout buf;
+	s5p_video_img_address addr;
+	u32 size;
+
+	if (b->type != V4L2_BUF_TYPE_VIDEO_OUTPUT)
+		return 0;
+
+	if (b->memory != V4L2_MEMORY_USERPTR || !b->m.userptr)
+		return -EINVAL;
+
+	if (copy_from_user(&buf, (void __user *)b->m.userptr, sizeof(buf)))
+		return -EFAULT;
+
+	addr.y_address = (unsigned int)buf.base_y;
+	addr.c_address = (unsigned int)buf.base_c;
+
+	size = s5ptv_status.vl_basic_param.img_width *
+		s5ptv_status.vl_basic_param.img_height;
+
+	if (!s5p_tv_v4l2_media_buf(addr.y_address, size) ||
+	    !s5p_tv_v4l2_media_buf(addr.c_address, size / 2)) {
+		V4L2PRINTK("buffer 0x%08x/0x%08x is not in media memory\n",
+			   addr.y_address, addr.c_address);
+		return -EFAULT;
+	}
+
+	return _s5p_vlayer_qbuf(b, &addr);
 }
 
 static int s5p_tv_v4l2_dqbuf(struct file *file, void *fh, struct v4l2_buffer *b)
 {
-	return 0;
+	if (b->type != V4L2_BUF_TYPE_VIDEO_OUTPUT)
+		return 0;
+
+	return _s5p_vlayer_dqbuf(b, file->f_flags & O_NONBLOCK);
 }
 
 
@@ -735,6 +815,7 @@ static int s5p_tv_v4l2_streamon(struct file *file, void *fh, enum v4l2_buf_type
 		_s5p_vlayer_init_param(0);
 		_s5p_vlayer_start();
 		s5ptv_status.vp_layer_enable = true;
+		_s5p_vlayer_streamon();
 
 		mdelay(50);
 
@@ -767,6 +848,7 @@ static int s5p_tv_v4l2_streamoff(struct file *file, void *fh, enum v4l2_buf_type
 		// Vlayer
 
 	case V4L2_BUF_TYPE_VIDEO_OUTPUT :
+		_s5p_vlayer_streamoff();
 		_s5p_vlayer_stop();
 		break;
 		// GRP0/1
@@ -1627,6 +1709,10 @@ const struct v4l2_ioctl_ops s5p_tv_v4l2_v_ops = {
 //	.vidioc_g_fmt_vid_out_overlay		= s5p_tv_v4l2_g_fmt_vid_out_overlay,		
 //	.vidioc_s_fmt_vid_out_overlay		= s5p_tv_v4l2_s_fmt_vid_out_overlay,		
 //	.vidioc_try_fmt_vid_out_overlay	= s5p_tv_v4l2_try_fmt_vid_out_overlay,			
+	.vidioc_reqbufs			= s5p_tv_v4l2_reqbufs,
+	.vidioc_querybuf		= s5p_tv_v4l2_querybuf,
+	.vidioc_qbuf			= s5p_tv_v4l2_qbuf,
+	.vidioc_dqbuf			= s5p_tv_v4l2_dqbuf,
 	.vidioc_streamon		= s5p_tv_v4l2_streamon,
 	.vidioc_streamoff		= s5p_tv_v4l2_streamoff,
 	.vidioc_g_std			= s5p_tv_v4l2_g_std,
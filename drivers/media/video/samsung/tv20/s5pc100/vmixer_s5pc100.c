@@ -22,6 +22,8 @@
 
 #include "regs/regs-vmx.h"
 
+extern void _s5p_vlayer_vsync(void);
+
 #ifdef COFIG_TVOUT_RAW_DBG
 #define S5P_MXR_DEBUG 1
 #endif
@@ -852,11 +854,29 @@ s5p_tv_vmx_err __s5p_vm_set_underflow_interrupt_enable(s5p_tv_vmx_layer layer, b
 	return VMIXER_NO_ERROR;
 }
 
+/*
+ * vsync interrupt - the video layer flips queued buffers from it
+ */
+void __s5p_vm_set_vsync_interrupt(bool en)
+{
+	if (en) {
+		writel(S5P_MXR_VSYNC_INT_FIRED, mixer_base + S5P_MXR_INT_STATUS);
+		writel((readl(mixer_base + S5P_MXR_INT_EN) | 
+			S5P_MXR_VSYNC_INT_ENABLE), mixer_base + S5P_MXR_INT_EN);
+	} else {
+		writel((readl(mixer_base + S5P_MXR_INT_EN) & 
+			~S5P_MXR_VSYNC_INT_ENABLE), mixer_base + S5P_MXR_INT_EN);
+	}
+
+	VMPRINTK("0x%x)\n\r", readl(mixer_base + S5P_MXR_INT_EN));
+}
+
 void __s5p_vm_clear_pend_all(void)
 {
 	writel(S5P_MXR_INT_FIRED | S5P_MXR_VP_INT_FIRED |
-	       S5P_MXR_GRP0_INT_FIRED | S5P_MXR_GRP1_INT_FIRED,
-	       mixer_base + S5P_MXR_INT_EN);
+	       S5P_MXR_GRP0_INT_FIRED | S5P_MXR_GRP1_INT_FIRED |
+	       S5P_MXR_VSYNC_INT_FIRED,
+	       mixer_base + S5P_MXR_INT_STATUS);
 }
 
 irqreturn_t __s5p_mixer_irq(int irq, void *dev_id)
@@ -865,6 +885,7 @@ irqreturn_t __s5p_mixer_irq(int irq, void *dev_id)
 	bool g0_i_f;
 	bool g1_i_f;
 	bool mxr_i_f;
+	bool vs_i_f;
 	u32 temp_reg = 0;
 
 	v_i_f = (readl(mixer_base + S5P_MXR_INT_STATUS) 
@@ -875,6 +896,8 @@ irqreturn_t __s5p_mixer_irq(int irq, void *dev_id)
 			& S5P_MXR_GRP1_INT_FIRED) ? true : false;
 	mxr_i_f = (readl(mixer_base + S5P_MXR_INT_STATUS) 
 			& S5P_MXR_INT_FIRED) ? true : false;
+	vs_i_f = (readl(mixer_base + S5P_MXR_INT_STATUS) 
+			& S5P_MXR_VSYNC_INT_FIRED) ? true : false;
 
 	if (mxr_i_f) {
 		temp_reg |= S5P_MXR_INT_FIRED;
@@ -894,7 +917,13 @@ irqreturn_t __s5p_mixer_irq(int irq, void *dev_id)
 			printk("GRP1 fifo under run!!\n\r");
 		}
 
+		if (vs_i_f)
+			temp_reg |= S5P_MXR_VSYNC_INT_FIRED;
+
 		writel(temp_reg, mixer_base + S5P_MXR_INT_STATUS);
+
+		if (vs_i_f)
+			_s5p_vlayer_vsync();
 	}
 
 	return IRQ_HANDLED;
@@ -162,6 +162,8 @@
 #define S5P_MXR_SD   (0<<0)
 
 // MIXER_INT_EN
+#define S5P_MXR_VSYNC_INT_ENABLE (1<<11)
+#define S5P_MXR_VSYNC_INT_DISABLE (0<<11)
 #define S5P_MXR_VP_INT_ENABLE    (1<<10)
 #define S5P_MXR_VP_INT_DISABLE   (0<<10)
 #define S5P_MXR_GRP1_INT_ENABLE  (1<<9)
@@ -170,6 +172,7 @@
 #define S5P_MXR_GRP0_INT_DISABLE (0<<8)
 
 // MIXER_INT_STATUS
+#define S5P_MXR_VSYNC_INT_FIRED  (1<<11)
 #define S5P_MXR_VP_INT_FIRED     (1<<10)
 #define S5P_MXR_GRP1_INT_FIRED   (1<<9)
 #define S5P_MXR_GRP0_INT_FIRED   (1<<8)
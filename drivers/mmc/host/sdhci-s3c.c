@@ -27,6 +27,10 @@
 
 #define MAX_BUS_CLK	(4)
 
+static int use_adma = 1;
+module_param(use_adma, bool, 0444);
+MODULE_PARM_DESC(use_adma, "Use ADMA2 when the controller offers it (default on)");
+
 struct sdhci_s3c {
 	struct sdhci_host	*host;
 	struct platform_device	*pdev;
@@ -356,6 +360,15 @@ static int __devinit sdhci_s3c_probe(struct platform_device *pdev)
 	host->quirks |= (SDHCI_QUIRK_32BIT_DMA_ADDR |
 			 SDHCI_QUIRK_32BIT_DMA_SIZE);
 
+	/* The ADMA engine takes neither unaligned addresses nor lengths
+	 * that are not a multiple of 32 bits, and the S3C descriptor
+	 * builder has no bounce entries for them, so send such requests
+	 * through PIO rather than let the engine corrupt them. */
+	host->quirks |= SDHCI_QUIRK_32BIT_ADMA_SIZE;
+
+	if (!use_adma)
+		host->quirks |= SDHCI_QUIRK_BROKEN_ADMA;
+
 	host->quirks |= SDHCI_QUIRK_NO_HISPD_BIT;
 
 	if (pdata->host_caps)
@@ -18,6 +18,9 @@
 #include <linux/io.h>
 #include <linux/dma-mapping.h>
 #include <linux/scatterlist.h>
+#include <linux/debugfs.h>
+#include <linux/seq_file.h>
+#include <linux/math64.h>
 
 #include <linux/leds.h>
 
@@ -324,6 +327,12 @@ static void sdhci_kunmap_atomic(void *buffer, unsigned long *flags)
 	local_irq_restore(*flags);
 }
 
+/*
+ * The descriptor table and the alignment buffer are allocated coherent
+ * once in sdhci_add_host(), so building a request only has to map its
+ * scatterlist and write the entries; nothing is mapped, synced or
+ * unmapped for the tables themselves on the request path.
+ */
 static int sdhci_adma_table_pre(struct sdhci_host *host,
 	struct mmc_data *data)
 {
@@ -331,23 +340,19 @@ static int sdhci_adma_table_pre(struct sdhci_host *host,
 
 #if !defined(CONFIG_MMC_SDHCI_S3C) && !defined(CONFIG_MMC_SDHCI_MODULE)
 	u8 *desc;
+	u8 *align;
+	dma_addr_t align_addr;
+	int offset;
+	char *buffer;
+	unsigned long flags;
 #else
         struct sdhci_adma2_desc *descriptor;
 #endif
-	u8 *align;
 	dma_addr_t addr;
-	dma_addr_t align_addr;
 	int len;
-#if !defined(CONFIG_MMC_SDHCI_S3C) && !defined(CONFIG_MMC_SDHCI_MODULE)
-	int offset;
-#endif
 
 	struct scatterlist *sg;
 	int i;
-#if !defined(CONFIG_MMC_SDHCI_S3C) && !defined(CONFIG_MMC_SDHCI_MODULE)
-	char *buffer;
-	unsigned long flags;
-#endif
 
 	/*
 	 * The spec does not specify endianness of descriptor table.
@@ -359,30 +364,19 @@ static int sdhci_adma_table_pre(struct sdhci_host *host,
 	else
 		direction = DMA_TO_DEVICE;
 
-	/*
-	 * The ADMA descriptor table is mapped further down as we
-	 * need to fill it with data first.
-	 */
-
-	host->align_addr = dma_map_single(mmc_dev(host->mmc),
-		host->align_buffer, 128 * 4, direction);
-	if (dma_mapping_error(mmc_dev(host->mmc), host->align_addr))
-		goto fail;
-	BUG_ON(host->align_addr & 0x3);
-
 	host->sg_count = dma_map_sg(mmc_dev(host->mmc),
 		data->sg, data->sg_len, direction);
 	if (host->sg_count == 0)
-		goto unmap_align;
+		goto fail;
 
 #if !defined(CONFIG_MMC_SDHCI_S3C) && !defined(CONFIG_MMC_SDHCI_MODULE)
 	desc = host->adma_desc;
-#else
-        descriptor = (struct sdhci_adma2_desc *)host->adma_desc;
-#endif
 	align = host->align_buffer;
 
 	align_addr = host->align_addr;
+#else
+        descriptor = (struct sdhci_adma2_desc *)host->adma_desc;
+#endif
 
 	for_each_sg(data->sg, sg, host->sg_count, i) {
 		addr = sg_dma_address(sg);
@@ -446,10 +440,21 @@ static int sdhci_adma_table_pre(struct sdhci_host *host,
 		 * If this triggers then we have a calculation bug
 		 * somewhere. :/
 		 */
-		WARN_ON((desc - host->adma_desc) > (128 * 2 + 1) * 4);
+		WARN_ON((desc - host->adma_desc) > SDHCI_ADMA_TABLE_SZ);
 #else
+		/*
+		 * No bounce entries here: sdhci_prepare_data() already
+		 * sent anything unaligned to PIO, so this is only a
+		 * guard against a request the host limits should have
+		 * ruled out.
+		 */
+		if ((addr & 0x3) || (len & 0x3) || len > 65536 ||
+		    i >= SDHCI_ADMA_MAX_SEGS)
+			goto unmap_entries;
+
+		/* a length of 0 encodes 64 KiB */
                 descriptor->dma_addr = addr;
-                descriptor->len_attr = (len << 16) | 0x21;
+                descriptor->len_attr = ((len & 0xffff) << 16) | 0x21;
                 descriptor++;
 #endif
 	}
@@ -473,28 +478,16 @@ static int sdhci_adma_table_pre(struct sdhci_host *host,
 	descriptor->len_attr |= 0x2;
 #endif
 
-	/*
-	 * Resync align buffer as we might have changed it.
-	 */
-	if (data->flags & MMC_DATA_WRITE) {
-		dma_sync_single_for_device(mmc_dev(host->mmc),
-			host->align_addr, 128 * 4, direction);
-	}
-
-	host->adma_addr = dma_map_single(mmc_dev(host->mmc),
-		host->adma_desc, (128 * 2 + 1) * 4, DMA_TO_DEVICE);
-	if (dma_mapping_error(mmc_dev(host->mmc), host->adma_addr))
-		goto unmap_entries;
-	BUG_ON(host->adma_addr & 0x3);
+	/* the table is coherent, but the entries must land before the go */
+	wmb();
 
 	return 0;
 
+#if defined(CONFIG_MMC_SDHCI_S3C) || defined(CONFIG_MMC_SDHCI_MODULE)
 unmap_entries:
 	dma_unmap_sg(mmc_dev(host->mmc), data->sg,
 		data->sg_len, direction);
-unmap_align:
-	dma_unmap_single(mmc_dev(host->mmc), host->align_addr,
-		128 * 4, direction);
+#endif
 fail:
 	return -EINVAL;
 }
@@ -515,12 +508,6 @@ static void sdhci_adma_table_post(struct sdhci_host *host,
 	else
 		direction = DMA_TO_DEVICE;
 
-	dma_unmap_single(mmc_dev(host->mmc), host->adma_addr,
-		(128 * 2 + 1) * 4, DMA_TO_DEVICE);
-
-	dma_unmap_single(mmc_dev(host->mmc), host->align_addr,
-		128 * 4, direction);
-
 	if (data->flags & MMC_DATA_READ) {
 		dma_sync_sg_for_cpu(mmc_dev(host->mmc), data->sg,
 			data->sg_len, direction);
@@ -545,6 +532,19 @@ static void sdhci_adma_table_post(struct sdhci_host *host,
 		data->sg_len, direction);
 }
 
+static void sdhci_adma_free(struct sdhci_host *host)
+{
+	if (host->adma_desc)
+		dma_free_coherent(mmc_dev(host->mmc), SDHCI_ADMA_TABLE_SZ,
+			host->adma_desc, host->adma_addr);
+	if (host->align_buffer)
+		dma_free_coherent(mmc_dev(host->mmc), SDHCI_ADMA_ALIGN_SZ,
+			host->align_buffer, host->align_addr);
+
+	host->adma_desc = NULL;
+	host->align_buffer = NULL;
+}
+
 static u8 sdhci_calc_timeout(struct sdhci_host *host, struct mmc_data *data)
 {
 	u8 count;
@@ -609,12 +609,13 @@ static void sdhci_prepare_data(struct sdhci_host *host, struct mmc_data *data)
 		return;
 
 	/* Sanity checks */
-	BUG_ON(data->blksz * data->blocks > 524288);
+	BUG_ON(data->blksz * data->blocks > host->mmc->max_req_size);
 	BUG_ON(data->blksz > host->mmc->max_blk_size);
 	BUG_ON(data->blocks > 65535);
 
 	host->data = data;
 	host->data_early = 0;
+	host->stats.start = ktime_get();
 
 	count = sdhci_calc_timeout(host, data);
 	writeb(count, host->ioaddr + SDHCI_TIMEOUT_CONTROL);
@@ -739,6 +740,11 @@ static void sdhci_prepare_data(struct sdhci_host *host, struct mmc_data *data)
 		writeb(ctrl, host->ioaddr + SDHCI_HOST_CONTROL);
 	}
 
+	if (!(host->flags & SDHCI_REQ_USE_DMA))
+		host->stats.pio++;
+	else if (host->flags & SDHCI_USE_ADMA)
+		host->stats.adma++;
+
         /* when using PIO mode sg_miter should be initialized. */
 	if (!(host->flags & SDHCI_REQ_USE_DMA)) {
 		sg_miter_start(&host->sg_miter,
@@ -746,7 +752,10 @@ static void sdhci_prepare_data(struct sdhci_host *host, struct mmc_data *data)
 		host->blocks = data->blocks;
 	}
 
-	/* We do not handle DMA boundaries, so set it to max (512 KiB) */
+	/*
+	 * We do not handle SDMA boundaries, so set it to max (512 KiB).
+	 * ADMA ignores the field.
+	 */
 	writew(SDHCI_MAKE_BLKSZ(7, data->blksz),
 		host->ioaddr + SDHCI_BLOCK_SIZE);
 	writew(data->blocks, host->ioaddr + SDHCI_BLOCK_COUNT);
@@ -823,6 +832,11 @@ static void sdhci_finish_data(struct sdhci_host *host)
 	else
 		data->bytes_xfered = data->blksz * data->blocks;
 
+	host->stats.requests++;
+	host->stats.bytes += data->bytes_xfered;
+	host->stats.busy_ns += ktime_to_ns(ktime_sub(ktime_get(),
+						     host->stats.start));
+
 	if (data->stop) {
 		/*
 		 * The controller needs a reset of internal state machines
@@ -1449,8 +1463,14 @@ static void sdhci_data_irq(struct sdhci_host *host, u32 intmask)
 		host->data->error = -ETIMEDOUT;
 	else if (intmask & (SDHCI_INT_DATA_CRC | SDHCI_INT_DATA_END_BIT))
 		host->data->error = -EILSEQ;
-	else if (intmask & SDHCI_INT_ADMA_ERROR)
+	else if (intmask & SDHCI_INT_ADMA_ERROR) {
+		host->stats.adma_errors++;
+		printk(KERN_ERR "%s: ADMA error 0x%08x at descriptor 0x%08x\n",
+			mmc_hostname(host->mmc),
+			readl(host->ioaddr + SDHCI_ADMA_ERROR),
+			readl(host->ioaddr + SDHCI_ADMA_ADDRESS));
 		host->data->error = -EIO;
+	}
 
 	if (host->data->error)
 		sdhci_finish_data(host);
@@ -1463,9 +1483,11 @@ static void sdhci_data_irq(struct sdhci_host *host, u32 intmask)
 		 * boundaries, but as we can't disable the feature
 		 * we need to at least restart the transfer.
 		 */
-		if (intmask & SDHCI_INT_DMA_END)
+		if (intmask & SDHCI_INT_DMA_END) {
+			host->stats.dma_boundary++;
 			writel(readl(host->ioaddr + SDHCI_DMA_ADDRESS),
 				host->ioaddr + SDHCI_DMA_ADDRESS);
+		}
 
 		if (intmask & SDHCI_INT_DATA_END) {
 			if (host->cmd) {
@@ -1501,6 +1523,8 @@ static irqreturn_t sdhci_irq(int irq, void *dev_id)
 	DBG("*** %s got interrupt: 0x%08x\n",
 		mmc_hostname(host->mmc), intmask);
 
+	host->stats.irqs++;
+
 	if (intmask & (SDHCI_INT_CARD_INSERT | SDHCI_INT_CARD_REMOVE)) {
 		writel(intmask & (SDHCI_INT_CARD_INSERT | SDHCI_INT_CARD_REMOVE),
 			host->ioaddr + SDHCI_INT_STATUS);
@@ -1630,6 +1654,88 @@ EXPORT_SYMBOL_GPL(sdhci_resume_host);
  *                                                                           *
 \*****************************************************************************/
 
+#ifdef CONFIG_DEBUG_FS
+
+/*
+ * "busy" is the rate while a data request was in flight, which is what
+ * the DMA mode and the card decide; irqs/MiB shows what it costs the CPU.
+ */
+static int sdhci_stats_show(struct seq_file *m, void *p)
+{
+	struct sdhci_host *host = m->private;
+	struct sdhci_stats st;
+	unsigned long flags;
+	u64 kbps = 0, irqs_mib = 0, us;
+
+	spin_lock_irqsave(&host->lock, flags);
+	st = host->stats;
+	spin_unlock_irqrestore(&host->lock, flags);
+
+	us = div_u64(st.busy_ns > 0 ? st.busy_ns : 0, NSEC_PER_USEC);
+	if (us)
+		kbps = div64_u64(st.bytes * 15625, us * 16);
+	if (st.bytes >> 20)
+		irqs_mib = div64_u64(st.irqs, st.bytes >> 20);
+
+	seq_printf(m, "mode:         %s\n",
+		(host->flags & SDHCI_USE_ADMA) ? "ADMA2" :
+		(host->flags & SDHCI_USE_DMA) ? "SDMA" : "PIO");
+	seq_printf(m, "requests:     %lu (adma %lu, pio %lu)\n",
+		st.requests, st.adma, st.pio);
+	seq_printf(m, "bytes:        %llu\n", (unsigned long long)st.bytes);
+	seq_printf(m, "busy KB/s:    %llu\n", (unsigned long long)kbps);
+	seq_printf(m, "irqs:         %lu\n", st.irqs);
+	seq_printf(m, "irqs/MiB:     %llu\n", (unsigned long long)irqs_mib);
+	seq_printf(m, "sdma restart: %lu\n", st.dma_boundary);
+	seq_printf(m, "adma errors:  %lu\n", st.adma_errors);
+
+	return 0;
+}
+
+static int sdhci_stats_open(struct inode *inode, struct file *file)
+{
+	return single_open(file, sdhci_stats_show, inode->i_private);
+}
+
+/* any write starts a new measurement */
+static ssize_t sdhci_stats_write(struct file *file, const char __user *ubuf,
+	size_t count, loff_t *ppos)
+{
+	struct sdhci_host *host = ((struct seq_file *)file->private_data)->private;
+	unsigned long flags;
+	ktime_t start;
+
+	spin_lock_irqsave(&host->lock, flags);
+	start = host->stats.start;
+	memset(&host->stats, 0, sizeof(host->stats));
+	host->stats.start = start;
+	spin_unlock_irqrestore(&host->lock, flags);
+
+	return count;
+}
+
+static const struct file_operations sdhci_stats_fops = {
+	.open		= sdhci_stats_open,
+	.read		= seq_read,
+	.write		= sdhci_stats_write,
+	.llseek		= seq_lseek,
+	.release	= single_release,
+};
+
+static void sdhci_add_debugfs(struct sdhci_host *host)
+{
+	/* removed along with the rest of the host's directory */
+	if (host->mmc->debugfs_root)
+		debugfs_create_file("sdhci_stats", S_IRUSR | S_IWUSR,
+			host->mmc->debugfs_root, host, &sdhci_stats_fops);
+}
+
+#else
+
+static inline void sdhci_add_debugfs(struct sdhci_host *host) {}
+
+#endif /* CONFIG_DEBUG_FS */
+
 struct sdhci_host *sdhci_alloc_host(struct device *dev,
 	size_t priv_size)
 {
@@ -1717,18 +1823,23 @@ int sdhci_add_host(struct sdhci_host *host)
 	if (host->flags & SDHCI_USE_ADMA) {
 		/*
 		 * We need to allocate descriptors for all sg entries
-		 * (128) and potentially one alignment transfer for
-		 * each of those entries.
+		 * (SDHCI_ADMA_MAX_SEGS) and potentially one alignment
+		 * transfer for each of those entries. Both live in
+		 * coherent memory for the lifetime of the host.
 		 */
-		host->adma_desc = kmalloc((128 * 2 + 1) * 4, GFP_KERNEL);
-		host->align_buffer = kmalloc(128 * 4, GFP_KERNEL);
+		host->adma_desc = dma_alloc_coherent(mmc_dev(mmc),
+			SDHCI_ADMA_TABLE_SZ, &host->adma_addr, GFP_KERNEL);
+		host->align_buffer = dma_alloc_coherent(mmc_dev(mmc),
+			SDHCI_ADMA_ALIGN_SZ, &host->align_addr, GFP_KERNEL);
 		if (!host->adma_desc || !host->align_buffer) {
-			kfree(host->adma_desc);
-			kfree(host->align_buffer);
+			sdhci_adma_free(host);
 			printk(KERN_WARNING "%s: Unable to allocate ADMA "
 				"buffers. Falling back to standard DMA.\n",
 				mmc_hostname(mmc));
 			host->flags &= ~SDHCI_USE_ADMA;
+		} else {
+			BUG_ON(host->adma_addr & 0x3);
+			BUG_ON(host->align_addr & 0x3);
 		}
 	}
 
@@ -1807,7 +1918,7 @@ int sdhci_add_host(struct sdhci_host *host)
 	 * can do scatter/gather or not.
 	 */
 	if (host->flags & SDHCI_USE_ADMA)
-		mmc->max_hw_segs = 128;
+		mmc->max_hw_segs = SDHCI_ADMA_MAX_SEGS;
 	else if (host->flags & SDHCI_USE_DMA)
 		mmc->max_hw_segs = 1;
 	else /* PIO */
@@ -1816,9 +1927,13 @@ int sdhci_add_host(struct sdhci_host *host)
 
 	/*
 	 * Maximum number of sectors in one transfer. Limited by DMA boundary
-	 * size (512KiB).
+	 * size (512KiB), except with ADMA which has no boundary and is only
+	 * limited by the descriptor table.
 	 */
-	mmc->max_req_size = 524288;
+	if (host->flags & SDHCI_USE_ADMA)
+		mmc->max_req_size = SDHCI_ADMA_MAX_SEGS * 65536;
+	else
+		mmc->max_req_size = 524288;
 
 	/*
 	 * Maximum segment size. Could be one segment with the maximum number
@@ -1887,6 +2002,7 @@ int sdhci_add_host(struct sdhci_host *host)
 	mmiowb();
 
 	mmc_add_host(mmc);
+	sdhci_add_debugfs(host);
 
 	printk(KERN_INFO "%s: SDHCI controller on %s [%s] using %s%s\n",
 		mmc_hostname(mmc), host->hw_name, dev_name(mmc_dev(mmc)),
@@ -1903,6 +2019,7 @@ reset:
 untasklet:
 	tasklet_kill(&host->card_tasklet);
 	tasklet_kill(&host->finish_tasklet);
+	sdhci_adma_free(host);
 
 	return ret;
 }
@@ -1948,11 +2065,7 @@ void sdhci_remove_host(struct sdhci_host *host, int dead)
 	tasklet_kill(&host->card_tasklet);
 	tasklet_kill(&host->finish_tasklet);
 
-	kfree(host->adma_desc);
-	kfree(host->align_buffer);
-
-	host->adma_desc = NULL;
-	host->align_buffer = NULL;
+	sdhci_adma_free(host);
 }
 
 EXPORT_SYMBOL_GPL(sdhci_remove_host);
@@ -10,6 +10,7 @@
  */
 
 #include <linux/scatterlist.h>
+#include <linux/ktime.h>
 
 /*
  * Controller registers
@@ -172,8 +173,29 @@
 #define   SDHCI_SPEC_100	0
 #define   SDHCI_SPEC_200	1
 
+/*
+ * ADMA2 descriptor table: one entry per sg segment plus a possible
+ * alignment entry for each, and a terminator. Each entry is 8 bytes.
+ */
+#define SDHCI_ADMA_MAX_SEGS	128
+#define SDHCI_ADMA_TABLE_SZ	((SDHCI_ADMA_MAX_SEGS * 2 + 1) * 8)
+#define SDHCI_ADMA_ALIGN_SZ	(SDHCI_ADMA_MAX_SEGS * 4)
+
 struct sdhci_ops;
 
+/* Transfer accounting, reported in debugfs as sdhci_stats */
+struct sdhci_stats {
+	unsigned long		requests;	/* data requests completed */
+	u64			bytes;		/* bytes moved by them */
+	unsigned long		irqs;		/* controller interrupts */
+	unsigned long		dma_boundary;	/* SDMA boundary restarts */
+	unsigned long		adma;		/* data requests run with ADMA */
+	unsigned long		pio;		/* data requests run with PIO */
+	unsigned long		adma_errors;	/* ADMA error interrupts */
+	s64			busy_ns;	/* time with data in flight */
+	ktime_t			start;		/* start of current data request */
+};
+
 struct sdhci_host {
 	/* Data set by hardware interface driver */
 	const char		*hw_name;	/* Hardware bus name */
@@ -263,6 +285,8 @@ struct sdhci_host {
 	dma_addr_t		adma_addr;	/* Mapped ADMA descr. table */
 	dma_addr_t		align_addr;	/* Mapped bounce buffer */
 
+	struct sdhci_stats	stats;		/* Transfer accounting */
+
 	struct tasklet_struct	card_tasklet;	/* Tasklet structures */
 	struct tasklet_struct	finish_tasklet;
 
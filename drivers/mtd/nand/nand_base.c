@@ -619,6 +619,7 @@ static void nand_command_lp(struct mtd_info *mtd, unsigned int command,
 	case NAND_CMD_ERASE1:
 	case NAND_CMD_ERASE2:
 	case NAND_CMD_SEQIN:
+	case NAND_CMD_PLANESEQIN:
 	case NAND_CMD_RNDIN:
 	case NAND_CMD_STATUS:
 	case NAND_CMD_DEPLETE1:
@@ -660,7 +661,10 @@ static void nand_command_lp(struct mtd_info *mtd, unsigned int command,
 		chip->cmd_ctrl(mtd, NAND_CMD_NONE,
 			       NAND_NCE | NAND_CTRL_CHANGE);
 
-		/* This applies to read commands */
+		/*
+		 * This applies to read commands, to cache read (31h/3Fh)
+		 * and to the short tDBSY after the plane 0 latch (11h)
+		 */
 	default:
 		/*
 		 * If we don't have access to the busy pin, we apply the given
@@ -998,6 +1002,26 @@ static int nand_read_page_syndrome(struct mtd_info *mtd, struct nand_chip *chip,
 	return 0;
 }
 
+/**
+ * nand_read_page_cache - [DEFAULT] read the next page of a cache read
+ * @mtd:	mtd info structure
+ * @chip:	nand chip info structure
+ * @buf:	buffer to store read data
+ * @last:	this is the last page of the sequence
+ *
+ * 31h moves the page the array has loaded into the cache register and
+ * starts loading the following one, 3Fh only moves it. The page is then
+ * read out of the cache register with the normal ECC read function.
+ */
+static int nand_read_page_cache(struct mtd_info *mtd, struct nand_chip *chip,
+				uint8_t *buf, int last)
+{
+	chip->cmdfunc(mtd, last ? NAND_CMD_READCACHEEND : NAND_CMD_READCACHESEQ,
+		      -1, -1);
+
+	return chip->ecc.read_page(mtd, chip, buf);
+}
+
 /**
  * nand_transfer_oob - [Internal] Transfer oob to client buffer
  * @chip:	nand chip structure
@@ -1058,11 +1082,12 @@ static uint8_t *nand_transfer_oob(struct nand_chip *chip, uint8_t *oob,
 static int nand_do_read_ops(struct mtd_info *mtd, loff_t from,
 			    struct mtd_oob_ops *ops)
 {
-	int chipnr, page, realpage, col, bytes, aligned;
+	int chipnr, page, realpage, col, bytes, aligned, next;
 	struct nand_chip *chip = mtd->priv;
 	struct mtd_ecc_stats stats;
 	int blkcheck = (1 << (chip->phys_erase_shift - chip->page_shift)) - 1;
 	int sndcmd = 1;
+	int cache, streaming = 0;
 	int ret = 0;
 	uint32_t readlen = ops->len;
 	uint32_t oobreadlen = ops->ooblen;
@@ -1081,9 +1106,14 @@ static int nand_do_read_ops(struct mtd_info *mtd, loff_t from,
 	buf = ops->datbuf;
 	oob = ops->oobbuf;
 
+	/* Sequential data reads can stream through the cache register */
+	cache = NAND_HAS_CACHEREAD(chip) && !oob && ops->mode != MTD_OOB_RAW;
+
 	while(1) {
 		bytes = min(mtd->writesize - col, readlen);
 		aligned = (bytes == mtd->writesize);
+		/* Another page of this block is wanted after this one */
+		next = readlen > bytes && ((page + 1) & blkcheck);
 
 		/* Is the current page in the buffer ? */
 		if (realpage != chip->pagebuf || oob) {
@@ -1092,17 +1122,33 @@ static int nand_do_read_ops(struct mtd_info *mtd, loff_t from,
 			if (likely(sndcmd)) {
 				chip->cmdfunc(mtd, NAND_CMD_READ0, 0x00, page);
 				sndcmd = 0;
+
+				/*
+				 * Load the next page while this one is read
+				 * out, up to the end of the block
+				 */
+				streaming = cache && next;
+				if (streaming)
+					chip->pagebuf = -1;
 			}
 
 			/* Now read the page into the buffer */
-			if (unlikely(ops->mode == MTD_OOB_RAW))
+			if (streaming) {
+				ret = chip->read_page_cache(mtd, chip, bufpoi, !next);
+				streaming = next;
+			} else if (unlikely(ops->mode == MTD_OOB_RAW))
 				ret = chip->ecc.read_page_raw(mtd, chip, bufpoi);
 			else if (!aligned && NAND_SUBPAGE_READ(chip) && !oob)
 				ret = chip->ecc.read_subpage(mtd, chip, col, bytes, bufpoi);
 			else
 				ret = chip->ecc.read_page(mtd, chip, bufpoi);
-			if (ret < 0)
+			if (ret < 0) {
+				/* Don't leave the chip in the middle of a sequence */
+				if (streaming)
+					chip->cmdfunc(mtd, NAND_CMD_READCACHEEND,
+						      -1, -1);
 				break;
+			}
 
 			/* Transfer not aligned data */
 			if (!aligned) {
@@ -1128,7 +1174,7 @@ static int nand_do_read_ops(struct mtd_info *mtd, loff_t from,
 						buf, ops, mtd->oobsize);
 			}
 
-			if (!(chip->options & NAND_NO_READRDY)) {
+			if (!streaming && !(chip->options & NAND_NO_READRDY)) {
 				/*
 				 * Apply delay or wait for ready/busy pin. Do
 				 * this before the AUTOINCR check, so no
@@ -1165,9 +1211,10 @@ static int nand_do_read_ops(struct mtd_info *mtd, loff_t from,
 		}
 
 		/* Check, if the chip supports auto page increment
-		 * or if we have hit a block boundary.
+		 * or if we have hit a block boundary. A cache read
+		 * sequence already has the next page on its way.
 		 */
-		if (!NAND_CANAUTOINCR(chip) || !(page & blkcheck))
+		if (!streaming && (!NAND_CANAUTOINCR(chip) || !(page & blkcheck)))
 			sndcmd = 1;
 	}
 
@@ -1666,6 +1713,93 @@ static int nand_write_page(struct mtd_info *mtd, struct nand_chip *chip,
 	return 0;
 }
 
+/**
+ * nand_write_page_planes - [DEFAULT] two-plane page program
+ * @mtd:	MTD device structure
+ * @chip:	NAND chip descriptor
+ * @buf0:	data for the page in the even block
+ * @buf1:	data for the page in the odd block
+ * @page:	page number in the even block
+ *
+ * Both pages are loaded (80h ... 11h, 81h ... 10h) and programmed in a
+ * single tPROG.
+ */
+static int nand_write_page_planes(struct mtd_info *mtd, struct nand_chip *chip,
+				  const uint8_t *buf0, const uint8_t *buf1,
+				  int page)
+{
+	int status;
+	int page1 = page + (1 << (chip->phys_erase_shift - chip->page_shift));
+
+	chip->cmdfunc(mtd, NAND_CMD_SEQIN, 0x00, page);
+	chip->ecc.write_page(mtd, chip, buf0);
+	chip->cmdfunc(mtd, NAND_CMD_PLANEPROG, -1, -1);
+
+	chip->cmdfunc(mtd, NAND_CMD_PLANESEQIN, 0x00, page1);
+	chip->ecc.write_page(mtd, chip, buf1);
+	chip->cmdfunc(mtd, NAND_CMD_PAGEPROG, -1, -1);
+
+	status = chip->waitfunc(mtd, chip);
+	/*
+	 * See if operation failed and additional status checks are
+	 * available
+	 */
+	if ((status & NAND_STATUS_FAIL) && (chip->errstat))
+		status = chip->errstat(mtd, chip, FL_WRITING, status, page);
+
+	if (status & NAND_STATUS_FAIL)
+		return -EIO;
+
+#ifdef CONFIG_MTD_NAND_VERIFY_WRITE
+	/* Send command to read back the data */
+	chip->cmdfunc(mtd, NAND_CMD_READ0, 0, page);
+	if (chip->verify_buf(mtd, buf0, mtd->writesize))
+		return -EIO;
+
+	chip->cmdfunc(mtd, NAND_CMD_READ0, 0, page1);
+	if (chip->verify_buf(mtd, buf1, mtd->writesize))
+		return -EIO;
+#endif
+	return 0;
+}
+
+/*
+ * Two-plane operations work on block 2n (plane 0) together with block
+ * 2n + 1 (plane 1). Check that page starts such a pair and len covers it.
+ */
+static int nand_plane_pair(struct nand_chip *chip, int page, uint64_t len)
+{
+	int pair_pages = 2 << (chip->phys_erase_shift - chip->page_shift);
+
+	if (!NAND_HAS_MULTIPLANE(chip) || (page & (pair_pages - 1)))
+		return 0;
+
+	return len >= (2ULL << chip->phys_erase_shift);
+}
+
+/*
+ * Program a whole block pair. Pages still go in ascending order within
+ * each block, as MLC requires.
+ */
+static int nand_write_planes(struct mtd_info *mtd, struct nand_chip *chip,
+			     const uint8_t *buf, int page)
+{
+	int i, ret;
+	int pages_per_block = 1 << (chip->phys_erase_shift - chip->page_shift);
+	const uint8_t *buf1 = buf + (1 << chip->phys_erase_shift);
+
+	for (i = 0; i < pages_per_block; i++) {
+		ret = chip->write_page_planes(mtd, chip, buf, buf1, page + i);
+		if (ret)
+			return ret;
+
+		buf += mtd->writesize;
+		buf1 += mtd->writesize;
+	}
+
+	return 0;
+}
+
 /**
  * nand_fill_oob - [Internal] Transfer client buffer to oob
  * @chip:	nand chip structure
@@ -1774,9 +1908,23 @@ static int nand_do_write_ops(struct mtd_info *mtd, loff_t to,
 
 	while(1) {
 		int bytes = mtd->writesize;
+		int pages = 1;
 		int cached = writelen > bytes && page != blockmask;
 		uint8_t *wbuf = buf;
 
+		/* Whole even/odd block pair ? Program both planes at once */
+		if (!column && !oob && ops->mode != MTD_OOB_RAW &&
+		    nand_plane_pair(chip, page, writelen)) {
+			bytes = 2 << chip->phys_erase_shift;
+			pages = 2 * (blockmask + 1);
+
+			ret = nand_write_planes(mtd, chip, buf, page);
+			if (ret)
+				break;
+
+			goto next;
+		}
+
 		/* Partial page write ? */
 		if (unlikely(column || writelen < (mtd->writesize - 1))) {
 			cached = 0;
@@ -1794,14 +1942,14 @@ static int nand_do_write_ops(struct mtd_info *mtd, loff_t to,
 				       (ops->mode == MTD_OOB_RAW));
 		if (ret)
 			break;
-
+next:
 		writelen -= bytes;
 		if (!writelen)
 			break;
 
 		column = 0;
 		buf += bytes;
-		realpage++;
+		realpage += pages;
 
 		page = realpage & chip->pagemask;
 		/* Check, if we cross a chip boundary */
@@ -2012,6 +2160,23 @@ static void multi_erase_cmd(struct mtd_info *mtd, int page)
 	chip->cmdfunc(mtd, NAND_CMD_ERASE2, -1, -1);
 }
 
+/**
+ * plane_erase_cmd - [GENERIC] two-plane block erase command function
+ * @mtd:	MTD device structure
+ * @page:	the page address of the even block of the pair
+ *
+ * Erase an even/odd block pair in one tBERS
+ */
+static void plane_erase_cmd(struct mtd_info *mtd, int page)
+{
+	struct nand_chip *chip = mtd->priv;
+	int pages_per_block = 1 << (chip->phys_erase_shift - chip->page_shift);
+
+	chip->cmdfunc(mtd, NAND_CMD_ERASE1, -1, page);
+	chip->cmdfunc(mtd, NAND_CMD_ERASE1, -1, page + pages_per_block);
+	chip->cmdfunc(mtd, NAND_CMD_ERASE2, -1, -1);
+}
+
 /**
  * nand_erase - [MTD Interface] erase block(s)
  * @mtd:	MTD device structure
@@ -2103,6 +2268,8 @@ int nand_erase_nand(struct mtd_info *mtd, struct erase_info *instr,
 	instr->state = MTD_ERASING;
 
 	while (len) {
+		int i, blocks = 1;
+
 		/*
 		 * heck if we have a bad block, we do not erase bad blocks !
 		 */
@@ -2114,48 +2281,72 @@ int nand_erase_nand(struct mtd_info *mtd, struct erase_info *instr,
 			goto erase_exit;
 		}
 
+		/* Erase a good even/odd block pair with one command */
+		if (nand_plane_pair(chip, page, len) &&
+		    !nand_block_checkbad(mtd, ((loff_t) (page + pages_per_block))
+					 << chip->page_shift, 0, allowbbt))
+			blocks = 2;
+
 		/*
 		 * Invalidate the page cache, if we erase the block which
 		 * contains the current cached page
 		 */
 		if (page <= chip->pagebuf && chip->pagebuf <
-		    (page + pages_per_block))
+		    (page + blocks * pages_per_block))
 			chip->pagebuf = -1;
 
-		chip->erase_cmd(mtd, page & chip->pagemask);
+		if (blocks == 2) {
+			chip->erase_cmd_planes(mtd, page & chip->pagemask);
+			status = chip->waitfunc(mtd, chip);
 
-		status = chip->waitfunc(mtd, chip);
+			/*
+			 * The status doesn't tell which plane failed, so
+			 * erase the pair again one block at a time
+			 */
+			if (status & NAND_STATUS_FAIL)
+				blocks = 1;
+		}
 
-		/*
-		 * See if operation failed and additional status checks are
-		 * available
-		 */
-		if ((status & NAND_STATUS_FAIL) && (chip->errstat))
-			status = chip->errstat(mtd, chip, FL_ERASING,
-					       status, page);
+		if (blocks == 1) {
+			chip->erase_cmd(mtd, page & chip->pagemask);
 
-		/* See if block erase succeeded */
-		if (status & NAND_STATUS_FAIL) {
-			DEBUG(MTD_DEBUG_LEVEL0, "nand_erase: "
-			      "Failed erase, page 0x%08x\n", page);
-			instr->state = MTD_ERASE_FAILED;
-			instr->fail_addr =
-				((loff_t)page << chip->page_shift);
-			goto erase_exit;
+			status = chip->waitfunc(mtd, chip);
+
+			/*
+			 * See if operation failed and additional status
+			 * checks are available
+			 */
+			if ((status & NAND_STATUS_FAIL) && (chip->errstat))
+				status = chip->errstat(mtd, chip, FL_ERASING,
+						       status, page);
+
+			/* See if block erase succeeded */
+			if (status & NAND_STATUS_FAIL) {
+				DEBUG(MTD_DEBUG_LEVEL0, "nand_erase: "
+				      "Failed erase, page 0x%08x\n", page);
+				instr->state = MTD_ERASE_FAILED;
+				instr->fail_addr =
+					((loff_t)page << chip->page_shift);
+				goto erase_exit;
+			}
 		}
 
 		/*
 		 * If BBT requires refresh, set the BBT rewrite flag to the
 		 * page being erased
 		 */
-		if (bbt_masked_page != 0xffffffff &&
-		    (page & BBT_PAGE_MASK) == bbt_masked_page)
-			    rewrite_bbt[chipnr] =
-					((loff_t)page << chip->page_shift);
+		for (i = 0; i < blocks; i++) {
+			int p = page + i * pages_per_block;
+
+			if (bbt_masked_page != 0xffffffff &&
+			    (p & BBT_PAGE_MASK) == bbt_masked_page)
+				rewrite_bbt[chipnr] =
+					((loff_t)p << chip->page_shift);
+		}
 
 		/* Increment page address and decrement length */
-		len -= (1 << chip->phys_erase_shift);
-		page += pages_per_block;
+		len -= ((loff_t)blocks << chip->phys_erase_shift);
+		page += blocks * pages_per_block;
 
 		/* Check, if we cross a chip boundary */
 		if (len && !(page & chip->pagemask)) {
@@ -2589,6 +2780,16 @@ int nand_scan_tail(struct mtd_info *mtd)
 
 	if (!chip->write_page)
 		chip->write_page = nand_write_page;
+	if (!chip->read_page_cache)
+		chip->read_page_cache = nand_read_page_cache;
+	if (!chip->write_page_planes)
+		chip->write_page_planes = nand_write_page_planes;
+	if (!chip->erase_cmd_planes)
+		chip->erase_cmd_planes = plane_erase_cmd;
+
+	/* Cache read and two-plane commands only exist on large page chips */
+	if (mtd->writesize <= 512)
+		chip->options &= ~(NAND_CACHEREAD | NAND_MULTIPLANE);
 
 	/*
 	 * check ECC mode, default to software if 3byte/512byte hardware ECC is
@@ -104,6 +104,9 @@ static char *gravepages = NULL;
 static unsigned int rptwear = 0;
 static unsigned int overridesize = 0;
 static char *cache_file = NULL;
+static unsigned int cache_read = 0;
+static unsigned int multi_plane = 0;
+static unsigned long sim_usecs;
 
 module_param(first_id_byte,  uint, 0400);
 module_param(second_id_byte, uint, 0400);
@@ -127,6 +130,9 @@ module_param(gravepages,     charp, 0400);
 module_param(rptwear,        uint, 0400);
 module_param(overridesize,   uint, 0400);
 module_param(cache_file,     charp, 0400);
+module_param(cache_read,     uint, 0400);
+module_param(multi_plane,    uint, 0400);
+module_param(sim_usecs,      ulong, 0444);
 
 MODULE_PARM_DESC(first_id_byte,  "The first byte returned by NAND Flash 'read ID' command (manufacturer ID)");
 MODULE_PARM_DESC(second_id_byte, "The second byte returned by NAND Flash 'read ID' command (chip ID)");
@@ -159,6 +165,9 @@ MODULE_PARM_DESC(overridesize,   "Specifies the NAND Flash size overriding the I
 				 "The size is specified in erase blocks and as the exponent of a power of two"
 				 " e.g. 5 means a size of 32 erase blocks");
 MODULE_PARM_DESC(cache_file,     "File to use to cache nand pages instead of memory");
+MODULE_PARM_DESC(cache_read,     "Support cache read (31h/3Fh) if not zero (large page chips only)");
+MODULE_PARM_DESC(multi_plane,    "Support two-plane program (11h/81h) and erase (60h-60h-D0h) if not zero");
+MODULE_PARM_DESC(sim_usecs,      "Time the simulated chip has been busy or transferring data (microseconds)");
 
 /* The largest possible page size */
 #define NS_LARGEST_PAGE_SIZE	2048
@@ -215,6 +224,7 @@ MODULE_PARM_DESC(cache_file,     "File to use to cache nand pages instead of mem
 #define STATE_CMD_RESET        0x0000000C /* reset */
 #define STATE_CMD_RNDOUT       0x0000000D /* random output command */
 #define STATE_CMD_RNDOUTSTART  0x0000000E /* random output start command */
+#define STATE_CMD_READCACHE    0x0000000F /* cache read sequential/end command */
 #define STATE_CMD_MASK         0x0000000F /* command states mask */
 
 /* After an address is input, the simulator goes to one of these states */
@@ -247,9 +257,10 @@ MODULE_PARM_DESC(cache_file,     "File to use to cache nand pages instead of mem
 #define ACTION_ZEROOFF   0x00400000 /* don't add any offset to address */
 #define ACTION_HALFOFF   0x00500000 /* add to address half of page */
 #define ACTION_OOBOFF    0x00600000 /* add to address OOB offset */
+#define ACTION_CACHECPY  0x00700000 /* copy the page loaded by a cache read to the internal buffer */
 #define ACTION_MASK      0x00700000 /* action mask */
 
-#define NS_OPER_NUM      13 /* Number of operations supported by the simulator */
+#define NS_OPER_NUM      14 /* Number of operations supported by the simulator */
 #define NS_OPER_STATES   6  /* Maximum number of states in operation */
 
 #define OPT_ANY          0xFFFFFFFF /* any chip supports this operation */
@@ -340,6 +351,26 @@ struct nandsim {
 		uint     off;     /* fixed page offset */
 	} regs;
 
+	/*
+	 * Plane 0 part of a two-plane program or erase, latched by 11h or
+	 * by the second 60h and carried out with the plane 1 part
+	 */
+	struct ns_plane {
+		uint32_t action;  /* ACTION_PRGPAGE, ACTION_SECERASE or 0 */
+		int replay;       /* the latched operation is being performed */
+		struct nandsim_regs regs;
+		union ns_mem buf; /* plane 0 page buffer */
+	} plane;
+
+	/* Next page of a cache read sequence, -1 if there is none */
+	int cache_next;
+
+	/* Simulated time, nanoseconds */
+	struct ns_timing {
+		uint64_t now;          /* chip busy or transferring data */
+		uint64_t array_ready;  /* the array finishes its current load */
+	} timing;
+
 	/* NAND flash lines state */
         struct ns_lines_status {
                 int ce;  /* chip Enable */
@@ -399,6 +430,8 @@ static struct nandsim_operations {
 	/* Large page devices random page read */
 	{OPT_LARGEPAGE, {STATE_CMD_RNDOUT, STATE_ADDR_COLUMN, STATE_CMD_RNDOUTSTART | ACTION_CPY,
 			       STATE_DATAOUT, STATE_READY}},
+	/* Cache read (large page devices) */
+	{OPT_LARGEPAGE, {STATE_CMD_READCACHE | ACTION_CACHECPY, STATE_DATAOUT, STATE_READY}},
 };
 
 struct weak_block {
@@ -687,6 +720,17 @@ static int init_nandsim(struct mtd_info *mtd)
 	}
 	memset(ns->buf.byte, 0xFF, ns->geom.pgszoob);
 
+	if (multi_plane) {
+		ns->plane.buf.byte = kmalloc(ns->geom.pgszoob, GFP_KERNEL);
+		if (!ns->plane.buf.byte) {
+			NS_ERR("init_nandsim: unable to allocate %u bytes for the plane buffer\n",
+				ns->geom.pgszoob);
+			ret = -ENOMEM;
+			goto error;
+		}
+		memset(ns->plane.buf.byte, 0xFF, ns->geom.pgszoob);
+	}
+
 	return 0;
 
 error:
@@ -700,6 +744,7 @@ error:
  */
 static void free_nandsim(struct nandsim *ns)
 {
+	kfree(ns->plane.buf.byte);
 	kfree(ns->buf.byte);
 	free_device(ns);
 
@@ -1021,6 +1066,8 @@ static char *get_state_name(uint32_t state)
 			return "STATE_CMD_RNDOUT";
 		case STATE_CMD_RNDOUTSTART:
 			return "STATE_CMD_RNDOUTSTART";
+		case STATE_CMD_READCACHE:
+			return "STATE_CMD_READCACHE";
 		case STATE_ADDR_PAGE:
 			return "STATE_ADDR_PAGE";
 		case STATE_ADDR_SEC:
@@ -1071,6 +1118,10 @@ static int check_command(int cmd)
 	case NAND_CMD_RESET:
 	case NAND_CMD_RNDOUT:
 	case NAND_CMD_RNDOUTSTART:
+	case NAND_CMD_READCACHESEQ:
+	case NAND_CMD_READCACHEEND:
+	case NAND_CMD_PLANEPROG:
+	case NAND_CMD_PLANESEQIN:
 		return 0;
 
 	case NAND_CMD_STATUS_MULTI:
@@ -1102,6 +1153,7 @@ static uint32_t get_state_by_command(unsigned command)
 		case NAND_CMD_STATUS_MULTI:
 			return STATE_CMD_STATUS_M;
 		case NAND_CMD_SEQIN:
+		case NAND_CMD_PLANESEQIN:
 			return STATE_CMD_SEQIN;
 		case NAND_CMD_READID:
 			return STATE_CMD_READID;
@@ -1113,6 +1165,9 @@ static uint32_t get_state_by_command(unsigned command)
 			return STATE_CMD_RNDOUT;
 		case NAND_CMD_RNDOUTSTART:
 			return STATE_CMD_RNDOUTSTART;
+		case NAND_CMD_READCACHESEQ:
+		case NAND_CMD_READCACHEEND:
+			return STATE_CMD_READCACHE;
 	}
 
 	NS_ERR("get_state_by_command: unknown command, BUG\n");
@@ -1568,6 +1623,101 @@ static int prog_page(struct nandsim *ns, int num)
 	return 0;
 }
 
+/*
+ * Let simulated time pass, busy-waiting for it if do_delays is set.
+ */
+static void ns_time_pass(struct nandsim *ns, uint32_t nsecs)
+{
+	ns->timing.now += nsecs;
+	sim_usecs = divide(ns->timing.now, 1000);
+
+	if (nsecs >= 1000000)
+		NS_MDELAY(nsecs / 1000000);
+	else
+		NS_UDELAY(nsecs / 1000);
+}
+
+/*
+ * Wait for the array to finish loading a page.
+ */
+static void ns_array_wait(struct nandsim *ns)
+{
+	if (ns->timing.array_ready > ns->timing.now)
+		ns_time_pass(ns, ns->timing.array_ready - ns->timing.now);
+}
+
+/*
+ * Keep the array busy for nsecs. A background load (cache read) runs
+ * while data is transferred, the others keep the whole chip busy.
+ */
+static void ns_array_busy(struct nandsim *ns, uint32_t nsecs, int background)
+{
+	ns_array_wait(ns);
+	ns->timing.array_ready = ns->timing.now + nsecs;
+	if (!background)
+		ns_array_wait(ns);
+}
+
+/*
+ * Time to transfer 'bytes' bytes over the bus, nanoseconds.
+ */
+static inline uint32_t ns_bus_time(struct nandsim *ns, uint cycle, uint bytes)
+{
+	return cycle * bytes / (ns->busw == 8 ? 1 : 2);
+}
+
+/*
+ * The first page of the sector addressed by an erase command. The first
+ * sector address bytes end up in the column register.
+ */
+static inline uint ns_sector_row(struct nandsim *ns, struct nandsim_regs *regs)
+{
+	return (regs->row << 8 * (ns->geom.pgaddrbytes - ns->geom.secaddrbytes)) |
+		regs->column;
+}
+
+static int do_state_action(struct nandsim *ns, uint32_t action);
+
+/*
+ * Perform the latched plane 0 part of a two-plane operation. Plane 0
+ * is the even block and plane 1 must be the odd block right after it.
+ *
+ * RETURNS: 0 if success, -1 if error.
+ */
+static int ns_plane_replay(struct nandsim *ns, uint32_t action)
+{
+	struct nandsim_regs regs = ns->regs;
+	union ns_mem buf = ns->buf;
+	uint row0 = ns->plane.regs.row, row1 = ns->regs.row;
+	int ret;
+
+	if (action == ACTION_SECERASE) {
+		row0 = ns_sector_row(ns, &ns->plane.regs);
+		row1 = ns_sector_row(ns, &ns->regs);
+	}
+
+	if (action != ns->plane.action || ((row0 / ns->geom.pgsec) & 1) ||
+	    row1 != row0 + ns->geom.pgsec) {
+		NS_ERR("do_state_action: pages %#x and %#x are not a two-plane pair\n",
+			row0, row1);
+		ns->plane.action = 0;
+		return -1;
+	}
+
+	ns->regs = ns->plane.regs;
+	ns->buf = ns->plane.buf;
+	ns->plane.replay = 1;
+
+	ret = do_state_action(ns, action);
+
+	ns->plane.replay = 0;
+	ns->plane.action = 0;
+	ns->regs = regs;
+	ns->buf = buf;
+
+	return ret;
+}
+
 /*
  * If state has any action bit, perform this action.
  *
@@ -1576,7 +1726,6 @@ static int prog_page(struct nandsim *ns, int num)
 static int do_state_action(struct nandsim *ns, uint32_t action)
 {
 	int num;
-	int busdiv = ns->busw == 8 ? 1 : 2;
 	unsigned int erase_block_no, page_no;
 
 	action &= ACTION_MASK;
@@ -1587,6 +1736,12 @@ static int do_state_action(struct nandsim *ns, uint32_t action)
 		return -1;
 	}
 
+	/* Program or erase the latched plane 0 first */
+	if ((action == ACTION_PRGPAGE || action == ACTION_SECERASE) &&
+	    ns->plane.action && !ns->plane.replay &&
+	    ns_plane_replay(ns, action) < 0)
+		return -1;
+
 	switch (action) {
 
 	case ACTION_CPY:
@@ -1612,8 +1767,45 @@ static int do_state_action(struct nandsim *ns, uint32_t action)
 		else
 			NS_LOG("read OOB of page %d\n", ns->regs.row);
 
-		NS_UDELAY(access_delay);
-		NS_UDELAY(input_cycle * ns->geom.pgsz / 1000 / busdiv);
+		/* Random data output reads the page register, not the array */
+		if (ns->regs.command != NAND_CMD_RNDOUTSTART)
+			ns_array_busy(ns, access_delay * 1000, 0);
+		if (ns->regs.command == NAND_CMD_READSTART)
+			ns->cache_next = ns->regs.row;
+		ns_time_pass(ns, ns_bus_time(ns, output_cycle, num));
+
+		break;
+
+	case ACTION_CACHECPY:
+		/*
+		 * Cache read - output the page the array has loaded and, for
+		 * 31h, load the next one while it is output.
+		 */
+
+		if (!cache_read || ns->cache_next < 0) {
+			NS_ERR("do_state_action: cache read without a page read\n");
+			return -1;
+		}
+
+		ns_array_wait(ns);
+		ns->regs.row = ns->cache_next;
+		ns->regs.column = ns->regs.off = 0;
+
+		if (ns->regs.command == NAND_CMD_READCACHESEQ &&
+		    ns->regs.row + 1 < ns->geom.pgnum) {
+			ns->cache_next = ns->regs.row + 1;
+			ns_array_busy(ns, access_delay * 1000, 1);
+		} else
+			ns->cache_next = -1;
+
+		num = ns->geom.pgszoob;
+		read_page(ns, num);
+
+		NS_DBG("do_state_action: (ACTION_CACHECPY:) copy %d bytes to int buf, raw offset %d\n",
+			num, NS_RAW_OFFSET(ns));
+		NS_LOG("cache read page %d\n", ns->regs.row);
+
+		ns_time_pass(ns, ns_bus_time(ns, output_cycle, num));
 
 		break;
 
@@ -1633,9 +1825,9 @@ static int do_state_action(struct nandsim *ns, uint32_t action)
 			return -1;
 		}
 
-		ns->regs.row = (ns->regs.row <<
-				8 * (ns->geom.pgaddrbytes - ns->geom.secaddrbytes)) | ns->regs.column;
+		ns->regs.row = ns_sector_row(ns, &ns->regs);
 		ns->regs.column = 0;
+		ns->cache_next = -1;
 
 		erase_block_no = ns->regs.row >> (ns->geom.secshift - ns->geom.pgshift);
 
@@ -1645,7 +1837,9 @@ static int do_state_action(struct nandsim *ns, uint32_t action)
 
 		erase_sector(ns);
 
-		NS_MDELAY(erase_delay);
+		/* Both planes of a two-plane erase take one tBERS */
+		if (!ns->plane.replay)
+			ns_array_busy(ns, erase_delay * 1000000, 0);
 
 		if (erase_block_wear)
 			update_wear(erase_block_no);
@@ -1678,13 +1872,16 @@ static int do_state_action(struct nandsim *ns, uint32_t action)
 			return -1;
 
 		page_no = ns->regs.row;
+		ns->cache_next = -1;
 
 		NS_DBG("do_state_action: copy %d bytes from int buf to (%#x, %#x), raw off = %d\n",
 			num, ns->regs.row, ns->regs.column, NS_RAW_OFFSET(ns) + ns->regs.off);
 		NS_LOG("programm page %d\n", ns->regs.row);
 
-		NS_UDELAY(programm_delay);
-		NS_UDELAY(output_cycle * ns->geom.pgsz / 1000 / busdiv);
+		/* Both planes of a two-plane program take one tPROG */
+		ns_time_pass(ns, ns_bus_time(ns, input_cycle, num));
+		if (!ns->plane.replay)
+			ns_array_busy(ns, programm_delay * 1000, 0);
 
 		if (write_error(page_no)) {
 			NS_WARN("simulating write failure in page %u\n", page_no);
@@ -1942,6 +2139,46 @@ static u_char ns_nand_read_byte(struct mtd_info *mtd)
 	return outb;
 }
 
+/*
+ * Two-plane program (80h-11h-81h-10h) and erase (60h-60h-D0h) latch the
+ * plane 0 part here, it is performed along with the plane 1 part.
+ *
+ * RETURNS: 1 if the command byte was consumed, 0 if not.
+ */
+static int ns_plane_latch(struct nandsim *ns, u_char byte)
+{
+	union ns_mem tmp;
+
+	if (byte == NAND_CMD_PLANEPROG) {
+		if (!multi_plane || NS_STATE(ns->state) != STATE_DATAIN) {
+			NS_ERR("write_byte: plane program command isn't expected, state is %s\n",
+				get_state_name(ns->state));
+			switch_to_ready_state(ns, NS_STATUS_FAILED(ns));
+			return 1;
+		}
+
+		NS_LOG("latch plane 0 program of page %d\n", ns->regs.row);
+		ns->plane.regs = ns->regs;
+		ns->plane.action = ACTION_PRGPAGE;
+		tmp = ns->plane.buf;
+		ns->plane.buf = ns->buf;
+		ns->buf = tmp;
+		switch_to_ready_state(ns, NS_STATUS_OK(ns));
+		return 1;
+	}
+
+	if (byte == NAND_CMD_ERASE1 && multi_plane && ns->op &&
+	    NS_STATE(ns->nxstate) == STATE_CMD_ERASE2) {
+		NS_LOG("latch plane 0 erase of sector %#x\n",
+			ns_sector_row(ns, &ns->regs));
+		ns->plane.regs = ns->regs;
+		ns->plane.action = ACTION_SECERASE;
+		switch_to_ready_state(ns, NS_STATUS_OK(ns));
+	}
+
+	return 0;
+}
+
 static void ns_nand_write_byte(struct mtd_info *mtd, u_char byte)
 {
         struct nandsim *ns = (struct nandsim *)((struct nand_chip *)mtd->priv)->priv;
@@ -1963,6 +2200,8 @@ static void ns_nand_write_byte(struct mtd_info *mtd, u_char byte)
 
 		if (byte == NAND_CMD_RESET) {
 			NS_LOG("reset chip\n");
+			ns->plane.action = 0;
+			ns->cache_next = -1;
 			switch_to_ready_state(ns, NS_STATUS_OK(ns));
 			return;
 		}
@@ -1973,6 +2212,9 @@ static void ns_nand_write_byte(struct mtd_info *mtd, u_char byte)
 			return;
 		}
 
+		if (ns_plane_latch(ns, byte))
+			return;
+
 		if (NS_STATE(ns->state) == STATE_DATAOUT_STATUS
 			|| NS_STATE(ns->state) == STATE_DATAOUT_STATUS_M
 			|| NS_STATE(ns->state) == STATE_DATAOUT) {
@@ -2257,6 +2499,10 @@ static int __init ns_init_module(void)
 	/* The NAND_SKIP_BBTSCAN option is necessary for 'overridesize' */
 	/* and 'badblocks' parameters to work */
 	chip->options   |= NAND_SKIP_BBTSCAN;
+	if (cache_read)
+		chip->options |= NAND_CACHEREAD;
+	if (multi_plane)
+		chip->options |= NAND_MULTIPLANE;
 
 	/*
 	 * Perform minimum nandsim structure initialization to handle
@@ -2268,6 +2514,7 @@ static int __init ns_init_module(void)
 		nand->geom.idbytes = 2;
 	nand->regs.status = NS_STATUS_OK(nand);
 	nand->nxstate = STATE_UNKNOWN;
+	nand->cache_next = -1;
 	nand->options |= OPT_PAGE256; /* temporary value */
 	nand->ids[0] = first_id_byte;
 	nand->ids[1] = second_id_byte;
@@ -21,6 +21,9 @@
 #include <linux/clk.h>
 #include <linux/jiffies.h>
 #include <linux/sched.h>
+#include <linux/interrupt.h>
+#include <linux/completion.h>
+#include <linux/dma-mapping.h>
 
 #include <linux/mtd/mtd.h>
 #include <linux/mtd/nand.h>
@@ -32,6 +35,11 @@
 #include <plat/regs-nand.h>
 #include <plat/nand.h>
 
+#if defined(CONFIG_MTD_NAND_S3C_DMA)
+#include <mach/dma.h>
+#include <plat/dma.h>
+#endif
+
 enum s3c_cpu_type {
 	TYPE_S3C2450,	/* including s3c2416 */
 	TYPE_S3C6400,
@@ -56,6 +64,20 @@ struct s3c_nand_info {
 	int				mtd_count;
 
 	enum s3c_cpu_type		cpu_type;
+
+	/* ECC encode/decode done interrupt */
+	int				irq;
+	int				ecc_armed;
+	struct completion		ecc_done;
+
+#if defined(CONFIG_MTD_NAND_S3C_DMA)
+	/* NFDATA read channel */
+	int				dma_ok;
+	enum s3c2410_dma_buffresult	dma_result;
+	struct completion		dma_done;
+	u8				*dma_buf;
+	dma_addr_t			dma_phys;
+#endif
 };
 static struct s3c_nand_info s3c_nand;
 
@@ -75,6 +97,15 @@ static struct mtd_info *s3c_mtd = NULL;
  */
 #undef	CONFIG_MTD_NAND_S3C_CACHEDPROG
 
+/*
+ * Not every part with 4KB pages does cache read and two-plane
+ * program/erase, and the ID bytes do not say which ones do. Leave both
+ * off unless the board knows its part has them.
+ */
+static int pipeline;
+module_param(pipeline, bool, 0444);
+MODULE_PARM_DESC(pipeline, "Cache read and two-plane ops on 4KB page parts");
+
 /* Nand flash global values by jsgood */
 int cur_ecc_mode = 0;
 int nand_type = S3C_NAND_TYPE_UNKNOWN;
@@ -237,6 +268,64 @@ static void s3c_nand_ce_off(struct mtd_info *mtd)
 }
 #endif
 
+#define S3C_NAND_ECC_TIMEOUT	msecs_to_jiffies(80)
+
+/*
+ * Clear a stale ECC done status and, when the NFC interrupt is
+ * available, have the coming encode or decode signal ecc_done.
+ */
+static void s3c_nand_arm_ecc(u_long *nfcont, int mode)
+{
+	void __iomem *regs = s3c_nand.regs;
+
+	writel(S3C_NFSTAT_ECCENCDONE | S3C_NFSTAT_ECCDECDONE, regs + S3C_NFSTAT);
+
+	*nfcont &= ~(S3C_NFCONT_ENCINT | S3C_NFCONT_DECINT);
+	s3c_nand.ecc_armed = 0;
+
+	if (s3c_nand.irq < 0)
+		return;
+
+	INIT_COMPLETION(s3c_nand.ecc_done);
+	*nfcont |= (mode == NAND_ECC_WRITE) ? S3C_NFCONT_ENCINT : S3C_NFCONT_DECINT;
+	s3c_nand.ecc_armed = 1;
+}
+
+/*
+ * Sleep until the armed encode/decode has finished. Returns 0 when
+ * nothing was armed or the interrupt never came, so the caller polls.
+ */
+static int s3c_nand_wait_ecc_irq(void)
+{
+	if (!s3c_nand.ecc_armed)
+		return 0;
+
+	s3c_nand.ecc_armed = 0;
+
+	if (!wait_for_completion_timeout(&s3c_nand.ecc_done, S3C_NAND_ECC_TIMEOUT)) {
+		dev_warn(s3c_nand.device, "ECC done interrupt timed out\n");
+		return 0;
+	}
+
+	return 1;
+}
+
+static irqreturn_t s3c_nand_irq(int irq, void *dev_id)
+{
+	void __iomem *regs = s3c_nand.regs;
+	u_long nfstat;
+
+	nfstat = readl(regs + S3C_NFSTAT) &
+		 (S3C_NFSTAT_ECCENCDONE | S3C_NFSTAT_ECCDECDONE);
+	if (!nfstat)
+		return IRQ_NONE;
+
+	writel(nfstat, regs + S3C_NFSTAT);
+	complete(&s3c_nand.ecc_done);
+
+	return IRQ_HANDLED;
+}
+
 /*
  * Function for checking ECCEncDone in NFSTAT
  * Written by jsgood
@@ -245,6 +334,9 @@ static void s3c_nand_wait_enc(void)
 {
         void __iomem *regs = s3c_nand.regs;
         unsigned long timeo = jiffies;
+
+	if (s3c_nand_wait_ecc_irq())
+		return;
  
         timeo += 16;    /* when Hz=200,  jiffies interval 1/200=5mS, waiting for 80mS  80/5 = 16 */
  
@@ -266,6 +358,9 @@ static void s3c_nand_wait_dec(void)
 {
 	void __iomem *regs = s3c_nand.regs;
         unsigned long timeo = jiffies;
+
+	if (s3c_nand_wait_ecc_irq())
+		return;
  
         timeo += 16;    /* when Hz=200,  jiffies interval  1/200=5mS, waiting for 80mS  80/5 = 16 */
  
@@ -340,6 +435,8 @@ static void s3c_nand_enable_hwecc(struct mtd_info *mtd, int mode)
 			nfcont |= S3C_NFCONT_ECC_ENC;
 		else if (mode == NAND_ECC_READ)
 			nfcont &= ~S3C_NFCONT_ECC_ENC;
+
+		s3c_nand_arm_ecc(&nfcont, mode);
 	}
 
 	writel(nfcont, regs + S3C_NFCONT);
@@ -617,6 +714,8 @@ static int s3c_nand_read_page_1bit(struct mtd_info *mtd, struct nand_chip *chip,
 		stat = chip->ecc.correct(mtd, p, chip->oob_poi + mecc_pos[0] + ((chip->ecc.steps - eccsteps) * eccbytes), 0);
 		if (stat == -1)
 			mtd->ecc_stats.failed++;
+		else if (stat > 0)
+			mtd->ecc_stats.corrected += stat;
 
 		col = eccsize * (chip->ecc.steps + 1 - eccsteps);
 	}
@@ -654,6 +753,8 @@ static int s3c_nand_read_page_4bit(struct mtd_info *mtd, struct nand_chip *chip,
 
 		if (stat == -1)
 			mtd->ecc_stats.failed++;
+		else if (stat > 0)
+			mtd->ecc_stats.corrected += stat;
 
 		col = eccsize * (chip->ecc.steps + 1 - eccsteps);
 	}
@@ -721,6 +822,8 @@ void s3c_nand_enable_hwecc_8bit(struct mtd_info *mtd, int mode)
 	else if (mode == NAND_ECC_READ)
 		nfcont &= ~S3C_NFCONT_ECC_ENC;
 
+	s3c_nand_arm_ecc(&nfcont, mode);
+
 	writel(nfcont, (regs + S3C_NFCONT));
 }
 
@@ -826,6 +929,139 @@ int s3c_nand_correct_data_8bit(struct mtd_info *mtd, u_char *dat, u_char *read_e
 	return ret;
 }
 
+#if defined(CONFIG_MTD_NAND_S3C_DMA)
+/*
+ * The NFC has no peripheral request line, so the data phase runs on a
+ * memory to memory channel whose source stays on NFDATA. The ECC engine
+ * snoops NFDATA whoever reads it, so decoding goes on during the DMA.
+ */
+#define S3C_NAND_DMA_CH		DMACH_NAND_M2M
+#define S3C_NAND_DMA_BUFSZ	512
+#define S3C_NAND_DMA_TIMEOUT	msecs_to_jiffies(80)
+
+static struct s3c2410_dma_client s3c_nand_dma_client = {
+	.name		= "s3c-nand-dma",
+};
+
+static void s3c_nand_dma_done(struct s3c2410_dma_chan *dma_ch, void *buf_id,
+			      int size, enum s3c2410_dma_buffresult result)
+{
+	s3c_nand.dma_result = result;
+	complete(&s3c_nand.dma_done);
+}
+
+/*
+ * Read len bytes of NFDATA into buf. Buffers the DMA can't reach
+ * (vmalloc, misaligned) go through a coherent bounce buffer.
+ * Returns -EINVAL without touching the bus when DMA can't be used,
+ * any other error means the column has moved and must be reissued.
+ */
+static int s3c_nand_dma_read(uint8_t *buf, int len)
+{
+	dma_addr_t dst;
+	int direct, ret = 0;
+
+	if (!s3c_nand.dma_ok || len > S3C_NAND_DMA_BUFSZ || (len & 3))
+		return -EINVAL;
+
+	direct = virt_addr_valid(buf) &&
+		 !((unsigned long)buf & (L1_CACHE_BYTES - 1));
+
+	if (direct)
+		dst = dma_map_single(s3c_nand.device, buf, len, DMA_FROM_DEVICE);
+	else
+		dst = s3c_nand.dma_phys;
+
+	INIT_COMPLETION(s3c_nand.dma_done);
+	s3c_nand.dma_result = S3C2410_RES_ERR;
+
+	s3c2410_dma_enqueue(S3C_NAND_DMA_CH, NULL, dst, len);
+	s3c2410_dma_ctrl(S3C_NAND_DMA_CH, S3C2410_DMAOP_START);
+
+	if (!wait_for_completion_timeout(&s3c_nand.dma_done, S3C_NAND_DMA_TIMEOUT)) {
+		s3c2410_dma_ctrl(S3C_NAND_DMA_CH, S3C2410_DMAOP_FLUSH);
+		ret = -ETIMEDOUT;
+	} else if (s3c_nand.dma_result != S3C2410_RES_OK)
+		ret = -EIO;
+
+	if (direct)
+		dma_unmap_single(s3c_nand.device, dst, len, DMA_FROM_DEVICE);
+	else if (!ret)
+		memcpy(buf, s3c_nand.dma_buf, len);
+
+	return ret;
+}
+
+static void s3c_nand_dma_init(struct platform_device *pdev, struct resource *res)
+{
+	init_completion(&s3c_nand.dma_done);
+
+	s3c_nand.dma_buf = dma_alloc_coherent(&pdev->dev, S3C_NAND_DMA_BUFSZ,
+					      &s3c_nand.dma_phys, GFP_KERNEL);
+	if (!s3c_nand.dma_buf)
+		goto no_dma;
+
+	if (s3c2410_dma_request(S3C_NAND_DMA_CH, &s3c_nand_dma_client, NULL)) {
+		dma_free_coherent(&pdev->dev, S3C_NAND_DMA_BUFSZ,
+				  s3c_nand.dma_buf, s3c_nand.dma_phys);
+		goto no_dma;
+	}
+
+	s3c2410_dma_set_buffdone_fn(S3C_NAND_DMA_CH, s3c_nand_dma_done);
+	s3c2410_dma_devconfig(S3C_NAND_DMA_CH, S3C_DMA_MEM2MEM_SET, 0,
+			      res->start + S3C_NFDATA);
+	s3c2410_dma_config(S3C_NAND_DMA_CH, 4, 0);
+
+	s3c_nand.dma_ok = 1;
+	dev_info(&pdev->dev, "using DMA for page reads\n");
+	return;
+
+no_dma:
+	dev_warn(&pdev->dev, "no DMA channel, page reads use PIO\n");
+}
+
+static void s3c_nand_dma_exit(struct platform_device *pdev)
+{
+	if (!s3c_nand.dma_ok)
+		return;
+
+	s3c_nand.dma_ok = 0;
+	s3c2410_dma_free(S3C_NAND_DMA_CH, &s3c_nand_dma_client);
+	dma_free_coherent(&pdev->dev, S3C_NAND_DMA_BUFSZ,
+			  s3c_nand.dma_buf, s3c_nand.dma_phys);
+}
+#else
+static inline int s3c_nand_dma_read(uint8_t *buf, int len)
+{
+	return -EINVAL;
+}
+#endif
+
+/*
+ * Read one ECC step at col with the decoder running. A DMA that fails
+ * part way leaves the column undefined, so restart the step with PIO.
+ */
+static void s3c_nand_read_step_8bit(struct mtd_info *mtd, struct nand_chip *chip,
+				    uint8_t *p, int col)
+{
+	int ret;
+
+	chip->cmdfunc(mtd, NAND_CMD_RNDOUT, col, -1);
+	s3c_nand_enable_hwecc_8bit(mtd, NAND_ECC_READ);
+
+	ret = s3c_nand_dma_read(p, chip->ecc.size);
+	if (!ret)
+		return;
+
+	if (ret != -EINVAL) {
+		dev_warn(s3c_nand.device, "DMA read failed (%d), using PIO\n", ret);
+		chip->cmdfunc(mtd, NAND_CMD_RNDOUT, col, -1);
+		s3c_nand_enable_hwecc_8bit(mtd, NAND_ECC_READ);
+	}
+
+	chip->read_buf(mtd, p, chip->ecc.size);
+}
+
 void s3c_nand_write_page_8bit(struct mtd_info *mtd, struct nand_chip *chip,
 				  const uint8_t *buf)
 {
@@ -868,15 +1104,15 @@ int s3c_nand_read_page_8bit(struct mtd_info *mtd, struct nand_chip *chip,
 
 	col = 0;
 	for (i = 0; eccsteps; eccsteps--, i += eccbytes, p += eccsize) {
-		chip->cmdfunc(mtd, NAND_CMD_RNDOUT, col, -1);
-		s3c_nand_enable_hwecc_8bit(mtd, NAND_ECC_READ);
-		chip->read_buf(mtd, p, eccsize);
+		s3c_nand_read_step_8bit(mtd, chip, p, col);
 		chip->write_buf(mtd, chip->oob_poi + mecc_pos[0] + ((chip->ecc.steps - eccsteps) * eccbytes), eccbytes);
 		chip->ecc.calculate(mtd, 0, 0);
 		stat = chip->ecc.correct(mtd, p, NULL, NULL);
 
 		if (stat == -1)
 			mtd->ecc_stats.failed++;
+		else if (stat > 0)
+			mtd->ecc_stats.corrected += stat;
 
 		col = eccsize * ((mtd->writesize / eccsize) + 1 - eccsteps);
 	}
@@ -938,6 +1174,8 @@ static int s3c_nand_probe(struct platform_device *pdev, enum s3c_cpu_type cpu_ty
 	u_char tmp;
 #endif
 
+	s3c_nand.irq = -ENXIO;
+
 	/* get the clock source and enable it */
 
 	s3c_nand.clk = clk_get(&pdev->dev, "nand");
@@ -973,6 +1211,21 @@ static int s3c_nand_probe(struct platform_device *pdev, enum s3c_cpu_type cpu_ty
 		goto exit_error;
 	}
 
+#if defined(CONFIG_MTD_NAND_S3C_HWECC)
+	/* ECC done interrupt, without it the ECC waits keep polling */
+	init_completion(&s3c_nand.ecc_done);
+	s3c_nand.irq = platform_get_irq(pdev, 0);
+	if (s3c_nand.irq >= 0 &&
+	    request_irq(s3c_nand.irq, s3c_nand_irq, 0, pdev->name, &s3c_nand)) {
+		dev_warn(&pdev->dev, "cannot claim IRQ %d, polling ECC\n", s3c_nand.irq);
+		s3c_nand.irq = -ENXIO;
+	}
+#endif
+
+#if defined(CONFIG_MTD_NAND_S3C_DMA)
+	s3c_nand_dma_init(pdev, res);
+#endif
+
 	/* allocate memory for MTD device structure and private data */
 	s3c_mtd = kmalloc(sizeof(struct mtd_info) + sizeof(struct nand_chip), GFP_KERNEL);
 
@@ -1037,6 +1290,7 @@ static int s3c_nand_probe(struct platform_device *pdev, enum s3c_cpu_type cpu_ty
 				nand_type = S3C_NAND_TYPE_SLC;				
 				nand->ecc.size = 512;
 				nand->ecc.bytes	= 4;
+				s3c_mtd->ecc_strength = 1;
 
 				if ((1024 << (tmp & 3)) == 4096) /* For 4KB Page 8_bit ECC */
 				{
@@ -1052,6 +1306,10 @@ static int s3c_nand_probe(struct platform_device *pdev, enum s3c_cpu_type cpu_ty
 				        nand->ecc.size = 512;
 				        nand->ecc.bytes = 13;
 				        nand->options |= NAND_NO_SUBPAGE_WRITE;
+					if (pipeline)
+						nand->options |= NAND_CACHEREAD |
+								 NAND_MULTIPLANE;
+					s3c_mtd->ecc_strength = 8;
 			        } else {
 					if ((1024 << (tmp & 0x3)) > 512) {
 						nand->ecc.read_page = s3c_nand_read_page_1bit;
@@ -1080,12 +1338,17 @@ static int s3c_nand_probe(struct platform_device *pdev, enum s3c_cpu_type cpu_ty
 	                                nand->ecc.size = 512;
         	                        nand->ecc.bytes = 13;
                 	                nand->options |= NAND_NO_SUBPAGE_WRITE;
+					if (pipeline)
+						nand->options |= NAND_CACHEREAD |
+								 NAND_MULTIPLANE;
+					s3c_mtd->ecc_strength = 8;
                         	} else {
 	                                nand->ecc.read_page = s3c_nand_read_page_4bit;
         	                        nand->ecc.write_page = s3c_nand_write_page_4bit;
                 	                nand->ecc.size = 512;
                         	        nand->ecc.bytes = 8;    /* really 7 bytes */
                                 	nand->ecc.layout = &s3c_nand_oob_mlc_64;
+					s3c_mtd->ecc_strength = 4;
 	                        }
 			}
 		} else {
@@ -1094,11 +1357,13 @@ static int s3c_nand_probe(struct platform_device *pdev, enum s3c_cpu_type cpu_ty
 			nand->cellinfo = 0;
 			nand->ecc.bytes = 4;
 			nand->ecc.layout = &s3c_nand_oob_16;
+			s3c_mtd->ecc_strength = 1;
 		}
 
 		printk("S3C NAND Driver is using hardware ECC.\n");
 #else
 		nand->ecc.mode = NAND_ECC_SOFT;
+		s3c_mtd->ecc_strength = 1;
 		printk("S3C NAND Driver is using software ECC.\n");
 #endif
 		if (nand_scan(s3c_mtd, 1)) {
@@ -1114,6 +1379,13 @@ static int s3c_nand_probe(struct platform_device *pdev, enum s3c_cpu_type cpu_ty
 	return 0;
 
 exit_error:
+#if defined(CONFIG_MTD_NAND_S3C_DMA)
+	s3c_nand_dma_exit(pdev);
+#endif
+	if (s3c_nand.irq >= 0) {
+		free_irq(s3c_nand.irq, &s3c_nand);
+		s3c_nand.irq = -ENXIO;
+	}
 	kfree(s3c_mtd);
 
 	return ret;
@@ -1166,6 +1438,14 @@ static int s3c_nand_resume(struct platform_device *dev)
 /* device management functions */
 static int s3c_nand_remove(struct platform_device *dev)
 {
+#if defined(CONFIG_MTD_NAND_S3C_DMA)
+	s3c_nand_dma_exit(dev);
+#endif
+	if (s3c_nand.irq >= 0) {
+		free_irq(s3c_nand.irq, &s3c_nand);
+		s3c_nand.irq = -ENXIO;
+	}
+
 	platform_set_drvdata(dev, NULL);
 
 	return 0;
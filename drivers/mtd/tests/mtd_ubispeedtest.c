@@ -0,0 +1,237 @@
+/*
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 as published by
+ * the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program; see the file COPYING. If not, write to the Free Software
+ * Foundation, 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+ *
+ * Test sustained write speed of an UBI volume right after a mass deletion,
+ * i.e., while UBI still has lots of physical eraseblocks pending erasure.
+ */
+
+#include <linux/init.h>
+#include <linux/module.h>
+#include <linux/moduleparam.h>
+#include <linux/err.h>
+#include <linux/mtd/ubi.h>
+#include <linux/sched.h>
+
+#define PRINT_PREF KERN_INFO "mtd_ubispeedtest: "
+
+static int ubi_num;
+module_param(ubi_num, int, S_IRUGO);
+MODULE_PARM_DESC(ubi_num, "UBI device number to use");
+
+static int vol_id;
+module_param(vol_id, int, S_IRUGO);
+MODULE_PARM_DESC(vol_id, "UBI volume ID to use (all its data is destroyed)");
+
+static struct ubi_volume_desc *desc;
+static struct ubi_volume_info vi;
+static unsigned char *iobuf;
+
+static struct timeval start, finish;
+static unsigned long next = 1;
+
+static inline unsigned int simple_rand(void)
+{
+	next = next * 1103515245 + 12345;
+	return (unsigned int)((next / 65536) % 32768);
+}
+
+static inline void simple_srand(unsigned long seed)
+{
+	next = seed;
+}
+
+static void set_random_data(unsigned char *buf, size_t len)
+{
+	size_t i;
+
+	for (i = 0; i < len; ++i)
+		buf[i] = simple_rand();
+}
+
+static inline void start_timing(void)
+{
+	do_gettimeofday(&start);
+}
+
+static inline void stop_timing(void)
+{
+	do_gettimeofday(&finish);
+}
+
+static long calc_ms(void)
+{
+	return (finish.tv_sec - start.tv_sec) * 1000 +
+	       (finish.tv_usec - start.tv_usec) / 1000;
+}
+
+static long calc_speed(void)
+{
+	long ms, k;
+
+	ms = calc_ms();
+	if (ms == 0)
+		ms = 1;
+	k = (long)vi.size * vi.usable_leb_size / 1024;
+	return (k * 1000) / ms;
+}
+
+static int write_all_lebs(void)
+{
+	int err, i;
+
+	for (i = 0; i < vi.size; ++i) {
+		err = ubi_leb_write(desc, i, iobuf, 0, vi.usable_leb_size,
+				    UBI_UNKNOWN);
+		if (err) {
+			printk(PRINT_PREF "error %d while writing LEB %d\n",
+			       err, i);
+			return err;
+		}
+		cond_resched();
+	}
+	return 0;
+}
+
+/*
+ * Unmap all LEBs of the volume. If @flush is not zero, the last LEB is erased
+ * instead, which makes UBI finish all the pending erasures before returning.
+ */
+static int unmap_all_lebs(int flush)
+{
+	int err, i;
+
+	for (i = 0; i < vi.size; ++i) {
+		if (flush && i == vi.size - 1)
+			err = ubi_leb_erase(desc, i);
+		else
+			err = ubi_leb_unmap(desc, i);
+		if (err) {
+			printk(PRINT_PREF "error %d while unmapping LEB %d\n",
+			       err, i);
+			return err;
+		}
+		cond_resched();
+	}
+	return 0;
+}
+
+static int __init mtd_ubispeedtest_init(void)
+{
+	int err;
+	long speed;
+
+	printk(KERN_INFO "\n");
+	printk(KERN_INFO "=================================================\n");
+	printk(PRINT_PREF "UBI device: %d, volume ID: %d\n", ubi_num, vol_id);
+
+	desc = ubi_open_volume(ubi_num, vol_id, UBI_EXCLUSIVE);
+	if (IS_ERR(desc)) {
+		err = PTR_ERR(desc);
+		printk(PRINT_PREF "error: cannot open UBI volume\n");
+		return err;
+	}
+
+	ubi_get_volume_info(desc, &vi);
+	printk(PRINT_PREF "volume size %d LEBs, LEB size %d\n",
+	       vi.size, vi.usable_leb_size);
+
+	err = -EINVAL;
+	if (vi.vol_type != UBI_DYNAMIC_VOLUME) {
+		printk(PRINT_PREF "error: not a dynamic volume\n");
+		goto out;
+	}
+
+	err = -ENOMEM;
+	iobuf = kmalloc(vi.usable_leb_size, GFP_KERNEL);
+	if (!iobuf) {
+		printk(PRINT_PREF "error: cannot allocate memory\n");
+		goto out;
+	}
+
+	simple_srand(1);
+	set_random_data(iobuf, vi.usable_leb_size);
+
+	/* Start from a clean state with no erasures pending */
+	err = unmap_all_lebs(1);
+	if (err)
+		goto out;
+
+	printk(PRINT_PREF "filling the volume\n");
+	err = write_all_lebs();
+	if (err)
+		goto out;
+	err = ubi_sync(ubi_num);
+	if (err)
+		goto out;
+
+	/* Delete everything, this leaves all PEBs pending erasure */
+	printk(PRINT_PREF "testing mass deletion\n");
+	start_timing();
+	err = unmap_all_lebs(0);
+	if (err)
+		goto out;
+	stop_timing();
+	printk(PRINT_PREF "unmapped %d LEBs in %ld ms\n", vi.size, calc_ms());
+
+	/* And immediately write the whole volume again */
+	printk(PRINT_PREF "testing write speed after mass deletion\n");
+	start_timing();
+	err = write_all_lebs();
+	if (err)
+		goto out;
+	err = ubi_sync(ubi_num);
+	if (err)
+		goto out;
+	stop_timing();
+	speed = calc_speed();
+	printk(PRINT_PREF "write speed after mass deletion is %ld KiB/s\n",
+	       speed);
+
+	/* The same with no erasures pending, for comparison */
+	err = unmap_all_lebs(1);
+	if (err)
+		goto out;
+
+	printk(PRINT_PREF "testing write speed with no erasures pending\n");
+	start_timing();
+	err = write_all_lebs();
+	if (err)
+		goto out;
+	err = ubi_sync(ubi_num);
+	if (err)
+		goto out;
+	stop_timing();
+	speed = calc_speed();
+	printk(PRINT_PREF "write speed with no erasures pending is %ld KiB/s\n",
+	       speed);
+
+	printk(PRINT_PREF "finished\n");
+out:
+	kfree(iobuf);
+	ubi_close_volume(desc);
+	if (err)
+		printk(PRINT_PREF "error %d occurred\n", err);
+	printk(KERN_INFO "=================================================\n");
+	return err;
+}
+module_init(mtd_ubispeedtest_init);
+
+static void __exit mtd_ubispeedtest_exit(void)
+{
+	return;
+}
+module_exit(mtd_ubispeedtest_exit);
+
+MODULE_DESCRIPTION("UBI write after mass deletion speed test module");
+MODULE_LICENSE("GPL");
@@ -120,6 +120,14 @@ static struct device_attribute dev_bgt_enabled =
 	__ATTR(bgt_enabled, S_IRUGO, dev_attribute_show, NULL);
 static struct device_attribute dev_mtd_num =
 	__ATTR(mtd_num, S_IRUGO, dev_attribute_show, NULL);
+static struct device_attribute dev_bitflip_reads =
+	__ATTR(bitflip_reads, S_IRUGO, dev_attribute_show, NULL);
+static struct device_attribute dev_max_bitflips =
+	__ATTR(max_bitflips, S_IRUGO, dev_attribute_show, NULL);
+static struct device_attribute dev_patrol_checks =
+	__ATTR(patrol_checks, S_IRUGO, dev_attribute_show, NULL);
+static struct device_attribute dev_patrol_scrubs =
+	__ATTR(patrol_scrubs, S_IRUGO, dev_attribute_show, NULL);
 
 /**
  * ubi_get_device - get UBI device.
@@ -256,6 +264,14 @@ static ssize_t dev_attribute_show(struct device *dev,
 		ret = sprintf(buf, "%d\n", ubi->thread_enabled);
 	else if (attr == &dev_mtd_num)
 		ret = sprintf(buf, "%d\n", ubi->mtd->index);
+	else if (attr == &dev_bitflip_reads)
+		ret = sprintf(buf, "%u\n", ubi->bitflip_reads);
+	else if (attr == &dev_max_bitflips)
+		ret = sprintf(buf, "%u\n", ubi->max_bitflips);
+	else if (attr == &dev_patrol_checks)
+		ret = sprintf(buf, "%u\n", ubi->patrol_checks);
+	else if (attr == &dev_patrol_scrubs)
+		ret = sprintf(buf, "%u\n", ubi->patrol_scrubs);
 	else
 		ret = -EINVAL;
 
@@ -320,6 +336,18 @@ static int ubi_sysfs_init(struct ubi_device *ubi)
 	if (err)
 		return err;
 	err = device_create_file(&ubi->dev, &dev_mtd_num);
+	if (err)
+		return err;
+	err = device_create_file(&ubi->dev, &dev_bitflip_reads);
+	if (err)
+		return err;
+	err = device_create_file(&ubi->dev, &dev_max_bitflips);
+	if (err)
+		return err;
+	err = device_create_file(&ubi->dev, &dev_patrol_checks);
+	if (err)
+		return err;
+	err = device_create_file(&ubi->dev, &dev_patrol_scrubs);
 	return err;
 }
 
@@ -329,6 +357,10 @@ static int ubi_sysfs_init(struct ubi_device *ubi)
  */
 static void ubi_sysfs_close(struct ubi_device *ubi)
 {
+	device_remove_file(&ubi->dev, &dev_patrol_scrubs);
+	device_remove_file(&ubi->dev, &dev_patrol_checks);
+	device_remove_file(&ubi->dev, &dev_max_bitflips);
+	device_remove_file(&ubi->dev, &dev_bitflip_reads);
 	device_remove_file(&ubi->dev, &dev_mtd_num);
 	device_remove_file(&ubi->dev, &dev_bgt_enabled);
 	device_remove_file(&ubi->dev, &dev_min_io_size);
@@ -478,17 +510,18 @@ static void free_internal_volumes(struct ubi_device *ubi)
  * This function returns zero in case of success and a negative error code in
  * case of failure.
  *
- * Note, currently this is the only method to attach UBI devices. Hopefully in
- * the future we'll have more scalable attaching methods and avoid full media
- * scanning. But even in this case scanning will be needed as a fall-back
- * attaching method if there are some on-flash table corruptions.
+ * If there is a valid fastmap, the scanning information is taken from it
+ * instead of scanning the media. Scanning is the fall-back attaching method
+ * if there is no fastmap or it is corrupted.
  */
 static int attach_by_scanning(struct ubi_device *ubi)
 {
 	int err;
 	struct ubi_scan_info *si;
 
-	si = ubi_scan(ubi);
+	si = ubi_read_fastmap(ubi);
+	if (!si)
+		si = ubi_scan(ubi);
 	if (IS_ERR(si))
 		return PTR_ERR(si);
 
@@ -509,6 +542,10 @@ static int attach_by_scanning(struct ubi_device *ubi)
 	if (err)
 		goto out_wl;
 
+	err = ubi_fastmap_reserve(ubi);
+	if (err)
+		goto out_wl;
+
 	ubi_scan_destroy_si(si);
 	return 0;
 
@@ -568,6 +605,17 @@ static int io_init(struct ubi_device *ubi)
 	if (ubi->mtd->block_isbad && ubi->mtd->block_markbad)
 		ubi->bad_allowed = 1;
 
+	/*
+	 * Scrub once a read needed three quarters of what the ECC is able to
+	 * correct. Drivers which do not tell their ECC strength get the
+	 * configured number of bit-flips.
+	 */
+	if (ubi->mtd->ecc_strength)
+		ubi->scrub_bitflips = DIV_ROUND_UP(ubi->mtd->ecc_strength * 3,
+						   4);
+	else
+		ubi->scrub_bitflips = CONFIG_MTD_UBI_SCRUB_BITFLIPS;
+
 	ubi->min_io_size = ubi->mtd->writesize;
 	ubi->hdrs_min_io_size = ubi->mtd->writesize >> ubi->mtd->subpage_sft;
 
@@ -817,6 +865,11 @@ int ubi_attach_mtd_dev(struct mtd_info *mtd, int ubi_num, int vid_hdr_offset)
 		goto out_free;
 
 	err = -ENOMEM;
+	ubi->peb_rd = vmalloc(ubi->peb_count * sizeof(struct ubi_peb_rd));
+	if (!ubi->peb_rd)
+		goto out_free;
+	memset(ubi->peb_rd, 0, ubi->peb_count * sizeof(struct ubi_peb_rd));
+
 	ubi->peb_buf1 = vmalloc(ubi->peb_size);
 	if (!ubi->peb_buf1)
 		goto out_free;
@@ -832,6 +885,10 @@ int ubi_attach_mtd_dev(struct mtd_info *mtd, int ubi_num, int vid_hdr_offset)
 		goto out_free;
 #endif
 
+	err = ubi_fastmap_init(ubi);
+	if (err)
+		goto out_free;
+
 	err = attach_by_scanning(ubi);
 	if (err) {
 		dbg_err("failed to attach by scanning, error %d", err);
@@ -863,6 +920,7 @@ int ubi_attach_mtd_dev(struct mtd_info *mtd, int ubi_num, int vid_hdr_offset)
 	ubi_msg("number of bad PEBs:         %d", ubi->bad_peb_count);
 	ubi_msg("max. allowed volumes:       %d", ubi->vtbl_slots);
 	ubi_msg("wear-leveling threshold:    %d", CONFIG_MTD_UBI_WL_THRESHOLD);
+	ubi_msg("bit-flips to scrub:         %u", ubi->scrub_bitflips);
 	ubi_msg("number of internal volumes: %d", UBI_INT_VOL_COUNT);
 	ubi_msg("number of user volumes:     %d",
 		ubi->vol_count - UBI_INT_VOL_COUNT);
@@ -890,6 +948,8 @@ out_detach:
 	free_internal_volumes(ubi);
 	vfree(ubi->vtbl);
 out_free:
+	ubi_fastmap_close(ubi);
+	vfree(ubi->peb_rd);
 	vfree(ubi->peb_buf1);
 	vfree(ubi->peb_buf2);
 #ifdef CONFIG_MTD_UBI_DEBUG
@@ -948,6 +1008,13 @@ int ubi_detach_mtd_dev(int ubi_num, int anyway)
 	if (ubi->bgt_thread)
 		kthread_stop(ubi->bgt_thread);
 
+	/*
+	 * Write the fastmap so that the next attach does not have to scan.
+	 * Nothing may wake up the stopped thread.
+	 */
+	ubi->thread_enabled = 0;
+	ubi_update_fastmap(ubi);
+
 	/*
 	 * Get a reference to the device in order to prevent 'dev_release()'
 	 * from freeing @ubi object.
@@ -959,6 +1026,8 @@ int ubi_detach_mtd_dev(int ubi_num, int anyway)
 	free_internal_volumes(ubi);
 	vfree(ubi->vtbl);
 	put_mtd_device(ubi->mtd);
+	ubi_fastmap_close(ubi);
+	vfree(ubi->peb_rd);
 	vfree(ubi->peb_buf1);
 	vfree(ubi->peb_buf2);
 #ifdef CONFIG_MTD_UBI_DEBUG
@@ -0,0 +1,861 @@
+/*
+ * Copyright (c) 2009 Samsung Electronics
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See
+ * the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+/*
+ * UBI fastmap.
+ *
+ * Attaching by scanning reads the EC and VID headers of every physical
+ * eraseblock, so the attach time grows linearly with the flash size. The
+ * fastmap is a snapshot of everything scanning would find out: the erase
+ * counter of each physical eraseblock, which logical eraseblock it is mapped
+ * to, and which physical eraseblocks are free or have to be erased. It is
+ * stored in a few physical eraseblocks, so attaching only has to find the
+ * fastmap and read it.
+ *
+ * The fastmap anchor (the physical eraseblock with the super block, see
+ * &struct ubi_fm_sb) is always one of the first %UBI_FM_MAX_START physical
+ * eraseblocks, so it is found by scanning only them. The anchor refers to the
+ * other fastmap physical eraseblocks, if any.
+ *
+ * The fastmap is only correct as long as nothing changes on the flash, and
+ * UBI changes the flash all the time. Instead of updating the fastmap on each
+ * change, the fastmap is invalidated (the anchor is erased) before the first
+ * change, and a new fastmap is written when the device has been idle for
+ * %UBI_FM_IDLE, and when the device is detached. If the fastmap is not found,
+ * or there is anything wrong with it, UBI falls back to scanning. This means
+ * an unclean power cut never makes attaching go wrong, it only makes it slow.
+ *
+ * Each flash change is bracketed by 'ubi_fastmap_begin()' and
+ * 'ubi_fastmap_end()'. EBA does this in the LEB write lock functions, and WL
+ * in 'do_work()'. When the fastmap is written, the counters of started and
+ * finished changes tell whether a change is in progress.
+ *
+ * The fastmap physical eraseblocks do not belong to the WL sub-system, and
+ * they are reserved in the same way as the EBA and bad PEB handling reserves
+ * are. They are re-used for each new fastmap, and exchanged for free physical
+ * eraseblocks when they become too worn out.
+ */
+
+#include <linux/crc32.h>
+#include "ubi.h"
+
+/* How long the device has to be idle before the fastmap is written */
+#define UBI_FM_IDLE (10 * HZ)
+
+/*
+ * A fastmap physical eraseblock is exchanged for a free one if its erase
+ * counter is higher than the lowest erase counter of free physical
+ * eraseblocks by more than this.
+ */
+#define UBI_FM_WL_DIFF (CONFIG_MTD_UBI_WL_THRESHOLD / 2)
+
+/**
+ * fm_max_size - the maximum size of the fastmap.
+ * @ubi: UBI device description object
+ */
+static int fm_max_size(const struct ubi_device *ubi)
+{
+	return sizeof(struct ubi_fm_sb) + sizeof(struct ubi_fm_hdr) +
+	       ubi->peb_count * sizeof(struct ubi_fm_peb) +
+	       (UBI_MAX_VOLUMES + UBI_INT_VOL_COUNT) *
+	       sizeof(struct ubi_fm_volume);
+}
+
+/**
+ * ubi_fastmap_init - initialize the fastmap.
+ * @ubi: UBI device description object
+ *
+ * This function has to be called before attaching. If the fastmap would not
+ * fit %UBI_FM_MAX_BLOCKS physical eraseblocks, it is disabled. Returns zero
+ * in case of success and a negative error code in case of failure.
+ */
+int ubi_fastmap_init(struct ubi_device *ubi)
+{
+	int blocks;
+
+	mutex_init(&ubi->fm_mutex);
+	atomic_set(&ubi->fm_started, 0);
+	atomic_set(&ubi->fm_finished, 0);
+	ubi->fm_last_change = jiffies;
+
+	blocks = DIV_ROUND_UP(fm_max_size(ubi), ubi->leb_size);
+	if (blocks > UBI_FM_MAX_BLOCKS) {
+		ubi_warn("fastmap would take %d PEBs, max. is %d, disabled",
+			 blocks, UBI_FM_MAX_BLOCKS);
+		return 0;
+	}
+
+	ubi->fm_buf = vmalloc(blocks * ubi->leb_size);
+	if (!ubi->fm_buf)
+		return -ENOMEM;
+
+	ubi->fm_blocks = blocks;
+	return 0;
+}
+
+/**
+ * ubi_fastmap_close - close the fastmap.
+ * @ubi: UBI device description object
+ */
+void ubi_fastmap_close(struct ubi_device *ubi)
+{
+	vfree(ubi->fm_buf);
+}
+
+/**
+ * fm_erase_block - erase a fastmap physical eraseblock.
+ * @ubi: UBI device description object
+ * @i: index of the physical eraseblock in the fastmap
+ * @ec_hdr: EC header buffer to use
+ *
+ * This function returns zero in case of success and a negative error code in
+ * case of failure.
+ */
+static int fm_erase_block(struct ubi_device *ubi, int i,
+			  struct ubi_ec_hdr *ec_hdr)
+{
+	int err, pnum = ubi->fm.pnum[i];
+	long long ec = ubi->fm.ec[i];
+
+	dbg_gen("erase fastmap PEB %d, EC %lld", pnum, ec);
+
+	err = ubi_io_sync_erase(ubi, pnum, 0);
+	if (err < 0)
+		return err;
+
+	ec += err;
+	if (ec > UBI_MAX_ERASECOUNTER) {
+		ubi_err("erase counter overflow at PEB %d, EC %lld", pnum, ec);
+		return -EINVAL;
+	}
+
+	ec_hdr->ec = cpu_to_be64(ec);
+	err = ubi_io_write_ec_hdr(ubi, pnum, ec_hdr);
+	if (err)
+		return err;
+
+	ubi->fm.ec[i] = ec;
+	ubi->fm.erased[i] = 1;
+	return 0;
+}
+
+/**
+ * fm_release - give all fastmap physical eraseblocks back to WL.
+ * @ubi: UBI device description object
+ * @torture_idx: index of the physical eraseblock to torture, %-1 if none
+ *
+ * This is used when something went wrong with a fastmap physical
+ * eraseblock, and when the fastmap is disabled.
+ */
+static void fm_release(struct ubi_device *ubi, int torture_idx)
+{
+	int i, err;
+
+	for (i = 0; i < ubi->fm.used_blocks; i++) {
+		err = ubi_wl_put_fm_peb(ubi, ubi->fm.pnum[i], ubi->fm.ec[i],
+					i == torture_idx);
+		if (err) {
+			ubi_err("cannot return fastmap PEB %d, error %d",
+				ubi->fm.pnum[i], err);
+			ubi_ro_mode(ubi);
+		}
+	}
+	ubi->fm.used_blocks = 0;
+}
+
+/**
+ * fm_invalidate - invalidate the fastmap on the flash.
+ * @ubi: UBI device description object
+ *
+ * The anchor is erased, so the next attach scans the flash unless a new
+ * fastmap is written. Has to be called with @ubi->fm_mutex locked. Returns
+ * zero in case of success and a negative error code in case of failure.
+ */
+static int fm_invalidate(struct ubi_device *ubi)
+{
+	int err;
+	struct ubi_ec_hdr *ec_hdr;
+
+	ec_hdr = kzalloc(ubi->ec_hdr_alsize, GFP_NOFS);
+	if (!ec_hdr)
+		return -ENOMEM;
+
+	err = fm_erase_block(ubi, 0, ec_hdr);
+	kfree(ec_hdr);
+	if (err) {
+		/*
+		 * The stale fastmap stays on the flash, so nothing may change
+		 * on the flash any more.
+		 */
+		ubi_err("cannot invalidate fastmap anchor PEB %d, error %d",
+			ubi->fm.pnum[0], err);
+		ubi_ro_mode(ubi);
+		return err;
+	}
+
+	dbg_gen("fastmap invalidated");
+	ubi->fm_valid = 0;
+
+	/* The background thread has to start counting the idle time */
+	spin_lock(&ubi->wl_lock);
+	if (ubi->thread_enabled)
+		wake_up_process(ubi->bgt_thread);
+	spin_unlock(&ubi->wl_lock);
+	return 0;
+}
+
+/**
+ * ubi_fastmap_begin - a flash change is going to start.
+ * @ubi: UBI device description object
+ *
+ * If there is a valid fastmap on the flash, it is invalidated. Each
+ * successful call has to be paired with a 'ubi_fastmap_end()' call. Returns
+ * zero in case of success and a negative error code in case of failure.
+ */
+int ubi_fastmap_begin(struct ubi_device *ubi)
+{
+	int err = 0;
+
+	atomic_inc(&ubi->fm_started);
+	smp_mb__after_atomic_inc();
+
+	/*
+	 * If the fastmap is being written, wait until it is done. The writer
+	 * sees our change has started and fails, or it completes and we
+	 * invalidate the new fastmap.
+	 */
+	if (!ubi->fm_busy) {
+		smp_rmb();
+		if (!ubi->fm_valid)
+			return 0;
+	}
+
+	mutex_lock(&ubi->fm_mutex);
+	if (ubi->fm_valid)
+		err = fm_invalidate(ubi);
+	mutex_unlock(&ubi->fm_mutex);
+
+	if (err)
+		ubi_fastmap_end(ubi);
+	return err;
+}
+
+/**
+ * ubi_fastmap_end - a flash change has finished.
+ * @ubi: UBI device description object
+ */
+void ubi_fastmap_end(struct ubi_device *ubi)
+{
+	ubi->fm_last_change = jiffies;
+	smp_mb__before_atomic_inc();
+	atomic_inc(&ubi->fm_finished);
+}
+
+/**
+ * ubi_fastmap_timeout - how long until the fastmap should be written.
+ * @ubi: UBI device description object
+ *
+ * This function is called by the background thread when it has nothing else
+ * to do. Returns the number of jiffies to sleep, zero if the fastmap should
+ * be written now, and %MAX_SCHEDULE_TIMEOUT if it should not be written at
+ * all.
+ */
+long ubi_fastmap_timeout(struct ubi_device *ubi)
+{
+	unsigned long expires;
+
+	if (!ubi->fm_blocks || ubi->fm_valid)
+		return MAX_SCHEDULE_TIMEOUT;
+
+	if (atomic_read(&ubi->fm_started) != atomic_read(&ubi->fm_finished))
+		return UBI_FM_IDLE;
+
+	expires = ubi->fm_last_change + UBI_FM_IDLE;
+	if (time_after_eq(jiffies, expires))
+		return 0;
+	return expires - jiffies;
+}
+
+/**
+ * fm_prepare_blocks - get the fastmap physical eraseblocks ready.
+ * @ubi: UBI device description object
+ * @ec_hdr: EC header buffer to use
+ *
+ * This function makes sure the fastmap owns @ubi->fm_blocks physical
+ * eraseblocks, exchanges the worn out ones and erases the rest. Returns zero
+ * in case of success and a negative error code in case of failure.
+ */
+static int fm_prepare_blocks(struct ubi_device *ubi, struct ubi_ec_hdr *ec_hdr)
+{
+	int i, pnum, ec, err;
+
+	for (i = 0; i < ubi->fm_blocks; i++) {
+		int owned = i < ubi->fm.used_blocks;
+		int max_ec = INT_MAX;
+
+		if (owned)
+			max_ec = ubi->fm.ec[i] - UBI_FM_WL_DIFF;
+
+		pnum = ubi_wl_get_fm_peb(ubi, i == 0, max_ec, &ec);
+		if (pnum >= 0) {
+			if (owned) {
+				err = ubi_wl_put_fm_peb(ubi, ubi->fm.pnum[i],
+							ubi->fm.ec[i], 0);
+				if (err) {
+					ubi_ro_mode(ubi);
+					return err;
+				}
+			} else
+				ubi->fm.used_blocks += 1;
+
+			ubi->fm.pnum[i] = pnum;
+			ubi->fm.ec[i] = ec;
+			ubi->fm.erased[i] = 1;
+			continue;
+		}
+
+		if (!owned)
+			return -ENOSPC;
+
+		if (!ubi->fm.erased[i]) {
+			err = fm_erase_block(ubi, i, ec_hdr);
+			if (err) {
+				fm_release(ubi, i);
+				return err;
+			}
+		}
+	}
+
+	return 0;
+}
+
+/**
+ * fm_snapshot - build the fastmap data in @ubi->fm_buf.
+ * @ubi: UBI device description object
+ *
+ * Has to be called when no flash changes are in progress. Returns the size of
+ * the fastmap data.
+ */
+static int fm_snapshot(struct ubi_device *ubi)
+{
+	int i, pnum, lnum, vol_count = 0;
+	struct ubi_fm_sb *sb = ubi->fm_buf;
+	struct ubi_fm_hdr *hdr = (struct ubi_fm_hdr *)(sb + 1);
+	struct ubi_fm_peb *pebs = (struct ubi_fm_peb *)(hdr + 1);
+	struct ubi_fm_volume *vols =
+			(struct ubi_fm_volume *)(pebs + ubi->peb_count);
+
+	memset(ubi->fm_buf, 0, ubi->fm_blocks * ubi->leb_size);
+	for (pnum = 0; pnum < ubi->peb_count; pnum++)
+		pebs[pnum].vol_id = cpu_to_be32(UBI_FM_PEB_SKIP);
+
+	spin_lock(&ubi->volumes_lock);
+	for (i = 0; i < UBI_MAX_VOLUMES + UBI_INT_VOL_COUNT; i++) {
+		struct ubi_volume *vol = ubi->volumes[i];
+		struct ubi_fm_volume *fmv = &vols[vol_count];
+		int mapped = 0;
+
+		if (!vol)
+			continue;
+
+		for (lnum = 0; lnum < vol->reserved_pebs; lnum++) {
+			pnum = vol->eba_tbl[lnum];
+			if (pnum < 0)
+				continue;
+
+			pebs[pnum].vol_id = cpu_to_be32(vol->vol_id);
+			pebs[pnum].lnum = cpu_to_be32(lnum);
+			mapped = 1;
+		}
+
+		if (!mapped)
+			continue;
+
+		fmv->vol_id = cpu_to_be32(vol->vol_id);
+		fmv->data_pad = cpu_to_be32(vol->data_pad);
+		if (vol->vol_type == UBI_STATIC_VOLUME) {
+			fmv->vol_type = UBI_VID_STATIC;
+			fmv->used_ebs = cpu_to_be32(vol->used_ebs);
+			fmv->last_data_size = cpu_to_be32(vol->last_eb_bytes);
+		} else
+			fmv->vol_type = UBI_VID_DYNAMIC;
+		if (vol->vol_id == UBI_LAYOUT_VOLUME_ID)
+			fmv->compat = UBI_LAYOUT_VOLUME_COMPAT;
+		vol_count += 1;
+	}
+	hdr->bad_peb_count = cpu_to_be32(ubi->bad_peb_count);
+	spin_unlock(&ubi->volumes_lock);
+
+	ubi_wl_fm_snapshot(ubi, pebs);
+
+	for (i = 0; i < ubi->fm.used_blocks; i++) {
+		pnum = ubi->fm.pnum[i];
+		pebs[pnum].vol_id = cpu_to_be32(UBI_FM_PEB_SELF);
+		pebs[pnum].ec = cpu_to_be32(ubi->fm.ec[i]);
+	}
+
+	hdr->magic = cpu_to_be32(UBI_FM_HDR_MAGIC);
+	hdr->peb_count = cpu_to_be32(ubi->peb_count);
+	hdr->vol_count = cpu_to_be32(vol_count);
+
+	return (void *)&vols[vol_count] - (void *)hdr;
+}
+
+/**
+ * fm_write - write the fastmap to the flash.
+ * @ubi: UBI device description object
+ * @data_size: size of the fastmap data
+ * @vid_hdr: VID header buffer to use
+ *
+ * The anchor is written last, so an interrupted write leaves no fastmap on
+ * the flash. Returns zero in case of success and a negative error code in
+ * case of failure.
+ */
+static int fm_write(struct ubi_device *ubi, int data_size,
+		    struct ubi_vid_hdr *vid_hdr)
+{
+	int i, err, len, size = sizeof(struct ubi_fm_sb) + data_size;
+	struct ubi_fm_sb *sb = ubi->fm_buf;
+
+	for (i = ubi->fm.used_blocks - 1; i >= 0; i--) {
+		int pnum = ubi->fm.pnum[i];
+		unsigned long long sqnum = ubi_next_sqnum(ubi);
+
+		if (i == 0) {
+			int j;
+			uint32_t crc;
+
+			sb->magic = cpu_to_be32(UBI_FM_SB_MAGIC);
+			sb->version = UBI_FM_FMT_VERSION;
+			sb->used_blocks = cpu_to_be32(ubi->fm.used_blocks);
+			sb->data_size = cpu_to_be32(data_size);
+			crc = crc32(UBI_CRC32_INIT, sb + 1, data_size);
+			sb->data_crc = cpu_to_be32(crc);
+			sb->sqnum = cpu_to_be64(sqnum);
+			for (j = 0; j < ubi->fm.used_blocks; j++)
+				sb->block_loc[j] = cpu_to_be32(ubi->fm.pnum[j]);
+			crc = crc32(UBI_CRC32_INIT, sb, UBI_FM_SB_SIZE_CRC);
+			sb->sb_crc = cpu_to_be32(crc);
+		}
+
+		vid_hdr->vol_type = UBI_FM_VOLUME_TYPE;
+		vid_hdr->compat = UBI_FM_VOLUME_COMPAT;
+		vid_hdr->sqnum = cpu_to_be64(sqnum);
+		vid_hdr->lnum = cpu_to_be32(i);
+		if (i == 0)
+			vid_hdr->vol_id = cpu_to_be32(UBI_FM_SB_VOLUME_ID);
+		else
+			vid_hdr->vol_id = cpu_to_be32(UBI_FM_DATA_VOLUME_ID);
+
+		err = ubi_io_write_vid_hdr(ubi, pnum, vid_hdr);
+		if (err)
+			goto out_release;
+		ubi->fm.erased[i] = 0;
+
+		len = min(size - i * ubi->leb_size, ubi->leb_size);
+		len = ALIGN(len, ubi->min_io_size);
+		err = ubi_io_write_data(ubi, ubi->fm_buf + i * ubi->leb_size,
+					pnum, 0, len);
+		if (err)
+			goto out_release;
+	}
+
+	return 0;
+
+out_release:
+	ubi_err("cannot write fastmap PEB %d, error %d", ubi->fm.pnum[i], err);
+	fm_release(ubi, i);
+	return err;
+}
+
+/**
+ * ubi_update_fastmap - write a new fastmap.
+ * @ubi: UBI device description object
+ *
+ * This function writes a new fastmap to the flash unless there already is a
+ * valid one. It fails with %-EBUSY if the flash is being changed. Returns
+ * zero in case of success and a negative error code in case of failure.
+ */
+int ubi_update_fastmap(struct ubi_device *ubi)
+{
+	int err, data_size;
+	struct ubi_ec_hdr *ec_hdr;
+	struct ubi_vid_hdr *vid_hdr;
+
+	if (!ubi->fm_blocks || ubi->ro_mode)
+		return 0;
+
+	/* Pending erasures would be lost if they were in progress */
+	err = ubi_wl_flush(ubi);
+	if (err)
+		goto out_retry;
+
+	err = -ENOMEM;
+	ec_hdr = kzalloc(ubi->ec_hdr_alsize, GFP_NOFS);
+	if (!ec_hdr)
+		goto out_retry;
+
+	vid_hdr = ubi_zalloc_vid_hdr(ubi, GFP_NOFS);
+	if (!vid_hdr) {
+		kfree(ec_hdr);
+		goto out_retry;
+	}
+
+	mutex_lock(&ubi->fm_mutex);
+	if (ubi->fm_valid) {
+		err = 0;
+		goto out_unlock;
+	}
+
+	ubi->fm_busy = 1;
+	smp_mb();
+	if (atomic_read(&ubi->fm_started) != atomic_read(&ubi->fm_finished)) {
+		err = -EBUSY;
+		goto out_busy;
+	}
+
+	err = fm_prepare_blocks(ubi, ec_hdr);
+	if (err)
+		goto out_busy;
+
+	data_size = fm_snapshot(ubi);
+	err = fm_write(ubi, data_size, vid_hdr);
+	if (err)
+		goto out_busy;
+
+	ubi->fm_valid = 1;
+	dbg_gen("fastmap written, anchor PEB %d, %d PEBs, %d bytes",
+		ubi->fm.pnum[0], ubi->fm.used_blocks, data_size);
+
+out_busy:
+	if (err)
+		/* Try again after the next idle period */
+		ubi->fm_last_change = jiffies;
+	smp_wmb();
+	ubi->fm_busy = 0;
+out_unlock:
+	mutex_unlock(&ubi->fm_mutex);
+	ubi_free_vid_hdr(ubi, vid_hdr);
+	kfree(ec_hdr);
+	if (err && err != -EBUSY && err != -ENOSPC)
+		ubi_warn("cannot write fastmap, error %d", err);
+	return err;
+
+out_retry:
+	ubi->fm_last_change = jiffies;
+	return err;
+}
+
+/**
+ * ubi_fastmap_reserve - reserve physical eraseblocks for the fastmap.
+ * @ubi: UBI device description object
+ *
+ * This function is called after the EBA and WL sub-systems have been
+ * initialized. If there are not enough available physical eraseblocks, the
+ * fastmap is disabled. Returns zero in case of success and a negative error
+ * code in case of failure.
+ */
+int ubi_fastmap_reserve(struct ubi_device *ubi)
+{
+	int err = 0;
+
+	if (!ubi->fm_blocks)
+		return 0;
+
+	spin_lock(&ubi->volumes_lock);
+	if (ubi->avail_pebs >= ubi->fm_blocks) {
+		ubi->avail_pebs -= ubi->fm_blocks;
+		ubi->rsvd_pebs += ubi->fm_blocks;
+		spin_unlock(&ubi->volumes_lock);
+		return 0;
+	}
+	spin_unlock(&ubi->volumes_lock);
+
+	ubi_warn("no PEBs for the fastmap, %d needed, %d available, disabled",
+		 ubi->fm_blocks, ubi->avail_pebs);
+
+	mutex_lock(&ubi->fm_mutex);
+	if (ubi->fm_valid)
+		err = fm_invalidate(ubi);
+	if (!err)
+		fm_release(ubi, -1);
+	ubi->fm_blocks = 0;
+	mutex_unlock(&ubi->fm_mutex);
+
+	return err;
+}
+
+/**
+ * fm_attach - build scanning information out of the fastmap.
+ * @ubi: UBI device description object
+ * @anchor: the fastmap anchor physical eraseblock
+ * @vid_hdr: VID header buffer to use
+ *
+ * This function returns the scanning information in case of success, %NULL
+ * if the fastmap is not valid, and an error pointer in case of failure.
+ */
+static struct ubi_scan_info *fm_attach(struct ubi_device *ubi, int anchor,
+				       struct ubi_vid_hdr *vid_hdr)
+{
+	int i, err, pnum, used_blocks, data_size, vol_count, self = 0;
+	uint32_t crc;
+	long long ec_sum = 0;
+	struct ubi_scan_info *si = NULL;
+	struct ubi_fm_sb *sb = ubi->fm_buf;
+	struct ubi_fm_hdr *hdr = (struct ubi_fm_hdr *)(sb + 1);
+	struct ubi_fm_peb *pebs = (struct ubi_fm_peb *)(hdr + 1);
+	struct ubi_fm_volume *vols, **vol_tbl;
+
+	vol_tbl = kzalloc((UBI_MAX_VOLUMES + UBI_INT_VOL_COUNT) *
+			  sizeof(struct ubi_fm_volume *), GFP_KERNEL);
+	if (!vol_tbl)
+		return ERR_PTR(-ENOMEM);
+
+	err = ubi_io_read_data(ubi, sb, anchor, 0, ubi->leb_size);
+	if (err && err != UBI_IO_BITFLIPS)
+		goto out_invalid;
+
+	crc = crc32(UBI_CRC32_INIT, sb, UBI_FM_SB_SIZE_CRC);
+	used_blocks = be32_to_cpu(sb->used_blocks);
+	data_size = be32_to_cpu(sb->data_size);
+	if (be32_to_cpu(sb->magic) != UBI_FM_SB_MAGIC ||
+	    sb->version != UBI_FM_FMT_VERSION ||
+	    be32_to_cpu(sb->sb_crc) != crc ||
+	    used_blocks != ubi->fm_blocks ||
+	    be32_to_cpu(sb->block_loc[0]) != anchor ||
+	    data_size < (int)sizeof(struct ubi_fm_hdr) ||
+	    data_size > ubi->fm_blocks * ubi->leb_size -
+			(int)sizeof(struct ubi_fm_sb))
+		goto out_invalid;
+
+	for (i = 1; i < used_blocks; i++) {
+		pnum = be32_to_cpu(sb->block_loc[i]);
+		if (pnum < 0 || pnum >= ubi->peb_count)
+			goto out_invalid;
+
+		err = ubi_io_read_vid_hdr(ubi, pnum, vid_hdr, 0);
+		if (err && err != UBI_IO_BITFLIPS)
+			goto out_err;
+		if (be32_to_cpu(vid_hdr->vol_id) != UBI_FM_DATA_VOLUME_ID ||
+		    be32_to_cpu(vid_hdr->lnum) != i)
+			goto out_invalid;
+
+		err = ubi_io_read_data(ubi, ubi->fm_buf + i * ubi->leb_size,
+				       pnum, 0, ubi->leb_size);
+		if (err && err != UBI_IO_BITFLIPS)
+			goto out_err;
+	}
+
+	crc = crc32(UBI_CRC32_INIT, sb + 1, data_size);
+	if (be32_to_cpu(sb->data_crc) != crc)
+		goto out_invalid;
+
+	vol_count = be32_to_cpu(hdr->vol_count);
+	if (be32_to_cpu(hdr->magic) != UBI_FM_HDR_MAGIC ||
+	    be32_to_cpu(hdr->peb_count) != ubi->peb_count ||
+	    vol_count < 0 || vol_count > UBI_MAX_VOLUMES + UBI_INT_VOL_COUNT ||
+	    data_size != sizeof(struct ubi_fm_hdr) +
+			 ubi->peb_count * sizeof(struct ubi_fm_peb) +
+			 vol_count * sizeof(struct ubi_fm_volume))
+		goto out_invalid;
+
+	vols = (struct ubi_fm_volume *)(pebs + ubi->peb_count);
+	for (i = 0; i < vol_count; i++) {
+		int vol_id = be32_to_cpu(vols[i].vol_id), idx = vol_id;
+
+		if (vol_id == UBI_LAYOUT_VOLUME_ID)
+			idx = UBI_MAX_VOLUMES;
+		else if (vol_id < 0 || vol_id >= UBI_MAX_VOLUMES)
+			goto out_invalid;
+		if (vol_tbl[idx])
+			goto out_invalid;
+		vol_tbl[idx] = &vols[i];
+	}
+
+	si = ubi_scan_alloc_si();
+	if (!si) {
+		err = -ENOMEM;
+		goto out_err;
+	}
+
+	for (pnum = 0; pnum < ubi->peb_count; pnum++) {
+		struct ubi_fm_volume *fmv;
+		uint32_t vol_id = be32_to_cpu(pebs[pnum].vol_id);
+		int ec = be32_to_cpu(pebs[pnum].ec) & ~UBI_FM_EC_SCRUB;
+		int scrub = !!(be32_to_cpu(pebs[pnum].ec) & UBI_FM_EC_SCRUB);
+		int lnum = be32_to_cpu(pebs[pnum].lnum), idx = vol_id;
+
+		if (vol_id == UBI_FM_PEB_SKIP)
+			continue;
+
+		if (vol_id == UBI_FM_PEB_SELF) {
+			self += 1;
+			goto account_ec;
+		}
+
+		if (vol_id == UBI_FM_PEB_FREE || vol_id == UBI_FM_PEB_ERASE) {
+			err = ubi_scan_add_to_list(si, pnum, ec,
+					vol_id == UBI_FM_PEB_FREE ?
+					&si->free : &si->erase);
+			if (err)
+				goto out_err;
+			goto account_ec;
+		}
+
+		if (vol_id == UBI_LAYOUT_VOLUME_ID)
+			idx = UBI_MAX_VOLUMES;
+		else if (vol_id >= UBI_MAX_VOLUMES)
+			goto out_invalid;
+		fmv = vol_tbl[idx];
+		if (!fmv || lnum < 0)
+			goto out_invalid;
+
+		memset(vid_hdr, 0, sizeof(struct ubi_vid_hdr));
+		vid_hdr->vol_type = fmv->vol_type;
+		vid_hdr->compat = fmv->compat;
+		vid_hdr->vol_id = fmv->vol_id;
+		vid_hdr->lnum = cpu_to_be32(lnum);
+		vid_hdr->data_pad = fmv->data_pad;
+		vid_hdr->used_ebs = fmv->used_ebs;
+		vid_hdr->data_size = fmv->last_data_size;
+
+		err = ubi_scan_add_used(ubi, si, pnum, ec, vid_hdr, scrub);
+		if (err == -ENOMEM)
+			goto out_err;
+		if (err)
+			goto out_invalid;
+
+account_ec:
+		si->is_empty = 0;
+		ec_sum += ec;
+		si->ec_count += 1;
+		if (ec > si->max_ec)
+			si->max_ec = ec;
+		if (ec < si->min_ec)
+			si->min_ec = ec;
+	}
+
+	if (self != used_blocks)
+		goto out_invalid;
+	for (i = 0; i < used_blocks; i++) {
+		pnum = be32_to_cpu(sb->block_loc[i]);
+		if (be32_to_cpu(pebs[pnum].vol_id) != UBI_FM_PEB_SELF)
+			goto out_invalid;
+
+		ubi->fm.pnum[i] = pnum;
+		ubi->fm.ec[i] = be32_to_cpu(pebs[pnum].ec);
+		ubi->fm.erased[i] = 0;
+	}
+
+	si->ec_sum = ec_sum;
+	if (si->ec_count)
+		si->mean_ec = div_u64(si->ec_sum, si->ec_count);
+	si->bad_peb_count = be32_to_cpu(hdr->bad_peb_count);
+	si->max_sqnum = be64_to_cpu(sb->sqnum);
+
+	ubi->fm.used_blocks = used_blocks;
+	ubi->fm_valid = 1;
+	kfree(vol_tbl);
+
+	ubi_msg("attached by fastmap, anchor PEB %d, %d PEBs", anchor,
+		used_blocks);
+	return si;
+
+out_invalid:
+	ubi_warn("fastmap at PEB %d is not valid, scan the flash", anchor);
+	if (si)
+		ubi_scan_destroy_si(si);
+	kfree(vol_tbl);
+	return NULL;
+
+out_err:
+	if (err > 0)
+		err = -EINVAL;
+	ubi_err("cannot read fastmap at PEB %d, error %d", anchor, err);
+	if (si)
+		ubi_scan_destroy_si(si);
+	kfree(vol_tbl);
+	if (err == -ENOMEM)
+		return ERR_PTR(err);
+	return NULL;
+}
+
+/**
+ * ubi_read_fastmap - attach by fastmap.
+ * @ubi: UBI device description object
+ *
+ * This function looks for the fastmap anchor among the first
+ * %UBI_FM_MAX_START physical eraseblocks and builds the scanning information
+ * out of the fastmap. Returns the scanning information in case of success,
+ * %NULL if the flash has to be scanned, and an error pointer in case of
+ * failure.
+ */
+struct ubi_scan_info *ubi_read_fastmap(struct ubi_device *ubi)
+{
+	int pnum, err, anchor = -1;
+	unsigned long long sqnum = 0;
+	struct ubi_vid_hdr *vid_hdr;
+	struct ubi_scan_info *si = NULL;
+
+	if (!ubi->fm_blocks)
+		return NULL;
+
+	vid_hdr = ubi_zalloc_vid_hdr(ubi, GFP_KERNEL);
+	if (!vid_hdr)
+		return ERR_PTR(-ENOMEM);
+
+	for (pnum = 0; pnum < min(UBI_FM_MAX_START, ubi->peb_count); pnum++) {
+		cond_resched();
+
+		err = ubi_io_is_bad(ubi, pnum);
+		if (err < 0) {
+			si = ERR_PTR(err);
+			goto out;
+		}
+		if (err)
+			continue;
+
+		err = ubi_io_read_vid_hdr(ubi, pnum, vid_hdr, 0);
+		if (err < 0) {
+			si = ERR_PTR(err);
+			goto out;
+		}
+		if (err && err != UBI_IO_BITFLIPS)
+			continue;
+
+		if (be32_to_cpu(vid_hdr->vol_id) != UBI_FM_SB_VOLUME_ID)
+			continue;
+
+		dbg_gen("fastmap anchor candidate PEB %d", pnum);
+		if (anchor == -1 || be64_to_cpu(vid_hdr->sqnum) > sqnum) {
+			anchor = pnum;
+			sqnum = be64_to_cpu(vid_hdr->sqnum);
+		}
+	}
+
+	if (anchor == -1) {
+		dbg_gen("no fastmap found");
+		goto out;
+	}
+
+	si = fm_attach(ubi, anchor, vid_hdr);
+
+out:
+	ubi_free_vid_hdr(ubi, vid_hdr);
+	return si;
+}
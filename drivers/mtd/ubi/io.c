@@ -92,10 +92,10 @@
 
 #ifdef CONFIG_MTD_UBI_DEBUG_PARANOID
 static int paranoid_check_not_bad(const struct ubi_device *ubi, int pnum);
-static int paranoid_check_peb_ec_hdr(const struct ubi_device *ubi, int pnum);
+static int paranoid_check_peb_ec_hdr(struct ubi_device *ubi, int pnum);
 static int paranoid_check_ec_hdr(const struct ubi_device *ubi, int pnum,
 				 const struct ubi_ec_hdr *ec_hdr);
-static int paranoid_check_peb_vid_hdr(const struct ubi_device *ubi, int pnum);
+static int paranoid_check_peb_vid_hdr(struct ubi_device *ubi, int pnum);
 static int paranoid_check_vid_hdr(const struct ubi_device *ubi, int pnum,
 				  const struct ubi_vid_hdr *vid_hdr);
 static int paranoid_check_all_ff(struct ubi_device *ubi, int pnum, int offset,
@@ -123,20 +123,26 @@ static int paranoid_check_all_ff(struct ubi_device *ubi, int pnum, int offset,
  *
  * o %0 if all the requested data were successfully read;
  * o %UBI_IO_BITFLIPS if all the requested data were successfully read, but
- *   correctable bit-flips were detected; this is harmless but may indicate
- *   that this eraseblock may become bad soon (but do not have to);
+ *   at least @ubi->scrub_bitflips correctable bit-flips were detected; this
+ *   is harmless but may indicate that this eraseblock may become bad soon
+ *   (but do not have to);
  * o %-EBADMSG if the MTD subsystem reported about data integrity problems, for
  *   example it can be an ECC error in case of NAND; this most probably means
  *   that the data is corrupted;
  * o %-EIO if some I/O error occurred;
  * o other negative error codes in case of other errors.
+ *
+ * The read and bit-flip counts of the physical eraseblock are updated. The
+ * number of corrected bit-flips is taken from the MTD ECC statistics, so it
+ * is the sum over all the ECC sub-pages of the read.
  */
-int ubi_io_read(const struct ubi_device *ubi, void *buf, int pnum, int offset,
+int ubi_io_read(struct ubi_device *ubi, void *buf, int pnum, int offset,
 		int len)
 {
 	int err, retries = 0;
 	size_t read;
 	loff_t addr;
+	uint32_t corrected;
 
 	dbg_io("read %d bytes from PEB %d:%d", len, pnum, offset);
 
@@ -149,10 +155,14 @@ int ubi_io_read(const struct ubi_device *ubi, void *buf, int pnum, int offset,
 		return err > 0 ? -EINVAL : err;
 
 	addr = (loff_t)pnum * ubi->peb_size + offset;
+	ubi->peb_rd[pnum].reads += 1;
 retry:
+	corrected = ubi->mtd->ecc_stats.corrected;
 	err = ubi->mtd->read(ubi->mtd, addr, len, &read, buf);
 	if (err) {
 		if (err == -EUCLEAN) {
+			unsigned int bitflips;
+
 			/*
 			 * -EUCLEAN is reported if there was a bit-flip which
 			 * was corrected, so this is harmless.
@@ -161,8 +171,24 @@ retry:
 			 * enabled. A corresponding message will be printed
 			 * later, when it is has been scrubbed.
 			 */
-			dbg_msg("fixable bit-flip detected at PEB %d", pnum);
+			bitflips = ubi->mtd->ecc_stats.corrected - corrected;
+			dbg_msg("%u fixable bit-flip(s) detected at PEB %d",
+				bitflips, pnum);
 			ubi_assert(len == read);
+
+			ubi->bitflip_reads += 1;
+			if (bitflips > ubi->max_bitflips)
+				ubi->max_bitflips = bitflips;
+			if (bitflips > ubi->peb_rd[pnum].bitflips)
+				ubi->peb_rd[pnum].bitflips = bitflips;
+
+			/*
+			 * A few bit-flips are normal on MLC NAND, moving the
+			 * data because of them would only wear the flash out.
+			 * If the driver does not count bit-flips, be careful.
+			 */
+			if (bitflips && bitflips < ubi->scrub_bitflips)
+				return 0;
 			return UBI_IO_BITFLIPS;
 		}
 
@@ -291,21 +317,23 @@ static void erase_callback(struct erase_info *ei)
 }
 
 /**
- * do_sync_erase - synchronously erase a physical eraseblock.
+ * do_sync_erase - synchronously erase physical eraseblocks.
  * @ubi: UBI device description object
- * @pnum: the physical eraseblock number to erase
+ * @pnum: the first physical eraseblock number to erase
+ * @count: how many consecutive physical eraseblocks to erase
  *
- * This function synchronously erases physical eraseblock @pnum and returns
- * zero in case of success and a negative error code in case of failure. If
- * %-EIO is returned, the physical eraseblock most probably went bad.
+ * This function synchronously erases @count physical eraseblocks starting
+ * from @pnum with one MTD request and returns zero in case of success and a
+ * negative error code in case of failure. If %-EIO is returned, one of the
+ * physical eraseblocks most probably went bad.
  */
-static int do_sync_erase(struct ubi_device *ubi, int pnum)
+static int do_sync_erase(struct ubi_device *ubi, int pnum, int count)
 {
-	int err, retries = 0;
+	int i, err, retries = 0;
 	struct erase_info ei;
 	wait_queue_head_t wq;
 
-	dbg_io("erase PEB %d", pnum);
+	dbg_io("erase PEB %d, count %d", pnum, count);
 
 retry:
 	init_waitqueue_head(&wq);
@@ -313,7 +341,7 @@ retry:
 
 	ei.mtd      = ubi->mtd;
 	ei.addr     = (loff_t)pnum * ubi->peb_size;
-	ei.len      = ubi->peb_size;
+	ei.len      = (uint64_t)count * ubi->peb_size;
 	ei.callback = erase_callback;
 	ei.priv     = (unsigned long)&wq;
 
@@ -348,9 +376,11 @@ retry:
 		return -EIO;
 	}
 
-	err = paranoid_check_all_ff(ubi, pnum, 0, ubi->peb_size);
-	if (err)
-		return err > 0 ? -EINVAL : err;
+	for (i = 0; i < count; i++) {
+		err = paranoid_check_all_ff(ubi, pnum + i, 0, ubi->peb_size);
+		if (err)
+			return err > 0 ? -EINVAL : err;
+	}
 
 	if (ubi_dbg_is_erase_failure() && !err) {
 		dbg_err("cannot erase PEB %d (emulated)", pnum);
@@ -401,7 +431,7 @@ static int torture_peb(struct ubi_device *ubi, int pnum)
 
 	mutex_lock(&ubi->buf_mutex);
 	for (i = 0; i < patt_count; i++) {
-		err = do_sync_erase(ubi, pnum);
+		err = do_sync_erase(ubi, pnum, 1);
 		if (err)
 			goto out;
 
@@ -493,13 +523,56 @@ int ubi_io_sync_erase(struct ubi_device *ubi, int pnum, int torture)
 			return ret;
 	}
 
-	err = do_sync_erase(ubi, pnum);
+	err = do_sync_erase(ubi, pnum, 1);
 	if (err)
 		return err;
 
+	/* Fresh data, fresh statistics */
+	memset(&ubi->peb_rd[pnum], 0, sizeof(struct ubi_peb_rd));
 	return ret + 1;
 }
 
+/**
+ * ubi_io_sync_erase_pair - synchronously erase two adjacent eraseblocks.
+ * @ubi: UBI device description object
+ * @pnum: the first physical eraseblock number to erase
+ *
+ * This function erases physical eraseblocks @pnum and @pnum + 1 with a single
+ * MTD erase request, which lets NAND chips with two planes erase both of them
+ * with one command. Torturing is not supported here, use
+ * 'ubi_io_sync_erase()' for that. If the pair erasure fails, the caller does
+ * not know which of the eraseblocks is at fault and has to erase them one by
+ * one to find out.
+ *
+ * This function returns the number of erasures made on each eraseblock in
+ * case of success and a negative error code in case of failure.
+ */
+int ubi_io_sync_erase_pair(struct ubi_device *ubi, int pnum)
+{
+	int err;
+
+	ubi_assert(pnum >= 0 && pnum + 1 < ubi->peb_count);
+
+	err = paranoid_check_not_bad(ubi, pnum);
+	if (err != 0)
+		return err > 0 ? -EINVAL : err;
+	err = paranoid_check_not_bad(ubi, pnum + 1);
+	if (err != 0)
+		return err > 0 ? -EINVAL : err;
+
+	if (ubi->ro_mode) {
+		ubi_err("read-only mode");
+		return -EROFS;
+	}
+
+	err = do_sync_erase(ubi, pnum, 2);
+	if (err)
+		return err;
+
+	memset(&ubi->peb_rd[pnum], 0, 2 * sizeof(struct ubi_peb_rd));
+	return 1;
+}
+
 /**
  * ubi_io_is_bad - check if a physical eraseblock is bad.
  * @ubi: UBI device description object
@@ -1118,7 +1191,7 @@ fail:
  * This function returns zero if the erase counter header is all right, %1 if
  * not, and a negative error code if an error occurred.
  */
-static int paranoid_check_peb_ec_hdr(const struct ubi_device *ubi, int pnum)
+static int paranoid_check_peb_ec_hdr(struct ubi_device *ubi, int pnum)
 {
 	int err;
 	uint32_t crc, hdr_crc;
@@ -1196,7 +1269,7 @@ fail:
  * This function returns zero if the volume identifier header is all right,
  * %1 if not, and a negative error code if an error occurred.
  */
-static int paranoid_check_peb_vid_hdr(const struct ubi_device *ubi, int pnum)
+static int paranoid_check_peb_vid_hdr(struct ubi_device *ubi, int pnum)
 {
 	int err;
 	uint32_t crc, hdr_crc;
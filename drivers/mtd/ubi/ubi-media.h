@@ -302,6 +302,18 @@ struct ubi_vid_hdr {
 #define UBI_LAYOUT_VOLUME_NAME   "layout volume"
 #define UBI_LAYOUT_VOLUME_COMPAT UBI_COMPAT_REJECT
 
+/*
+ * The fastmap volumes contain a snapshot of the erase counters and the EBA
+ * tables (see fastmap.c). The super block volume holds the fastmap anchor and
+ * the data volume holds the rest of the fastmap. They are not real volumes -
+ * they are never seen in the volume table, and UBI binaries which do not know
+ * about the fastmap simply erase them.
+ */
+#define UBI_FM_SB_VOLUME_ID      (UBI_INTERNAL_VOL_START + 1)
+#define UBI_FM_DATA_VOLUME_ID    (UBI_INTERNAL_VOL_START + 2)
+#define UBI_FM_VOLUME_TYPE       UBI_VID_DYNAMIC
+#define UBI_FM_VOLUME_COMPAT     UBI_COMPAT_DELETE
+
 /* The maximum number of volumes per one UBI device */
 #define UBI_MAX_VOLUMES 128
 
@@ -365,4 +377,132 @@ struct ubi_vtbl_record {
 	__be32  crc;
 } __attribute__ ((packed));
 
+/* Fastmap super block magic number (ASCII "UBIF") */
+#define UBI_FM_SB_MAGIC  0x55424946
+/* Fastmap header magic number (ASCII "UBIM") */
+#define UBI_FM_HDR_MAGIC 0x5542494D
+
+/* The version of the fastmap format */
+#define UBI_FM_FMT_VERSION 1
+
+/* The fastmap anchor is always one of the first %UBI_FM_MAX_START PEBs */
+#define UBI_FM_MAX_START  64
+/* The maximum number of physical eraseblocks the fastmap may take */
+#define UBI_FM_MAX_BLOCKS 32
+
+/*
+ * Markers stored in the @vol_id field of the fastmap PEB records instead of a
+ * volume ID.
+ *
+ * @UBI_FM_PEB_FREE: the PEB is free
+ * @UBI_FM_PEB_ERASE: the PEB has to be erased
+ * @UBI_FM_PEB_SKIP: the PEB is bad or does not belong to UBI
+ * @UBI_FM_PEB_SELF: the PEB belongs to the fastmap itself
+ */
+#define UBI_FM_PEB_FREE  0xFFFFFFFF
+#define UBI_FM_PEB_ERASE 0xFFFFFFFE
+#define UBI_FM_PEB_SKIP  0xFFFFFFFD
+#define UBI_FM_PEB_SELF  0xFFFFFFFC
+
+/* This bit of the fastmap PEB record @ec field means the PEB needs scrubbing */
+#define UBI_FM_EC_SCRUB 0x80000000
+
+/* Size of the fastmap super block without the ending CRC */
+#define UBI_FM_SB_SIZE_CRC (sizeof(struct ubi_fm_sb) - sizeof(__be32))
+
+/**
+ * struct ubi_fm_sb - fastmap super block.
+ * @magic: fastmap super block magic number (%UBI_FM_SB_MAGIC)
+ * @version: version of the fastmap format (%UBI_FM_FMT_VERSION)
+ * @padding1: reserved for future, zeroes
+ * @used_blocks: how many physical eraseblocks the fastmap takes
+ * @data_size: how many bytes of fastmap data follow the super block
+ * @data_crc: CRC checksum of the fastmap data
+ * @padding2: reserved for future, zeroes
+ * @sqnum: the highest sequence number on the flash when the fastmap was
+ *         written
+ * @block_loc: the physical eraseblocks the fastmap is stored in, the anchor
+ *             first
+ * @padding3: reserved for future, zeroes
+ * @sb_crc: super block CRC checksum
+ *
+ * The super block is stored at the beginning of the fastmap anchor, i.e., of
+ * the logical eraseblock 0 of the %UBI_FM_SB_VOLUME_ID volume. It is followed
+ * by the fastmap data, which continue in the logical eraseblocks of the
+ * %UBI_FM_DATA_VOLUME_ID volume stored in @block_loc[1], @block_loc[2], and
+ * so on. The fastmap data consist of &struct ubi_fm_hdr, one
+ * &struct ubi_fm_peb record for each physical eraseblock of the device, and
+ * one &struct ubi_fm_volume record for each volume which has mapped logical
+ * eraseblocks.
+ */
+struct ubi_fm_sb {
+	__be32  magic;
+	__u8    version;
+	__u8    padding1[3];
+	__be32  used_blocks;
+	__be32  data_size;
+	__be32  data_crc;
+	__u8    padding2[4];
+	__be64  sqnum;
+	__be32  block_loc[UBI_FM_MAX_BLOCKS];
+	__u8    padding3[28];
+	__be32  sb_crc;
+} __attribute__ ((packed));
+
+/**
+ * struct ubi_fm_hdr - fastmap header.
+ * @magic: fastmap header magic number (%UBI_FM_HDR_MAGIC)
+ * @peb_count: count of physical eraseblocks of the device
+ * @bad_peb_count: count of bad physical eraseblocks
+ * @vol_count: count of &struct ubi_fm_volume records
+ * @padding: reserved for future, zeroes
+ */
+struct ubi_fm_hdr {
+	__be32  magic;
+	__be32  peb_count;
+	__be32  bad_peb_count;
+	__be32  vol_count;
+	__u8    padding[16];
+} __attribute__ ((packed));
+
+/**
+ * struct ubi_fm_peb - fastmap record of a physical eraseblock.
+ * @ec: erase counter, possibly with the %UBI_FM_EC_SCRUB bit set
+ * @vol_id: ID of the volume the physical eraseblock belongs to, or one of the
+ *          %UBI_FM_PEB_FREE, %UBI_FM_PEB_ERASE, %UBI_FM_PEB_SKIP or
+ *          %UBI_FM_PEB_SELF markers
+ * @lnum: logical eraseblock number the physical eraseblock is mapped to
+ */
+struct ubi_fm_peb {
+	__be32  ec;
+	__be32  vol_id;
+	__be32  lnum;
+} __attribute__ ((packed));
+
+/**
+ * struct ubi_fm_volume - fastmap record of a volume.
+ * @vol_id: volume ID
+ * @vol_type: volume type (%UBI_VID_DYNAMIC or %UBI_VID_STATIC)
+ * @compat: compatibility flags of the volume
+ * @padding1: reserved for future, zeroes
+ * @used_ebs: how many logical eraseblocks the data of a static volume takes
+ * @data_pad: how many bytes at the end of logical eraseblocks are not used
+ * @last_data_size: how many bytes are stored in the last logical eraseblock
+ *                  of a static volume
+ * @padding2: reserved for future, zeroes
+ *
+ * These are the fields the VID headers of the volume would provide if the
+ * flash was scanned.
+ */
+struct ubi_fm_volume {
+	__be32  vol_id;
+	__u8    vol_type;
+	__u8    compat;
+	__u8    padding1[2];
+	__be32  used_ebs;
+	__be32  data_pad;
+	__be32  last_data_size;
+	__u8    padding2[12];
+} __attribute__ ((packed));
+
 #endif /* !__UBI_MEDIA_H__ */
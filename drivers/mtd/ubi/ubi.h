@@ -163,6 +163,40 @@ struct ubi_rename_entry {
 	struct list_head list;
 };
 
+/**
+ * struct ubi_fm_layout - the physical eraseblocks of the fastmap.
+ * @used_blocks: how many physical eraseblocks the fastmap owns
+ * @pnum: the physical eraseblock numbers, the anchor first
+ * @ec: their erase counters
+ * @erased: non-zero if the physical eraseblock contains only the EC header
+ *
+ * The fastmap physical eraseblocks are not known to the WL sub-system. They
+ * are re-used for every new fastmap.
+ */
+struct ubi_fm_layout {
+	int used_blocks;
+	int pnum[UBI_FM_MAX_BLOCKS];
+	int ec[UBI_FM_MAX_BLOCKS];
+	int erased[UBI_FM_MAX_BLOCKS];
+};
+
+/**
+ * struct ubi_peb_rd - read statistics of a physical eraseblock.
+ * @reads: how many times the physical eraseblock was read since it was erased
+ * @checked: value of @reads when the patrol last checked the physical
+ *           eraseblock
+ * @bitflips: the most bit-flips corrected in one read since the physical
+ *            eraseblock was erased
+ *
+ * The statistics are not protected by any lock because they are only used to
+ * steer the patrol and to inform the user.
+ */
+struct ubi_peb_rd {
+	unsigned int reads;
+	unsigned int checked;
+	unsigned int bitflips;
+};
+
 struct ubi_volume_desc;
 
 /**
@@ -319,13 +353,14 @@ struct ubi_wl_entry;
  *
  * @used: RB-tree of used physical eraseblocks
  * @free: RB-tree of free physical eraseblocks
+ * @free_count: how many physical eraseblocks are in @free
  * @scrub: RB-tree of physical eraseblocks which need scrubbing
  * @pq: protection queue (contain physical eraseblocks which are temporarily
  *      protected from the wear-leveling worker)
  * @pq_head: protection queue head
- * @wl_lock: protects the @used, @free, @pq, @pq_head, @lookuptbl, @move_from,
- * 	     @move_to, @move_to_put @erase_pending, @wl_scheduled and @works
- * 	     fields
+ * @wl_lock: protects the @used, @free, @free_count, @pq, @pq_head,
+ * 	     @lookuptbl, @move_from, @move_to, @move_to_put @erase_pending,
+ * 	     @wl_scheduled and @works fields
  * @move_mutex: serializes eraseblock moves
  * @work_sem: synchronizes the WL worker with use tasks
  * @wl_scheduled: non-zero if the wear-leveling was scheduled
@@ -340,6 +375,18 @@ struct ubi_wl_entry;
  * @thread_enabled: if the background thread is enabled
  * @bgt_name: background thread name
  *
+ * @fm: the physical eraseblocks of the fastmap
+ * @fm_blocks: how many physical eraseblocks the fastmap needs (zero if the
+ *             fastmap is disabled)
+ * @fm_buf: buffer of @fm_blocks logical eraseblocks the fastmap is built in
+ * @fm_valid: if the fastmap on the flash describes the flash
+ * @fm_busy: if the fastmap is being written
+ * @fm_started: how many flash changes were started
+ * @fm_finished: how many flash changes were finished
+ * @fm_last_change: time of the last flash change (in jiffies)
+ * @fm_mutex: serializes fastmap writing and invalidation, protects @fm,
+ *            @fm_buf and @fm_valid
+ *
  * @flash_size: underlying MTD device size (in bytes)
  * @peb_count: count of physical eraseblocks on the MTD device
  * @peb_size: physical eraseblock size
@@ -362,6 +409,18 @@ struct ubi_wl_entry;
  *               not
  * @mtd: MTD device descriptor
  *
+ * @peb_rd: read statistics of the physical eraseblocks
+ * @scrub_bitflips: how many bit-flips corrected in one read make UBI scrub
+ * @bitflip_reads: how many reads needed bit-flips to be corrected
+ * @max_bitflips: the most bit-flips corrected in one read
+ * @patrol_buf: buffer of @min_io_size bytes the patrol reads to (%NULL if the
+ *              patrol is disabled)
+ * @patrol_pnum: where the patrol continues its round
+ * @patrol_next: when the patrol checks the next physical eraseblock (jiffies)
+ * @patrol_checks: how many physical eraseblocks the patrol checked
+ * @patrol_scrubs: how many physical eraseblocks the patrol scheduled for
+ *                 scrubbing
+ *
  * @peb_buf1: a buffer of PEB size used for different purposes
  * @peb_buf2: another buffer of PEB size used for different purposes
  * @buf_mutex: protects @peb_buf1 and @peb_buf2
@@ -404,6 +463,7 @@ struct ubi_device {
 	/* Wear-leveling sub-system's stuff */
 	struct rb_root used;
 	struct rb_root free;
+	int free_count;
 	struct rb_root scrub;
 	struct list_head pq[UBI_PROT_QUEUE_LEN];
 	int pq_head;
@@ -421,6 +481,19 @@ struct ubi_device {
 	int thread_enabled;
 	char bgt_name[sizeof(UBI_BGT_NAME_PATTERN)+2];
 
+#ifdef CONFIG_MTD_UBI_FASTMAP
+	/* Fastmap stuff */
+	struct ubi_fm_layout fm;
+	int fm_blocks;
+	void *fm_buf;
+	int fm_valid;
+	int fm_busy;
+	atomic_t fm_started;
+	atomic_t fm_finished;
+	unsigned long fm_last_change;
+	struct mutex fm_mutex;
+#endif
+
 	/* I/O sub-system's stuff */
 	long long flash_size;
 	int peb_count;
@@ -440,6 +513,17 @@ struct ubi_device {
 	int bad_allowed;
 	struct mtd_info *mtd;
 
+	/* Read statistics and the patrol */
+	struct ubi_peb_rd *peb_rd;
+	unsigned int scrub_bitflips;
+	unsigned int bitflip_reads;
+	unsigned int max_bitflips;
+	void *patrol_buf;
+	int patrol_pnum;
+	unsigned long patrol_next;
+	unsigned int patrol_checks;
+	unsigned int patrol_scrubs;
+
 	void *peb_buf1;
 	void *peb_buf2;
 	struct mutex buf_mutex;
@@ -500,7 +584,29 @@ void ubi_gluebi_updated(struct ubi_volume *vol);
 #define ubi_gluebi_updated(vol)
 #endif
 
+/* fastmap.c */
+#ifdef CONFIG_MTD_UBI_FASTMAP
+int ubi_fastmap_init(struct ubi_device *ubi);
+void ubi_fastmap_close(struct ubi_device *ubi);
+struct ubi_scan_info *ubi_read_fastmap(struct ubi_device *ubi);
+int ubi_fastmap_reserve(struct ubi_device *ubi);
+int ubi_update_fastmap(struct ubi_device *ubi);
+long ubi_fastmap_timeout(struct ubi_device *ubi);
+int ubi_fastmap_begin(struct ubi_device *ubi);
+void ubi_fastmap_end(struct ubi_device *ubi);
+#else
+#define ubi_fastmap_init(ubi) 0
+#define ubi_fastmap_close(ubi)
+#define ubi_read_fastmap(ubi) NULL
+#define ubi_fastmap_reserve(ubi) 0
+#define ubi_update_fastmap(ubi) 0
+#define ubi_fastmap_timeout(ubi) MAX_SCHEDULE_TIMEOUT
+#define ubi_fastmap_begin(ubi) 0
+#define ubi_fastmap_end(ubi)
+#endif
+
 /* eba.c */
+unsigned long long ubi_next_sqnum(struct ubi_device *ubi);
 int ubi_eba_unmap_leb(struct ubi_device *ubi, struct ubi_volume *vol,
 		      int lnum);
 int ubi_eba_read_leb(struct ubi_device *ubi, struct ubi_volume *vol, int lnum,
@@ -524,13 +630,19 @@ int ubi_wl_scrub_peb(struct ubi_device *ubi, int pnum);
 int ubi_wl_init_scan(struct ubi_device *ubi, struct ubi_scan_info *si);
 void ubi_wl_close(struct ubi_device *ubi);
 int ubi_thread(void *u);
+#ifdef CONFIG_MTD_UBI_FASTMAP
+int ubi_wl_get_fm_peb(struct ubi_device *ubi, int anchor, int max_ec, int *ec);
+int ubi_wl_put_fm_peb(struct ubi_device *ubi, int pnum, int ec, int torture);
+void ubi_wl_fm_snapshot(struct ubi_device *ubi, struct ubi_fm_peb *pebs);
+#endif
 
 /* io.c */
-int ubi_io_read(const struct ubi_device *ubi, void *buf, int pnum, int offset,
+int ubi_io_read(struct ubi_device *ubi, void *buf, int pnum, int offset,
 		int len);
 int ubi_io_write(struct ubi_device *ubi, const void *buf, int pnum, int offset,
 		 int len);
 int ubi_io_sync_erase(struct ubi_device *ubi, int pnum, int torture);
+int ubi_io_sync_erase_pair(struct ubi_device *ubi, int pnum);
 int ubi_io_is_bad(const struct ubi_device *ubi, int pnum);
 int ubi_io_mark_bad(const struct ubi_device *ubi, int pnum);
 int ubi_io_read_ec_hdr(struct ubi_device *ubi, int pnum,
@@ -609,7 +721,7 @@ static inline void ubi_free_vid_hdr(const struct ubi_device *ubi,
  * the beginning of the logical eraseblock, not to the beginning of the
  * physical eraseblock.
  */
-static inline int ubi_io_read_data(const struct ubi_device *ubi, void *buf,
+static inline int ubi_io_read_data(struct ubi_device *ubi, void *buf,
 				   int pnum, int offset, int len)
 {
 	ubi_assert(offset >= 0);
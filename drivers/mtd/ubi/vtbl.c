@@ -311,9 +311,16 @@ static int create_vtbl(struct ubi_device *ubi, struct ubi_scan_info *si,
 
 	ubi_msg("create volume table (copy #%d)", copy + 1);
 
+	/* The volume table is written bypassing EBA, tell the fastmap */
+	err = ubi_fastmap_begin(ubi);
+	if (err)
+		return err;
+
 	vid_hdr = ubi_zalloc_vid_hdr(ubi, GFP_KERNEL);
-	if (!vid_hdr)
+	if (!vid_hdr) {
+		ubi_fastmap_end(ubi);
 		return -ENOMEM;
+	}
 
 	/*
 	 * Check if there is a logical eraseblock which would have to contain
@@ -357,6 +364,7 @@ retry:
 				vid_hdr, 0);
 	kfree(new_seb);
 	ubi_free_vid_hdr(ubi, vid_hdr);
+	ubi_fastmap_end(ubi);
 	return err;
 
 write_error:
@@ -371,6 +379,7 @@ write_error:
 	kfree(new_seb);
 out_free:
 	ubi_free_vid_hdr(ubi, vid_hdr);
+	ubi_fastmap_end(ubi);
 	return err;
 
 }
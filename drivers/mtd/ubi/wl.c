@@ -53,6 +53,13 @@
  * in a physical eraseblock, it has to be moved. Technically this is the same
  * as moving it for wear-leveling reasons.
  *
+ * Bit-flips are only detected when the data are read, and data which is never
+ * read may rot unnoticed, while data which is read very often disturbs the
+ * other pages of its eraseblock. So when the background thread is idle it
+ * patrols: it reads used physical eraseblocks one by one and scrubs those
+ * with too many bit-flips. Physical eraseblocks which were read many times
+ * since their last check go first, the others are checked in turn.
+ *
  * As it was said, for the UBI sub-system all physical eraseblocks are either
  * "free" or "used". Free eraseblock are kept in the @wl->free RB-tree, while
  * used eraseblocks are kept in @wl->used or @wl->scrub RB-trees, or
@@ -139,6 +146,29 @@
  */
 #define WL_MAX_FAILURES 32
 
+/* Time between two physical eraseblock checks of the patrol */
+#define PATROL_INTERVAL msecs_to_jiffies(CONFIG_MTD_UBI_PATROL_INTERVAL)
+
+/*
+ * If a physical eraseblock was read more than this many times since the
+ * patrol last checked it, it is checked before the others (read disturb).
+ */
+#define PATROL_DISTURB_READS 10000
+
+/*
+ * When there are fewer free physical eraseblocks than this, pending erasures
+ * are done before any other work, so that writers do not wait for the
+ * wear-leveling worker to finish copying data around.
+ */
+#define WL_FREE_LOW 4
+
+/*
+ * How many pending works to look through when searching for an erasure of the
+ * neighbouring physical eraseblock which may be done together with the
+ * current one (see 'erase_pair()').
+ */
+#define WL_PAIR_SCAN 64
+
 /**
  * struct ubi_work - UBI work description data structure.
  * @list: a link in the list of pending works
@@ -170,6 +200,11 @@ static int paranoid_check_in_pq(struct ubi_device *ubi, struct ubi_wl_entry *e);
 #define paranoid_check_in_pq(ubi, e) 0
 #endif
 
+static int erase_worker(struct ubi_device *ubi, struct ubi_work *wl_wrk,
+			int cancel);
+static int erase_pair(struct ubi_device *ubi, struct ubi_work *wrk1,
+		      struct ubi_work *wrk2);
+
 /**
  * wl_tree_add - add a wear-leveling entry to a WL RB-tree.
  * @e: the wear-leveling entry to add
@@ -206,6 +241,65 @@ static void wl_tree_add(struct ubi_wl_entry *e, struct rb_root *root)
 	rb_insert_color(&e->u.rb, root);
 }
 
+/**
+ * pick_work - pick the next pending work to do.
+ * @ubi: UBI device description object
+ *
+ * Works are normally done in the order they were scheduled. But if the free
+ * physical eraseblocks are running out, the first pending erasure is picked
+ * instead, because that is what gives writers a free eraseblock soonest. Must
+ * be called with @ubi->wl_lock locked and a non-empty works list.
+ */
+static struct ubi_work *pick_work(struct ubi_device *ubi)
+{
+	struct ubi_work *wrk;
+
+	if (ubi->free_count < WL_FREE_LOW)
+		list_for_each_entry(wrk, &ubi->works, list)
+			if (wrk->func == &erase_worker)
+				return wrk;
+
+	return list_entry(ubi->works.next, struct ubi_work, list);
+}
+
+/**
+ * erase_buddy - find a pending erasure to do together with another one.
+ * @ubi: UBI device description object
+ * @wrk: the erasure work which is about to be done
+ *
+ * Physical eraseblocks 2*N and 2*N+1 usually sit in different planes of the
+ * same NAND chip, and the chip can erase both with one two-plane command. This
+ * function looks for a pending erasure of the other eraseblock of the pair,
+ * removes it from the works list and returns it. Returns %NULL if there is no
+ * such work or if @wrk is not a plain erasure. Must be called with
+ * @ubi->wl_lock locked.
+ */
+static struct ubi_work *erase_buddy(struct ubi_device *ubi,
+				    struct ubi_work *wrk)
+{
+	struct ubi_work *buddy;
+	int pnum, scanned = 0;
+
+	if (wrk->func != &erase_worker || wrk->torture)
+		return NULL;
+
+	pnum = wrk->e->pnum ^ 1;
+	list_for_each_entry(buddy, &ubi->works, list) {
+		if (scanned++ == WL_PAIR_SCAN)
+			break;
+		if (buddy->func != &erase_worker || buddy->torture ||
+		    buddy->e->pnum != pnum)
+			continue;
+
+		list_del(&buddy->list);
+		ubi->works_count -= 1;
+		ubi_assert(ubi->works_count >= 0);
+		return buddy;
+	}
+
+	return NULL;
+}
+
 /**
  * do_work - do one pending work.
  * @ubi: UBI device description object
@@ -216,7 +310,7 @@ static void wl_tree_add(struct ubi_wl_entry *e, struct rb_root *root)
 static int do_work(struct ubi_device *ubi)
 {
 	int err;
-	struct ubi_work *wrk;
+	struct ubi_work *wrk, *buddy;
 
 	cond_resched();
 
@@ -234,20 +328,40 @@ static int do_work(struct ubi_device *ubi)
 		return 0;
 	}
 
-	wrk = list_entry(ubi->works.next, struct ubi_work, list);
+	wrk = pick_work(ubi);
 	list_del(&wrk->list);
 	ubi->works_count -= 1;
 	ubi_assert(ubi->works_count >= 0);
+	buddy = erase_buddy(ubi, wrk);
 	spin_unlock(&ubi->wl_lock);
 
+	/* Both erasure and moving change the flash */
+	err = ubi_fastmap_begin(ubi);
+	if (err) {
+		spin_lock(&ubi->wl_lock);
+		if (buddy) {
+			list_add(&buddy->list, &ubi->works);
+			ubi->works_count += 1;
+		}
+		list_add(&wrk->list, &ubi->works);
+		ubi->works_count += 1;
+		spin_unlock(&ubi->wl_lock);
+		up_read(&ubi->work_sem);
+		return err;
+	}
+
 	/*
 	 * Call the worker function. Do not touch the work structure
 	 * after this call as it will have been freed or reused by that
 	 * time by the worker function.
 	 */
-	err = wrk->func(ubi, wrk, 0);
+	if (buddy)
+		err = erase_pair(ubi, wrk, buddy);
+	else
+		err = wrk->func(ubi, wrk, 0);
 	if (err)
 		ubi_err("work failed with error code %d", err);
+	ubi_fastmap_end(ubi);
 	up_read(&ubi->work_sem);
 
 	return err;
@@ -282,6 +396,27 @@ static int produce_free_peb(struct ubi_device *ubi)
 	return 0;
 }
 
+/**
+ * in_pq - check if a wear-leveling entry is in the protection queue.
+ * @ubi: UBI device description object
+ * @e: the wear-leveling entry to check
+ *
+ * This function returns non-zero if @e is in the protection queue and zero if
+ * it is not. The caller has to hold @ubi->wl_lock.
+ */
+static int in_pq(struct ubi_device *ubi, struct ubi_wl_entry *e)
+{
+	struct ubi_wl_entry *p;
+	int i;
+
+	for (i = 0; i < UBI_PROT_QUEUE_LEN; ++i)
+		list_for_each_entry(p, &ubi->pq[i], u.list)
+			if (p == e)
+				return 1;
+
+	return 0;
+}
+
 /**
  * in_wl_tree - check if wear-leveling entry is present in a WL RB-tree.
  * @e: the wear-leveling entry to check
@@ -454,6 +589,7 @@ retry:
 	 * be protected from being moved for some time.
 	 */
 	rb_erase(&e->u.rb, &ubi->free);
+	ubi->free_count -= 1;
 	dbg_wl("PEB %d EC %d", e->pnum, e->ec);
 	prot_queue_add(ubi, e);
 	spin_unlock(&ubi->wl_lock);
@@ -485,36 +621,22 @@ static int prot_queue_del(struct ubi_device *ubi, int pnum)
 }
 
 /**
- * sync_erase - synchronously erase a physical eraseblock.
+ * write_new_ec - write the erase counter header of a freshly erased PEB.
  * @ubi: UBI device description object
- * @e: the the physical eraseblock to erase
- * @torture: if the physical eraseblock has to be tortured
+ * @e: the physical eraseblock which was erased
+ * @erasures: how many times it was erased
  *
  * This function returns zero in case of success and a negative error code in
  * case of failure.
  */
-static int sync_erase(struct ubi_device *ubi, struct ubi_wl_entry *e,
-		      int torture)
+static int write_new_ec(struct ubi_device *ubi, struct ubi_wl_entry *e,
+			int erasures)
 {
 	int err;
 	struct ubi_ec_hdr *ec_hdr;
 	unsigned long long ec = e->ec;
 
-	dbg_wl("erase PEB %d, old EC %llu", e->pnum, ec);
-
-	err = paranoid_check_ec(ubi, e->pnum, e->ec);
-	if (err > 0)
-		return -EINVAL;
-
-	ec_hdr = kzalloc(ubi->ec_hdr_alsize, GFP_NOFS);
-	if (!ec_hdr)
-		return -ENOMEM;
-
-	err = ubi_io_sync_erase(ubi, e->pnum, torture);
-	if (err < 0)
-		goto out_free;
-
-	ec += err;
+	ec += erasures;
 	if (ec > UBI_MAX_ERASECOUNTER) {
 		/*
 		 * Erase counter overflow. Upgrade UBI and use 64-bit
@@ -522,12 +644,15 @@ static int sync_erase(struct ubi_device *ubi, struct ubi_wl_entry *e,
 		 */
 		ubi_err("erase counter overflow at PEB %d, EC %llu",
 			e->pnum, ec);
-		err = -EINVAL;
-		goto out_free;
+		return -EINVAL;
 	}
 
 	dbg_wl("erased PEB %d, new EC %llu", e->pnum, ec);
 
+	ec_hdr = kzalloc(ubi->ec_hdr_alsize, GFP_NOFS);
+	if (!ec_hdr)
+		return -ENOMEM;
+
 	ec_hdr->ec = cpu_to_be64(ec);
 
 	err = ubi_io_write_ec_hdr(ubi, e->pnum, ec_hdr);
@@ -545,6 +670,33 @@ out_free:
 	return err;
 }
 
+/**
+ * sync_erase - synchronously erase a physical eraseblock.
+ * @ubi: UBI device description object
+ * @e: the the physical eraseblock to erase
+ * @torture: if the physical eraseblock has to be tortured
+ *
+ * This function returns zero in case of success and a negative error code in
+ * case of failure.
+ */
+static int sync_erase(struct ubi_device *ubi, struct ubi_wl_entry *e,
+		      int torture)
+{
+	int err;
+
+	dbg_wl("erase PEB %d, old EC %d", e->pnum, e->ec);
+
+	err = paranoid_check_ec(ubi, e->pnum, e->ec);
+	if (err > 0)
+		return -EINVAL;
+
+	err = ubi_io_sync_erase(ubi, e->pnum, torture);
+	if (err < 0)
+		return err;
+
+	return write_new_ec(ubi, e, err);
+}
+
 /**
  * serve_prot_queue - check if it is time to stop protecting PEBs.
  * @ubi: UBI device description object
@@ -589,6 +741,25 @@ repeat:
 	spin_unlock(&ubi->wl_lock);
 }
 
+/**
+ * add_erased - add a freshly erased physical eraseblock to the free tree.
+ * @ubi: UBI device description object
+ * @e: the physical eraseblock which was erased
+ */
+static void add_erased(struct ubi_device *ubi, struct ubi_wl_entry *e)
+{
+	spin_lock(&ubi->wl_lock);
+	wl_tree_add(e, &ubi->free);
+	ubi->free_count += 1;
+	spin_unlock(&ubi->wl_lock);
+
+	/*
+	 * One more erase operation has happened, take care about protected
+	 * physical eraseblocks.
+	 */
+	serve_prot_queue(ubi);
+}
+
 /**
  * schedule_ubi_work - schedule a work.
  * @ubi: UBI device description object
@@ -608,9 +779,6 @@ static void schedule_ubi_work(struct ubi_device *ubi, struct ubi_work *wrk)
 	spin_unlock(&ubi->wl_lock);
 }
 
-static int erase_worker(struct ubi_device *ubi, struct ubi_work *wl_wrk,
-			int cancel);
-
 /**
  * schedule_erase - schedule an erase work.
  * @ubi: UBI device description object
@@ -717,6 +885,7 @@ static int wear_leveling_worker(struct ubi_device *ubi, struct ubi_work *wrk,
 
 	paranoid_check_in_wl_tree(e2, &ubi->free);
 	rb_erase(&e2->u.rb, &ubi->free);
+	ubi->free_count -= 1;
 	ubi->move_from = e1;
 	ubi->move_to = e2;
 	spin_unlock(&ubi->wl_lock);
@@ -980,16 +1149,7 @@ static int erase_worker(struct ubi_device *ubi, struct ubi_work *wl_wrk,
 	if (!err) {
 		/* Fine, we've erased it successfully */
 		kfree(wl_wrk);
-
-		spin_lock(&ubi->wl_lock);
-		wl_tree_add(e, &ubi->free);
-		spin_unlock(&ubi->wl_lock);
-
-		/*
-		 * One more erase operation has happened, take care about
-		 * protected physical eraseblocks.
-		 */
-		serve_prot_queue(ubi);
+		add_erased(ubi, e);
 
 		/* And take care about wear-leveling */
 		err = ensure_wear_leveling(ubi);
@@ -998,7 +1158,6 @@ static int erase_worker(struct ubi_device *ubi, struct ubi_work *wl_wrk,
 
 	ubi_err("failed to erase PEB %d, error %d", pnum, err);
 	kfree(wl_wrk);
-	kmem_cache_free(ubi_wl_entry_slab, e);
 
 	if (err == -EINTR || err == -ENOMEM || err == -EAGAIN ||
 	    err == -EBUSY) {
@@ -1011,7 +1170,15 @@ static int erase_worker(struct ubi_device *ubi, struct ubi_work *wl_wrk,
 			goto out_ro;
 		}
 		return err;
-	} else if (err != -EIO) {
+	}
+
+	/* The PEB is not going to be used any more */
+	spin_lock(&ubi->wl_lock);
+	ubi->lookuptbl[pnum] = NULL;
+	spin_unlock(&ubi->wl_lock);
+	kmem_cache_free(ubi_wl_entry_slab, e);
+
+	if (err != -EIO) {
 		/*
 		 * If this is not %-EIO, we have no idea what to do. Scheduling
 		 * this physical eraseblock for erasure again would cause
@@ -1067,6 +1234,66 @@ out_ro:
 	return err;
 }
 
+/**
+ * erase_pair - erase two neighbouring physical eraseblocks together.
+ * @ubi: UBI device description object
+ * @wrk1: erasure work of one physical eraseblock of the pair
+ * @wrk2: erasure work of the other physical eraseblock of the pair
+ *
+ * This function erases physical eraseblocks 2*N and 2*N+1 with a single MTD
+ * request (see 'erase_buddy()'). If that fails, or the erase counter header of
+ * one of them cannot be written, that eraseblock goes through the normal
+ * 'erase_worker()' path which retries it alone and takes care of bad
+ * eraseblocks. Returns zero in case of success and a negative error code in
+ * case of failure.
+ */
+static int erase_pair(struct ubi_device *ubi, struct ubi_work *wrk1,
+		      struct ubi_work *wrk2)
+{
+	struct ubi_work *wrk[2];
+	int i, err, erased;
+
+	if (wrk1->e->pnum < wrk2->e->pnum) {
+		wrk[0] = wrk1;
+		wrk[1] = wrk2;
+	} else {
+		wrk[0] = wrk2;
+		wrk[1] = wrk1;
+	}
+	ubi_assert(wrk[0]->e->pnum + 1 == wrk[1]->e->pnum);
+
+	dbg_wl("erase PEBs %d and %d together",
+	       wrk[0]->e->pnum, wrk[1]->e->pnum);
+
+	if (paranoid_check_ec(ubi, wrk[0]->e->pnum, wrk[0]->e->ec) > 0 ||
+	    paranoid_check_ec(ubi, wrk[1]->e->pnum, wrk[1]->e->ec) > 0)
+		erased = -EINVAL;
+	else
+		erased = ubi_io_sync_erase_pair(ubi, wrk[0]->e->pnum);
+	if (erased < 0)
+		dbg_wl("pair erasure failed, error %d", erased);
+
+	for (i = 0; i < 2; i++) {
+		struct ubi_wl_entry *e = wrk[i]->e;
+
+		if (erased > 0 && !write_new_ec(ubi, e, erased)) {
+			kfree(wrk[i]);
+			add_erased(ubi, e);
+			continue;
+		}
+
+		err = erase_worker(ubi, wrk[i], 0);
+		if (err) {
+			/* Leave the other one for later */
+			if (i == 0)
+				schedule_ubi_work(ubi, wrk[1]);
+			return err;
+		}
+	}
+
+	return ensure_wear_leveling(ubi);
+}
+
 /**
  * ubi_wl_put_peb - return a PEB to the wear-leveling sub-system.
  * @ubi: UBI device description object
@@ -1148,16 +1375,18 @@ retry:
 }
 
 /**
- * ubi_wl_scrub_peb - schedule a physical eraseblock for scrubbing.
+ * schedule_scrub - schedule a physical eraseblock for scrubbing.
  * @ubi: UBI device description object
  * @pnum: the physical eraseblock to schedule
+ * @may_be_gone: whether @pnum may have been put in the meantime
  *
- * If a bit-flip in a physical eraseblock is detected, this physical eraseblock
- * needs scrubbing. This function schedules a physical eraseblock for
- * scrubbing which is done in background. This function returns zero in case of
- * success and a negative error code in case of failure.
+ * Callers which hold the LEB lock know that @pnum is used or protected. The
+ * patrol does not, so a concurrent 'ubi_wl_put_peb()' may have put it. If
+ * @may_be_gone is not zero, such a PEB is silently skipped instead of being
+ * treated as a lost PEB. This function returns zero in case of success and a
+ * negative error code in case of failure.
  */
-int ubi_wl_scrub_peb(struct ubi_device *ubi, int pnum)
+static int schedule_scrub(struct ubi_device *ubi, int pnum, int may_be_gone)
 {
 	struct ubi_wl_entry *e;
 
@@ -1166,6 +1395,11 @@ int ubi_wl_scrub_peb(struct ubi_device *ubi, int pnum)
 retry:
 	spin_lock(&ubi->wl_lock);
 	e = ubi->lookuptbl[pnum];
+	if (!e && may_be_gone) {
+		spin_unlock(&ubi->wl_lock);
+		return 0;
+	}
+
 	if (e == ubi->move_from || in_wl_tree(e, &ubi->scrub)) {
 		spin_unlock(&ubi->wl_lock);
 		return 0;
@@ -1190,6 +1424,13 @@ retry:
 	} else {
 		int err;
 
+		if (may_be_gone && !in_pq(ubi, e)) {
+			/* Put and pending erasure, or already free again */
+			spin_unlock(&ubi->wl_lock);
+			dbg_wl("PEB %d is not used any more", pnum);
+			return 0;
+		}
+
 		err = prot_queue_del(ubi, e->pnum);
 		if (err) {
 			ubi_err("PEB %d not found", pnum);
@@ -1209,6 +1450,260 @@ retry:
 	return ensure_wear_leveling(ubi);
 }
 
+/**
+ * ubi_wl_scrub_peb - schedule a physical eraseblock for scrubbing.
+ * @ubi: UBI device description object
+ * @pnum: the physical eraseblock to schedule
+ *
+ * If a bit-flip in a physical eraseblock is detected, this physical eraseblock
+ * needs scrubbing. This function schedules a physical eraseblock for
+ * scrubbing which is done in background. This function returns zero in case of
+ * success and a negative error code in case of failure.
+ */
+int ubi_wl_scrub_peb(struct ubi_device *ubi, int pnum)
+{
+	return schedule_scrub(ubi, pnum, 0);
+}
+
+#ifdef CONFIG_MTD_UBI_FASTMAP
+
+/**
+ * ubi_wl_get_fm_peb - get a physical eraseblock for the fastmap.
+ * @ubi: UBI device description object
+ * @anchor: if the physical eraseblock is going to be the fastmap anchor
+ * @max_ec: the erase counter has to be lower than this
+ * @ec: the erase counter of the physical eraseblock is returned here
+ *
+ * This function takes the least worn out free physical eraseblock, or the
+ * least worn out one among the first %UBI_FM_MAX_START if @anchor is set, out
+ * of the WL sub-system and gives it to the fastmap. Unlike
+ * 'ubi_wl_get_peb()', it never produces free physical eraseblocks. Returns
+ * the physical eraseblock number in case of success and %-ENOSPC if there is
+ * no suitable free physical eraseblock.
+ */
+int ubi_wl_get_fm_peb(struct ubi_device *ubi, int anchor, int max_ec, int *ec)
+{
+	int pnum = -ENOSPC;
+	struct rb_node *rb;
+	struct ubi_wl_entry *e;
+
+	spin_lock(&ubi->wl_lock);
+	ubi_rb_for_each_entry(rb, e, &ubi->free, u.rb) {
+		if (e->ec >= max_ec)
+			break;
+		if (anchor && e->pnum >= UBI_FM_MAX_START)
+			continue;
+
+		paranoid_check_in_wl_tree(e, &ubi->free);
+		rb_erase(&e->u.rb, &ubi->free);
+		ubi->free_count -= 1;
+		ubi->lookuptbl[e->pnum] = NULL;
+		pnum = e->pnum;
+		*ec = e->ec;
+		kmem_cache_free(ubi_wl_entry_slab, e);
+		break;
+	}
+	spin_unlock(&ubi->wl_lock);
+
+	dbg_wl("PEB %d for the fastmap, anchor %d", pnum, anchor);
+	return pnum;
+}
+
+/**
+ * ubi_wl_put_fm_peb - give a fastmap physical eraseblock back to WL.
+ * @ubi: UBI device description object
+ * @pnum: physical eraseblock to return
+ * @ec: its erase counter
+ * @torture: if this physical eraseblock has to be tortured
+ *
+ * The physical eraseblock is scheduled for erasure. This function returns
+ * zero in case of success and a negative error code in case of failure.
+ */
+int ubi_wl_put_fm_peb(struct ubi_device *ubi, int pnum, int ec, int torture)
+{
+	int err;
+	struct ubi_wl_entry *e;
+
+	dbg_wl("fastmap PEB %d EC %d", pnum, ec);
+
+	e = kmem_cache_alloc(ubi_wl_entry_slab, GFP_NOFS);
+	if (!e)
+		return -ENOMEM;
+
+	e->pnum = pnum;
+	e->ec = ec;
+	spin_lock(&ubi->wl_lock);
+	ubi->lookuptbl[pnum] = e;
+	spin_unlock(&ubi->wl_lock);
+
+	err = schedule_erase(ubi, e, torture);
+	if (err) {
+		spin_lock(&ubi->wl_lock);
+		ubi->lookuptbl[pnum] = NULL;
+		spin_unlock(&ubi->wl_lock);
+		kmem_cache_free(ubi_wl_entry_slab, e);
+	}
+
+	return err;
+}
+
+/**
+ * ubi_wl_fm_snapshot - record the state of physical eraseblocks.
+ * @ubi: UBI device description object
+ * @pebs: fastmap physical eraseblock records
+ *
+ * The caller has already stored the volume ID and LEB number of all mapped
+ * physical eraseblocks to @pebs, and %UBI_FM_PEB_SKIP to the rest. This
+ * function adds the erase counters and the scrubbing flags, and marks free
+ * physical eraseblocks with %UBI_FM_PEB_FREE. Physical eraseblocks which
+ * belong to the WL sub-system but are not mapped (i.e., are waiting for
+ * erasure) are marked with %UBI_FM_PEB_ERASE.
+ *
+ * Must be called when no works and no I/O are in progress.
+ */
+void ubi_wl_fm_snapshot(struct ubi_device *ubi, struct ubi_fm_peb *pebs)
+{
+	int pnum;
+	struct rb_node *rb;
+	struct ubi_wl_entry *e;
+
+	spin_lock(&ubi->wl_lock);
+	for (pnum = 0; pnum < ubi->peb_count; pnum++) {
+		e = ubi->lookuptbl[pnum];
+		if (!e)
+			continue;
+
+		if (pebs[pnum].vol_id == cpu_to_be32(UBI_FM_PEB_SKIP))
+			pebs[pnum].vol_id = cpu_to_be32(UBI_FM_PEB_ERASE);
+		pebs[pnum].ec = cpu_to_be32(e->ec);
+	}
+
+	ubi_rb_for_each_entry(rb, e, &ubi->free, u.rb)
+		pebs[e->pnum].vol_id = cpu_to_be32(UBI_FM_PEB_FREE);
+	ubi_rb_for_each_entry(rb, e, &ubi->scrub, u.rb)
+		pebs[e->pnum].ec = cpu_to_be32(e->ec | UBI_FM_EC_SCRUB);
+	spin_unlock(&ubi->wl_lock);
+}
+
+#endif /* CONFIG_MTD_UBI_FASTMAP */
+
+/**
+ * patrol_pick - pick the physical eraseblock to check.
+ * @ubi: UBI device description object
+ *
+ * This function returns the physical eraseblock number, or %-1 if there are
+ * no used physical eraseblocks.
+ */
+static int patrol_pick(struct ubi_device *ubi)
+{
+	int pnum = -1, first = -1, hot = -1;
+	unsigned int hot_reads = PATROL_DISTURB_READS;
+	struct rb_node *rb;
+	struct ubi_wl_entry *e;
+
+	spin_lock(&ubi->wl_lock);
+	ubi_rb_for_each_entry(rb, e, &ubi->used, u.rb) {
+		struct ubi_peb_rd *rd = &ubi->peb_rd[e->pnum];
+
+		if (rd->reads - rd->checked > hot_reads) {
+			hot = e->pnum;
+			hot_reads = rd->reads - rd->checked;
+		}
+		if (e->pnum >= ubi->patrol_pnum &&
+		    (pnum == -1 || e->pnum < pnum))
+			pnum = e->pnum;
+		if (first == -1 || e->pnum < first)
+			first = e->pnum;
+	}
+	spin_unlock(&ubi->wl_lock);
+
+	if (hot != -1)
+		return hot;
+
+	if (pnum == -1)
+		pnum = first;
+	ubi->patrol_pnum = pnum + 1;
+	return pnum;
+}
+
+/**
+ * patrol_peb - check one physical eraseblock for bit-flips.
+ * @ubi: UBI device description object
+ *
+ * The physical eraseblock is read up to the first empty NAND page, and if
+ * the read reports %UBI_IO_BITFLIPS, it is scheduled for scrubbing.
+ * Uncorrectable errors are only reported, because the data could not be
+ * moved anyway. The patrol holds no LEB lock, so the PEB may have been put
+ * by the time it is scheduled, and this is not an error.
+ */
+static void patrol_peb(struct ubi_device *ubi)
+{
+	int pnum, offset, err = 0, scrub = 0;
+
+	ubi->patrol_next = jiffies + PATROL_INTERVAL;
+
+	/* Erasure and moving must not pull the PEB from under us */
+	down_write(&ubi->work_sem);
+	pnum = patrol_pick(ubi);
+	if (pnum == -1) {
+		up_write(&ubi->work_sem);
+		return;
+	}
+
+	for (offset = 0; offset < ubi->peb_size; offset += ubi->min_io_size) {
+		void *buf = ubi->patrol_buf;
+
+		err = ubi_io_read(ubi, buf, pnum, offset, ubi->min_io_size);
+		if (err && err != UBI_IO_BITFLIPS && err != -EBADMSG)
+			break;
+		if (!ubi_calc_data_len(ubi, buf, ubi->min_io_size)) {
+			/* The rest of the PEB is not written */
+			err = 0;
+			break;
+		}
+		if (err == -EBADMSG) {
+			ubi_warn("patrol: uncorrectable data at PEB %d:%d",
+				 pnum, offset);
+			break;
+		}
+		if (err == UBI_IO_BITFLIPS)
+			scrub = 1;
+	}
+
+	ubi->peb_rd[pnum].checked = ubi->peb_rd[pnum].reads;
+	ubi->patrol_checks += 1;
+	up_write(&ubi->work_sem);
+
+	if (err < 0 && err != -EBADMSG)
+		ubi_err("patrol: error %d while reading PEB %d", err, pnum);
+
+	if (scrub) {
+		ubi_msg("patrol: scrub PEB %d, up to %u bit-flips", pnum,
+			ubi->peb_rd[pnum].bitflips);
+		ubi->patrol_scrubs += 1;
+		err = schedule_scrub(ubi, pnum, 1);
+		if (err)
+			ubi_err("patrol: cannot scrub PEB %d, error %d",
+				pnum, err);
+	}
+}
+
+/**
+ * patrol_timeout - how long until the patrol checks the next PEB.
+ * @ubi: UBI device description object
+ *
+ * This function returns the number of jiffies, or %MAX_SCHEDULE_TIMEOUT if
+ * the patrol is disabled.
+ */
+static long patrol_timeout(struct ubi_device *ubi)
+{
+	if (!ubi->patrol_buf)
+		return MAX_SCHEDULE_TIMEOUT;
+	if (time_after_eq(jiffies, ubi->patrol_next))
+		return 0;
+	return ubi->patrol_next - jiffies;
+}
+
 /**
  * ubi_wl_flush - flush all pending works.
  * @ubi: UBI device description object
@@ -1308,9 +1803,31 @@ int ubi_thread(void *u)
 		spin_lock(&ubi->wl_lock);
 		if (list_empty(&ubi->works) || ubi->ro_mode ||
 			       !ubi->thread_enabled) {
+			long timeout = MAX_SCHEDULE_TIMEOUT;
+			long patrol = MAX_SCHEDULE_TIMEOUT;
+
+			/*
+			 * Idle time is when the fastmap gets written and when
+			 * the patrol checks PEBs.
+			 */
+			if (!ubi->ro_mode && ubi->thread_enabled) {
+				timeout = ubi_fastmap_timeout(ubi);
+				patrol = patrol_timeout(ubi);
+			}
+			if (timeout == 0) {
+				spin_unlock(&ubi->wl_lock);
+				ubi_update_fastmap(ubi);
+				continue;
+			}
+			if (patrol == 0) {
+				spin_unlock(&ubi->wl_lock);
+				patrol_peb(ubi);
+				continue;
+			}
+
 			set_current_state(TASK_INTERRUPTIBLE);
 			spin_unlock(&ubi->wl_lock);
-			schedule();
+			schedule_timeout(min(timeout, patrol));
 			continue;
 		}
 		spin_unlock(&ubi->wl_lock);
@@ -1387,6 +1904,14 @@ int ubi_wl_init_scan(struct ubi_device *ubi, struct ubi_scan_info *si)
 	if (!ubi->lookuptbl)
 		return err;
 
+	/* Only NAND-like flashes have bit-flips worth patrolling for */
+	if (CONFIG_MTD_UBI_PATROL_INTERVAL && ubi->bad_allowed) {
+		ubi->patrol_buf = kmalloc(ubi->min_io_size, GFP_KERNEL);
+		if (!ubi->patrol_buf)
+			goto out_free;
+		ubi->patrol_next = jiffies + PATROL_INTERVAL;
+	}
+
 	for (i = 0; i < UBI_PROT_QUEUE_LEN; i++)
 		INIT_LIST_HEAD(&ubi->pq[i]);
 	ubi->pq_head = 0;
@@ -1418,6 +1943,7 @@ int ubi_wl_init_scan(struct ubi_device *ubi, struct ubi_scan_info *si)
 		e->ec = seb->ec;
 		ubi_assert(e->ec >= 0);
 		wl_tree_add(e, &ubi->free);
+		ubi->free_count += 1;
 		ubi->lookuptbl[e->pnum] = e;
 	}
 
@@ -1480,6 +2006,7 @@ out_free:
 	tree_destroy(&ubi->used);
 	tree_destroy(&ubi->free);
 	tree_destroy(&ubi->scrub);
+	kfree(ubi->patrol_buf);
 	kfree(ubi->lookuptbl);
 	return err;
 }
@@ -1513,6 +2040,7 @@ void ubi_wl_close(struct ubi_device *ubi)
 	tree_destroy(&ubi->used);
 	tree_destroy(&ubi->free);
 	tree_destroy(&ubi->scrub);
+	kfree(ubi->patrol_buf);
 	kfree(ubi->lookuptbl);
 }
 
@@ -39,6 +39,7 @@
 #include <linux/mm.h>
 #include <linux/device.h>
 #include <linux/dma-mapping.h>
+#include <linux/ktime.h>
 
 #include <asm/byteorder.h>
 #include <asm/dma.h>
@@ -78,6 +79,10 @@
 #define RegReadErr		5
 #define FAIL_TO_SETUP		6
 
+/* DxEPTSIZn limits for one multi-packet DMA transfer (non-control EPs) */
+#define S3C_UDC_DMA_MAX_PKTCNT	0x3ff
+#define S3C_UDC_DMA_MAX_XFER	0x7ffff
+
 #define TEST_J_SEL		0x1
 #define TEST_K_SEL		0x2
 #define TEST_SE0_NAK_SEL	0x3
@@ -92,6 +97,18 @@ typedef enum ep_type {
 	ep_control, ep_bulk_in, ep_bulk_out, ep_interrupt
 } ep_type_t;
 
+/* per-endpoint transfer accounting, reported through debugfs */
+struct s3c_ep_stats {
+	u64 bytes;		/* payload moved by completed requests */
+	u32 requests;		/* requests completed */
+	u32 chunks;		/* DMA transfers programmed */
+	u32 starved;		/* completions that left the endpoint idle */
+	s64 active_ns;		/* time with a DMA transfer armed */
+	ktime_t first;		/* first DMA start since enable */
+	ktime_t last;		/* last completion */
+	ktime_t armed;		/* start of the current DMA transfer */
+};
+
 struct s3c_ep {
 	struct usb_ep ep;
 	struct s3c_udc *dev;
@@ -106,6 +123,7 @@ struct s3c_ep {
 
 	ep_type_t ep_type;
 	u32 fifo;
+	struct s3c_ep_stats stats;
 #ifdef CONFIG_USB_GADGET_S3C_FS
 	u32 csr1;
 	u32 csr2;
@@ -115,6 +133,7 @@ struct s3c_ep {
 struct s3c_request {
 	struct usb_request req;
 	struct list_head queue;
+	u32 xfer_len;		/* bytes programmed in the current DMA */
 };
 
 struct s3c_udc {
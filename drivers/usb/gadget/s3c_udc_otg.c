@@ -214,6 +214,124 @@ udc_proc_read(char *page, char **start, off_t off, int count,
 
 #endif	/* CONFIG_USB_GADGET_DEBUG_FILES */
 
+#ifdef CONFIG_USB_GADGET_DEBUG_FS
+
+#include <linux/debugfs.h>
+#include <linux/seq_file.h>
+#include <linux/math64.h>
+
+static struct dentry *s3c_udc_debugfs_root;
+
+/* KiB/s for @bytes moved in @ns */
+static unsigned long s3c_udc_kbps(u64 bytes, s64 ns)
+{
+	u64 us;
+
+	if (ns <= 0)
+		return 0;
+
+	us = div_u64(ns, NSEC_PER_USEC);
+	if (!us)
+		return 0;
+
+	return (unsigned long)div64_u64(bytes * 15625, us * 16);
+}
+
+/*
+ * "wire" is the rate while a DMA transfer was armed, "rate" the rate over
+ * the whole run from the first transfer to the last completion; a wide gap
+ * between the two means the endpoint sat idle waiting for requests.
+ */
+static int s3c_udc_throughput_show(struct seq_file *m, void *p)
+{
+	struct s3c_udc *dev = m->private;
+	struct s3c_ep_stats st;
+	unsigned long flags;
+	s64 elapsed;
+	int i;
+
+	seq_printf(m, "%-12s %12s %8s %8s %8s %10s %10s\n", "ep", "bytes",
+		   "reqs", "dmas", "starved", "wire KB/s", "rate KB/s");
+
+	for (i = 1; i < S3C_MAX_ENDPOINTS; i++) {
+		struct s3c_ep *ep = &dev->ep[i];
+
+		spin_lock_irqsave(&dev->lock, flags);
+		st = ep->stats;
+		spin_unlock_irqrestore(&dev->lock, flags);
+
+		if (!st.chunks)
+			continue;
+
+		elapsed = ktime_to_ns(ktime_sub(st.last, st.first));
+
+		seq_printf(m, "%-12s %12llu %8u %8u %8u %10lu %10lu\n",
+			   ep->ep.name, (unsigned long long)st.bytes,
+			   st.requests, st.chunks, st.starved,
+			   s3c_udc_kbps(st.bytes, st.active_ns),
+			   s3c_udc_kbps(st.bytes, elapsed));
+	}
+
+	return 0;
+}
+
+static int s3c_udc_throughput_open(struct inode *inode, struct file *file)
+{
+	return single_open(file, s3c_udc_throughput_show, inode->i_private);
+}
+
+/* any write starts a new measurement */
+static ssize_t s3c_udc_throughput_write(struct file *file,
+					const char __user *ubuf,
+					size_t count, loff_t *ppos)
+{
+	struct seq_file *m = file->private_data;
+	struct s3c_udc *dev = m->private;
+	unsigned long flags;
+	int i;
+
+	spin_lock_irqsave(&dev->lock, flags);
+	for (i = 0; i < S3C_MAX_ENDPOINTS; i++)
+		memset(&dev->ep[i].stats, 0, sizeof(dev->ep[i].stats));
+	spin_unlock_irqrestore(&dev->lock, flags);
+
+	return count;
+}
+
+static const struct file_operations s3c_udc_throughput_fops = {
+	.open		= s3c_udc_throughput_open,
+	.read		= seq_read,
+	.write		= s3c_udc_throughput_write,
+	.llseek		= seq_lseek,
+	.release	= single_release,
+	.owner		= THIS_MODULE,
+};
+
+static void s3c_udc_debugfs_init(struct s3c_udc *dev)
+{
+	s3c_udc_debugfs_root = debugfs_create_dir(driver_name, NULL);
+	if (IS_ERR(s3c_udc_debugfs_root) || !s3c_udc_debugfs_root) {
+		s3c_udc_debugfs_root = NULL;
+		return;
+	}
+
+	debugfs_create_file("throughput", 0644, s3c_udc_debugfs_root,
+			    dev, &s3c_udc_throughput_fops);
+}
+
+static void s3c_udc_debugfs_exit(void)
+{
+	debugfs_remove_recursive(s3c_udc_debugfs_root);
+	s3c_udc_debugfs_root = NULL;
+}
+
+#else	/* !CONFIG_USB_GADGET_DEBUG_FS */
+
+static inline void s3c_udc_debugfs_init(struct s3c_udc *dev) {}
+static inline void s3c_udc_debugfs_exit(void) {}
+
+#endif	/* CONFIG_USB_GADGET_DEBUG_FS */
+
 #if	OTG_DMA_MODE /* DMA Mode */
 #include "s3c_udc_otg_xfer_dma.c"
 
@@ -608,6 +726,7 @@ static int s3c_ep_enable(struct usb_ep *_ep,
 	ep->stopped = 0;
 	ep->desc = desc;
 	ep->pio_irqs = 0;
+	memset(&ep->stats, 0, sizeof(ep->stats));
 	ep->ep.maxpacket = le16_to_cpu(desc->wMaxPacketSize);
 
 	/* Reset halt state */
@@ -1075,6 +1194,7 @@ static int s3c_udc_probe(struct platform_device *pdev)
 	disable_irq(IRQ_OTG);
 	local_irq_enable();
 	create_proc_files();
+	s3c_udc_debugfs_init(dev);
 
 	return retval;
 }
@@ -1092,6 +1212,7 @@ static int s3c_udc_remove(struct platform_device *pdev)
 	}
 
 	remove_proc_files();
+	s3c_udc_debugfs_exit();
 	usb_gadget_unregister_driver(dev->driver);
 
 	free_irq(IRQ_OTG, dev);
@@ -65,6 +65,38 @@ static inline void s3c_udc_pre_setup(void)
 	writel(ep_ctrl|DEPCTL_EPENA|DEPCTL_CNAK, S3C_UDC_OTG_DOEPCTL(EP0_CON));
 }
 
+/*
+ * Bytes of a request to program in one DMA transfer. The core moves up
+ * to PKTCNT packets per transfer without CPU help, so large requests go
+ * out in as few transfers as the DxEPTSIZ fields allow, cut on a packet
+ * boundary so that only the final one can end short.
+ */
+static u32 s3c_udc_dma_chunk(struct s3c_ep *ep, u32 length)
+{
+	u32 max = min((u32)S3C_UDC_DMA_MAX_XFER,
+		      (u32)S3C_UDC_DMA_MAX_PKTCNT * ep_maxpacket(ep));
+
+	if (length > max)
+		length = max - (max % ep_maxpacket(ep));
+
+	return length;
+}
+
+static inline void s3c_udc_stats_arm(struct s3c_ep *ep)
+{
+	ep->stats.armed = ktime_get();
+	if (!ep->stats.first.tv64)
+		ep->stats.first = ep->stats.armed;
+	ep->stats.chunks++;
+}
+
+static inline void s3c_udc_stats_done(struct s3c_ep *ep)
+{
+	ep->stats.last = ktime_get();
+	ep->stats.active_ns += ktime_to_ns(ktime_sub(ep->stats.last,
+						     ep->stats.armed));
+}
+
 static int setdma_rx(struct s3c_ep *ep, struct s3c_request *req)
 {
 	u32 *buf, ctrl;
@@ -75,6 +107,10 @@ static int setdma_rx(struct s3c_ep *ep, struct s3c_request *req)
 	prefetchw(buf);
 
 	length = req->req.length - req->req.actual;
+	if (ep_num != EP0_CON)
+		length = s3c_udc_dma_chunk(ep, length);
+
+	req->xfer_len = length;
 	dma_cache_maint(buf, length, DMA_FROM_DEVICE);
 
 	if(length == 0)
@@ -84,6 +120,8 @@ static int setdma_rx(struct s3c_ep *ep, struct s3c_request *req)
 
 	ctrl =  readl(S3C_UDC_OTG_DOEPCTL(ep_num));
 
+	s3c_udc_stats_arm(ep);
+
 	writel(virt_to_phys(buf), S3C_UDC_OTG_DOEPDMA(ep_num));
 	writel((pktcnt<<19)|(length<<0), S3C_UDC_OTG_DOEPTSIZ(ep_num));
 	writel(DEPCTL_EPENA|DEPCTL_CNAK|ctrl, S3C_UDC_OTG_DOEPCTL(ep_num));
@@ -111,9 +149,12 @@ static int setdma_tx(struct s3c_ep *ep, struct s3c_request *req)
 
 	if(ep_num == EP0_CON) {
 		length = min(length, (u32)ep_maxpacket(ep));
+	} else {
+		length = s3c_udc_dma_chunk(ep, length);
 	}
 
 	req->req.actual += length;
+	req->xfer_len = length;
 	dma_cache_maint(buf, length, DMA_TO_DEVICE);
 
 	if(length == 0) {
@@ -135,6 +176,8 @@ static int setdma_tx(struct s3c_ep *ep, struct s3c_request *req)
 	writel(ctrl , S3C_UDC_OTG_DIEPCTL(ep_num));
 #endif
 
+	s3c_udc_stats_arm(ep);
+
 	writel(virt_to_phys(buf), S3C_UDC_OTG_DIEPDMA(ep_num));
 	writel((pktcnt<<19)|(length<<0), S3C_UDC_OTG_DIEPTSIZ(ep_num));
 	ctrl = readl(S3C_UDC_OTG_DIEPCTL(ep_num));
@@ -155,6 +198,39 @@ static int setdma_tx(struct s3c_ep *ep, struct s3c_request *req)
 	return length;
 }
 
+/*
+ * Retire a finished request. The request queued behind it is armed
+ * before the completion callback runs, so the endpoint keeps moving
+ * data while the gadget driver refills and requeues its buffer. When
+ * nothing is queued behind it, a request the callback queues finds the
+ * queue empty and s3c_queue() arms it, so there is nothing left to do
+ * here afterwards.
+ */
+static void s3c_udc_retire(struct s3c_ep *ep, struct s3c_request *req,
+			   int is_in)
+{
+	struct s3c_request *next = NULL;
+
+	if (req->queue.next != &ep->queue) {
+		next = list_entry(req->queue.next, struct s3c_request, queue);
+		DEBUG("%s: %s next request(0x%p) start...\n",
+			__func__, ep->ep.name, next);
+
+		if (is_in)
+			setdma_tx(ep, next);
+		else
+			setdma_rx(ep, next);
+	}
+
+	ep->stats.bytes += req->req.actual;
+	ep->stats.requests++;
+
+	if (!next)
+		ep->stats.starved++;
+
+	done(ep, req, 0);
+}
+
 static void complete_rx(struct s3c_udc *dev, u8 ep_num)
 {
 	struct s3c_ep *ep = &dev->ep[ep_num];
@@ -169,6 +245,7 @@ static void complete_rx(struct s3c_udc *dev, u8 ep_num)
 	}
 
 	req = list_entry(ep->queue.next, struct s3c_request, queue);
+	s3c_udc_stats_done(ep);
 
 	ep_tsr = readl(S3C_UDC_OTG_DOEPTSIZ(ep_num));
 
@@ -176,34 +253,36 @@ static void complete_rx(struct s3c_udc *dev, u8 ep_num)
 		xfer_size = (ep_tsr & 0x7f);
 
 	} else {
-		xfer_size = (ep_tsr & 0x7fff);
+		xfer_size = (ep_tsr & S3C_UDC_DMA_MAX_XFER);
 	}
 
-	dma_cache_maint(req->req.buf, req->req.length, DMA_FROM_DEVICE);
-	xfer_length = req->req.length - xfer_size;
+	dma_cache_maint(req->req.buf + req->req.actual, req->xfer_len,
+			DMA_FROM_DEVICE);
+	xfer_length = req->xfer_len - xfer_size;
 	req->req.actual += min(xfer_length, req->req.length - req->req.actual);
-	is_short = (xfer_length < ep->ep.maxpacket);
+	is_short = (xfer_length < req->xfer_len) ||
+		   (xfer_length % ep->ep.maxpacket);
 
 	DEBUG_OUT_EP("%s: RX DMA done : ep = %d, rx bytes = %d/%d, "
 		     "is_short = %d, DOEPTSIZ = 0x%x, remained bytes = %d\n",
 			__func__, ep_num, req->req.actual, req->req.length,
 			is_short, ep_tsr, xfer_size);
 
-	if (is_short || req->req.actual == xfer_length) {
-		if(ep_num == EP0_CON && dev->ep0state == DATA_STATE_RECV) {
-			DEBUG_OUT_EP("	=> Send ZLP\n");
-			dev->ep0state = WAIT_FOR_SETUP;
-			s3c_udc_ep0_zlp();
+	if (!is_short && req->req.actual < req->req.length) {
+		if (ep_num != EP0_CON) {
+			/* more of this request than fits in one transfer */
+			setdma_rx(ep, req);
+		}
+		return;
+	}
 
-		} else {
-			done(ep, req, 0);
+	if(ep_num == EP0_CON && dev->ep0state == DATA_STATE_RECV) {
+		DEBUG_OUT_EP("	=> Send ZLP\n");
+		dev->ep0state = WAIT_FOR_SETUP;
+		s3c_udc_ep0_zlp();
 
-			if(!list_empty(&ep->queue)) {
-				req = list_entry(ep->queue.next, struct s3c_request, queue);
-				DEBUG_OUT_EP("%s: Next Rx request start...\n", __func__);
-				setdma_rx(ep, req);
-			}
-		}
+	} else {
+		s3c_udc_retire(ep, req, 0);
 	}
 }
 
@@ -211,7 +290,7 @@ static void complete_tx(struct s3c_udc *dev, u8 ep_num)
 {
 	struct s3c_ep *ep = &dev->ep[ep_num];
 	struct s3c_request *req;
-	u32 ep_tsr = 0, xfer_size = 0, xfer_length, is_short = 0;
+	u32 ep_tsr = 0, xfer_size = 0;
 	u32 last;
 
 	if (list_empty(&ep->queue)) {
@@ -222,6 +301,7 @@ static void complete_tx(struct s3c_udc *dev, u8 ep_num)
 	}
 
 	req = list_entry(ep->queue.next, struct s3c_request, queue);
+	s3c_udc_stats_done(ep);
 
 	if(dev->ep0state == DATA_STATE_XMIT) {
 		DEBUG_IN_EP("%s: ep_num = %d, ep0stat == DATA_STATE_XMIT\n",
@@ -242,29 +322,28 @@ static void complete_tx(struct s3c_udc *dev, u8 ep_num)
 		xfer_size = (ep_tsr & 0x7f);
 
 	} else {
-		xfer_size = (ep_tsr & 0x7fff);
+		xfer_size = (ep_tsr & S3C_UDC_DMA_MAX_XFER);
 	}
 
-	req->req.actual = req->req.length - xfer_size;
-	xfer_length = req->req.length - xfer_size;
-	req->req.actual += min(xfer_length, req->req.length - req->req.actual);
-	is_short = (xfer_length < ep->ep.maxpacket);
+	/* setdma_tx() already counted the whole transfer */
+	req->req.actual -= min(xfer_size, req->xfer_len);
 
 	DEBUG_IN_EP("%s: TX DMA done : ep = %d, tx bytes = %d/%d, "
-		     "is_short = %d, DIEPTSIZ = 0x%x, remained bytes = %d\n",
+		     "DIEPTSIZ = 0x%x, remained bytes = %d\n",
 			__func__, ep_num, req->req.actual, req->req.length,
-			is_short, ep_tsr, xfer_size);
-
-	if (req->req.actual == req->req.length) {
-		done(ep, req, 0);
+			ep_tsr, xfer_size);
 
-		if(!list_empty(&ep->queue)) {
-			req = list_entry(ep->queue.next, struct s3c_request, queue);
-			DEBUG_IN_EP("%s: Next Tx request start...\n", __func__);
+	if (req->req.actual < req->req.length) {
+		if (ep_num != EP0_CON && !xfer_size) {
+			/* more of this request than fits in one transfer */
 			setdma_tx(ep, req);
 		}
+		return;
 	}
+
+	s3c_udc_retire(ep, req, 1);
 }
+
 static inline void s3c_udc_check_tx_queue(struct s3c_udc *dev, u8 ep_num)
 {
 	struct s3c_ep *ep = &dev->ep[ep_num];
@@ -22,6 +22,7 @@
 #include <linux/slab.h>
 #include <linux/mm.h>
 #include <linux/mman.h>
+#include <linux/poll.h>
 #include <linux/vt.h>
 #include <linux/init.h>
 #include <linux/linux_logo.h>
@@ -1352,6 +1353,17 @@ __releases(&info->lock)
 	return 0;
 }
 
+static unsigned int
+fb_poll(struct file *file, poll_table *wait)
+{
+	struct fb_info * const info = file->private_data;
+
+	if (info && info->fbops->fb_poll)
+		return info->fbops->fb_poll(info, file, wait);
+
+	return DEFAULT_POLLMASK;
+}
+
 static int
 fb_open(struct inode *inode, struct file *file)
 __acquires(&info->lock)
@@ -1413,6 +1425,7 @@ static const struct file_operations fb_fops = {
 	.compat_ioctl = fb_compat_ioctl,
 #endif
 	.mmap =		fb_mmap,
+	.poll =		fb_poll,
 	.open =		fb_open,
 	.release =	fb_release,
 #ifdef HAVE_ARCH_FB_UNMAPPED_AREA
@@ -30,8 +30,12 @@
 #include <linux/io.h>
 #include <linux/memory.h>
 #include <linux/cpufreq.h>
+#include <linux/spinlock.h>
+#include <linux/time.h>
+#include <linux/uaccess.h>
 #include <plat/clock.h>
 #include <plat/cpu-freq.h>
+#include <plat/media.h>
 
 #ifdef CONFIG_FB_S3C_LTE480WV
 #include "logo_rgb24_wvga_landscape.h"
@@ -87,16 +91,346 @@ int fb_is_primary_device(struct fb_info *fb)
 }
 #endif
 
+/* called with slock held */
+static void __s3cfb_update_vsync(void)
+{
+	struct s3c_platform_fb *pdata = to_fb_plat(fbdev->dev);
+	struct s3cfb_window *win;
+	int i, on = fbdev->vsync_req || fbdev->update_mask;
+
+	/* reprogrammed when the display is powered up again */
+	if (fbdev->fb_off)
+		return;
+
+	for (i = 0; i < pdata->nr_wins; i++) {
+		win = fbdev->fb[i]->par;
+		if (win->flip_depth || win->vsync_events)
+			on = 1;
+	}
+
+	if (on)
+		s3cfb_set_global_interrupt(fbdev, 1);
+
+	s3cfb_set_vsync_interrupt(fbdev, on);
+}
+
+static void s3cfb_update_vsync(void)
+{
+	unsigned long flags;
+
+	spin_lock_irqsave(&fbdev->slock, flags);
+	__s3cfb_update_vsync();
+	spin_unlock_irqrestore(&fbdev->slock, flags);
+}
+
+static void s3cfb_set_plane_alpha(struct s3cfb_window *win, int channel,
+				  unsigned char r, unsigned char g,
+				  unsigned char b)
+{
+	win->alpha.mode = PLANE_BLENDING;
+	win->alpha.channel = channel;
+#if defined (CONFIG_CPU_S5PC110)
+	win->alpha.avalue_h = S3CFB_AVALUE_H(r, g, b);
+	win->alpha.avalue_l = S3CFB_AVALUE_L(r, g, b);
+#else
+	win->alpha.value = S3CFB_AVALUE(r, g, b);
+#endif
+}
+
+/* called with slock held, from the frame interrupt or with vsync off */
+static void s3cfb_apply_update(int id)
+{
+	struct fb_info *fb = fbdev->fb[id];
+	struct s3cfb_window *win = fb->par;
+	struct s3cfb_user_win_update *u = &win->staged;
+
+	if (u->flags & S3CFB_UPDATE_POSITION) {
+		win->x = u->x;
+		win->y = u->y;
+		s3cfb_set_window_position(fbdev, id);
+	}
+
+	if (u->flags & S3CFB_UPDATE_ALPHA) {
+		s3cfb_set_plane_alpha(win, u->alpha_channel, u->alpha_red,
+				      u->alpha_green, u->alpha_blue);
+		s3cfb_set_alpha_blending(fbdev, id);
+	}
+
+	if (u->flags & S3CFB_UPDATE_CHROMA) {
+		win->chroma.enabled = u->chroma_enabled;
+		win->chroma.key = S3CFB_CHROMA(u->chroma_red, u->chroma_green,
+					       u->chroma_blue);
+		s3cfb_set_chroma_key(fbdev, id);
+	}
+
+	if (u->flags & S3CFB_UPDATE_ADDR)
+		win->buf_addr = u->addr;
+
+	if (u->flags & S3CFB_UPDATE_YOFFSET) {
+		fb->var.yoffset = u->yoffset;
+		win->latched = u->yoffset;
+	}
+
+	if (u->flags & (S3CFB_UPDATE_ADDR | S3CFB_UPDATE_YOFFSET))
+		s3cfb_set_buffer_offset(fbdev, id, win->latched);
+
+	if (u->flags & S3CFB_UPDATE_ENABLE) {
+		if (u->enabled && !s3cfb_window_on(fbdev, id))
+			win->enabled = 1;
+		else if (!u->enabled && !s3cfb_window_off(fbdev, id))
+			win->enabled = 0;
+	}
+
+	u->flags = 0;
+}
+
+/* write every staged window update under one shadow register protect */
+static void s3cfb_commit_updates(void)
+{
+	int i;
+
+	if (!fbdev->update_mask)
+		return;
+
+	s3cfb_set_shadow_protect(fbdev, 1);
+
+	for (i = 0; i < S3CFB_MAX_WINDOWS; i++) {
+		if (fbdev->update_mask & (1 << i))
+			s3cfb_apply_update(i);
+	}
+
+	s3cfb_set_shadow_protect(fbdev, 0);
+
+	fbdev->update_mask = 0;
+}
+
+/*
+ * The shadow registers are reloaded at vsync, so the pan latched here
+ * is scanned out from the next frame on and the one latched at the
+ * previous interrupt is on screen now.
+ */
 static irqreturn_t s3cfb_irq_frame(int irq, void *dev_id)
 {
+	struct s3c_platform_fb *pdata = to_fb_plat(fbdev->dev);
+	struct s3cfb_window *win;
+	int i;
+
 	s3cfb_clear_interrupt(fbdev);
 
+	spin_lock(&fbdev->slock);
+
+	do_gettimeofday(&fbdev->vsync_time);
 	fbdev->wq_count++;
+
+	for (i = 0; fbdev->fb && i < pdata->nr_wins; i++) {
+		win = fbdev->fb[i]->par;
+		win->scanout = win->latched;
+
+		if (win->flip_count) {
+			win->latched = win->flip_queue[win->flip_head];
+			win->flip_head = (win->flip_head + 1) %
+						S3CFB_FLIP_QUEUE_MAX;
+			win->flip_count--;
+			s3cfb_set_buffer_offset(fbdev, i, win->latched);
+		}
+	}
+
+	if (fbdev->fb && fbdev->update_mask) {
+		s3cfb_commit_updates();
+		__s3cfb_update_vsync();
+	}
+
+	spin_unlock(&fbdev->slock);
+
 	wake_up(&fbdev->wq);
 
 	return IRQ_HANDLED;
 }
 
+/* drop the queued pans and show the latest one right away */
+static void s3cfb_flush_flips(int id)
+{
+	struct fb_info *fb = fbdev->fb[id];
+	struct s3cfb_window *win = fb->par;
+	unsigned long flags;
+
+	spin_lock_irqsave(&fbdev->slock, flags);
+
+	if (win->flip_count) {
+		win->flip_count = 0;
+		s3cfb_set_buffer_offset(fbdev, id, fb->var.yoffset);
+	}
+
+	win->flip_head = 0;
+	win->latched = fb->var.yoffset;
+	win->scanout = fb->var.yoffset;
+
+	spin_unlock_irqrestore(&fbdev->slock, flags);
+}
+
+#ifdef CONFIG_PLAT_S5PC1XX
+/* a decoded or captured frame MFC or FIMC holds */
+static int s3cfb_media_buffer(unsigned long addr, unsigned long len)
+{
+	return s3c_media_claimed(S3C_MDEV_MFC, addr, len) ||
+		s3c_media_claimed(S3C_MDEV_FIMC0, addr, len) ||
+		s3c_media_claimed(S3C_MDEV_FIMC1, addr, len) ||
+		s3c_media_claimed(S3C_MDEV_FIMC2, addr, len);
+}
+#else
+static inline int s3cfb_media_buffer(unsigned long addr, unsigned long len)
+{
+	return 0;
+}
+#endif
+
+/*
+ * The buffer must lie in video memory fimd allocated for some window, or
+ * in media memory MFC or FIMC holds.
+ */
+static int s3cfb_check_buffer(struct fb_info *fb, unsigned long addr)
+{
+	struct s3c_platform_fb *pdata = to_fb_plat(fbdev->dev);
+	unsigned long len = fb->fix.line_length * fb->var.yres_virtual;
+	struct fb_fix_screeninfo *fix;
+	struct s3cfb_window *win;
+	int i;
+
+	for (i = 0; i < pdata->nr_wins; i++) {
+		fix = &fbdev->fb[i]->fix;
+		win = fbdev->fb[i]->par;
+
+		if (win->owner != DMA_MEM_FIMD || !fix->smem_start)
+			continue;
+
+		if (addr >= fix->smem_start && len <= fix->smem_len &&
+		    addr - fix->smem_start <= fix->smem_len - len)
+			return 0;
+	}
+
+	if (s3cfb_media_buffer(addr, len))
+		return 0;
+
+	return -EINVAL;
+}
+
+/*
+ * Validate a S3CFB_WIN_UPDATE request and merge it into the updates
+ * already staged, so a compositor issuing several per frame only costs
+ * one register commit at the next vsync.
+ */
+static int s3cfb_stage_update(struct s3cfb_user_update *up)
+{
+	struct s3c_platform_fb *pdata = to_fb_plat(fbdev->dev);
+	struct s3cfb_lcd *lcd = fbdev->lcd;
+	struct s3cfb_user_win_update *u, *staged;
+	struct s3cfb_window *win;
+	struct fb_info *fb;
+	unsigned long flags;
+	int i;
+
+	if (up->count > S3CFB_MAX_WINDOWS)
+		return -EINVAL;
+
+	for (i = 0; i < up->count; i++) {
+		u = &up->win[i];
+
+		if (u->id < 0 || u->id >= pdata->nr_wins) {
+			dev_err(fbdev->dev, "invalid window %d\n", u->id);
+			return -EINVAL;
+		}
+
+		fb = fbdev->fb[u->id];
+		win = fb->par;
+
+		if ((u->flags & (S3CFB_UPDATE_ALPHA | S3CFB_UPDATE_CHROMA)) &&
+		    u->id == 0) {
+			dev_err(fbdev->dev, "[fb0] does not support alpha "
+				"blending and chroma key\n");
+			return -EINVAL;
+		}
+
+		if ((u->flags & S3CFB_UPDATE_ADDR) &&
+		    (win->owner != DMA_MEM_OTHER ||
+		     s3cfb_check_buffer(fb, u->addr))) {
+			dev_err(fbdev->dev, "[fb%d] invalid buffer address\n",
+				u->id);
+			return -EINVAL;
+		}
+
+		if ((u->flags & S3CFB_UPDATE_YOFFSET) &&
+		    u->yoffset + fb->var.yres > fb->var.yres_virtual) {
+			dev_err(fbdev->dev, "[fb%d] invalid yoffset value\n",
+				u->id);
+			return -EINVAL;
+		}
+
+		if (u->flags & S3CFB_UPDATE_POSITION) {
+			if (u->x < 0)
+				u->x = 0;
+
+			if (u->y < 0)
+				u->y = 0;
+
+			if (u->x + fb->var.xres > lcd->width)
+				u->x = lcd->width - fb->var.xres;
+
+			if (u->y + fb->var.yres > lcd->height)
+				u->y = lcd->height - fb->var.yres;
+		}
+	}
+
+	spin_lock_irqsave(&fbdev->slock, flags);
+
+	for (i = 0; i < up->count; i++) {
+		u = &up->win[i];
+		fb = fbdev->fb[u->id];
+		win = fb->par;
+		staged = &win->staged;
+
+		if (u->flags & S3CFB_UPDATE_POSITION) {
+			staged->x = u->x;
+			staged->y = u->y;
+		}
+
+		if (u->flags & S3CFB_UPDATE_ENABLE)
+			staged->enabled = u->enabled;
+
+		if (u->flags & S3CFB_UPDATE_ALPHA) {
+			staged->alpha_channel = u->alpha_channel;
+			staged->alpha_red = u->alpha_red;
+			staged->alpha_green = u->alpha_green;
+			staged->alpha_blue = u->alpha_blue;
+		}
+
+		if (u->flags & S3CFB_UPDATE_CHROMA) {
+			staged->chroma_enabled = u->chroma_enabled;
+			staged->chroma_red = u->chroma_red;
+			staged->chroma_green = u->chroma_green;
+			staged->chroma_blue = u->chroma_blue;
+		}
+
+		if (u->flags & S3CFB_UPDATE_ADDR)
+			staged->addr = u->addr;
+
+		if (u->flags & S3CFB_UPDATE_YOFFSET)
+			staged->yoffset = u->yoffset;
+
+		staged->id = u->id;
+		staged->flags |= u->flags;
+		fbdev->update_mask |= (1 << u->id);
+	}
+
+	/* latched at the next vsync, scanned out from the one after */
+	up->sequence = fbdev->wq_count + 2;
+
+	__s3cfb_update_vsync();
+
+	spin_unlock_irqrestore(&fbdev->slock, flags);
+
+	return 0;
+}
+
 #ifdef CONFIG_FB_S3C_TRACE_UNDERRUN
 static irqreturn_t s3cfb_irq_fifo(int irq, void *dev_id)
 {
@@ -163,9 +497,7 @@ static int s3cfb_init_global(void)
 	fbdev->output = OUTPUT_RGB;
 	fbdev->rgb_mode = MODE_RGB_P;
 	
-	fbdev->wq_count = 0;
 	fbdev->fb_off = 0;
-	init_waitqueue_head(&fbdev->wq);
 	mutex_init(&fbdev->lock);
 
 	s3cfb_set_output(fbdev);
@@ -403,6 +735,7 @@ static int s3cfb_blank(int blank_mode, struct fb_info *fb)
 	struct s3cfb_window *win = fb->par;
 	struct s3c_platform_fb *pdata = to_fb_plat(fbdev->dev);
 	struct platform_device *pdev = to_platform_device(fbdev->dev);
+	unsigned long flags;
 	int check_win;
 
 	dev_dbg(fbdev->dev, "change blank mode\n");
@@ -426,6 +759,10 @@ static int s3cfb_blank(int blank_mode, struct fb_info *fb)
 			s3cfb_enable_window(win->id);
 		}
 
+		spin_lock_irqsave(&fbdev->slock, flags);
+		s3cfb_commit_updates();
+		__s3cfb_update_vsync();
+		spin_unlock_irqrestore(&fbdev->slock, flags);
 		break;
 
 	case FB_BLANK_NORMAL:
@@ -437,6 +774,7 @@ static int s3cfb_blank(int blank_mode, struct fb_info *fb)
 	case FB_BLANK_POWERDOWN:
 		s3cfb_disable_window(win->id);
 		s3cfb_win_map_off(fbdev, win->id);
+		s3cfb_flush_flips(win->id);
 		check_win = s3cfb_check_win_status();
 		if ((check_win == 0) && (fbdev->fb_off == 0)) {
 			if (fbdev->lcd->deinit_ldi)
@@ -459,23 +797,101 @@ static int s3cfb_blank(int blank_mode, struct fb_info *fb)
 	return 0;
 }
 
+/*
+ * With a flip queue the new offset is written at the next vsync instead
+ * of now, and -EBUSY tells the caller that flip_depth pans are already
+ * waiting.  Without one, or while nothing is scanned out, pan at once.
+ */
 static int s3cfb_pan_display(struct fb_var_screeninfo *var, struct fb_info *fb)
 {
 	struct s3cfb_window *win = fb->par;
+	unsigned long flags;
+	int ret = 0;
 
 	if (var->yoffset + var->yres > var->yres_virtual) {
 		dev_err(fbdev->dev, "invalid yoffset value\n");
 		return -EINVAL;
 	}
 
-	fb->var.yoffset = var->yoffset;
-
 	dev_dbg(fbdev->dev, "[fb%d] yoffset for pan display: %d\n", win->id,
 		var->yoffset);
-	
-	s3cfb_set_buffer_address(fbdev, win->id);
 
-	return 0;
+	spin_lock_irqsave(&fbdev->slock, flags);
+
+	if (!win->flip_depth || !win->enabled || fbdev->fb_off) {
+		fb->var.yoffset = var->yoffset;
+		win->latched = var->yoffset;
+		s3cfb_set_buffer_offset(fbdev, win->id, var->yoffset);
+	} else if (win->flip_count >= win->flip_depth) {
+		ret = -EBUSY;
+	} else {
+		fb->var.yoffset = var->yoffset;
+		win->flip_queue[(win->flip_head + win->flip_count) %
+				S3CFB_FLIP_QUEUE_MAX] = var->yoffset;
+		win->flip_count++;
+	}
+
+	spin_unlock_irqrestore(&fbdev->slock, flags);
+
+	return ret;
+}
+
+static ssize_t s3cfb_read(struct fb_info *fb, char __user *buf,
+			  size_t count, loff_t *ppos)
+{
+	struct s3cfb_window *win = fb->par;
+	struct s3cfb_vsync_event event;
+	unsigned long flags;
+	int ret;
+
+	if (!win->vsync_events)
+		return fb_sys_read(fb, buf, count, ppos);
+
+	if (count < sizeof(event))
+		return -EINVAL;
+
+	ret = wait_event_interruptible(fbdev->wq,
+				       fbdev->wq_count != win->event_seq ||
+				       !win->vsync_events);
+	if (ret)
+		return ret;
+
+	if (!win->vsync_events)
+		return -EAGAIN;
+
+	spin_lock_irqsave(&fbdev->slock, flags);
+	event.sequence = fbdev->wq_count;
+	event.timestamp = fbdev->vsync_time;
+	event.yoffset = win->scanout;
+	event.queued = win->flip_count;
+	win->event_seq = event.sequence;
+	spin_unlock_irqrestore(&fbdev->slock, flags);
+
+	if (copy_to_user(buf, &event, sizeof(event)))
+		return -EFAULT;
+
+	return sizeof(event);
+}
+
+/* readable on a new vsync, writable while a pan would not get -EBUSY */
+static unsigned int s3cfb_poll(struct fb_info *fb, struct file *file,
+			       struct poll_table_struct *wait)
+{
+	struct s3cfb_window *win = fb->par;
+	unsigned int mask = 0;
+
+	if (!win->vsync_events)
+		return DEFAULT_POLLMASK;
+
+	poll_wait(file, &fbdev->wq, wait);
+
+	if (fbdev->wq_count != win->event_seq)
+		mask |= POLLIN | POLLRDNORM;
+
+	if (win->flip_count < win->flip_depth || !win->flip_depth)
+		mask |= POLLOUT | POLLWRNORM;
+
+	return mask;
 }
 
 static inline unsigned int __chan_to_field(unsigned int chan,
@@ -538,6 +954,19 @@ static int s3cfb_release_window(struct fb_info *fb)
 {
 	struct s3c_platform_fb *pdata = to_fb_plat(fbdev->dev);
 	struct s3cfb_window *win = fb->par;
+	unsigned long flags;
+
+	s3cfb_flush_flips(win->id);
+	win->flip_depth = 0;
+	win->vsync_events = 0;
+
+	spin_lock_irqsave(&fbdev->slock, flags);
+	win->staged.flags = 0;
+	fbdev->update_mask &= ~(1 << win->id);
+	spin_unlock_irqrestore(&fbdev->slock, flags);
+
+	wake_up(&fbdev->wq);
+	s3cfb_update_vsync();
 
 	if (win->id != pdata->default_win) {
 		s3cfb_disable_window(win->id);
@@ -572,11 +1001,21 @@ static int s3cfb_cursor(struct fb_info *info, struct fb_cursor *cursor)
 
 static int s3cfb_wait_for_vsync(void)
 {
+	unsigned int count = fbdev->wq_count;
+	int ret;
+
 	dev_dbg(fbdev->dev, "waiting for VSYNC interrupt\n");
 
-	sleep_on_timeout(&fbdev->wq, HZ / 10);
+	ret = wait_event_interruptible_timeout(fbdev->wq,
+					       fbdev->wq_count != count,
+					       HZ / 10);
+	if (ret < 0)
+		return ret;
 
-	dev_dbg(fbdev->dev, "got a VSYNC interrupt\n");
+	if (ret == 0)
+		dev_dbg(fbdev->dev, "timed out waiting for VSYNC\n");
+	else
+		dev_dbg(fbdev->dev, "got a VSYNC interrupt\n");
 
 	return 0;
 }
@@ -592,12 +1031,14 @@ static int s3cfb_ioctl(struct fb_info *fb, unsigned int cmd, unsigned long arg)
 		struct s3cfb_user_window user_window;
 		struct s3cfb_user_plane_alpha user_alpha;
 		struct s3cfb_user_chroma user_chroma;
+		struct s3cfb_user_update user_update;
 		int vsync;
+		unsigned int depth;
 	} p;
 
 	switch (cmd) {
 	case FBIO_WAITFORVSYNC:
-		s3cfb_wait_for_vsync();
+		ret = s3cfb_wait_for_vsync();
 		break;
 
 	case S3CFB_WIN_POSITION:
@@ -632,20 +1073,10 @@ static int s3cfb_ioctl(struct fb_info *fb, unsigned int cmd, unsigned long arg)
 				   sizeof(p.user_alpha)))
 			ret = -EFAULT;
 		else {
-			win->alpha.mode = PLANE_BLENDING;
-			win->alpha.channel = p.user_alpha.channel;
-#if defined (CONFIG_CPU_S5PC110)
-			win->alpha.avalue_h =
-			    S3CFB_AVALUE_H(p.user_alpha.red,
-					 p.user_alpha.green, p.user_alpha.blue);
-			win->alpha.avalue_l =
-			    S3CFB_AVALUE_L(p.user_alpha.red,
-					 p.user_alpha.green, p.user_alpha.blue);
-#else
-			win->alpha.value =
-			    S3CFB_AVALUE(p.user_alpha.red,
-					 p.user_alpha.green, p.user_alpha.blue);
-#endif
+			s3cfb_set_plane_alpha(win, p.user_alpha.channel,
+					      p.user_alpha.red,
+					      p.user_alpha.green,
+					      p.user_alpha.blue);
 
 			s3cfb_set_alpha_blending(fbdev, win->id);
 		}
@@ -670,10 +1101,47 @@ static int s3cfb_ioctl(struct fb_info *fb, unsigned int cmd, unsigned long arg)
 		if (get_user(p.vsync, (int __user *)arg))
 			ret = -EFAULT;
 		else {
-			if (p.vsync)
-				s3cfb_set_global_interrupt(fbdev, 1);
+			fbdev->vsync_req = p.vsync;
+			s3cfb_update_vsync();
+		}
+		break;
 
-			s3cfb_set_vsync_interrupt(fbdev, p.vsync);
+	case S3CFB_SET_FLIP_QUEUE:
+		if (get_user(p.depth, (unsigned int __user *)arg))
+			ret = -EFAULT;
+		else if (p.depth > S3CFB_FLIP_QUEUE_MAX ||
+			 p.depth > fb->fix.ypanstep) {
+			dev_err(fbdev->dev, "[fb%d] flip queue of %u needs "
+				"more buffers\n", win->id, p.depth);
+			ret = -EINVAL;
+		} else {
+			s3cfb_flush_flips(win->id);
+			win->flip_depth = p.depth;
+			s3cfb_update_vsync();
+		}
+		break;
+
+	case S3CFB_WIN_UPDATE:
+		if (copy_from_user(&p.user_update,
+				   (struct s3cfb_user_update __user *)arg,
+				   sizeof(p.user_update)))
+			ret = -EFAULT;
+		else {
+			ret = s3cfb_stage_update(&p.user_update);
+			if (!ret && put_user(p.user_update.sequence,
+				&((struct s3cfb_user_update __user *)arg)->sequence))
+				ret = -EFAULT;
+		}
+		break;
+
+	case S3CFB_SET_VSYNC_EVENT:
+		if (get_user(p.vsync, (int __user *)arg))
+			ret = -EFAULT;
+		else {
+			win->event_seq = fbdev->wq_count;
+			win->vsync_events = p.vsync ? 1 : 0;
+			wake_up(&fbdev->wq);
+			s3cfb_update_vsync();
 		}
 		break;
 	}
@@ -690,6 +1158,8 @@ struct fb_ops s3cfb_ops = {
 	.fb_set_par = s3cfb_set_par,
 	.fb_blank = s3cfb_blank,
 	.fb_pan_display = s3cfb_pan_display,
+	.fb_read = s3cfb_read,
+	.fb_poll = s3cfb_poll,
 	.fb_setcolreg = s3cfb_setcolreg,
 	.fb_cursor = s3cfb_cursor,
 	.fb_ioctl = s3cfb_ioctl,
@@ -862,18 +1332,18 @@ int s3cfb_direct_ioctl(int id, unsigned int cmd, unsigned long arg)
 
 	case S3CFB_SET_WIN_ADDR:
 		fix->smem_start = (unsigned long)argp;
+		win->buf_addr = 0;
 		s3cfb_set_buffer_address(fbdev, id);
 		break;
 
 	case S3CFB_SET_WIN_MEM :
 		win->owner = (enum s3cfb_mem_owner_t)argp;
+		win->buf_addr = 0;
 		break;
 
 	case S3CFB_SET_VSYNC_INT:
-		if (argp)
-			s3cfb_set_global_interrupt(fbdev, 1);
-
-		s3cfb_set_vsync_interrupt(fbdev, argp);
+		fbdev->vsync_req = argp ? 1 : 0;
+		s3cfb_update_vsync();
 		break;
 
 	case S3CFB_GET_VSYNC_INT_STATUS:
@@ -1165,6 +1635,8 @@ static int s3cfb_probe(struct platform_device *pdev)
 	}
 
 	fbdev->dev = &pdev->dev;
+	init_waitqueue_head(&fbdev->wq);
+	spin_lock_init(&fbdev->slock);
 	s3cfb_set_lcd_info(fbdev);
 
 	/* gpio */
@@ -1318,6 +1790,7 @@ int s3cfb_resume(struct platform_device *pdev)
 	struct s3c_platform_fb *pdata = to_fb_plat(&pdev->dev);
 	struct fb_info *fb;
 	struct s3cfb_window *win;
+	unsigned long flags;
 	int i;
 
 	dev_dbg(fbdev->dev, "wake up from suspend\n");
@@ -1330,12 +1803,18 @@ int s3cfb_resume(struct platform_device *pdev)
 	for (i = 0; i < pdata->nr_wins; i++) {
 		fb = fbdev->fb[i];
 		win = fb->par;
+		s3cfb_flush_flips(win->id);
 		if ((win->owner == DMA_MEM_FIMD) && (win->enabled)) {
 			s3cfb_set_win_params(win->id);
 			s3cfb_enable_window(win->id);
 		}
 	}
 
+	spin_lock_irqsave(&fbdev->slock, flags);
+	s3cfb_commit_updates();
+	__s3cfb_update_vsync();
+	spin_unlock_irqrestore(&fbdev->slock, flags);
+
 	if (pdata->cfg_gpio)
 		pdata->cfg_gpio(pdev);
 
@@ -16,6 +16,8 @@
 #ifdef __KERNEL__
 #include <linux/wait.h>
 #include <linux/mutex.h>
+#include <linux/spinlock.h>
+#include <linux/time.h>
 #include <linux/fb.h>
 #include <plat/fb.h>
 #endif
@@ -25,6 +27,8 @@
  *
 */
 #define S3CFB_NAME		"s3cfb"
+#define S3CFB_FLIP_QUEUE_MAX	4
+#define S3CFB_MAX_WINDOWS	5
 
 #if defined (CONFIG_CPU_S5PC110)
 #define S3CFB_AVALUE_H(r, g, b)	(((r & 0xf0) << 4) | (g & 0xf0) | ((b & 0xf0) >> 4))
@@ -78,6 +82,58 @@ enum s3cfb_mem_owner_t {
 	DMA_MEM_OTHER	= 2,
 };
 
+/*
+ * struct s3cfb_user_win_update
+ * @id:			window to update
+ * @flags:		S3CFB_UPDATE_* fields to apply
+ * @x, @y:		position (S3CFB_UPDATE_POSITION)
+ * @enabled:		window on or off (S3CFB_UPDATE_ENABLE)
+ * @alpha_channel:	plane alpha channel and value (S3CFB_UPDATE_ALPHA)
+ * @chroma_enabled:	colour key and value (S3CFB_UPDATE_CHROMA)
+ * @addr:		physical buffer for windows whose memory is owned by
+ *			another driver, inside the video memory of a window
+ *			owned by fimd or an MFC or FIMC buffer
+ *			(S3CFB_UPDATE_ADDR)
+ * @yoffset:		pan inside the window memory, var.yoffset follows
+ *			at the vsync commit (S3CFB_UPDATE_YOFFSET)
+*/
+#define S3CFB_UPDATE_POSITION	(1 << 0)
+#define S3CFB_UPDATE_ENABLE	(1 << 1)
+#define S3CFB_UPDATE_ALPHA	(1 << 2)
+#define S3CFB_UPDATE_CHROMA	(1 << 3)
+#define S3CFB_UPDATE_ADDR	(1 << 4)
+#define S3CFB_UPDATE_YOFFSET	(1 << 5)
+
+struct s3cfb_user_win_update {
+	int		id;
+	unsigned int	flags;
+	int		x;
+	int		y;
+	int		enabled;
+	int		alpha_channel;
+	unsigned char	alpha_red;
+	unsigned char	alpha_green;
+	unsigned char	alpha_blue;
+	int		chroma_enabled;
+	unsigned char	chroma_red;
+	unsigned char	chroma_green;
+	unsigned char	chroma_blue;
+	unsigned long	addr;
+	unsigned int	yoffset;
+};
+
+/*
+ * struct s3cfb_user_update
+ * @count:		entries used in win
+ * @win:		per window updates, committed together at next vsync
+ * @sequence:		returned frame count of the first frame showing them
+*/
+struct s3cfb_user_update {
+	unsigned int			count;
+	struct s3cfb_user_win_update	win[S3CFB_MAX_WINDOWS];
+	unsigned int			sequence;
+};
+
 /*
  * F I M D   S T R U C T U R E S
  *
@@ -193,6 +249,15 @@ struct s3cfb_lcd {
  * @pseudo_pal:		pseudo palette for fb layer
  * @alpha:		alpha blending structure
  * @chroma:		chroma key structure
+ * @flip_depth:		pans that may wait for vsync (0: pan immediately)
+ * @flip_queue:		yoffsets waiting for vsync, oldest at flip_head
+ * @latched:		yoffset written to the shadow registers at last vsync
+ * @scanout:		yoffset being scanned out
+ * @vsync_events:	if read() returns struct s3cfb_vsync_event
+ * @event_seq:		frame count of the last event read
+ * @staged:		S3CFB_WIN_UPDATE fields waiting for vsync
+ * @buf_addr:		buffer set by S3CFB_UPDATE_ADDR, scanned out instead
+ *			of fix.smem_start when not 0
 */
 struct s3cfb_window {
 	int			id;
@@ -207,12 +272,28 @@ struct s3cfb_window {
 	unsigned int		pseudo_pal[16];
 	struct			s3cfb_alpha alpha;
 	struct			s3cfb_chroma chroma;
+
+	unsigned int		flip_depth;
+	unsigned int		flip_queue[S3CFB_FLIP_QUEUE_MAX];
+	unsigned int		flip_head;
+	unsigned int		flip_count;
+	unsigned int		latched;
+	unsigned int		scanout;
+	int			vsync_events;
+	unsigned int		event_seq;
+	struct			s3cfb_user_win_update staged;
+	dma_addr_t		buf_addr;
 };
 
 /*
  * struct s3cfb_global
  *
  * @fb:			pointer to fb_info
+ * @slock:		protects the flip queues against the frame interrupt
+ * @wq_count:		frame count, incremented at every vsync
+ * @vsync_time:		time of the last vsync
+ * @vsync_req:		if the vsync interrupt was asked for by ioctl
+ * @update_mask:	windows with staged updates
  * @enabled:		if signal output enabled
  * @dsi:		if mipi-dsim enabled
  * @interlace:		if interlace format is used
@@ -229,6 +310,10 @@ struct s3cfb_global {
 	int			irq;
 	wait_queue_head_t	wq;
 	unsigned int		wq_count;
+	spinlock_t		slock;
+	struct timeval		vsync_time;
+	int			vsync_req;
+	unsigned int		update_mask;
 	struct fb_info		**fb;
 
 	/* fimd */
@@ -271,6 +356,19 @@ struct s3cfb_user_chroma {
 	unsigned char	blue;
 };
 
+/*
+ * read() on a window with S3CFB_SET_VSYNC_EVENT on returns the latest
+ * vsync; gaps in sequence are frames missed by the reader.  yoffset is
+ * the buffer scanned out from this frame on, queued the pans still
+ * waiting for a vsync.
+*/
+struct s3cfb_vsync_event {
+	__u32		sequence;
+	struct timeval	timestamp;
+	__u32		yoffset;
+	__u32		queued;
+};
+
 
 /*
  * C U S T O M  I O C T L S
@@ -283,6 +381,9 @@ struct s3cfb_user_chroma {
 #define S3CFB_SET_VSYNC_INT		_IOW ('F', 206, u32)
 #define S3CFB_GET_VSYNC_INT_STATUS	_IOR ('F', 207, u32)
 #define S3CFB_PAN_DISPLAY		_IOW ('F', 208, u32)
+#define S3CFB_SET_FLIP_QUEUE		_IOW ('F', 209, u32)
+#define S3CFB_SET_VSYNC_EVENT		_IOW ('F', 210, u32)
+#define S3CFB_WIN_UPDATE		_IOWR('F', 211, struct s3cfb_user_update)
 #define S3CFB_GET_LCD_WIDTH		_IOR ('F', 302, int)
 #define S3CFB_GET_LCD_HEIGHT		_IOR ('F', 303, int)
 #define S3CFB_SET_WRITEBACK		_IOW ('F', 304, u32)
@@ -325,6 +426,9 @@ extern int s3cfb_set_alpha_blending(struct s3cfb_global *ctrl, int id);
 extern int s3cfb_set_window_position(struct s3cfb_global *ctrl, int id);
 extern int s3cfb_set_window_size(struct s3cfb_global *ctrl, int id);
 extern int s3cfb_set_buffer_address(struct s3cfb_global *ctrl, int id);
+extern int s3cfb_set_buffer_offset(struct s3cfb_global *ctrl, int id,
+				   unsigned int yoffset);
+extern int s3cfb_set_shadow_protect(struct s3cfb_global *ctrl, int protect);
 extern int s3cfb_set_buffer_size(struct s3cfb_global *ctrl, int id);
 extern int s3cfb_set_chroma_key(struct s3cfb_global *ctrl, int id);
 
@@ -480,15 +480,35 @@ int s3cfb_set_window_control(struct s3cfb_global *ctrl, int id)
 	return 0;
 }
 
-int s3cfb_set_buffer_address(struct s3cfb_global *ctrl, int id)
+int s3cfb_set_shadow_protect(struct s3cfb_global *ctrl, int protect)
+{
+	unsigned int cfg;
+
+	if (protect)
+		cfg = S3C_PRTCON_PROTECT;
+	else
+		cfg = S3C_PRTCON_UPDATABLE;
+
+	writel(cfg, ctrl->regs + S3C_PRTCON);
+
+	dev_dbg(ctrl->dev, "shadow registers are %s\n",
+		protect ? "protected" : "updatable");
+
+	return 0;
+}
+
+int s3cfb_set_buffer_offset(struct s3cfb_global *ctrl, int id,
+			    unsigned int yoffset)
 {
 	struct fb_fix_screeninfo *fix = &ctrl->fb[id]->fix;
 	struct fb_var_screeninfo *var = &ctrl->fb[id]->var;
+	struct s3cfb_window *win = ctrl->fb[id]->par;
+	dma_addr_t base = win->buf_addr ? win->buf_addr : fix->smem_start;
 	dma_addr_t start_addr = 0, end_addr = 0;
 
-	if (fix->smem_start) {
-		start_addr = fix->smem_start + (var->xres_virtual *
-				(var->bits_per_pixel / 8) * var->yoffset);
+	if (base) {
+		start_addr = base + (var->xres_virtual *
+				(var->bits_per_pixel / 8) * yoffset);
 
 		end_addr = start_addr + (var->xres_virtual *
 				(var->bits_per_pixel / 8) * var->yres);
@@ -503,6 +523,11 @@ int s3cfb_set_buffer_address(struct s3cfb_global *ctrl, int id)
 	return 0;
 }
 
+int s3cfb_set_buffer_address(struct s3cfb_global *ctrl, int id)
+{
+	return s3cfb_set_buffer_offset(ctrl, id, ctrl->fb[id]->var.yoffset);
+}
+
 int s3cfb_set_alpha_blending(struct s3cfb_global *ctrl, int id)
 {
 	struct s3cfb_window *win = ctrl->fb[id]->par;
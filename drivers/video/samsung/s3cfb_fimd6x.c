@@ -564,30 +564,50 @@ int s3cfb_set_window_control(struct s3cfb_global *ctrl, int id)
 	return 0;
 }
 
-int s3cfb_set_buffer_address(struct s3cfb_global *ctrl, int id)
+int s3cfb_set_shadow_protect(struct s3cfb_global *ctrl, int protect)
+{
+	u32 cfg;
+
+	if (protect)
+		cfg = S3C_PRTCON_PROTECT;
+	else
+		cfg = S3C_PRTCON_UPDATABLE;
+
+	writel(cfg, ctrl->regs + S3C_PRTCON);
+
+	dev_dbg(ctrl->dev, "shadow registers are %s\n",
+		protect ? "protected" : "updatable");
+
+	return 0;
+}
+
+int s3cfb_set_buffer_offset(struct s3cfb_global *ctrl, int id,
+			    unsigned int yoffset)
 {
 	struct fb_fix_screeninfo *fix = &ctrl->fb[id]->fix;
 	struct fb_var_screeninfo *var = &ctrl->fb[id]->var;
+	struct s3cfb_window *win = ctrl->fb[id]->par;
+	dma_addr_t base = win->buf_addr ? win->buf_addr : fix->smem_start;
 	dma_addr_t start_addr = 0, end_addr = 0;
 	u32 shw;
 
-	if (fix->smem_start) {
-		start_addr = fix->smem_start + (var->xres_virtual *
-				(var->bits_per_pixel / 8) * var->yoffset);
+	if (base) {
+		start_addr = base + (var->xres_virtual *
+				(var->bits_per_pixel / 8) * yoffset);
 
 		end_addr = start_addr + (var->xres_virtual *
 				(var->bits_per_pixel / 8) * var->yres);
 	}
 
 	shw = readl(ctrl->regs + S3C_WINSHMAP);
-        shw |= S3C_WINSHMAP_PROTECT(id);
+        shw |= S3C_WINSHMAP_PROTECT(1 << id);
         writel(shw, ctrl->regs + S3C_WINSHMAP);
 
 	writel(start_addr, ctrl->regs + S3C_VIDADDR_START0(id));
 	writel(end_addr, ctrl->regs + S3C_VIDADDR_END0(id));
 
 	shw = readl(ctrl->regs + S3C_WINSHMAP);
-        shw &= ~(S3C_WINSHMAP_PROTECT(id));
+        shw &= ~(S3C_WINSHMAP_PROTECT(1 << id));
         writel(shw, ctrl->regs + S3C_WINSHMAP);
 
 	dev_dbg(ctrl->dev, "[fb%d] start_addr: 0x%08x, end_addr: 0x%08x\n",
@@ -596,6 +616,11 @@ int s3cfb_set_buffer_address(struct s3cfb_global *ctrl, int id)
 	return 0;
 }
 
+int s3cfb_set_buffer_address(struct s3cfb_global *ctrl, int id)
+{
+	return s3cfb_set_buffer_offset(ctrl, id, ctrl->fb[id]->var.yoffset);
+}
+
 int s3cfb_set_alpha_blending(struct s3cfb_global *ctrl, int id)
 {
 	struct s3cfb_window *win = ctrl->fb[id]->par;
@@ -655,7 +680,7 @@ int s3cfb_set_window_position(struct s3cfb_global *ctrl, int id)
 	u32 cfg, shw;
 
 	shw = readl(ctrl->regs + S3C_WINSHMAP);
-	shw |= S3C_WINSHMAP_PROTECT(id);
+	shw |= S3C_WINSHMAP_PROTECT(1 << id);
 	writel(shw, ctrl->regs + S3C_WINSHMAP);
 
 	cfg = S3C_VIDOSD_LEFT_X(win->x) | S3C_VIDOSD_TOP_Y(win->y);
@@ -667,7 +692,7 @@ int s3cfb_set_window_position(struct s3cfb_global *ctrl, int id)
 	writel(cfg, ctrl->regs + S3C_VIDOSD_B(id));
 
 	shw = readl(ctrl->regs + S3C_WINSHMAP);
-	shw &= ~(S3C_WINSHMAP_PROTECT(id));
+	shw &= ~(S3C_WINSHMAP_PROTECT(1 << id));
 	writel(shw, ctrl->regs + S3C_WINSHMAP);
 
 	dev_dbg(ctrl->dev, "[fb%d] offset: (%d, %d, %d, %d)\n", id,
@@ -139,6 +139,12 @@ struct mtd_info {
 	/* ecc layout structure pointer - read only ! */
 	struct nand_ecclayout *ecclayout;
 
+	/* Max number of bit-flips the ECC corrects in one ECC step, zero if
+	 * the driver does not tell. Users like UBI use it to decide when the
+	 * data are worth moving before they become uncorrectable.
+	 */
+	unsigned int ecc_strength;
+
 	/* Data for variable erase regions. If numeraseregions is zero,
 	 * it means that the whole device has erasesize as given above.
 	 */
@@ -84,6 +84,12 @@ extern void nand_wait_ready(struct mtd_info *mtd);
 #define NAND_CMD_READSTART	0x30
 #define NAND_CMD_RNDOUTSTART	0xE0
 #define NAND_CMD_CACHEDPROG	0x15
+#define NAND_CMD_READCACHESEQ	0x31
+#define NAND_CMD_READCACHEEND	0x3f
+
+/* Two-plane program/erase (Samsung large page MLC) */
+#define NAND_CMD_PLANEPROG	0x11
+#define NAND_CMD_PLANESEQIN	0x81
 
 /* Extended commands for AG-AND device */
 /*
@@ -177,6 +183,8 @@ typedef enum {
 #define NAND_MUST_PAD(chip) (!(chip->options & NAND_NO_PADDING))
 #define NAND_HAS_CACHEPROG(chip) ((chip->options & NAND_CACHEPRG))
 #define NAND_HAS_COPYBACK(chip) ((chip->options & NAND_COPYBACK))
+#define NAND_HAS_CACHEREAD(chip) ((chip->options & NAND_CACHEREAD))
+#define NAND_HAS_MULTIPLANE(chip) ((chip->options & NAND_MULTIPLANE))
 /* Large page NAND with SOFT_ECC should support subpage reads */
 #define NAND_SUBPAGE_READ(chip) ((chip->ecc.mode == NAND_ECC_SOFT) \
 					&& (chip->page_shift > 9))
@@ -193,6 +201,12 @@ typedef enum {
 /* This option is defined if the board driver allocates its own buffers
    (e.g. because it needs them DMA-coherent */
 #define NAND_OWN_BUFFERS	0x00040000
+/* Chip and controller can stream pages with cache read (31h/3Fh).
+ * Only honoured for large page devices. */
+#define NAND_CACHEREAD		0x00080000
+/* Chip can program and erase an even/odd block pair at once
+ * (two-plane 11h/81h and 60h/60h/D0h). Large page devices only. */
+#define NAND_MULTIPLANE		0x00100000
 /* Options set by nand scan */
 /* Nand scan has allocated controller struct */
 #define NAND_CONTROLLER_ALLOC	0x80000000
@@ -361,6 +375,10 @@ struct nand_buffers {
  * @errstat:		[OPTIONAL] hardware specific function to perform additional error status checks
  *			(determine if errors are correctable)
  * @write_page:		[REPLACEABLE] High-level page write function
+ * @read_page_cache:	[REPLACEABLE] move the next page of a cache read into the
+ *			cache register (31h, or 3Fh for the last one) and read it
+ * @write_page_planes:	[REPLACEABLE] program the same page of an even/odd block pair
+ * @erase_cmd_planes:	[REPLACEABLE] erase command for an even/odd block pair
  */
 
 struct nand_chip {
@@ -385,6 +403,12 @@ struct nand_chip {
 	int		(*errstat)(struct mtd_info *mtd, struct nand_chip *this, int state, int status, int page);
 	int		(*write_page)(struct mtd_info *mtd, struct nand_chip *chip,
 				      const uint8_t *buf, int page, int cached, int raw);
+	int		(*read_page_cache)(struct mtd_info *mtd, struct nand_chip *chip,
+					   uint8_t *buf, int last);
+	int		(*write_page_planes)(struct mtd_info *mtd, struct nand_chip *chip,
+					     const uint8_t *buf0, const uint8_t *buf1,
+					     int page);
+	void		(*erase_cmd_planes)(struct mtd_info *mtd, int page);
 
 	int		chip_delay;
 	unsigned int	options;
@@ -31,7 +31,21 @@ test_pages_isolated(unsigned long start_pfn, unsigned long end_pfn);
  * Please use make_pagetype_isolated()/make_pagetype_movable().
  */
 extern int set_migratetype_isolate(struct page *page);
-extern void unset_migratetype_isolate(struct page *page);
+extern void unset_migratetype_isolate(struct page *page, int migratetype);
+
+#ifdef CONFIG_MIGRATE_CONTIG
+/*
+ * Contiguous regions lent to movable pages. init_contig_range() turns a
+ * reserved range into MIGRATE_CONTIG pageblocks, alloc_contig_range()
+ * takes pages back from it and free_contig_range() lends them again.
+ */
+extern void init_contig_range(unsigned long start_pfn, unsigned long nr_pages);
+extern int alloc_contig_range(unsigned long start_pfn, unsigned long end_pfn);
+extern void free_contig_range(unsigned long pfn, unsigned long nr_pages);
+
+/* internal, for alloc_contig_range() */
+extern int take_contig_range(unsigned long start_pfn, unsigned long end_pfn);
+#endif
 
 
 #endif
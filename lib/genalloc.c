@@ -159,6 +159,75 @@ unsigned long gen_pool_alloc(struct gen_pool *pool, size_t size)
 }
 EXPORT_SYMBOL(gen_pool_alloc);
 
+/**
+ * gen_pool_alloc_best_fit - allocate aligned special memory from the pool
+ * @pool: pool to allocate from
+ * @size: number of bytes to allocate from the pool
+ * @align_order: log base 2 of the alignment of the returned address
+ *
+ * Allocate the requested number of bytes from the specified pool, starting
+ * on a (1 << @align_order) byte boundary. Every free area of every chunk is
+ * looked at and the smallest one that can hold the request is used, so
+ * large free areas are kept for large requests.
+ */
+unsigned long gen_pool_alloc_best_fit(struct gen_pool *pool, size_t size,
+				      int align_order)
+{
+	struct list_head *_chunk;
+	struct gen_pool_chunk *chunk, *best_chunk = NULL;
+	unsigned long addr, flags;
+	int order = pool->min_alloc_order;
+	int nbits, bit, next_bit, start_bit, end_bit;
+	int best_bit = 0, best_len = 0;
+
+	if (size == 0)
+		return 0;
+
+	if (align_order < order)
+		align_order = order;
+
+	nbits = (size + (1UL << order) - 1) >> order;
+
+	write_lock_irqsave(&pool->lock, flags);
+	list_for_each(_chunk, &pool->chunks) {
+		chunk = list_entry(_chunk, struct gen_pool_chunk, next_chunk);
+
+		end_bit = (chunk->end_addr - chunk->start_addr) >> order;
+
+		bit = find_next_zero_bit(chunk->bits, end_bit, 0);
+		while (bit < end_bit) {
+			next_bit = find_next_bit(chunk->bits, end_bit, bit);
+
+			addr = ALIGN(chunk->start_addr +
+				     ((unsigned long)bit << order),
+				     1UL << align_order);
+			start_bit = (addr - chunk->start_addr) >> order;
+
+			if (start_bit + nbits <= next_bit &&
+			    (best_chunk == NULL || next_bit - bit < best_len)) {
+				best_chunk = chunk;
+				best_bit = start_bit;
+				best_len = next_bit - bit;
+			}
+
+			bit = find_next_zero_bit(chunk->bits, end_bit,
+						 next_bit);
+		}
+	}
+
+	addr = 0;
+	if (best_chunk != NULL) {
+		addr = best_chunk->start_addr +
+				((unsigned long)best_bit << order);
+		while (nbits--)
+			__set_bit(best_bit++, best_chunk->bits);
+	}
+	write_unlock_irqrestore(&pool->lock, flags);
+
+	return addr;
+}
+EXPORT_SYMBOL(gen_pool_alloc_best_fit);
+
 /**
  * gen_pool_free - free allocated special memory back to the pool
  * @pool: pool to free to
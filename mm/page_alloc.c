@@ -845,6 +845,15 @@ static struct page *__rmqueue(struct zone *zone, unsigned int order,
 
 	page = __rmqueue_smallest(zone, order, migratetype);
 
+#ifdef CONFIG_MIGRATE_CONTIG
+	/*
+	 * Movable pages may borrow the contiguous region, they are migrated
+	 * away again when a driver claims it. Nothing else falls back here.
+	 */
+	if (unlikely(!page) && migratetype == MIGRATE_MOVABLE)
+		page = __rmqueue_smallest(zone, order, MIGRATE_CONTIG);
+#endif
+
 	if (unlikely(!page))
 		page = __rmqueue_fallback(zone, order, migratetype);
 
@@ -4706,8 +4715,15 @@ int set_migratetype_isolate(struct page *page)
 	/*
 	 * In future, more migrate types will be able to be isolation target.
 	 */
-	if (get_pageblock_migratetype(page) != MIGRATE_MOVABLE)
+	switch (get_pageblock_migratetype(page)) {
+	case MIGRATE_MOVABLE:
+#ifdef CONFIG_MIGRATE_CONTIG
+	case MIGRATE_CONTIG:
+#endif
+		break;
+	default:
 		goto out;
+	}
 	set_pageblock_migratetype(page, MIGRATE_ISOLATE);
 	move_freepages_block(zone, page, MIGRATE_ISOLATE);
 	ret = 0;
@@ -4718,7 +4734,7 @@ out:
 	return ret;
 }
 
-void unset_migratetype_isolate(struct page *page)
+void unset_migratetype_isolate(struct page *page, int migratetype)
 {
 	struct zone *zone;
 	unsigned long flags;
@@ -4726,12 +4742,115 @@ void unset_migratetype_isolate(struct page *page)
 	spin_lock_irqsave(&zone->lock, flags);
 	if (get_pageblock_migratetype(page) != MIGRATE_ISOLATE)
 		goto out;
-	set_pageblock_migratetype(page, MIGRATE_MOVABLE);
-	move_freepages_block(zone, page, MIGRATE_MOVABLE);
+	set_pageblock_migratetype(page, migratetype);
+	move_freepages_block(zone, page, migratetype);
 out:
 	spin_unlock_irqrestore(&zone->lock, flags);
 }
 
+#ifdef CONFIG_MIGRATE_CONTIG
+/*
+ * Turn a reserved, pageblock aligned range into MIGRATE_CONTIG pageblocks.
+ * The pages are left allocated with a reference each; give the ones that
+ * are not in use to the page allocator with free_contig_range().
+ */
+void __init init_contig_range(unsigned long start_pfn, unsigned long nr_pages)
+{
+	unsigned long pfn, end_pfn = start_pfn + nr_pages;
+	struct page *page;
+
+	BUG_ON(start_pfn & (pageblock_nr_pages - 1));
+	BUG_ON(nr_pages & (pageblock_nr_pages - 1));
+
+	for (pfn = start_pfn; pfn < end_pfn; pfn += pageblock_nr_pages)
+		set_pageblock_migratetype(pfn_to_page(pfn), MIGRATE_CONTIG);
+
+	for (pfn = start_pfn; pfn < end_pfn; pfn++) {
+		page = pfn_to_page(pfn);
+		ClearPageReserved(page);
+		init_page_count(page);
+	}
+
+	totalram_pages += nr_pages;
+}
+
+/*
+ * Take the free pages of [start_pfn, end_pfn) off the free lists. The
+ * pageblocks must be isolated and the range free already, otherwise
+ * nothing is taken and -EBUSY is returned. Buddies straddling the ends
+ * of the range are split and their outer parts freed again.
+ */
+int take_contig_range(unsigned long start_pfn, unsigned long end_pfn)
+{
+	unsigned long scan = start_pfn & ~(MAX_ORDER_NR_PAGES - 1);
+	unsigned long pfn, first = end_pfn, last = start_pfn;
+	struct zone *zone = page_zone(pfn_to_page(start_pfn));
+	struct page *page;
+	unsigned long flags;
+	int order, i;
+
+	spin_lock_irqsave(&zone->lock, flags);
+
+	/* buddies never cross a MAX_ORDER boundary, so scanning from one
+	 * only ever lands on buddy heads or on pages in use */
+	for (pfn = scan; pfn < end_pfn; ) {
+		page = pfn_to_page(pfn);
+		if (PageBuddy(page)) {
+			pfn += 1UL << page_order(page);
+		} else if (pfn >= start_pfn) {
+			spin_unlock_irqrestore(&zone->lock, flags);
+			return -EBUSY;
+		} else {
+			pfn++;
+		}
+	}
+
+	for (pfn = scan; pfn < end_pfn; ) {
+		page = pfn_to_page(pfn);
+		if (!PageBuddy(page)) {
+			pfn++;
+			continue;
+		}
+
+		order = page_order(page);
+		if (pfn + (1UL << order) <= start_pfn) {
+			pfn += 1UL << order;
+			continue;
+		}
+
+		list_del(&page->lru);
+		rmv_page_order(page);
+		zone->free_area[order].nr_free--;
+		__mod_zone_page_state(zone, NR_FREE_PAGES, -(1UL << order));
+
+		for (i = 0; i < (1 << order); i++)
+			set_page_refcounted(page + i);
+
+		first = min(first, pfn);
+		pfn += 1UL << order;
+		last = max(last, pfn);
+	}
+
+	spin_unlock_irqrestore(&zone->lock, flags);
+
+	for (pfn = first; pfn < start_pfn; pfn++)
+		__free_page(pfn_to_page(pfn));
+	for (pfn = end_pfn; pfn < last; pfn++)
+		__free_page(pfn_to_page(pfn));
+
+	return 0;
+}
+
+/*
+ * Give [pfn, pfn + nr_pages) back to the page allocator.
+ */
+void free_contig_range(unsigned long pfn, unsigned long nr_pages)
+{
+	for (; nr_pages--; pfn++)
+		__free_page(pfn_to_page(pfn));
+}
+#endif /* CONFIG_MIGRATE_CONTIG */
+
 #ifdef CONFIG_MEMORY_HOTREMOVE
 /*
  * All pages in the range must be isolated before calling this.
@@ -5,6 +5,8 @@
 #include <linux/mm.h>
 #include <linux/page-isolation.h>
 #include <linux/pageblock-flags.h>
+#include <linux/migrate.h>
+#include <linux/swap.h>
 #include "internal.h"
 
 static inline struct page *
@@ -56,16 +58,14 @@ undo:
 	for (pfn = start_pfn;
 	     pfn < undo_pfn;
 	     pfn += pageblock_nr_pages)
-		unset_migratetype_isolate(pfn_to_page(pfn));
+		unset_migratetype_isolate(pfn_to_page(pfn), MIGRATE_MOVABLE);
 
 	return -EBUSY;
 }
 
-/*
- * Make isolated pages available again.
- */
-int
-undo_isolate_page_range(unsigned long start_pfn, unsigned long end_pfn)
+static void
+__undo_isolate_page_range(unsigned long start_pfn, unsigned long end_pfn,
+			  int migratetype)
 {
 	unsigned long pfn;
 	struct page *page;
@@ -77,8 +77,17 @@ undo_isolate_page_range(unsigned long start_pfn, unsigned long end_pfn)
 		page = __first_valid_page(pfn, pageblock_nr_pages);
 		if (!page || get_pageblock_migratetype(page) != MIGRATE_ISOLATE)
 			continue;
-		unset_migratetype_isolate(page);
+		unset_migratetype_isolate(page, migratetype);
 	}
+}
+
+/*
+ * Make isolated pages available again.
+ */
+int
+undo_isolate_page_range(unsigned long start_pfn, unsigned long end_pfn)
+{
+	__undo_isolate_page_range(start_pfn, end_pfn, MIGRATE_MOVABLE);
 	return 0;
 }
 /*
@@ -140,3 +149,81 @@ int test_pages_isolated(unsigned long start_pfn, unsigned long end_pfn)
 	spin_unlock_irqrestore(&zone->lock, flags);
 	return ret ? 0 : -EBUSY;
 }
+
+#ifdef CONFIG_MIGRATE_CONTIG
+
+#define CONTIG_MIGRATE_RETRIES	5
+
+static struct page *
+contig_migrate_alloc(struct page *page, unsigned long private, int **x)
+{
+	return alloc_page(GFP_HIGHUSER_MOVABLE);
+}
+
+/* migrate the movable pages in use in [start_pfn, end_pfn) elsewhere */
+static int
+migrate_contig_range(unsigned long start_pfn, unsigned long end_pfn)
+{
+	unsigned long pfn;
+	struct page *page;
+	LIST_HEAD(source);
+	int ret;
+
+	for (pfn = start_pfn; pfn < end_pfn; pfn++) {
+		page = pfn_to_page(pfn);
+		if (!page_count(page) || PageBuddy(page))
+			continue;
+		if (!isolate_lru_page(page))
+			list_add_tail(&page->lru, &source);
+	}
+
+	if (list_empty(&source))
+		return 0;
+
+	ret = migrate_pages(&source, contig_migrate_alloc, 0);
+	if (ret)
+		putback_lru_pages(&source);
+
+	return ret;
+}
+
+/*
+ * alloc_contig_range() -- allocate [start_pfn, end_pfn) from pageblocks of
+ * MIGRATE_CONTIG type, migrating the movable pages borrowing it.
+ *
+ * The pageblocks around the range are isolated while this runs, so that
+ * nothing new lands in it. Returns 0 with every page of the range
+ * allocated, or -EBUSY if some page could not be moved away.
+ * Callers must serialise allocations sharing a pageblock.
+ */
+int alloc_contig_range(unsigned long start_pfn, unsigned long end_pfn)
+{
+	unsigned long outer_start = start_pfn & ~(pageblock_nr_pages - 1);
+	unsigned long outer_end = ALIGN(end_pfn, pageblock_nr_pages);
+	int tries, ret;
+
+	ret = start_isolate_page_range(outer_start, outer_end);
+	if (ret)
+		return ret;
+
+	for (tries = 0; tries < CONTIG_MIGRATE_RETRIES; tries++) {
+		/* pages still on the pagevecs are not on the LRU yet */
+		lru_add_drain_all();
+
+		migrate_contig_range(start_pfn, end_pfn);
+
+		/* and freed ones may sit on the per-cpu lists */
+		drain_all_pages();
+
+		ret = take_contig_range(start_pfn, end_pfn);
+		if (!ret)
+			break;
+
+		cond_resched();
+	}
+
+	__undo_isolate_page_range(outer_start, outer_end, MIGRATE_CONTIG);
+
+	return ret;
+}
+#endif /* CONFIG_MIGRATE_CONTIG */
@@ -392,6 +392,9 @@ static char * const migratetype_names[MIGRATE_TYPES] = {
 	"Reclaimable",
 	"Movable",
 	"Reserve",
+#ifdef CONFIG_MIGRATE_CONTIG
+	"Contig",
+#endif
 	"Isolate",
 };
 
@@ -13,6 +13,7 @@
 #include <linux/interrupt.h>
 #include <linux/platform_device.h>
 #include <linux/dma-mapping.h>
+#include <linux/moduleparam.h>
 
 #include <sound/pcm.h>
 #include <sound/pcm_params.h>
@@ -57,13 +58,29 @@ static const struct snd_pcm_hardware s3c_idma_hardware = {
 	.channels_min = 2,
 	.channels_max = 2,
 	.buffer_bytes_max = MAX_LP_BUFF,
-	.period_bytes_min = LP_DMA_PERIOD,
+	.period_bytes_min = LP_DMA_PERIOD_MIN,
 	.period_bytes_max = LP_DMA_PERIOD,
 	.periods_min = 1,
-	.periods_max = 2,
+	.periods_max = LP_DMA_PERIODS_MAX,
 	.fifo_size = 64,
 };
 
+/*
+ * With mmap_noirq set, an mmap stream runs without period interrupts.
+ * The application tracks the DMA itself through SNDRV_PCM_IOCTL_HWSYNC,
+ * which reads the word-exact transfer count. The pointer only gives the
+ * position inside the buffer, and snd_pcm_update_hw_ptr() takes a step
+ * back of less than half a buffer for jitter, not a wrap. So the DMA must
+ * move less than half a buffer between two syncs, or the stream position
+ * stalls or skips whole buffers. Nothing calls snd_pcm_period_elapsed()
+ * in this mode, so poll() and blocking waits never wake up; the
+ * application has to time its syncs itself. Read/write streams always
+ * keep their interrupts.
+ */
+static int mmap_noirq;
+module_param(mmap_noirq, bool, 0644);
+MODULE_PARM_DESC(mmap_noirq, "Run mmap streams without period interrupts");
+
 struct lpam_i2s_pdata {
 	spinlock_t lock;
 	int state;
@@ -76,6 +93,8 @@ static struct s3c_idma_info {
 	struct snd_dma_buffer ibuff;
 	void __iomem  *regs;
 	unsigned      dma_prd;
+	unsigned      dma_end;
+	int           noirq;
 	spinlock_t    lock;
 	void          *token;
 	void (*cb)(void *dt, int bytes_xfer);
@@ -94,7 +113,7 @@ static int s3c_idma_enqueue(void *token)
 	s3c_idma.token = token;
 	spin_unlock(&s3c_idma.lock);
 
-	pr_debug("%s: %x@%x\n", __func__, MAX_LP_BUFF, LP_TXBUFF_ADDR);
+	pr_debug("%s: %x@%x\n", __func__, s3c_idma.dma_end, LP_TXBUFF_ADDR);
 
 	val = LP_TXBUFF_ADDR + s3c_idma.dma_prd;
 	writel(val, s3c_idma.regs + S5P_IISADDR0);
@@ -104,24 +123,31 @@ static int s3c_idma_enqueue(void *token)
 
 	val = readl(s3c_idma.regs + S5P_IISSIZE);
 	val &= ~(S5P_IISSIZE_TRNMSK << S5P_IISSIZE_SHIFT);
-	val |= (((MAX_LP_BUFF >> 2) & S5P_IISSIZE_TRNMSK) << S5P_IISSIZE_SHIFT);
+	val |= (((s3c_idma.dma_end >> 2) & S5P_IISSIZE_TRNMSK) << S5P_IISSIZE_SHIFT);
 	writel(val, s3c_idma.regs + S5P_IISSIZE);
 
 	val = readl(s3c_idma.regs + S5P_IISAHB);
-	val |= S5P_IISAHB_INTENLVL0;
+	if (s3c_idma.noirq)
+		val &= ~S5P_IISAHB_INTENLVL0;
+	else
+		val |= S5P_IISAHB_INTENLVL0;
 	writel(val, s3c_idma.regs + S5P_IISAHB);
 
 	return 0;
 }
 
-static void s3c_idma_setcallbk(void (*cb)(void *, int), unsigned prd)
+static void s3c_idma_setcallbk(void (*cb)(void *, int), unsigned prd,
+				unsigned size, int noirq)
 {
 	spin_lock(&s3c_idma.lock);
 	s3c_idma.cb = cb;
 	s3c_idma.dma_prd = prd;
+	s3c_idma.dma_end = size;
+	s3c_idma.noirq = noirq;
 	spin_unlock(&s3c_idma.lock);
 
-	pr_debug("%s:%d dma_period=%x\n", __func__, __LINE__, s3c_idma.dma_prd);
+	pr_debug("%s:%d dma_period=%x dma_end=%x noirq=%d\n", __func__,
+		__LINE__, s3c_idma.dma_prd, s3c_idma.dma_end, noirq);
 }
 
 static void s3c_idma_ctrl(int op)
@@ -133,8 +159,11 @@ static void s3c_idma_ctrl(int op)
 	val = readl(s3c_idma.regs + S5P_IISAHB);
 	val &= ~(S5P_IISAHB_INTENLVL0 | S5P_IISAHB_DMAEN);
 
-	if (op == LPAM_DMA_START)
-		val |= S5P_IISAHB_INTENLVL0 | S5P_IISAHB_DMAEN;
+	if (op == LPAM_DMA_START) {
+		val |= S5P_IISAHB_DMAEN;
+		if (!s3c_idma.noirq)
+			val |= S5P_IISAHB_INTENLVL0;
+	}
 
 	writel(val, s3c_idma.regs + S5P_IISAHB);
 
@@ -159,6 +188,7 @@ static int s3c_idma_hw_params(struct snd_pcm_substream *substream,
 {
 	struct snd_pcm_runtime *runtime = substream->runtime;
 	struct snd_dma_buffer *buf = &substream->dma_buffer;
+	int noirq;
 
 	pr_debug("Entered %s\n", __func__);
 
@@ -168,7 +198,11 @@ static int s3c_idma_hw_params(struct snd_pcm_substream *substream,
 	snd_pcm_set_runtime_buffer(substream, &s3c_idma.ibuff);
 	runtime->dma_bytes = params_buffer_bytes(params);
 
-	s3c_idma_setcallbk(s3c_idma_done, params_period_bytes(params));
+	noirq = mmap_noirq &&
+		params_access(params) == SNDRV_PCM_ACCESS_MMAP_INTERLEAVED;
+
+	s3c_idma_setcallbk(s3c_idma_done, params_period_bytes(params),
+			runtime->dma_bytes, noirq);
 	s3c_idma_enqueue((void *)substream);
 
 	pr_debug("DmaAddr=@%x Total=0x%xbytes PrdSz=0x%x #Prds=%u\n",
@@ -254,6 +288,10 @@ static snd_pcm_uframes_t
 
 	res = src - runtime->dma_addr;
 
+	/* the count reads the full size for a moment before it reloads */
+	if (res >= runtime->dma_bytes)
+		res = 0;
+
 	spin_unlock(&prtd->lock);
 
 	pr_debug("Pointer %x %x\n", src, dst);
@@ -312,7 +350,7 @@ static irqreturn_t s3c_iis_irq(int irqno, void *dev_id)
 		if (iisahb & S5P_IISAHB_LVL0INT) {
 			val = readl(s3c_idma.regs + S5P_IISADDR0) - LP_TXBUFF_ADDR; /* current offset */
 			val += s3c_idma.dma_prd; /* Length before next Lvl0 Intr */
-			val %= MAX_LP_BUFF; /* Round off at boundary */
+			val %= s3c_idma.dma_end; /* Round off at boundary */
 			writel(LP_TXBUFF_ADDR + val, s3c_idma.regs + S5P_IISADDR0); /* Update start address */
 		}
 
@@ -323,7 +361,7 @@ static irqreturn_t s3c_iis_irq(int irqno, void *dev_id)
 		/* Keep callback in the end */
 		if (s3c_idma.cb) {
 		   val = (iisahb & S5P_IISAHB_LVL0INT) ?
-				s3c_idma.dma_prd : MAX_LP_BUFF;
+				s3c_idma.dma_prd : s3c_idma.dma_end;
 		   s3c_idma.cb(s3c_idma.token, val);
 		}
 	}
@@ -339,10 +377,13 @@ static int s3c_idma_open(struct snd_pcm_substream *substream)
 
 	pr_debug("Entered %s\n", __func__);
 
-	snd_pcm_hw_constraint_minmax(runtime,
-		SNDRV_PCM_HW_PARAM_BUFFER_BYTES, MAX_LP_BUFF, MAX_LP_BUFF);
 	snd_soc_set_runtime_hwparams(substream, &s3c_idma_hardware);
 
+	/* the level interrupt wraps at the buffer size, in whole words */
+	snd_pcm_hw_constraint_integer(runtime, SNDRV_PCM_HW_PARAM_PERIODS);
+	snd_pcm_hw_constraint_step(runtime, 0,
+		SNDRV_PCM_HW_PARAM_PERIOD_BYTES, 4);
+
 	prtd = kzalloc(sizeof(struct lpam_i2s_pdata), GFP_KERNEL);
 	if (prtd == NULL)
 		return -ENOMEM;
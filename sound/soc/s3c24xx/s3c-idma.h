@@ -22,6 +22,10 @@
 #define LP_DMA_PERIOD (128 * 1024)
 #endif
 
+/* smallest period, about 0.7ms of 48kHz S16 stereo */
+#define LP_DMA_PERIOD_MIN	128
+#define LP_DMA_PERIODS_MAX	32
+
 #define LP_TXBUFF_ADDR    (0xC0000000)
 
 /* dma_state */